@@ -5,6 +5,7 @@
 #include "../map.h"
 #include "../tile.h"
 #include "border_brush.h"
+#include "brush_search.h"
 #include "creature_brush.h"
 #include "doodad_brush.h"
 #include "ground_brush.h"
@@ -12,9 +13,6 @@
 #include "raw_brush.h"
 #include "wall_brush.h"
 
-#define FTS_FUZZY_MATCH_IMPLEMENTATION
-#include "../../vendor/fts_fuzzy_match/fts_fuzzy_match.h"
-
 vme_unordered_map<uint32_t, std::unique_ptr<RawBrush>> Brush::rawBrushes;
 vme_unordered_map<std::string, std::unique_ptr<GroundBrush>> Brush::groundBrushes;
 vme_unordered_map<std::string, std::unique_ptr<BorderBrush>> Brush::borderBrushes;
@@ -298,93 +296,34 @@ const vme_unordered_map<uint32_t, std::unique_ptr<RawBrush>> &Brush::getRawBrush
 
 BrushSearchResult Brush::search(std::string searchString)
 {
-    using Match = std::pair<int, Brush *>;
-
     BrushSearchResult searchResult;
-
-    std::vector<Match> matches;
-
-    for (const auto &[_, rawBrush] : rawBrushes)
-    {
-        int score = 1;
-        bool match = fts::fuzzy_match(searchString.c_str(), rawBrush->name().c_str(), score) ||
-                     std::to_string(rawBrush->serverId()).find(searchString) != std::string::npos;
-
-        if (match)
-        {
-            matches.emplace_back(std::pair{score, rawBrush.get()});
-            ++searchResult.rawCount;
-        }
-    }
-
-    for (const auto &[_, groundBrush] : groundBrushes)
-    {
-        int score;
-        bool match = fts::fuzzy_match(searchString.c_str(), groundBrush->name().c_str(), score);
-
-        if (match)
-        {
-            matches.emplace_back(std::pair{score, groundBrush.get()});
-            ++searchResult.groundCount;
-        }
-    }
-
-    for (const auto &[_, doodadBrush] : doodadBrushes)
-    {
-        int score;
-        bool match = fts::fuzzy_match(searchString.c_str(), doodadBrush->name().c_str(), score);
-
-        if (match)
-        {
-            matches.emplace_back(std::pair{score, doodadBrush.get()});
-            ++searchResult.doodadCount;
-        }
-    }
-
-    for (const auto &[_, creatureBrush] : creatureBrushes)
-    {
-        int score;
-        bool match = fts::fuzzy_match(searchString.c_str(), creatureBrush->name().c_str(), score);
-
-        if (match)
-        {
-            matches.emplace_back(std::pair{score, creatureBrush.get()});
-            ++searchResult.creatureCount;
-        }
-    }
-
-    std::sort(matches.begin(), matches.end(), Brush::matchSorter);
-
     searchResult.matches = std::make_unique<std::vector<Brush *>>();
-    searchResult.matches->reserve(matches.size());
 
-    std::transform(matches.begin(), matches.end(), std::back_inserter(*searchResult.matches),
-                   [](Match match) -> Brush * { return match.second; });
+    BrushSearch search(searchIndex(), std::move(searchString));
+    search.run([&searchResult](BrushSearchResult &&batch) {
+        searchResult.matches->insert(searchResult.matches->end(), batch.matches->begin(), batch.matches->end());
+        searchResult.rawCount += batch.rawCount;
+        searchResult.groundCount += batch.groundCount;
+        searchResult.doodadCount += batch.doodadCount;
+        searchResult.creatureCount += batch.creatureCount;
+    });
 
     return searchResult;
 }
 
-bool Brush::brushSorter(const Brush *leftBrush, const Brush *rightBrush)
+std::shared_ptr<const BrushSearchIndex> Brush::searchIndex()
 {
-    if (leftBrush->type() != rightBrush->type())
+    static std::shared_ptr<const BrushSearchIndex> index;
+    if (!index || !index->upToDate())
     {
-        return to_underlying(leftBrush->type()) < to_underlying(rightBrush->type());
+        index = BrushSearchIndex::build();
     }
 
-    // Both raw here, no need to check rightBrush (we check if they are the same above)
-    if (leftBrush->type() == BrushType::Raw)
-    {
-        return static_cast<const RawBrush *>(leftBrush)->serverId() > static_cast<const RawBrush *>(rightBrush)->serverId();
-    }
-
-    // Same brushes but not of type Raw, use match score
-    return leftBrush->name() < rightBrush->name();
+    return index;
 }
 
-bool Brush::matchSorter(std::pair<int, Brush *> &lhs, const std::pair<int, Brush *> &rhs)
+bool Brush::brushSorter(const Brush *leftBrush, const Brush *rightBrush)
 {
-    auto leftBrush = lhs.second;
-    auto rightBrush = rhs.second;
     if (leftBrush->type() != rightBrush->type())
     {
         return to_underlying(leftBrush->type()) < to_underlying(rightBrush->type());
@@ -393,11 +332,11 @@ bool Brush::matchSorter(std::pair<int, Brush *> &lhs, const std::pair<int, Brush
     // Both raw here, no need to check rightBrush (we check if they are the same above)
     if (leftBrush->type() == BrushType::Raw)
     {
-        return static_cast<RawBrush *>(leftBrush)->serverId() < static_cast<RawBrush *>(rightBrush)->serverId();
+        return static_cast<const RawBrush *>(leftBrush)->serverId() > static_cast<const RawBrush *>(rightBrush)->serverId();
     }
 
     // Same brushes but not of type Raw, use match score
-    return lhs.first < rhs.first;
+    return leftBrush->name() < rightBrush->name();
 }
 
 vme_unordered_map<std::string, std::unique_ptr<GroundBrush>> &Brush::getGroundBrushes()
@@ -30,6 +30,7 @@ class Map;
 class Tile;
 class ItemType;
 class Brush;
+class BrushSearchIndex;
 
 class BrushShape
 {
@@ -164,8 +165,15 @@ class Brush
 
     const std::string &name() const noexcept;
 
+    /*
+		Searches the raw, ground, doodad and creature brushes on the calling thread. See BrushSearch for a search
+		that can run in the background.
+	*/
     static BrushSearchResult search(std::string searchString);
 
+    // The search index of the current brushes. Rebuilt if brushes were added since the last call.
+    static std::shared_ptr<const BrushSearchIndex> searchIndex();
+
     virtual std::vector<ThingDrawInfo> getPreviewTextureInfo(int variation) const = 0;
     virtual void updatePreview(int variation);
     virtual int variationCount() const;
@@ -229,7 +237,7 @@ class Brush
     static void setBrushShape(BrushShape *brushShape) noexcept;
 
   protected:
-    static bool matchSorter(std::pair<int, Brush *> &lhs, const std::pair<int, Brush *> &rhs);
+    friend class BrushSearchIndex;
 
     // ServerId -> Brush
     static vme_unordered_map<uint32_t, std::unique_ptr<RawBrush>> rawBrushes;
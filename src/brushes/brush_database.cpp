@@ -0,0 +1,225 @@
+#include "brush_database.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#include "../debug.h"
+#include "../file.h"
+#include "../logger.h"
+#include "../mapped_file.h"
+#include "../thread_pool.h"
+#include "../time_util.h"
+#include "brush_loader.h"
+
+using json = nlohmann::json;
+
+namespace
+{
+    constexpr std::array<char, 8> Magic = {'V', 'M', 'E', 'B', 'R', 'D', 'B', '\0'};
+
+    struct Header
+    {
+        std::array<char, 8> magic;
+        uint32_t formatVersion;
+        uint32_t documentCount;
+    };
+
+    // Followed by the file name of the source and dataSize bytes of MessagePack
+    struct DocumentHeader
+    {
+        uint64_t sourceHash;
+        uint64_t dataSize;
+        uint32_t nameLength;
+        uint32_t reserved;
+    };
+
+    static_assert(sizeof(Header) == 16);
+    static_assert(offsetof(Header, formatVersion) == BrushDatabase::FormatVersionOffset);
+    static_assert(sizeof(DocumentHeader) == 24);
+} // namespace
+
+BrushDatabase::BrushDatabase(std::filesystem::path databaseFile, std::vector<std::filesystem::path> sourceFiles)
+    : databaseFile(std::move(databaseFile))
+{
+    documents.reserve(sourceFiles.size());
+    for (auto &path : sourceFiles)
+    {
+        documents.emplace_back(Document{std::move(path), std::nullopt, std::nullopt});
+    }
+}
+
+size_t BrushDatabase::compile()
+{
+    TimePoint start;
+
+    for (auto &document : documents)
+    {
+        document.hash = File::contentHash(document.path);
+    }
+
+    if (!databaseFile.empty())
+    {
+        readDatabase();
+    }
+
+    std::vector<Document *> stale;
+    for (auto &document : documents)
+    {
+        // Missing files are reported by BrushLoader when the brushes are loaded
+        if (document.hash && !document.json)
+        {
+            stale.emplace_back(&document);
+        }
+    }
+
+    if (!stale.empty())
+    {
+        ThreadPool::parallelFor(stale.size(), [&stale](size_t i) {
+            stale[i]->json = BrushLoader::parseFile(stale[i]->path);
+        });
+
+        if (!databaseFile.empty())
+        {
+            writeDatabase();
+        }
+    }
+
+    compiled = true;
+
+    VME_LOG("Compiled " << documents.size() << " brush files (" << stale.size() << " parsed) in " << start.elapsedMillis() << " ms.");
+
+    return stale.size();
+}
+
+bool BrushDatabase::load(BrushLoader &loader)
+{
+    DEBUG_ASSERT(compiled, "BrushDatabase::compile must be called before BrushDatabase::load.");
+
+    bool success = true;
+    for (auto &document : documents)
+    {
+        if (document.json)
+        {
+            success &= loader.load(*document.json, document.path);
+
+            // The brushes hold everything they need, the document is not used again
+            document.json.reset();
+        }
+        else
+        {
+            success &= loader.load(document.path);
+        }
+    }
+
+    return success;
+}
+
+const nlohmann::json *BrushDatabase::compiledDocument(const std::filesystem::path &sourceFile) const
+{
+    auto document = std::find_if(documents.begin(), documents.end(), [&sourceFile](const Document &document) {
+        return document.path == sourceFile;
+    });
+
+    return document != documents.end() && document->json ? &*document->json : nullptr;
+}
+
+void BrushDatabase::readDatabase()
+{
+    auto file = MappedFile::open(databaseFile);
+    if (!file)
+    {
+        return;
+    }
+
+    File::Cursor cursor(file->data(), file->size());
+
+    Header header;
+    if (!cursor.read(&header, sizeof(Header)) || header.magic != Magic || header.formatVersion != FormatVersion)
+    {
+        VME_LOG_D("Ignoring the outdated brush database " << databaseFile.string());
+        return;
+    }
+
+    for (uint32_t i = 0; i < header.documentCount; ++i)
+    {
+        DocumentHeader documentHeader;
+        if (!cursor.read(&documentHeader, sizeof(DocumentHeader)))
+        {
+            VME_LOG_ERROR("The brush database " << databaseFile.string() << " is damaged.");
+            return;
+        }
+
+        std::string name(documentHeader.nameLength, '\0');
+        const uint8_t *data = cursor.read(name.data(), name.size()) ? cursor.skip(documentHeader.dataSize) : nullptr;
+        if (!data)
+        {
+            VME_LOG_ERROR("The brush database " << databaseFile.string() << " is damaged.");
+            return;
+        }
+
+        auto document = std::find_if(documents.begin(), documents.end(), [&name](const Document &document) {
+            return document.path.filename().string() == name;
+        });
+
+        if (document == documents.end() || document->hash != documentHeader.sourceHash)
+        {
+            continue;
+        }
+
+        try
+        {
+            document->json = json::from_msgpack(data, data + documentHeader.dataSize);
+        }
+        catch (const json::exception &exception)
+        {
+            VME_LOG_ERROR("Could not decode " << name << " from the brush database: " << exception.what());
+        }
+    }
+}
+
+void BrushDatabase::writeDatabase() const
+{
+    TimePoint start;
+
+    Header header;
+    header.magic = Magic;
+    header.formatVersion = FormatVersion;
+    header.documentCount = 0;
+
+    std::vector<uint8_t> buffer(sizeof(Header));
+    for (const auto &document : documents)
+    {
+        if (!document.json)
+        {
+            continue;
+        }
+
+        std::string name = document.path.filename().string();
+        std::vector<uint8_t> data = json::to_msgpack(*document.json);
+
+        DocumentHeader documentHeader;
+        documentHeader.sourceHash = *document.hash;
+        documentHeader.dataSize = data.size();
+        documentHeader.nameLength = static_cast<uint32_t>(name.size());
+        documentHeader.reserved = 0;
+
+        File::append(buffer, &documentHeader, sizeof(DocumentHeader));
+        File::append(buffer, name.data(), name.size());
+        File::append(buffer, data.data(), data.size());
+
+        ++header.documentCount;
+    }
+
+    std::memcpy(buffer.data(), &header, sizeof(Header));
+
+    if (auto error = File::writeAtomically(databaseFile, buffer))
+    {
+        VME_LOG_ERROR("Could not write the brush database " << databaseFile.string() << ": " << error.message());
+        return;
+    }
+
+    VME_LOG("Wrote the brush database (" << buffer.size() / 1024 << " KB) in " << start.elapsedMillis() << " ms.");
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <vector>
+
+class BrushLoader;
+
+/*
+	The brush files of a client compiled into a single binary file. Each brush file is stored as MessagePack
+	together with a hash of its JSON source, so later starts decode the compiled documents instead of parsing the
+	JSON text. Only brush files whose hash changed are parsed again, in parallel, and the database is rewritten.
+
+	Compiling does not touch any editor state, so it can run before the item types are loaded. load then adds the
+	brushes through BrushLoader in the order of the source files, because later files refer to brushes from
+	earlier ones.
+
+	FormatVersion must be increased whenever the layout of the database changes.
+*/
+class BrushDatabase
+{
+  public:
+    // An empty databaseFile parses every source file and does not read or write a database
+    BrushDatabase(std::filesystem::path databaseFile, std::vector<std::filesystem::path> sourceFiles);
+
+    /*
+		Reads the compiled brush files and parses the ones that are missing or stale. Returns the number of files
+		that were parsed. Safe to call from any thread.
+	*/
+    size_t compile();
+
+    /*
+		Adds the brushes of every source file. compile must have been called. Returns false if any file failed.
+	*/
+    bool load(BrushLoader &loader);
+
+    // The compiled document of a source file. nullptr if the file could not be read or was already loaded.
+    const nlohmann::json *compiledDocument(const std::filesystem::path &sourceFile) const;
+
+    static constexpr uint32_t FormatVersion = 1;
+    // Byte offset of the format version in the database file
+    static constexpr size_t FormatVersionOffset = 8;
+
+  private:
+    struct Document
+    {
+        std::filesystem::path path;
+        std::optional<uint64_t> hash;
+        std::optional<nlohmann::json> json;
+    };
+
+    void readDatabase();
+    void writeDatabase() const;
+
+    std::filesystem::path databaseFile;
+    std::vector<Document> documents;
+    bool compiled = false;
+};
@@ -155,17 +155,24 @@ int getIntOrElse(const json &j, std::string key, uint32_t fallback)
 
 bool BrushLoader::load(std::filesystem::path path)
 {
-    TimePoint start;
-
     if (!std::filesystem::exists(path))
     {
         VME_LOG_ERROR(std::format("Could not find file '{}'", path.string()));
         return false;
     }
 
+    return load(parseFile(path), path);
+}
+
+json BrushLoader::parseFile(const std::filesystem::path &path)
+{
     std::ifstream fileStream(path);
-    json rootJson = json::parse(fileStream, nullptr, true, true);
-    fileStream.close();
+    return json::parse(fileStream, nullptr, true, true);
+}
+
+bool BrushLoader::load(const json &rootJson, const std::filesystem::path &path)
+{
+    TimePoint start;
 
     auto topTrace = stackTrace;
 
@@ -202,7 +209,7 @@ bool BrushLoader::load(std::filesystem::path path)
         return false;
     }
 
-    VME_LOG("Loaded brushes in " << start.elapsedMillis() << " ms.");
+    VME_LOG("Loaded brushes from " << path.filename().string() << " in " << start.elapsedMillis() << " ms.");
 
     return true;
 }
@@ -24,6 +24,17 @@ class BrushLoader
   public:
     bool load(std::filesystem::path path);
 
+    /*
+		Adds the palettes, brushes, tilesets and creatures of a brush file that was already parsed. The path is
+		only used in messages.
+	*/
+    bool load(const nlohmann::json &rootJson, const std::filesystem::path &path);
+
+    /*
+		Parses a brush file without adding anything to the editor, so it is safe to call from any thread.
+	*/
+    static nlohmann::json parseFile(const std::filesystem::path &path);
+
   private:
     void parseBrushes(const nlohmann::json &brushesJson);
     void parseTilesets(const nlohmann::json &tilesetsJson);
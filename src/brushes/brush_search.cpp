@@ -0,0 +1,270 @@
+#include "brush_search.h"
+
+#include <algorithm>
+#include <cctype>
+#include <utility>
+
+#include "creature_brush.h"
+#include "doodad_brush.h"
+#include "ground_brush.h"
+#include "raw_brush.h"
+
+#define FTS_FUZZY_MATCH_IMPLEMENTATION
+#include "../../vendor/fts_fuzzy_match/fts_fuzzy_match.h"
+
+namespace
+{
+    std::string lowercase(const std::string &s)
+    {
+        std::string result(s);
+        std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return result;
+    }
+
+    // One bit per letter and digit. Other characters share the remaining bits.
+    uint64_t characterMask(const std::string &lowercaseText)
+    {
+        uint64_t mask = 0;
+        for (unsigned char c : lowercaseText)
+        {
+            uint32_t bit;
+            if ('a' <= c && c <= 'z')
+            {
+                bit = c - 'a';
+            }
+            else if ('0' <= c && c <= '9')
+            {
+                bit = 26 + (c - '0');
+            }
+            else
+            {
+                bit = 36 + c % 28;
+            }
+
+            mask |= uint64_t(1) << bit;
+        }
+
+        return mask;
+    }
+
+    bool isSubsequence(const std::string &pattern, const std::string &text)
+    {
+        size_t next = 0;
+        for (size_t i = 0; i < text.size() && next < pattern.size(); ++i)
+        {
+            if (text[i] == pattern[next])
+            {
+                ++next;
+            }
+        }
+
+        return next == pattern.size();
+    }
+
+    bool isNumber(const std::string &s)
+    {
+        return !s.empty() && std::all_of(s.begin(), s.end(), [](unsigned char c) { return std::isdigit(c); });
+    }
+
+    void count(BrushSearchResult &result, BrushType type)
+    {
+        switch (type)
+        {
+            case BrushType::Raw:
+                ++result.rawCount;
+                break;
+            case BrushType::Ground:
+                ++result.groundCount;
+                break;
+            case BrushType::Doodad:
+                ++result.doodadCount;
+                break;
+            case BrushType::Creature:
+                ++result.creatureCount;
+                break;
+            default:
+                break;
+        }
+    }
+} // namespace
+
+std::array<size_t, 4> BrushSearchIndex::brushCounts()
+{
+    return {Brush::rawBrushes.size(), Brush::groundBrushes.size(), Brush::doodadBrushes.size(), Brush::creatureBrushes.size()};
+}
+
+std::shared_ptr<const BrushSearchIndex> BrushSearchIndex::build()
+{
+    auto index = std::make_shared<BrushSearchIndex>();
+    index->builtBrushCounts = brushCounts();
+
+    auto &entries = index->entries;
+    entries.reserve(Brush::rawBrushes.size() + Brush::groundBrushes.size() + Brush::doodadBrushes.size() + Brush::creatureBrushes.size());
+
+    auto add = [&entries](Brush *brush, std::string serverId) {
+        std::string name = lowercase(brush->name());
+        uint64_t characters = characterMask(name);
+        entries.emplace_back(Entry{brush, brush->type(), characters, std::move(name), std::move(serverId)});
+    };
+
+    for (const auto &[_, brush] : Brush::creatureBrushes)
+    {
+        add(brush.get(), "");
+    }
+    for (const auto &[_, brush] : Brush::doodadBrushes)
+    {
+        add(brush.get(), "");
+    }
+    for (const auto &[_, brush] : Brush::groundBrushes)
+    {
+        add(brush.get(), "");
+    }
+    for (const auto &[serverId, brush] : Brush::rawBrushes)
+    {
+        add(brush.get(), std::to_string(serverId));
+    }
+
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry &lhs, const Entry &rhs) {
+        if (lhs.type != rhs.type)
+        {
+            return to_underlying(lhs.type) < to_underlying(rhs.type);
+        }
+
+        if (lhs.type == BrushType::Raw)
+        {
+            return static_cast<const RawBrush *>(lhs.brush)->serverId() < static_cast<const RawBrush *>(rhs.brush)->serverId();
+        }
+
+        return false;
+    });
+
+    return index;
+}
+
+bool BrushSearchIndex::upToDate() const
+{
+    return builtBrushCounts == brushCounts();
+}
+
+size_t BrushSearchIndex::size() const noexcept
+{
+    return entries.size();
+}
+
+BrushSearch::BrushSearch(std::shared_ptr<const BrushSearchIndex> index, std::string query, std::shared_ptr<const BrushSearch> previous)
+    : index(std::move(index)), _query(std::move(query))
+{
+    if (previous && previous->finished() && previous->index == this->index && _query.starts_with(previous->_query))
+    {
+        candidates = previous->matches;
+        std::sort(candidates.begin(), candidates.end());
+        refined = true;
+    }
+}
+
+bool BrushSearch::run(const std::function<void(BrushSearchResult &&)> &onMatches, size_t batchSize)
+{
+    const auto &entries = index->entries;
+
+    const std::string lowercaseQuery = lowercase(_query);
+    const uint64_t queryCharacters = characterMask(lowercaseQuery);
+    const bool numericQuery = isNumber(_query);
+
+    const size_t candidateCount = refined ? candidates.size() : entries.size();
+    auto entryIndex = [this](size_t i) { return refined ? candidates[i] : static_cast<uint32_t>(i); };
+
+    BrushSearchResult batch;
+    batch.matches = std::make_unique<std::vector<Brush *>>();
+
+    auto addMatch = [&](uint32_t index) {
+        const BrushSearchIndex::Entry &entry = entries[index];
+        batch.matches->emplace_back(entry.brush);
+        count(batch, entry.type);
+        matches.emplace_back(index);
+
+        if (batch.matches->size() >= batchSize)
+        {
+            onMatches(std::move(batch));
+            batch = BrushSearchResult{};
+            batch.matches = std::make_unique<std::vector<Brush *>>();
+        }
+    };
+
+    // Matches of a brush type other than raw are sorted by score before they are passed on
+    std::vector<std::pair<int, uint32_t>> scored;
+
+    for (size_t i = 0; i < candidateCount;)
+    {
+        BrushType type = entries[entryIndex(i)].type;
+        scored.clear();
+
+        for (; i < candidateCount && entries[entryIndex(i)].type == type; ++i)
+        {
+            if (i % 256 == 0 && _cancelled)
+            {
+                return false;
+            }
+
+            uint32_t index = entryIndex(i);
+            const BrushSearchIndex::Entry &entry = entries[index];
+
+            int score = 1;
+            bool match = (entry.characters & queryCharacters) == queryCharacters &&
+                         isSubsequence(lowercaseQuery, entry.lowercaseName) &&
+                         fts::fuzzy_match(_query.c_str(), entry.brush->name().c_str(), score);
+
+            if (!match && numericQuery && entry.serverId.find(_query) != std::string::npos)
+            {
+                match = true;
+            }
+
+            if (!match)
+            {
+                continue;
+            }
+
+            if (type == BrushType::Raw)
+            {
+                addMatch(index);
+            }
+            else
+            {
+                scored.emplace_back(score, index);
+            }
+        }
+
+        std::stable_sort(scored.begin(), scored.end(), [](const auto &lhs, const auto &rhs) { return lhs.first < rhs.first; });
+        for (const auto &[score, index] : scored)
+        {
+            addMatch(index);
+        }
+    }
+
+    if (!batch.matches->empty())
+    {
+        onMatches(std::move(batch));
+    }
+
+    _finished = true;
+    return true;
+}
+
+void BrushSearch::cancel() noexcept
+{
+    _cancelled = true;
+}
+
+bool BrushSearch::cancelled() const noexcept
+{
+    return _cancelled;
+}
+
+bool BrushSearch::finished() const noexcept
+{
+    return _finished;
+}
+
+const std::string &BrushSearch::query() const noexcept
+{
+    return _query;
+}
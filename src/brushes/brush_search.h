@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "brush.h"
+
+/*
+	An index over the brushes that can be searched for: raw, ground, doodad and creature brushes.
+
+	Names are lowercased once, and every entry has a mask of the characters in its name. A query is a fuzzy
+	subsequence match, so a brush whose name lacks any character of the query is rejected by a single AND before
+	the fuzzy matcher runs. Raw brushes keep their server ID as text for numeric queries.
+
+	Entries are stored in the order of the search results: by brush type, and raw brushes by server ID. The index
+	holds pointers to the brushes, so it is rebuilt when brushes are added (see upToDate).
+*/
+class BrushSearchIndex
+{
+  public:
+    // Must be called from the main thread.
+    static std::shared_ptr<const BrushSearchIndex> build();
+
+    // False if brushes were added since the index was built. Must be called from the main thread.
+    bool upToDate() const;
+
+    size_t size() const noexcept;
+
+  private:
+    friend class BrushSearch;
+
+    struct Entry
+    {
+        Brush *brush;
+        BrushType type;
+        uint64_t characters;
+        std::string lowercaseName;
+        // Empty for brushes that are not raw brushes
+        std::string serverId;
+    };
+
+    static std::array<size_t, 4> brushCounts();
+
+    std::vector<Entry> entries;
+    std::array<size_t, 4> builtBrushCounts;
+};
+
+/*
+	One query against a BrushSearchIndex. run may be called on any thread and stops early once cancel is called.
+
+	A brush that does not match a query cannot match a longer query that starts with it. A search for such a query
+	therefore only looks at the matches of the previous, finished search.
+*/
+class BrushSearch
+{
+  public:
+    BrushSearch(std::shared_ptr<const BrushSearchIndex> index, std::string query, std::shared_ptr<const BrushSearch> previous = nullptr);
+
+    /*
+		Passes the matches to onMatches in batches, in result order. The counts of a batch only include its own
+		matches. Returns false if the search was cancelled.
+	*/
+    bool run(const std::function<void(BrushSearchResult &&)> &onMatches, size_t batchSize = DefaultBatchSize);
+
+    void cancel() noexcept;
+    bool cancelled() const noexcept;
+    bool finished() const noexcept;
+
+    const std::string &query() const noexcept;
+
+    static constexpr size_t DefaultBatchSize = 256;
+
+  private:
+    std::shared_ptr<const BrushSearchIndex> index;
+    std::string _query;
+
+    // Indices of the entries to look at, in entry order. Every entry if empty and there is no previous search.
+    std::vector<uint32_t> candidates;
+    bool refined = false;
+
+    // Indices of the matching entries. Only complete once the search has finished.
+    std::vector<uint32_t> matches;
+
+    std::atomic<bool> _cancelled = false;
+    std::atomic<bool> _finished = false;
+};
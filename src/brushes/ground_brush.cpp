@@ -12,6 +12,7 @@
 #include "../settings.h"
 #include "../tile.h"
 #include "../tile_cover.h"
+#include "../trace.h"
 #include "border_brush.h"
 #include "mountain_brush.h"
 
@@ -454,6 +455,11 @@ const std::unordered_set<uint32_t> &GroundBrush::serverIds() const
     return _serverIds;
 }
 
+const std::vector<WeightedItemId> &GroundBrush::weightedIds() const noexcept
+{
+    return _weightedIds;
+}
+
 void GroundBrush::restrictReplacement(const Tile *tile)
 {
     if (!tile || !tile->ground())
@@ -754,6 +760,7 @@ void GroundBrush::postBorderize(MapView &mapView, const Position &position, Grou
 
 void GroundBrush::borderize(MapView &mapView, const Position &position)
 {
+    VME_TRACE_SCOPE("GroundBrush::borderize");
     using namespace TileCoverShortHands;
 
     GroundNeighborMap neighbors(nullptr, position, *mapView.map());
@@ -95,6 +95,7 @@ class GroundBrush final : public Brush
     const std::string getDisplayId() const override;
 
     const std::unordered_set<uint32_t> &serverIds() const;
+    const std::vector<WeightedItemId> &weightedIds() const noexcept;
 
     static void restrictReplacement(const Tile *tile);
     static void disableReplacement();
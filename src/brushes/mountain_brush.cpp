@@ -5,6 +5,7 @@
 #include "../map_view.h"
 #include "../settings.h"
 #include "../tile_cover.h"
+#include "../trace.h"
 #include "border_brush.h"
 #include "ground_brush.h"
 #include "raw_brush.h"
@@ -269,6 +270,7 @@ const MountainPart::MountainCover *MountainPart::BorderBlock::getCover(MountainB
 
 void MountainBrush::generalBorderize(MapView &mapView, const Position &position)
 {
+    VME_TRACE_SCOPE("MountainBrush::generalBorderize");
     using namespace TileCoverShortHands;
 
     MountainNeighborMap neighbors(position, *mapView.map());
@@ -0,0 +1,751 @@
+#include "client_data_cache.h"
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "file.h"
+#include "graphics/appearances.h"
+#include "items.h"
+#include "logger.h"
+#include "mapped_file.h"
+#include "time_util.h"
+
+namespace
+{
+    constexpr std::array<char, 8> Magic = {'V', 'M', 'E', 'C', 'D', 'A', 'T', '\0'};
+
+    struct SourceStamp
+    {
+        uint64_t size = 0;
+        int64_t modified = 0;
+
+        bool operator==(const SourceStamp &other) const = default;
+    };
+
+    using SourceStamps = std::array<SourceStamp, 3>;
+
+    std::optional<SourceStamp> sourceStamp(const std::filesystem::path &path)
+    {
+        std::error_code error;
+        auto size = std::filesystem::file_size(path, error);
+        if (error)
+        {
+            return std::nullopt;
+        }
+
+        auto modified = std::filesystem::last_write_time(path, error);
+        if (error)
+        {
+            return std::nullopt;
+        }
+
+        return SourceStamp{static_cast<uint64_t>(size), static_cast<int64_t>(modified.time_since_epoch().count())};
+    }
+
+    std::optional<SourceStamps> sourceStamps(const ClientDataCache::SourceFiles &sourceFiles)
+    {
+        auto appearances = sourceStamp(sourceFiles.appearances);
+        auto itemsOtb = sourceStamp(sourceFiles.itemsOtb);
+        auto itemsXml = sourceStamp(sourceFiles.itemsXml);
+        if (!appearances || !itemsOtb || !itemsXml)
+        {
+            return std::nullopt;
+        }
+
+        return SourceStamps{*appearances, *itemsOtb, *itemsXml};
+    }
+
+    struct Section
+    {
+        uint64_t offset = 0;
+        uint64_t count = 0;
+    };
+
+    struct StringRef
+    {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+    };
+
+    struct SpriteInfoRecord
+    {
+        // Index of the first sprite ID in the sprite ID section
+        uint32_t firstSpriteId;
+        uint32_t spriteIdCount;
+        uint32_t boundingSquare;
+
+        uint8_t patternWidth;
+        uint8_t patternHeight;
+        uint8_t patternDepth;
+        uint8_t patternSize;
+        uint8_t layers;
+        uint8_t isOpaque;
+
+        uint8_t hasAnimation;
+        uint8_t synchronized;
+        uint8_t randomStartPhase;
+        int8_t loopType;
+        uint32_t defaultStartPhase;
+        uint32_t loopCount;
+
+        // Index of the first phase in the phase section
+        uint32_t firstPhase;
+        uint32_t phaseCount;
+    };
+
+    struct FrameGroupRecord
+    {
+        uint32_t fixedGroup;
+        uint32_t id;
+        SpriteInfoRecord spriteInfo;
+    };
+
+    struct ObjectRecord
+    {
+        uint64_t flags;
+        uint32_t clientId;
+        uint32_t firstFrameGroup;
+        uint32_t frameGroupCount;
+        StringRef name;
+        uint8_t quadrantRenderType;
+        ObjectAppearance::AppearanceFlagData flagData;
+    };
+
+    struct CreatureRecord
+    {
+        uint32_t id;
+        uint32_t firstFrameGroup;
+        uint32_t frameGroupCount;
+    };
+
+    struct ItemTypeRecord
+    {
+        StringRef name;
+        StringRef article;
+        StringRef pluralName;
+        StringRef description;
+
+        // Only valid if hasAppearance is set
+        uint32_t appearanceClientId;
+
+        uint32_t id;
+        uint32_t weight;
+        uint32_t levelDoor;
+        uint32_t flags;
+
+        uint16_t rotateTo;
+        uint16_t volume;
+        uint16_t maxTextLen;
+        uint16_t writeOnceItemId;
+        uint16_t maxItems;
+        uint16_t wareId;
+
+        uint8_t hasAppearance;
+        uint8_t group;
+        uint8_t type;
+        uint8_t floorChange;
+        uint8_t stackOrder;
+        uint8_t stackableSpriteType;
+
+        uint8_t allowPickupable;
+        uint8_t pickupable;
+        uint8_t canReadText;
+        uint8_t canWriteText;
+        uint8_t isVertical;
+        uint8_t isHorizontal;
+        uint8_t isHangable;
+        uint8_t lookThrough;
+        uint8_t showCount;
+        uint8_t stackable;
+    };
+
+    struct ClientIdRecord
+    {
+        uint32_t clientId;
+        uint32_t serverId;
+    };
+
+    // A cache written by a build with a different record layout is rejected.
+    constexpr std::array<uint32_t, 8> RecordSizes = {
+        sizeof(SpriteInfoRecord),
+        sizeof(FrameGroupRecord),
+        sizeof(ObjectRecord),
+        sizeof(CreatureRecord),
+        sizeof(ItemTypeRecord),
+        sizeof(ClientIdRecord),
+        sizeof(SpritePhase),
+        sizeof(OTB::VersionInfo)};
+
+    struct Header
+    {
+        std::array<char, 8> magic;
+        uint32_t formatVersion;
+        uint32_t highestServerId;
+        std::array<uint32_t, 8> recordSizes;
+
+        uint64_t appearancesHash;
+        uint64_t itemsOtbHash;
+        uint64_t itemsXmlHash;
+
+        // Compared before the hashes, in the order appearances, items.otb, items.xml
+        SourceStamps sourceStamps;
+
+        Section objects;
+        Section creatures;
+        Section frameGroups;
+        Section spriteIds;
+        Section phases;
+        Section itemTypes;
+        Section clientIds;
+        Section strings;
+
+        OTB::VersionInfo otbVersionInfo;
+    };
+
+    static_assert(std::is_trivially_copyable_v<ObjectAppearance::AppearanceFlagData>);
+    static_assert(std::is_trivially_copyable_v<SpritePhase>);
+    static_assert(std::is_trivially_copyable_v<OTB::VersionInfo>);
+    static_assert(offsetof(Header, formatVersion) == ClientDataCache::FormatVersionOffset);
+
+    /*
+		The tables of a cache file while it is being written.
+	*/
+    struct Tables
+    {
+        std::vector<ObjectRecord> objects;
+        std::vector<CreatureRecord> creatures;
+        std::vector<FrameGroupRecord> frameGroups;
+        std::vector<uint32_t> spriteIds;
+        std::vector<SpritePhase> phases;
+        std::vector<ItemTypeRecord> itemTypes;
+        std::vector<ClientIdRecord> clientIds;
+        std::string strings;
+
+        StringRef addString(const std::string &s)
+        {
+            StringRef ref{static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(s.size())};
+            strings += s;
+            return ref;
+        }
+
+        // Returns the index of the first added frame group
+        uint32_t addFrameGroups(const std::vector<FrameGroup> &groups)
+        {
+            uint32_t first = static_cast<uint32_t>(frameGroups.size());
+
+            for (const auto &group : groups)
+            {
+                const SpriteInfo &info = group.spriteInfo;
+
+                SpriteInfoRecord record{};
+                record.firstSpriteId = static_cast<uint32_t>(spriteIds.size());
+                record.spriteIdCount = static_cast<uint32_t>(info.spriteIds.size());
+                record.boundingSquare = info.boundingSquare;
+                record.patternWidth = info.patternWidth;
+                record.patternHeight = info.patternHeight;
+                record.patternDepth = info.patternDepth;
+                record.patternSize = info.patternSize;
+                record.layers = info.layers;
+                record.isOpaque = info.isOpaque;
+
+                spriteIds.insert(spriteIds.end(), info.spriteIds.begin(), info.spriteIds.end());
+
+                if (info.hasAnimation())
+                {
+                    const SpriteAnimation &animation = *info.animation();
+                    record.hasAnimation = 1;
+                    record.synchronized = animation.synchronized;
+                    record.randomStartPhase = animation.randomStartPhase;
+                    record.loopType = static_cast<int8_t>(animation.loopType);
+                    record.defaultStartPhase = animation.defaultStartPhase;
+                    record.loopCount = animation.loopCount;
+                    record.firstPhase = static_cast<uint32_t>(phases.size());
+                    record.phaseCount = static_cast<uint32_t>(animation.phases.size());
+
+                    phases.insert(phases.end(), animation.phases.begin(), animation.phases.end());
+                }
+
+                frameGroups.emplace_back(FrameGroupRecord{static_cast<uint32_t>(group.fixedGroup), group.id, record});
+            }
+
+            return first;
+        }
+    };
+
+    template <typename T>
+    Section append(std::vector<uint8_t> &out, const T *data, size_t count)
+    {
+        // Keeps every section aligned for its records when the file is mapped
+        out.resize((out.size() + 7) & ~size_t(7));
+
+        Section section{out.size(), count};
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+        out.insert(out.end(), bytes, bytes + count * sizeof(T));
+
+        return section;
+    }
+
+    /*
+		Bounds-checked access to the sections of a mapped cache file.
+	*/
+    class Reader
+    {
+      public:
+        Reader(const MappedFile &file)
+            : file(file) {}
+
+        template <typename T>
+        std::optional<std::span<const T>> view(Section section) const
+        {
+            if (section.offset % alignof(T) != 0 || section.offset > file.size() || section.count > (file.size() - section.offset) / sizeof(T))
+            {
+                return std::nullopt;
+            }
+
+            return std::span<const T>(reinterpret_cast<const T *>(file.data() + section.offset), section.count);
+        }
+
+      private:
+        const MappedFile &file;
+    };
+
+    /*
+		Builds appearances and item types from the sections of a cache file. Every index is checked, so a damaged
+		file fails instead of producing broken objects.
+	*/
+    struct Loader
+    {
+        std::span<const FrameGroupRecord> frameGroups;
+        std::span<const uint32_t> spriteIds;
+        std::span<const SpritePhase> phases;
+        std::span<const char> strings;
+
+        static bool inRange(uint64_t first, uint64_t count, size_t size)
+        {
+            return first <= size && count <= size - first;
+        }
+
+        std::optional<std::string> string(StringRef ref) const
+        {
+            if (!inRange(ref.offset, ref.length, strings.size()))
+            {
+                return std::nullopt;
+            }
+
+            return std::string(strings.data() + ref.offset, ref.length);
+        }
+
+        std::optional<std::vector<FrameGroup>> loadFrameGroups(uint32_t first, uint32_t count) const
+        {
+            if (!inRange(first, count, frameGroups.size()))
+            {
+                return std::nullopt;
+            }
+
+            std::vector<FrameGroup> result;
+            result.reserve(count);
+
+            for (const auto &group : frameGroups.subspan(first, count))
+            {
+                const SpriteInfoRecord &record = group.spriteInfo;
+                if (!inRange(record.firstSpriteId, record.spriteIdCount, spriteIds.size()))
+                {
+                    return std::nullopt;
+                }
+
+                SpriteInfo info;
+                if (record.hasAnimation)
+                {
+                    if (!inRange(record.firstPhase, record.phaseCount, phases.size()))
+                    {
+                        return std::nullopt;
+                    }
+
+                    SpriteAnimation animation{};
+                    animation.defaultStartPhase = record.defaultStartPhase;
+                    animation.synchronized = record.synchronized;
+                    animation.randomStartPhase = record.randomStartPhase;
+                    animation.loopType = static_cast<AnimationLoopType>(record.loopType);
+                    animation.loopCount = record.loopCount;
+
+                    auto recordPhases = phases.subspan(record.firstPhase, record.phaseCount);
+                    animation.phases.assign(recordPhases.begin(), recordPhases.end());
+
+                    info = SpriteInfo(std::move(animation));
+                }
+
+                info.boundingSquare = record.boundingSquare;
+                info.patternWidth = record.patternWidth;
+                info.patternHeight = record.patternHeight;
+                info.patternDepth = record.patternDepth;
+                info.patternSize = record.patternSize;
+                info.layers = record.layers;
+                info.isOpaque = record.isOpaque;
+
+                auto ids = spriteIds.subspan(record.firstSpriteId, record.spriteIdCount);
+                info.spriteIds.assign(ids.begin(), ids.end());
+
+                result.emplace_back(static_cast<FixedFrameGroup>(group.fixedGroup), group.id, std::move(info));
+            }
+
+            return result;
+        }
+    };
+} // namespace
+
+ClientDataCache::ClientDataCache(std::filesystem::path cacheFile, SourceFiles sourceFiles)
+    : cacheFile(std::move(cacheFile)), sourceFiles(std::move(sourceFiles)) {}
+
+bool ClientDataCache::loaded() const noexcept
+{
+    return _loaded;
+}
+
+const std::optional<ClientDataCache::Hashes> &ClientDataCache::sourceHashes()
+{
+    if (!hashes)
+    {
+        auto appearances = File::contentHash(sourceFiles.appearances);
+        auto itemsOtb = File::contentHash(sourceFiles.itemsOtb);
+        auto itemsXml = File::contentHash(sourceFiles.itemsXml);
+
+        if (appearances && itemsOtb && itemsXml)
+        {
+            hashes = Hashes{*appearances, *itemsOtb, *itemsXml};
+        }
+    }
+
+    return hashes;
+}
+
+ClientDataCache::SourceCheck ClientDataCache::checkSources()
+{
+    Header header{};
+    {
+        std::ifstream stream(cacheFile, std::ios::binary);
+        if (!stream.read(reinterpret_cast<char *>(&header), sizeof(Header)))
+        {
+            return SourceCheck::Invalid;
+        }
+    }
+
+    if (header.magic != Magic || header.formatVersion != FormatVersion || header.recordSizes != RecordSizes)
+    {
+        VME_LOG("The client data cache " << cacheFile.string() << " has an old format and will be rebuilt.");
+        return SourceCheck::Invalid;
+    }
+
+    auto stamps = sourceStamps(sourceFiles);
+    if (stamps && header.sourceStamps == *stamps)
+    {
+        return SourceCheck::SameStamps;
+    }
+
+    const auto &sources = sourceHashes();
+    if (!sources || header.appearancesHash != sources->appearances || header.itemsOtbHash != sources->itemsOtb || header.itemsXmlHash != sources->itemsXml)
+    {
+        return SourceCheck::Changed;
+    }
+
+    // The files were copied or touched. Only the stamps are rewritten; if that fails, the next check hashes again.
+    if (stamps)
+    {
+        std::fstream stream(cacheFile, std::ios::in | std::ios::out | std::ios::binary);
+        stream.seekp(offsetof(Header, sourceStamps));
+        stream.write(reinterpret_cast<const char *>(stamps->data()), sizeof(SourceStamps));
+    }
+
+    return SourceCheck::SameContents;
+}
+
+bool ClientDataCache::load()
+{
+    TimePoint start;
+
+    switch (checkSources())
+    {
+        case SourceCheck::Invalid:
+            return false;
+        case SourceCheck::Changed:
+            VME_LOG("The client files changed since the client data cache was written. It will be rebuilt.");
+            return false;
+        default:
+            break;
+    }
+
+    auto file = MappedFile::open(cacheFile);
+    if (!file || file->size() < sizeof(Header))
+    {
+        return false;
+    }
+
+    Header header;
+    std::memcpy(&header, file->data(), sizeof(Header));
+
+    Reader reader(*file);
+    auto objectRecords = reader.view<ObjectRecord>(header.objects);
+    auto creatureRecords = reader.view<CreatureRecord>(header.creatures);
+    auto frameGroupRecords = reader.view<FrameGroupRecord>(header.frameGroups);
+    auto spriteIds = reader.view<uint32_t>(header.spriteIds);
+    auto phases = reader.view<SpritePhase>(header.phases);
+    auto itemTypeRecords = reader.view<ItemTypeRecord>(header.itemTypes);
+    auto clientIdRecords = reader.view<ClientIdRecord>(header.clientIds);
+    auto strings = reader.view<char>(header.strings);
+
+    if (!objectRecords || !creatureRecords || !frameGroupRecords || !spriteIds || !phases || !itemTypeRecords || !clientIdRecords || !strings)
+    {
+        VME_LOG_ERROR("The client data cache " << cacheFile.string() << " is damaged. It will be rebuilt.");
+        return false;
+    }
+
+    Loader loader{*frameGroupRecords, *spriteIds, *phases, *strings};
+
+    auto fail = [this]() {
+        VME_LOG_ERROR("The client data cache " << cacheFile.string() << " is damaged. It will be rebuilt.");
+        return false;
+    };
+
+    // Everything is built on the side first, so a damaged cache does not leave partially loaded client data.
+    vme_unordered_map<uint32_t, ObjectAppearance> objects;
+    objects.reserve(objectRecords->size());
+    for (const auto &record : *objectRecords)
+    {
+        auto name = loader.string(record.name);
+        auto frameGroups = loader.loadFrameGroups(record.firstFrameGroup, record.frameGroupCount);
+        if (!name || !frameGroups)
+        {
+            return fail();
+        }
+
+        ObjectAppearance appearance;
+        appearance.clientId = record.clientId;
+        appearance.flags = static_cast<AppearanceFlag>(record.flags);
+        appearance.flagData = record.flagData;
+        appearance.quadrantRenderType = static_cast<QuadrantRenderType>(record.quadrantRenderType);
+        appearance.setFrameGroups(std::move(*frameGroups));
+        appearance.setName(std::move(*name));
+
+        objects.emplace(record.clientId, std::move(appearance));
+    }
+
+    vme_unordered_map<uint32_t, CreatureAppearance> creatures;
+    creatures.reserve(creatureRecords->size());
+    for (const auto &record : *creatureRecords)
+    {
+        auto frameGroups = loader.loadFrameGroups(record.firstFrameGroup, record.frameGroupCount);
+        if (!frameGroups)
+        {
+            return fail();
+        }
+
+        CreatureAppearance appearance;
+        appearance._id = record.id;
+        appearance._frameGroups = std::move(*frameGroups);
+
+        creatures.emplace(record.id, std::move(appearance));
+    }
+
+    std::vector<ItemType> itemTypes(itemTypeRecords->size());
+    for (size_t i = 0; i < itemTypes.size(); ++i)
+    {
+        const ItemTypeRecord &record = (*itemTypeRecords)[i];
+        ItemType &itemType = itemTypes[i];
+
+        auto name = loader.string(record.name);
+        auto article = loader.string(record.article);
+        auto pluralName = loader.string(record.pluralName);
+        auto description = loader.string(record.description);
+        if (!name || !article || !pluralName || !description)
+        {
+            return fail();
+        }
+
+        if (record.hasAppearance && objects.find(record.appearanceClientId) == objects.end())
+        {
+            return fail();
+        }
+
+        itemType.setName(std::move(*name));
+        itemType.article = std::move(*article);
+        itemType.pluralName = std::move(*pluralName);
+        itemType.description = std::move(*description);
+
+        itemType.group = static_cast<ItemType::Group>(record.group);
+        itemType.type = static_cast<ItemTypes_t>(record.type);
+        itemType.id = record.id;
+        itemType.weight = record.weight;
+        itemType.levelDoor = record.levelDoor;
+        itemType.rotateTo = record.rotateTo;
+        itemType.volume = record.volume;
+        itemType.maxTextLen = record.maxTextLen;
+        itemType.writeOnceItemId = record.writeOnceItemId;
+        itemType.maxItems = record.maxItems;
+        itemType.wareId = record.wareId;
+        itemType.floorChange = static_cast<FloorChange>(record.floorChange);
+        itemType.stackOrder = static_cast<TileStackOrder>(record.stackOrder);
+        itemType.stackableSpriteType = static_cast<StackableSpriteType>(record.stackableSpriteType);
+        itemType.allowPickupable = record.allowPickupable;
+        itemType.pickupable = record.pickupable;
+        itemType.canReadText = record.canReadText;
+        itemType.canWriteText = record.canWriteText;
+        itemType.isVertical = record.isVertical;
+        itemType.isHorizontal = record.isHorizontal;
+        itemType.isHangable = record.isHangable;
+        itemType.lookThrough = record.lookThrough;
+        itemType.showCount = record.showCount;
+        itemType.stackable = record.stackable;
+        itemType.flags = static_cast<ItemTypeFlag>(record.flags);
+    }
+
+    // Commit
+    Appearances::_objects = std::move(objects);
+    Appearances::_creatures = std::move(creatures);
+    Appearances::isLoaded = true;
+
+    Items &items = Items::items;
+    items.itemTypes = std::move(itemTypes);
+    for (size_t i = 0; i < items.itemTypes.size(); ++i)
+    {
+        const ItemTypeRecord &record = (*itemTypeRecords)[i];
+        if (record.hasAppearance)
+        {
+            items.itemTypes[i].appearance = &Appearances::getObjectById(record.appearanceClientId);
+        }
+    }
+
+    items.clientIdToServerId.clear();
+    items.clientIdToServerId.reserve(clientIdRecords->size());
+    for (const auto &record : *clientIdRecords)
+    {
+        items.clientIdToServerId.emplace(record.clientId, record.serverId);
+    }
+
+    items.highestServerId = header.highestServerId;
+    items._otbVersionInfo = header.otbVersionInfo;
+
+    _loaded = true;
+
+    VME_LOG("Loaded appearances and items from the client data cache in " << start.elapsedMillis() << " ms.");
+    return true;
+}
+
+bool ClientDataCache::save()
+{
+    TimePoint start;
+
+    const auto &sources = sourceHashes();
+    if (!sources)
+    {
+        return false;
+    }
+
+    Tables tables;
+
+    for (const auto &[clientId, appearance] : Appearances::_objects)
+    {
+        ObjectRecord record{};
+        record.flags = static_cast<uint64_t>(appearance.flags);
+        record.clientId = appearance.clientId;
+        record.firstFrameGroup = tables.addFrameGroups(appearance.frameGroups());
+        record.frameGroupCount = static_cast<uint32_t>(appearance.frameGroupCount());
+        record.name = tables.addString(appearance.name());
+        record.quadrantRenderType = static_cast<uint8_t>(appearance.quadrantRenderType);
+        record.flagData = appearance.flagData;
+
+        tables.objects.emplace_back(record);
+    }
+
+    for (const auto &[id, appearance] : Appearances::_creatures)
+    {
+        CreatureRecord record{};
+        record.id = appearance._id;
+        record.firstFrameGroup = tables.addFrameGroups(appearance.frameGroups());
+        record.frameGroupCount = static_cast<uint32_t>(appearance.frameGroupCount());
+
+        tables.creatures.emplace_back(record);
+    }
+
+    const Items &items = Items::items;
+    for (const auto &itemType : items.itemTypes)
+    {
+        ItemTypeRecord record{};
+        record.name = tables.addString(itemType.name());
+        record.article = tables.addString(itemType.article);
+        record.pluralName = tables.addString(itemType.pluralName);
+        record.description = tables.addString(itemType.description);
+
+        record.hasAppearance = itemType.appearance != nullptr;
+        record.appearanceClientId = itemType.appearance ? itemType.appearance->clientId : 0;
+
+        record.group = static_cast<uint8_t>(itemType.group);
+        record.type = static_cast<uint8_t>(itemType.type);
+        record.id = itemType.id;
+        record.weight = itemType.weight;
+        record.levelDoor = itemType.levelDoor;
+        record.rotateTo = itemType.rotateTo;
+        record.volume = itemType.volume;
+        record.maxTextLen = itemType.maxTextLen;
+        record.writeOnceItemId = itemType.writeOnceItemId;
+        record.maxItems = itemType.maxItems;
+        record.wareId = itemType.wareId;
+        record.floorChange = static_cast<uint8_t>(itemType.floorChange);
+        record.stackOrder = static_cast<uint8_t>(itemType.stackOrder);
+        record.stackableSpriteType = static_cast<uint8_t>(itemType.stackableSpriteType);
+        record.allowPickupable = itemType.allowPickupable;
+        record.pickupable = itemType.pickupable;
+        record.canReadText = itemType.canReadText;
+        record.canWriteText = itemType.canWriteText;
+        record.isVertical = itemType.isVertical;
+        record.isHorizontal = itemType.isHorizontal;
+        record.isHangable = itemType.isHangable;
+        record.lookThrough = itemType.lookThrough;
+        record.showCount = itemType.showCount;
+        record.stackable = itemType.stackable;
+        record.flags = static_cast<uint32_t>(itemType.flags);
+
+        tables.itemTypes.emplace_back(record);
+    }
+
+    for (const auto &[clientId, serverId] : items.clientIdToServerId)
+    {
+        tables.clientIds.emplace_back(ClientIdRecord{clientId, serverId});
+    }
+
+    Header header{};
+    header.magic = Magic;
+    header.formatVersion = FormatVersion;
+    header.highestServerId = items.highestServerId;
+    header.recordSizes = RecordSizes;
+    header.appearancesHash = sources->appearances;
+    header.itemsOtbHash = sources->itemsOtb;
+    header.itemsXmlHash = sources->itemsXml;
+    header.sourceStamps = sourceStamps(sourceFiles).value_or(SourceStamps{});
+    header.otbVersionInfo = items._otbVersionInfo;
+
+    std::vector<uint8_t> buffer(sizeof(Header));
+    header.objects = append(buffer, tables.objects.data(), tables.objects.size());
+    header.creatures = append(buffer, tables.creatures.data(), tables.creatures.size());
+    header.frameGroups = append(buffer, tables.frameGroups.data(), tables.frameGroups.size());
+    header.spriteIds = append(buffer, tables.spriteIds.data(), tables.spriteIds.size());
+    header.phases = append(buffer, tables.phases.data(), tables.phases.size());
+    header.itemTypes = append(buffer, tables.itemTypes.data(), tables.itemTypes.size());
+    header.clientIds = append(buffer, tables.clientIds.data(), tables.clientIds.size());
+    header.strings = append(buffer, tables.strings.data(), tables.strings.size());
+
+    std::memcpy(buffer.data(), &header, sizeof(Header));
+
+    if (auto error = File::writeAtomically(cacheFile, buffer))
+    {
+        VME_LOG_ERROR("Could not write the client data cache " << cacheFile.string() << ": " << error.message());
+        return false;
+    }
+
+    VME_LOG("Wrote the client data cache (" << buffer.size() / 1024 << " KB) in " << start.elapsedMillis() << " ms.");
+    return true;
+}
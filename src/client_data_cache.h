@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+/*
+	A binary cache of the item types and appearances that are built from appearances.dat, items.otb and
+	items.xml. Loading the cache skips the protobuf, OTB and XML parsing as well as the merging of the three files.
+
+	The cache file is a header followed by flat arrays of fixed-size records and a string table. It is
+	memory-mapped when loaded. The header stores the size, modification time and hash of each source file and a
+	format version. The sources are only hashed if a size or modification time differs; if a hash or the format
+	version does not match, or the file is damaged, load returns false without changing any state and the client
+	files are parsed as usual.
+
+	FormatVersion must be increased whenever the records change or the parsing of the source files produces
+	different item types or appearances.
+*/
+class ClientDataCache
+{
+  public:
+    struct SourceFiles
+    {
+        std::filesystem::path appearances;
+        std::filesystem::path itemsOtb;
+        std::filesystem::path itemsXml;
+    };
+
+    enum class SourceCheck
+    {
+        // The cache file is missing, unreadable or has another format
+        Invalid,
+        Changed,
+        // A source file has another size or modification time but the same contents. The cache file is updated
+        // with the new times, so the next check does not hash the sources again.
+        SameContents,
+        SameStamps
+    };
+
+    ClientDataCache(std::filesystem::path cacheFile, SourceFiles sourceFiles);
+
+    // Compares the source files with the ones that the cache file was written for
+    SourceCheck checkSources();
+
+    /*
+		Loads Appearances and Items from the cache file. Returns false if the cache is missing, stale or invalid.
+		Texture atlases are not cached by the item types; call Items::cacheTextureAtlases once the catalog is
+		loaded.
+	*/
+    bool load();
+
+    /*
+		Writes the currently loaded Appearances and Items to the cache file. Failing to write is not an error.
+	*/
+    bool save();
+
+    bool loaded() const noexcept;
+
+    static constexpr uint32_t FormatVersion = 2;
+    // Byte offset of the format version in the cache file
+    static constexpr size_t FormatVersionOffset = 8;
+
+  private:
+    struct Hashes
+    {
+        uint64_t appearances = 0;
+        uint64_t itemsOtb = 0;
+        uint64_t itemsXml = 0;
+    };
+
+    const std::optional<Hashes> &sourceHashes();
+
+    std::filesystem::path cacheFile;
+    SourceFiles sourceFiles;
+
+    std::optional<Hashes> hashes;
+    bool _loaded = false;
+};
@@ -1,11 +1,17 @@
 #include "config.h"
 
 #include <fstream>
+#include <memory>
 #include <nlohmann/json.hpp>
 #include <sstream>
 
+#include "client_data_cache.h"
 #include "graphics/appearances.h"
+#include "graphics/atlas_disk_cache.h"
+#include "graphics/sprite_opacity.h"
 #include "items.h"
+#include "settings.h"
+#include "task_graph.h"
 #include "util.h"
 
 namespace
@@ -15,6 +21,14 @@ namespace
     constexpr auto ConfigFile = "config.json";
     constexpr auto CatalogContentFile = "catalog-content.json";
     constexpr auto AppearancesFile = "appearances.dat";
+    constexpr auto ItemsOtbFile = "items.otb";
+    constexpr auto ItemsXmlFile = "items.xml";
+    constexpr auto AtlasCacheFolder = "cache/atlases";
+    constexpr auto ClientDataCacheFile = "cache/client-data.bin";
+    constexpr auto SpriteOpacityCacheFile = "cache/sprite-opacity.bin";
+
+    constexpr auto ClientDataCacheTask = "client data cache";
+    constexpr auto SpriteOpacityTask = "sprite opacity";
 } // namespace
 
 Config::Config(const std::string version)
@@ -41,6 +55,22 @@ Result<Config, Config::Error> Config::create(const std::string version)
 }
 
 std::optional<Config::Error> Config::load()
+{
+    TaskGraph tasks;
+
+    auto error = addLoadTasks(tasks);
+    if (error)
+    {
+        return error;
+    }
+
+    tasks.run();
+    tasks.logTimings("Loading client " + _version);
+
+    return std::nullopt;
+}
+
+std::optional<Config::Error> Config::addLoadTasks(TaskGraph &tasks)
 {
     std::optional<Config::Error> result;
 
@@ -80,15 +110,81 @@ std::optional<Config::Error> Config::load()
 
     GOOGLE_PROTOBUF_VERIFY_VERSION;
 
-    Appearances::loadTextureAtlases(_assetFolder / CatalogContentFile, _assetFolder);
-    Appearances::loadAppearanceData(_dataFolder / AppearancesFile);
+    if (Settings::CACHE_ATLASES_ON_DISK)
+    {
+        AtlasDiskCache::open(_dataFolder / AtlasCacheFolder, _version);
+    }
+
+    std::shared_ptr<ClientDataCache> cache;
+    if (Settings::CACHE_CLIENT_DATA)
+    {
+        ClientDataCache::SourceFiles sourceFiles{_dataFolder / AppearancesFile, _dataFolder / ItemsOtbFile, _dataFolder / ItemsXmlFile};
+        cache = std::make_shared<ClientDataCache>(_dataFolder / ClientDataCacheFile, std::move(sourceFiles));
+    }
 
-    Items::loadFromOtb(_dataFolder / "items.otb");
-    Items::loadMissingItemTypes();
-    Items::loadFromXml(_dataFolder / "items.xml");
+    auto cacheLoaded = [cache]() { return cache && cache->loaded(); };
+
+    // The catalog and the client data do not depend on each other. The items need both.
+    tasks.add(CatalogContentFile, [this]() {
+        Appearances::loadTextureAtlases(_assetFolder / CatalogContentFile, _assetFolder);
+    });
+
+    if (Settings::PRECOMPUTE_SPRITE_OPACITY)
+    {
+        tasks.add(
+            SpriteOpacityTask, [this]() {
+                SpriteOpacityCache::load(_dataFolder / SpriteOpacityCacheFile);
+            },
+            {CatalogContentFile});
+    }
 
-    VME_LOG_D(std::format("Items: {} (highest server ID: {})", Items::items.size(), Items::items.highestServerId));
-    VME_LOG_D("Client object count: " << Appearances::objectCount());
+    tasks.add(ClientDataCacheTask, [cache]() {
+        if (cache)
+        {
+            cache->load();
+        }
+    });
+
+    // If the cache was loaded, the tasks below only do the work that the cache does not cover.
+    tasks.add(
+        AppearancesFile, [this, cacheLoaded]() {
+            if (!cacheLoaded())
+            {
+                Appearances::loadAppearanceData(_dataFolder / AppearancesFile);
+            }
+        },
+        {ClientDataCacheTask});
+
+    tasks.add(
+        ItemsOtbFile, [this, cacheLoaded]() {
+            if (cacheLoaded())
+            {
+                Items::cacheTextureAtlases();
+                return;
+            }
+
+            Items::loadFromOtb(_dataFolder / ItemsOtbFile);
+            Items::loadMissingItemTypes();
+        },
+        {CatalogContentFile, AppearancesFile});
+
+    tasks.add(
+        ItemsLoadedTask, [this, cache, cacheLoaded]() {
+            if (!cacheLoaded())
+            {
+                Items::loadFromXml(_dataFolder / ItemsXmlFile);
+
+                // Written before the brushes are loaded, because they add brush flags to the item types
+                if (cache)
+                {
+                    cache->save();
+                }
+            }
+
+            VME_LOG_D(std::format("Items: {} (highest server ID: {})", Items::items.size(), Items::items.highestServerId));
+            VME_LOG_D("Client object count: " << Appearances::objectCount());
+        },
+        {ItemsOtbFile});
 
     _loaded = true;
     return result;
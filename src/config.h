@@ -6,6 +6,8 @@
 
 #include "../vendor/result/result.h"
 
+class TaskGraph;
+
 class Config
 {
   public:
@@ -31,6 +33,15 @@ class Config
     std::optional<Config::Error> load();
     void loadOrTerminate();
 
+    /*
+		Validates the config and adds the tasks that load the client files to the graph. The client data is
+		loaded once the graph has run, so the Config must outlive the run. Tasks that need the items can depend on
+		Config::ItemsLoadedTask.
+	*/
+    std::optional<Config::Error> addLoadTasks(TaskGraph &tasks);
+
+    static constexpr auto ItemsLoadedTask = "items.xml";
+
   private:
     Config(const std::string version);
 
@@ -1,6 +1,7 @@
 #include "creature.h"
 
 #include "graphics/appearances.h"
+#include "graphics/outfit_variation.h"
 #include "item.h"
 #include "items.h"
 #include "logger.h"
@@ -54,70 +55,9 @@ CreatureType *Creatures::addCreatureType(std::string id, std::string name, Outfi
     _creatureTypes.emplace(id, std::make_unique<CreatureType>(id, name, outfit));
     auto creatureType = _creatureTypes.at(id).get();
 
-    // Layers > 1 means we have a template. If so, instantiate the necessary atlas templates for this creature type
-    bool multiLayer = creatureType->frameGroup(0).spriteInfo.layers > 1;
-    if (multiLayer)
-    {
-        bool needsTemplate = creatureType->outfitId() != 0;
-        if (needsTemplate)
-            createTextureVariation(creatureType, outfit);
-    }
-
     return creatureType;
 }
 
-void Creatures::createTextureVariation(CreatureType *creatureType, const Outfit &outfit)
-{
-    std::vector<Texture *> textures;
-
-    auto &frameGroup = creatureType->frameGroup(0);
-    uint8_t postureCount = frameGroup.spriteInfo.patternDepth;
-    uint8_t addonCount = frameGroup.spriteInfo.patternHeight; // Includes "no addon (base outfit)"
-    uint8_t directionCount = frameGroup.spriteInfo.patternWidth;
-
-    auto variationId = outfit.id();
-
-    for (uint8_t postureType = 0; postureType < postureCount; ++postureType)
-    {
-        for (uint8_t addonType = 0; addonType < addonCount; ++addonType)
-        {
-            for (uint8_t direction = 0; direction < directionCount; ++direction)
-            {
-                uint32_t spriteIndex = creatureType->getIndex(frameGroup, postureType, addonType, direction);
-
-                uint32_t spriteId = frameGroup.getSpriteId(spriteIndex);
-                uint32_t templateSpriteId = frameGroup.getSpriteId(spriteIndex + 1);
-
-                TextureAtlas *targetAtlas = creatureType->getTextureAtlas(spriteId);
-                auto &targetTexture = targetAtlas->getVariation(variationId)->texture;
-
-                if (targetTexture.finalized())
-                {
-                    continue;
-                }
-
-                // Add texture to the list of textures to be finalized once we have finished with all the overlays
-                auto found = std::find_if(textures.begin(), textures.end(), [&targetTexture](const Texture *texture) {
-                    return texture->id() == targetTexture.id();
-                });
-                if (found == textures.end())
-                {
-                    textures.push_back(&targetTexture);
-                }
-
-                TextureAtlas *templateAtlas = creatureType->getTextureAtlas(templateSpriteId);
-
-                targetAtlas->overlay(templateAtlas, variationId, templateSpriteId, spriteId, outfit.look);
-            }
-        }
-    }
-
-    for (Texture *texture : textures)
-    {
-        texture->finalize();
-    }
-}
-
 uint32_t CreatureType::getIndex(const FrameGroup &frameGroup, uint8_t creaturePosture, uint8_t addonType, Direction direction) const
 {
     return getIndex(frameGroup, creaturePosture, addonType, to_underlying(direction));
@@ -183,7 +123,9 @@ CreatureType::CreatureType(CreatureType &&other) noexcept
     : appearance(other.appearance),
       _outfit(other._outfit),
       _id(other._id),
-      _name(other._name) {}
+      _name(other._name),
+      variation(std::move(other.variation)),
+      variationCreated(other.variationCreated) {}
 
 const CreatureType *Creatures::creatureType(uint16_t looktype)
 {
@@ -256,19 +198,83 @@ uint32_t CreatureType::getSpriteId(uint32_t frameGroupId, Direction direction) c
 
 const TextureInfo CreatureType::getTextureInfo(uint32_t frameGroupId, Direction direction) const
 {
-    return appearance.getTextureInfo(frameGroupId, direction, TextureInfo::CoordinateType::Normalized);
+    return getTextureInfo(frameGroupId, direction, TextureInfo::CoordinateType::Normalized);
+}
+
+const OutfitVariation *CreatureType::colorVariation() const
+{
+    if (!variationCreated)
+    {
+        // Colors the sprites if the outfit has color templates, unless another creature type already did
+        variation = OutfitVariations::get(*this);
+        variationCreated = true;
+    }
+
+    return variation.get();
 }
 
 const TextureInfo CreatureType::getTextureInfo(uint32_t frameGroupId, Direction direction, TextureInfo::CoordinateType coordinateType) const
 {
-    return appearance.getTextureInfo(frameGroupId, direction, coordinateType);
+    TextureInfo info = appearance.getTextureInfo(frameGroupId, direction, coordinateType);
+    if (const OutfitVariation *outfitVariation = colorVariation())
+    {
+        outfitVariation->apply(info, getSpriteId(frameGroupId, direction), coordinateType);
+    }
+
+    return info;
 }
 
 const TextureInfo CreatureType::getTextureInfo(uint32_t frameGroupId, int posture, int addonType, Direction direction, TextureInfo::CoordinateType coordinateType) const
+{
+    TextureInfo info = appearance.getTextureInfo(frameGroupId, posture, addonType, direction, coordinateType);
+    if (const OutfitVariation *outfitVariation = colorVariation())
+    {
+        const FrameGroup &group = frameGroup(frameGroupId);
+        outfitVariation->apply(info, group.getSpriteId(getIndex(group, posture, addonType, direction)), coordinateType);
+    }
+
+    return info;
+}
+
+const TextureInfo CreatureType::getUncoloredTextureInfo(uint32_t frameGroupId, int posture, int addonType, Direction direction, TextureInfo::CoordinateType coordinateType) const
 {
     return appearance.getTextureInfo(frameGroupId, posture, addonType, direction, coordinateType);
 }
 
+std::optional<TextureInfo> CreatureType::getColorTemplateInfo(uint32_t frameGroupId, int posture, int addonType, Direction direction, TextureInfo::CoordinateType coordinateType) const
+{
+    if (!hasColoredOutfit())
+    {
+        return std::nullopt;
+    }
+
+    const FrameGroup &group = frameGroup(frameGroupId);
+    uint32_t spriteIndex = getIndex(group, posture, addonType, direction);
+
+    // The color template is the layer after the sprite
+    uint32_t spriteId = group.getSpriteId(spriteIndex);
+    uint32_t templateSpriteId = group.getSpriteId(spriteIndex + 1);
+
+    TextureInfo info = getUncoloredTextureInfo(frameGroupId, posture, addonType, direction, coordinateType);
+    TextureWindow spriteWindow = info.atlas->getTextureWindow(spriteId, coordinateType);
+
+    info.atlas = getTextureAtlas(templateSpriteId);
+    TextureWindow templateWindow = info.atlas->getTextureWindow(templateSpriteId, coordinateType);
+
+    if (coordinateType == TextureInfo::CoordinateType::Normalized)
+    {
+        info.window = templateWindow;
+    }
+    else
+    {
+        // Keeps the adjustments that were made to the window of the sprite, like OutfitVariation::apply
+        info.window.x0 += templateWindow.x0 - spriteWindow.x0;
+        info.window.y0 += templateWindow.y0 - spriteWindow.y0;
+    }
+
+    return info;
+}
+
 const std::vector<FrameGroup> &CreatureType::frameGroups() const noexcept
 {
     return appearance.frameGroups();
@@ -284,6 +290,11 @@ bool CreatureType::hasColorVariation() const
     return frameGroup(0).spriteInfo.layers > 1;
 }
 
+bool CreatureType::hasColoredOutfit() const
+{
+    return !_outfit.isItem() && _outfit.id() != 0 && hasColorVariation();
+}
+
 //>>>>>>>>>>>>>>>>>>>>
 //>>>>>>>>>>>>>>>>>>>>
 //>>>>>>Creature>>>>>>
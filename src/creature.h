@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <sstream>
 #include <string>
 #include <variant>
@@ -13,6 +14,7 @@
 
 class CreatureAppearance;
 class ObjectAppearance;
+class OutfitVariation;
 class Item;
 
 namespace tibia::protobuf::appearances
@@ -52,6 +54,14 @@ class CreatureType
 
     const TextureInfo getTextureInfo(uint32_t frameGroupId, int posture, int addonType, Direction direction, TextureInfo::CoordinateType coordinateType = TextureInfo::CoordinateType::Normalized) const;
 
+    /*
+		The sprite before it is colored, and the color template that selects the outfit colors for its pixels
+		(nullopt unless hasColoredOutfit). Unlike getTextureInfo, these never color the outfit, so no atlas has to be
+		decompressed.
+	*/
+    const TextureInfo getUncoloredTextureInfo(uint32_t frameGroupId, int posture, int addonType, Direction direction, TextureInfo::CoordinateType coordinateType) const;
+    std::optional<TextureInfo> getColorTemplateInfo(uint32_t frameGroupId, int posture, int addonType, Direction direction, TextureInfo::CoordinateType coordinateType) const;
+
     const Outfit &outfit() const noexcept
     {
         return _outfit;
@@ -64,6 +74,9 @@ class CreatureType
 
     bool hasColorVariation() const;
 
+    // True if the sprites are drawn with the outfit colors, i.e. the outfit has colors and color templates
+    bool hasColoredOutfit() const;
+
     uint32_t outfitId() const noexcept;
 
   private:
@@ -77,6 +90,16 @@ class CreatureType
     std::string _id;
     std::string _name;
 
+    // Colors the outfit when it is drawn for the first time
+    const OutfitVariation *colorVariation() const;
+
+    /*
+		The colored sprites of the outfit. Shared with every creature type that has the same looktype and colors.
+		Created on first use, because coloring decompresses the atlases of the outfit.
+	*/
+    mutable std::shared_ptr<const OutfitVariation> variation;
+    mutable bool variationCreated = false;
+
     /**
      * Stores the creature appearance. A creature appearance can be either:
      * 1. A creature-based appearance (CreatureAppearance)
@@ -139,8 +162,6 @@ class Creatures
         // Empty
     }
 
-    static void createTextureVariation(CreatureType *creatureType, const Outfit &outfit);
-
     static vme_unordered_map<std::string, std::unique_ptr<CreatureType>> _creatureTypes;
 
     /**
@@ -32,6 +32,7 @@ class GeneralDebugException : public std::exception
         std::ostringstream s;                                                                             \
         s << "[ERROR] " << __FILE__ << ", line " << (unsigned)(__LINE__) << ": " << message << std::endl; \
         VME_LOG_D(s.str());                                                                               \
+        Logger::flush();                                                                                  \
         throw GeneralDebugException(s.str().c_str());                                                     \
     } while (false)
 
@@ -1,10 +1,13 @@
 #include "file.h"
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
+#include <thread>
 
 #include "debug.h"
+#include "mapped_file.h"
 
 std::vector<uint8_t> File::read(const char *filename)
 {
@@ -46,4 +49,125 @@ void File::write(const std::filesystem::path &filepath, std::vector<uint8_t> &&b
 {
     std::ofstream outfile(filepath, std::ios::out | std::ios::binary);
     outfile.write((const char *)buffer.data(), buffer.size());
-}
\ No newline at end of file
+}
+
+void File::Fnv1a::add(const void *data, size_t size)
+{
+    constexpr uint64_t Prime = 1099511628211ULL;
+
+    auto bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= Prime;
+    }
+}
+
+std::optional<uint64_t> File::contentHash(const std::filesystem::path &path)
+{
+    Fnv1a hash;
+
+    std::error_code error;
+    auto size = std::filesystem::file_size(path, error);
+    if (error)
+    {
+        return std::nullopt;
+    }
+
+    // Empty files can not be mapped
+    if (size == 0)
+    {
+        return hash.value();
+    }
+
+    auto file = MappedFile::open(path);
+    if (!file)
+    {
+        return std::nullopt;
+    }
+
+    hash.add(file->data(), file->size());
+    return hash.value();
+}
+
+std::error_code File::writeAtomically(const std::filesystem::path &path,
+                                      const std::function<void(std::ostream &)> &write,
+                                      const std::function<void()> &beforeReplace)
+{
+    std::error_code error;
+    if (path.has_parent_path())
+    {
+        std::filesystem::create_directories(path.parent_path(), error);
+    }
+
+    // Unique per thread, for caches that several threads write to
+    std::filesystem::path temporaryPath = path;
+    temporaryPath += "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+
+    {
+        std::ofstream stream(temporaryPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (stream)
+        {
+            write(stream);
+        }
+
+        if (!stream)
+        {
+            stream.close();
+            std::filesystem::remove(temporaryPath, error);
+            return std::make_error_code(std::io_errc::stream);
+        }
+    }
+
+    if (beforeReplace)
+    {
+        beforeReplace();
+    }
+
+    error.clear();
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error)
+    {
+        std::error_code removeError;
+        std::filesystem::remove(temporaryPath, removeError);
+    }
+
+    return error;
+}
+
+std::error_code File::writeAtomically(const std::filesystem::path &path, const std::vector<uint8_t> &buffer)
+{
+    return writeAtomically(path, [&buffer](std::ostream &stream) {
+        stream.write(reinterpret_cast<const char *>(buffer.data()), buffer.size());
+    });
+}
+
+void File::append(std::vector<uint8_t> &buffer, const void *data, size_t size)
+{
+    auto bytes = static_cast<const uint8_t *>(data);
+    buffer.insert(buffer.end(), bytes, bytes + size);
+}
+
+bool File::Cursor::read(void *target, size_t size)
+{
+    if (remaining() < size)
+    {
+        return false;
+    }
+
+    std::memcpy(target, cursor, size);
+    cursor += size;
+    return true;
+}
+
+const uint8_t *File::Cursor::skip(uint64_t size)
+{
+    if (remaining() < size)
+    {
+        return nullptr;
+    }
+
+    const uint8_t *start = cursor;
+    cursor += size;
+    return start;
+}
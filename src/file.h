@@ -1,7 +1,13 @@
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <iosfwd>
+#include <optional>
 #include <string>
+#include <system_error>
+#include <type_traits>
 #include <vector>
 
 namespace File
@@ -12,4 +18,80 @@ namespace File
 
     void write(const std::filesystem::path &filepath, std::vector<uint8_t> &&buffer);
 
+    /*
+		64-bit FNV-1a. Unlike std::hash, the result is the same with every standard library, so it can be stored in
+		files that are read by another build.
+	*/
+    class Fnv1a
+    {
+      public:
+        void add(const void *data, size_t size);
+
+        template <typename T>
+        void add(const T &value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            add(&value, sizeof(T));
+        }
+
+        void add(const std::string &s)
+        {
+            add(s.data(), s.size());
+        }
+
+        uint64_t value() const noexcept
+        {
+            return hash;
+        }
+
+      private:
+        uint64_t hash = 14695981039346656037ULL;
+    };
+
+    // 64-bit FNV-1a hash of the file contents. Empty if the file can not be read.
+    std::optional<uint64_t> contentHash(const std::filesystem::path &path);
+
+    /*
+		Writes a file through a temporary file next to it that is then renamed to path, so that a crash never leaves
+		a partial file behind and a reader never sees one. The parent directory is created if needed.
+
+		write fills the temporary file. beforeReplace runs after writing, before path is replaced; for example to
+		release a mapping of path, which can not be replaced while it is mapped on every platform.
+
+		Returns an error if the file could not be written. path is unchanged in that case.
+	*/
+    std::error_code writeAtomically(const std::filesystem::path &path,
+                                    const std::function<void(std::ostream &)> &write,
+                                    const std::function<void()> &beforeReplace = {});
+    std::error_code writeAtomically(const std::filesystem::path &path, const std::vector<uint8_t> &buffer);
+
+    // Appends the raw bytes of data to buffer
+    void append(std::vector<uint8_t> &buffer, const void *data, size_t size);
+
+    /*
+		Reads consecutive values from a range of bytes, usually a mapped file. Every read checks the bounds, so a
+		damaged file fails instead of reading past its end.
+	*/
+    class Cursor
+    {
+      public:
+        Cursor(const uint8_t *data, size_t size)
+            : cursor(data), end(data + size) {}
+
+        // Copies size bytes to target. Returns false, and does not move, if fewer bytes are left.
+        bool read(void *target, size_t size);
+
+        // Moves past size bytes and returns the first of them. Returns nullptr, and does not move, if fewer are left.
+        const uint8_t *skip(uint64_t size);
+
+        size_t remaining() const noexcept
+        {
+            return static_cast<size_t>(end - cursor);
+        }
+
+      private:
+        const uint8_t *cursor;
+        const uint8_t *end;
+    };
+
 } // namespace File
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "frame_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#include "debug.h"
+#include "logger.h"
+
+FrameStatistics::PhaseTimer::PhaseTimer(FrameStatistics &statistics, RenderPhase phase)
+    : statistics(statistics), phase(phase) {}
+
+FrameStatistics::PhaseTimer::~PhaseTimer()
+{
+    statistics.current.millis[static_cast<size_t>(phase)] += start.elapsedNanos() / 1e6f;
+}
+
+void FrameStatistics::beginFrame()
+{
+    current = Sample{};
+    frameStart = TimePoint::now();
+}
+
+void FrameStatistics::endFrame()
+{
+    current.millis[static_cast<size_t>(RenderPhase::Frame)] = frameStart.elapsedNanos() / 1e6f;
+
+    samples[nextSample] = current;
+    nextSample = (nextSample + 1) % WindowSize;
+    sampleCount = std::min(sampleCount + 1, WindowSize);
+}
+
+const FrameStatistics::Sample &FrameStatistics::lastSample() const noexcept
+{
+    return samples[(nextSample + WindowSize - 1) % WindowSize];
+}
+
+const FrameCounters &FrameStatistics::lastCounters() const noexcept
+{
+    return lastSample().counters;
+}
+
+double FrameStatistics::lastMillis(RenderPhase phase) const noexcept
+{
+    return lastSample().millis[static_cast<size_t>(phase)];
+}
+
+size_t FrameStatistics::frameCount() const noexcept
+{
+    return sampleCount;
+}
+
+template <typename F>
+FrameStatistics::Percentiles FrameStatistics::percentiles(F &&value) const
+{
+    if (sampleCount == 0)
+    {
+        return {};
+    }
+
+    // The ring buffer is full or filled from the start, so the first sampleCount entries are the valid ones.
+    std::vector<double> values;
+    values.reserve(sampleCount);
+    for (size_t i = 0; i < sampleCount; ++i)
+    {
+        values.emplace_back(value(samples[i]));
+    }
+
+    std::sort(values.begin(), values.end());
+
+    // Nearest-rank percentile
+    auto at = [&values](double percentile) {
+        size_t rank = static_cast<size_t>(std::ceil(percentile * values.size()));
+        return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+    };
+
+    return Percentiles{at(0.50), at(0.95), at(0.99)};
+}
+
+FrameStatistics::Percentiles FrameStatistics::millis(RenderPhase phase) const
+{
+    return percentiles([phase](const Sample &sample) { return sample.millis[static_cast<size_t>(phase)]; });
+}
+
+FrameStatistics::Percentiles FrameStatistics::counter(uint32_t FrameCounters::*counter) const
+{
+    return percentiles([counter](const Sample &sample) { return sample.counters.*counter; });
+}
+
+const char *FrameStatistics::name(RenderPhase phase)
+{
+    switch (phase)
+    {
+        case RenderPhase::Map:
+            return "map";
+        case RenderPhase::CurrentAction:
+            return "action";
+        case RenderPhase::Overlay:
+            return "overlay";
+        case RenderPhase::Frame:
+            return "frame";
+        default:
+            ABORT_PROGRAM("Unknown RenderPhase.");
+    }
+}
+
+std::string FrameStatistics::summary() const
+{
+    std::ostringstream s;
+    s << std::fixed << std::setprecision(2);
+
+    auto write = [&s](const char *name, const Percentiles &percentiles) {
+        s << name << ' ' << percentiles.p50 << '/' << percentiles.p95 << '/' << percentiles.p99;
+    };
+
+    s << "Last " << sampleCount << " frames, p50/p95/p99: ";
+
+    for (auto phase : {RenderPhase::Frame, RenderPhase::Map, RenderPhase::CurrentAction, RenderPhase::Overlay})
+    {
+        write(name(phase), millis(phase));
+        s << " ms, ";
+    }
+
+    s << std::setprecision(0);
+    write("tiles", counter(&FrameCounters::tilesVisited));
+    s << ", ";
+    write("sprites", counter(&FrameCounters::spritesIssued));
+    s << ", ";
+    write("binds", counter(&FrameCounters::descriptorBinds));
+    s << ", ";
+    write("animated", counter(&FrameCounters::animatedItems));
+
+    return s.str();
+}
+
+void FrameStatistics::logSummary() const
+{
+    VME_LOG(summary());
+}
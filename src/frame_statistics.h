@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "time_util.h"
+
+enum class RenderPhase : uint8_t
+{
+    Map,
+    CurrentAction,
+    Overlay,
+    // The whole frame, including Vulkan setup and submission
+    Frame
+};
+
+constexpr size_t RenderPhaseCount = 4;
+
+struct FrameCounters
+{
+    uint32_t tilesVisited = 0;
+    uint32_t spritesIssued = 0;
+    uint32_t descriptorBinds = 0;
+    uint32_t animatedItems = 0;
+};
+
+/*
+	Per-phase CPU timings and draw counters of the last WindowSize frames rendered by a MapRenderer.
+
+	Recording a frame only reads the clock a few times and increments integers. Percentiles are computed when they
+	are requested, so the statistics can stay enabled in release builds.
+*/
+class FrameStatistics
+{
+  public:
+    static constexpr size_t WindowSize = 256;
+
+    struct Percentiles
+    {
+        double p50 = 0;
+        double p95 = 0;
+        double p99 = 0;
+    };
+
+    /*
+		Adds the time from construction to destruction to a phase of the current frame.
+	*/
+    class PhaseTimer
+    {
+      public:
+        PhaseTimer(FrameStatistics &statistics, RenderPhase phase);
+        ~PhaseTimer();
+
+        PhaseTimer(const PhaseTimer &) = delete;
+        PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+      private:
+        FrameStatistics &statistics;
+        RenderPhase phase;
+        TimePoint start;
+    };
+
+    void beginFrame();
+    void endFrame();
+
+    inline FrameCounters &counters() noexcept;
+
+    // Counters and timings of the last finished frame
+    const FrameCounters &lastCounters() const noexcept;
+    double lastMillis(RenderPhase phase) const noexcept;
+
+    // Number of frames that the percentiles are computed over
+    size_t frameCount() const noexcept;
+
+    Percentiles millis(RenderPhase phase) const;
+    Percentiles counter(uint32_t FrameCounters::*counter) const;
+
+    std::string summary() const;
+    void logSummary() const;
+
+    static const char *name(RenderPhase phase);
+
+  private:
+    struct Sample
+    {
+        std::array<float, RenderPhaseCount> millis{};
+        FrameCounters counters;
+    };
+
+    template <typename F>
+    Percentiles percentiles(F &&value) const;
+
+    const Sample &lastSample() const noexcept;
+
+    std::array<Sample, WindowSize> samples{};
+    size_t nextSample = 0;
+    size_t sampleCount = 0;
+
+    Sample current;
+    TimePoint frameStart;
+};
+
+inline FrameCounters &FrameStatistics::counters() noexcept
+{
+    return current.counters;
+}
@@ -4,13 +4,21 @@
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include <set>
 #include <string>
 #include <unordered_map>
 
+#pragma warning(push, 0)
+#include <google/protobuf/arena.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+#pragma warning(pop)
+
 #include "../file.h"
 #include "../logger.h"
+#include "../mapped_file.h"
 #include "../time_util.h"
 #include "../util.h"
 #include "texture_atlas.h"
@@ -21,45 +29,234 @@ vme_unordered_map<uint32_t, CreatureAppearance> Appearances::_creatures;
 std::vector<SpriteRange> Appearances::textureAtlasSpriteRanges;
 vme_unordered_map<uint32_t, std::unique_ptr<TextureAtlas>> Appearances::textureAtlases;
 
+std::unique_ptr<MappedFile> Appearances::encodedAppearances;
+
 bool Appearances::isLoaded;
 
+uint64_t Appearances::_catalogHash = 0;
+
+namespace
+{
+    using google::protobuf::io::CodedInputStream;
+    using google::protobuf::internal::WireFormatLite;
+
+    /*
+		Frame groups of different objects may be decoded from the render thread and from workers. Also guards the
+		writes to ObjectAppearance::_atlases.
+	*/
+    std::mutex frameGroupDecodeMutex;
+
+    uint32_t fieldNumber(uint32_t tag)
+    {
+        return WireFormatLite::GetTagFieldNumber(tag);
+    }
+
+    WireFormatLite::WireType wireType(uint32_t tag)
+    {
+        return WireFormatLite::GetTagWireType(tag);
+    }
+
+    /*
+		Calls onField(tag, input) for every field of a serialized message. onField must either read or skip the
+		field and return false if that fails. Returns false if the message is malformed.
+	*/
+    template <typename F>
+    bool forEachField(std::span<const uint8_t> message, F &&onField)
+    {
+        CodedInputStream input(message.data(), static_cast<int>(message.size()));
+        while (uint32_t tag = input.ReadTag())
+        {
+            if (!onField(tag, input))
+            {
+                return false;
+            }
+        }
+
+        return input.CurrentPosition() == static_cast<int>(message.size());
+    }
+
+    // Reads a length-delimited field as a view into the message
+    bool readBytes(CodedInputStream &input, std::span<const uint8_t> message, std::span<const uint8_t> &result)
+    {
+        uint32_t length;
+        if (!input.ReadVarint32(&length))
+        {
+            return false;
+        }
+
+        size_t offset = static_cast<size_t>(input.CurrentPosition());
+        if (length > message.size() - offset || !input.Skip(static_cast<int>(length)))
+        {
+            return false;
+        }
+
+        result = message.subspan(offset, length);
+        return true;
+    }
+
+    bool skipField(CodedInputStream &input, uint32_t tag)
+    {
+        return WireFormatLite::SkipField(&input, tag);
+    }
+
+    // Reads the first sprite ID of an encoded FrameGroup without decoding the rest of it
+    std::optional<uint32_t> readFirstSpriteId(std::span<const uint8_t> frameGroup)
+    {
+        std::span<const uint8_t> spriteInfo;
+        forEachField(frameGroup, [&](uint32_t tag, CodedInputStream &input) {
+            return fieldNumber(tag) == proto::FrameGroup::kSpriteInfoFieldNumber && wireType(tag) == WireFormatLite::WIRETYPE_LENGTH_DELIMITED
+                       ? readBytes(input, frameGroup, spriteInfo)
+                       : skipField(input, tag);
+        });
+
+        std::optional<uint32_t> result;
+        forEachField(spriteInfo, [&](uint32_t tag, CodedInputStream &input) {
+            if (result || fieldNumber(tag) != proto::SpriteInfo::kSpriteIdFieldNumber)
+            {
+                return skipField(input, tag);
+            }
+
+            uint32_t spriteId;
+            if (wireType(tag) == WireFormatLite::WIRETYPE_VARINT)
+            {
+                if (!input.ReadVarint32(&spriteId))
+                {
+                    return false;
+                }
+                result = spriteId;
+                return true;
+            }
+
+            // Packed sprite IDs
+            std::span<const uint8_t> packed;
+            if (wireType(tag) != WireFormatLite::WIRETYPE_LENGTH_DELIMITED || !readBytes(input, spriteInfo, packed))
+            {
+                return false;
+            }
+
+            CodedInputStream packedInput(packed.data(), static_cast<int>(packed.size()));
+            if (packedInput.ReadVarint32(&spriteId))
+            {
+                result = spriteId;
+            }
+            return true;
+        });
+
+        return result;
+    }
+} // namespace
+
 void Appearances::loadAppearanceData(const std::filesystem::path path)
 {
     TimePoint start;
 
-    proto::Appearances parsed;
+    auto fail = [&path]() {
+        auto absolutePath = std::filesystem::absolute(std::filesystem::path(path));
+
+        std::stringstream s;
+        s << "Failed to parse appearances file at " << absolutePath << "." << std::endl;
+        ABORT_PROGRAM(s.str());
+    };
 
+    auto file = MappedFile::open(path);
+    if (!file)
     {
-        std::fstream input(path, std::ios::in | std::ios::binary);
-        bool success = parsed.ParseFromIstream(&input);
-        google::protobuf::ShutdownProtobufLibrary();
+        fail();
+    }
 
-        if (!success)
-        {
-            auto absolutePath = std::filesystem::absolute(std::filesystem::path(path));
+    std::span<const uint8_t> appearances(file->data(), file->size());
 
-            std::stringstream s;
-            s << "Failed to parse appearances file at " << absolutePath << "." << std::endl;
-            ABORT_PROGRAM(s.str());
+    // Only the top level is walked here. Objects are read field by field so that their frame groups can stay encoded.
+    std::vector<std::span<const uint8_t>> objects;
+    std::vector<std::span<const uint8_t>> outfits;
+    bool success = forEachField(appearances, [&](uint32_t tag, CodedInputStream &input) {
+        if (wireType(tag) == WireFormatLite::WIRETYPE_LENGTH_DELIMITED)
+        {
+            switch (fieldNumber(tag))
+            {
+                case proto::Appearances::kObjectFieldNumber:
+                    return readBytes(input, appearances, objects.emplace_back());
+                case proto::Appearances::kOutfitFieldNumber:
+                    return readBytes(input, appearances, outfits.emplace_back());
+                default:
+                    break;
+            }
         }
+        return skipField(input, tag);
+    });
+
+    if (!success)
+    {
+        fail();
     }
 
+    // Every message parsed below is allocated on the arena and freed at once when loading is done
+    google::protobuf::Arena arena;
+
     TimePoint startObjects;
-    for (int i = 0; i < parsed.object_size(); ++i)
+    Appearances::_objects.reserve(objects.size());
+    for (const auto object : objects)
     {
-        const proto::Appearance &object = parsed.object(i);
-        Appearances::_objects.emplace(object.id(), object);
+        uint32_t clientId = 0;
+        std::string name;
+        proto::AppearanceFlags *flags = nullptr;
+        std::span<const uint8_t> frameGroup;
+        int frameGroupCount = 0;
+
+        success = forEachField(object, [&](uint32_t tag, CodedInputStream &input) {
+            std::span<const uint8_t> bytes;
+            switch (fieldNumber(tag))
+            {
+                case proto::Appearance::kIdFieldNumber:
+                    return wireType(tag) == WireFormatLite::WIRETYPE_VARINT && input.ReadVarint32(&clientId);
+                case proto::Appearance::kFrameGroupFieldNumber:
+                    ++frameGroupCount;
+                    return readBytes(input, object, frameGroup);
+                case proto::Appearance::kFlagsFieldNumber:
+                    flags = google::protobuf::Arena::CreateMessage<proto::AppearanceFlags>(&arena);
+                    return readBytes(input, object, bytes) && flags->ParseFromArray(bytes.data(), static_cast<int>(bytes.size()));
+                case proto::Appearance::kNameFieldNumber:
+                    if (!readBytes(input, object, bytes))
+                    {
+                        return false;
+                    }
+                    name.assign(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+                    return true;
+                default:
+                    return skipField(input, tag);
+            }
+        });
+
+        if (!success)
+        {
+            fail();
+        }
+
+        if (frameGroupCount > 1)
+        {
+            VME_LOG_D("More than one frame group for object with clientId: " << clientId);
+            frameGroup = {};
+        }
+
+        Appearances::_objects.emplace(clientId, ObjectAppearance(clientId, std::move(name), flags, frameGroup));
     }
     auto objectsMs = startObjects.elapsedMillis();
 
     TimePoint startOutfits;
-    for (int i = 0; i < parsed.outfit_size(); ++i)
+    for (const auto outfit : outfits)
     {
-        auto &creatureAppearance = parsed.outfit(i);
-        Appearances::_creatures.emplace(creatureAppearance.id(), creatureAppearance);
+        auto creatureAppearance = google::protobuf::Arena::CreateMessage<proto::Appearance>(&arena);
+        if (!creatureAppearance->ParseFromArray(outfit.data(), static_cast<int>(outfit.size())))
+        {
+            fail();
+        }
+        Appearances::_creatures.emplace(creatureAppearance->id(), *creatureAppearance);
     }
     auto outfitsMs = startOutfits.elapsedMillis();
 
+    // Kept mapped for the frame groups that are decoded later
+    Appearances::encodedAppearances = std::make_unique<MappedFile>(std::move(*file));
+
     VME_LOG("Loaded appearances.dat in " << start.elapsedMillis() << " ms (objects: " << objectsMs << " ms, "
                                          << "outfits: " << outfitsMs << " ms).");
 
@@ -77,6 +274,8 @@ void Appearances::loadTextureAtlases(const std::filesystem::path catalogContents
         ABORT_PROGRAM(s.str());
     }
 
+    _catalogHash = File::contentHash(catalogContentsPath).value_or(0);
+
     std::ifstream fileStream(catalogContentsPath);
     nlohmann::json catalogJson;
     fileStream >> catalogJson;
@@ -97,11 +296,14 @@ void Appearances::loadTextureAtlases(const std::filesystem::path catalogContents
             std::filesystem::path filePath(filename);
             std::filesystem::path absolutePath = assetFolder / filePath;
 
-            LZMACompressedBuffer compressedBuffer;
-            compressedBuffer.buffer = File::read(absolutePath.string());
+            // Only the catalog entry is kept. The file is read when a sprite of the atlas is first needed.
+            if (!std::filesystem::is_regular_file(absolutePath))
+            {
+                ABORT_PROGRAM("Could not find file: " + absolutePath.string());
+            }
 
             Appearances::textureAtlases[lastSpriteId] = std::make_unique<TextureAtlas>(
-                std::move(compressedBuffer),
+                std::move(absolutePath),
                 TextureAtlasSize.width,
                 TextureAtlasSize.height,
                 firstSpriteId,
@@ -124,7 +326,7 @@ void Appearances::loadTextureAtlases(const std::filesystem::path catalogContents
         Appearances::textureAtlasSpriteRanges.end(),
         [](SpriteRange a, SpriteRange b) { return a.start < b.start; });
 
-    VME_LOG("Loaded compressed texture atlases in " << start.elapsedMillis() << " ms.");
+    VME_LOG("Loaded " << textureAtlasSpriteRanges.size() << " texture atlas entries from the catalog in " << start.elapsedMillis() << " ms.");
 }
 
 std::pair<bool, std::optional<std::string>> Appearances::dumpSpriteFiles(const std::filesystem::path &assetFolder, const std::filesystem::path &destinationFolder)
@@ -232,11 +434,16 @@ size_t Appearances::objectCount()
     return Appearances::_objects.size();
 }
 
+uint64_t Appearances::catalogHash() noexcept
+{
+    return _catalogHash;
+}
+
 SpriteInfo Appearances::parseSpriteInfo(const proto::SpriteInfo &spriteInfo)
 {
     SpriteInfo info = spriteInfo.has_animation() ? SpriteInfo(Appearances::parseSpriteAnimation(spriteInfo.animation())) : SpriteInfo();
     info.boundingSquare = spriteInfo.bounding_square();
-    info.isOpaque = spriteInfo.bounding_square();
+    info.isOpaque = spriteInfo.is_opaque();
     info.layers = spriteInfo.layers();
     info.patternWidth = spriteInfo.pattern_width();
     info.patternHeight = spriteInfo.pattern_height();
@@ -297,35 +504,26 @@ SpriteAnimation Appearances::parseSpriteAnimation(const proto::SpriteAnimation &
     return anim;
 }
 
-/*
-    Constructs an Appearance from protobuf Appearance data.
-*/
-ObjectAppearance::ObjectAppearance(const proto::Appearance &protobufAppearance)
+ObjectAppearance::ObjectAppearance(uint32_t clientId, std::string name, const proto::AppearanceFlags *flags, std::span<const uint8_t> encodedFrameGroup)
+    : clientId(clientId), encodedFrameGroup(encodedFrameGroup), flags(static_cast<AppearanceFlag>(0)), _name(std::move(name))
 {
-    this->clientId = protobufAppearance.id();
-    this->setName(protobufAppearance.name());
-
-    if (protobufAppearance.frame_group_size() == 1)
+    if (encodedFrameGroup.empty())
     {
-        const auto &spriteInfo = protobufAppearance.frame_group().at(0).sprite_info();
-        // bool cumulative = protobufAppearance.flags().has_cumulative() && protobufAppearance.flags().cumulative();
-
-        auto group = protobufAppearance.frame_group(0);
-        _frameGroups.emplace_back(static_cast<FixedFrameGroup>(group.fixed_frame_group()),
-                                  static_cast<uint32_t>(group.id()),
-                                  Appearances::parseSpriteInfo(spriteInfo));
+        frameGroupsDecoded = true;
     }
     else
     {
-        VME_LOG_D("More than one frame group for object with clientId: " << protobufAppearance.id());
+        _firstSpriteId = readFirstSpriteId(encodedFrameGroup);
     }
 
-    // Flags
-    this->flags = static_cast<AppearanceFlag>(0);
-    if (protobufAppearance.has_flags())
+    if (flags)
     {
-        auto flags = protobufAppearance.flags();
+        parseFlags(*flags);
+    }
+}
 
+void ObjectAppearance::parseFlags(const proto::AppearanceFlags &flags)
+{
 #define ADD_FLAG_UTIL(flagType, flag) \
     do                                \
     {                                 \
@@ -335,117 +533,117 @@ ObjectAppearance::ObjectAppearance(const proto::Appearance &protobufAppearance)
         }                             \
     } while (false)
 
-        ADD_FLAG_UTIL(bank, AppearanceFlag::Ground);
-        ADD_FLAG_UTIL(clip, AppearanceFlag::Border);
-        ADD_FLAG_UTIL(bottom, AppearanceFlag::Bottom);
-        ADD_FLAG_UTIL(top, AppearanceFlag::Top);
-        ADD_FLAG_UTIL(container, AppearanceFlag::Container);
-        ADD_FLAG_UTIL(cumulative, AppearanceFlag::Cumulative);
-        ADD_FLAG_UTIL(usable, AppearanceFlag::Usable);
-        ADD_FLAG_UTIL(forceuse, AppearanceFlag::Forceuse);
-        ADD_FLAG_UTIL(multiuse, AppearanceFlag::Multiuse);
-        ADD_FLAG_UTIL(write, AppearanceFlag::Write);
-        ADD_FLAG_UTIL(write_once, AppearanceFlag::WriteOnce);
-        ADD_FLAG_UTIL(liquidpool, AppearanceFlag::Liquidpool);
-        ADD_FLAG_UTIL(unpass, AppearanceFlag::Unpass);
-        ADD_FLAG_UTIL(unmove, AppearanceFlag::Unmove);
-        ADD_FLAG_UTIL(unsight, AppearanceFlag::Unsight);
-        ADD_FLAG_UTIL(avoid, AppearanceFlag::Avoid);
-        ADD_FLAG_UTIL(no_movement_animation, AppearanceFlag::NoMovementAnimation);
-        ADD_FLAG_UTIL(take, AppearanceFlag::Take);
-        ADD_FLAG_UTIL(liquidcontainer, AppearanceFlag::LiquidContainer);
-        ADD_FLAG_UTIL(hang, AppearanceFlag::Hang);
-        ADD_FLAG_UTIL(hook, AppearanceFlag::Hook);
-        ADD_FLAG_UTIL(rotate, AppearanceFlag::Rotate);
-        ADD_FLAG_UTIL(light, AppearanceFlag::Light);
-        ADD_FLAG_UTIL(dont_hide, AppearanceFlag::DontHide);
-        ADD_FLAG_UTIL(translucent, AppearanceFlag::Translucent);
-        ADD_FLAG_UTIL(shift, AppearanceFlag::Shift);
-        ADD_FLAG_UTIL(height, AppearanceFlag::Height);
-        ADD_FLAG_UTIL(lying_object, AppearanceFlag::LyingObject);
-        ADD_FLAG_UTIL(animate_always, AppearanceFlag::AnimateAlways);
-        ADD_FLAG_UTIL(automap, AppearanceFlag::Automap);
-        ADD_FLAG_UTIL(lenshelp, AppearanceFlag::Lenshelp);
-        ADD_FLAG_UTIL(fullbank, AppearanceFlag::Fullbank);
-        ADD_FLAG_UTIL(ignore_look, AppearanceFlag::IgnoreLook);
-        ADD_FLAG_UTIL(clothes, AppearanceFlag::Clothes);
-        ADD_FLAG_UTIL(default_action, AppearanceFlag::DefaultAction);
-        ADD_FLAG_UTIL(market, AppearanceFlag::Market);
-        ADD_FLAG_UTIL(wrap, AppearanceFlag::Wrap);
-        ADD_FLAG_UTIL(unwrap, AppearanceFlag::Unwrap);
-        ADD_FLAG_UTIL(topeffect, AppearanceFlag::Topeffect);
-        // TODO npcsaledata flag is not handled right now (probably not needed)
-        ADD_FLAG_UTIL(changedtoexpire, AppearanceFlag::ChangedToExpire);
-        ADD_FLAG_UTIL(corpse, AppearanceFlag::Corpse);
-        ADD_FLAG_UTIL(player_corpse, AppearanceFlag::PlayerCorpse);
-        ADD_FLAG_UTIL(cyclopediaitem, AppearanceFlag::CyclopediaItem);
+    ADD_FLAG_UTIL(bank, AppearanceFlag::Ground);
+    ADD_FLAG_UTIL(clip, AppearanceFlag::Border);
+    ADD_FLAG_UTIL(bottom, AppearanceFlag::Bottom);
+    ADD_FLAG_UTIL(top, AppearanceFlag::Top);
+    ADD_FLAG_UTIL(container, AppearanceFlag::Container);
+    ADD_FLAG_UTIL(cumulative, AppearanceFlag::Cumulative);
+    ADD_FLAG_UTIL(usable, AppearanceFlag::Usable);
+    ADD_FLAG_UTIL(forceuse, AppearanceFlag::Forceuse);
+    ADD_FLAG_UTIL(multiuse, AppearanceFlag::Multiuse);
+    ADD_FLAG_UTIL(write, AppearanceFlag::Write);
+    ADD_FLAG_UTIL(write_once, AppearanceFlag::WriteOnce);
+    ADD_FLAG_UTIL(liquidpool, AppearanceFlag::Liquidpool);
+    ADD_FLAG_UTIL(unpass, AppearanceFlag::Unpass);
+    ADD_FLAG_UTIL(unmove, AppearanceFlag::Unmove);
+    ADD_FLAG_UTIL(unsight, AppearanceFlag::Unsight);
+    ADD_FLAG_UTIL(avoid, AppearanceFlag::Avoid);
+    ADD_FLAG_UTIL(no_movement_animation, AppearanceFlag::NoMovementAnimation);
+    ADD_FLAG_UTIL(take, AppearanceFlag::Take);
+    ADD_FLAG_UTIL(liquidcontainer, AppearanceFlag::LiquidContainer);
+    ADD_FLAG_UTIL(hang, AppearanceFlag::Hang);
+    ADD_FLAG_UTIL(hook, AppearanceFlag::Hook);
+    ADD_FLAG_UTIL(rotate, AppearanceFlag::Rotate);
+    ADD_FLAG_UTIL(light, AppearanceFlag::Light);
+    ADD_FLAG_UTIL(dont_hide, AppearanceFlag::DontHide);
+    ADD_FLAG_UTIL(translucent, AppearanceFlag::Translucent);
+    ADD_FLAG_UTIL(shift, AppearanceFlag::Shift);
+    ADD_FLAG_UTIL(height, AppearanceFlag::Height);
+    ADD_FLAG_UTIL(lying_object, AppearanceFlag::LyingObject);
+    ADD_FLAG_UTIL(animate_always, AppearanceFlag::AnimateAlways);
+    ADD_FLAG_UTIL(automap, AppearanceFlag::Automap);
+    ADD_FLAG_UTIL(lenshelp, AppearanceFlag::Lenshelp);
+    ADD_FLAG_UTIL(fullbank, AppearanceFlag::Fullbank);
+    ADD_FLAG_UTIL(ignore_look, AppearanceFlag::IgnoreLook);
+    ADD_FLAG_UTIL(clothes, AppearanceFlag::Clothes);
+    ADD_FLAG_UTIL(default_action, AppearanceFlag::DefaultAction);
+    ADD_FLAG_UTIL(market, AppearanceFlag::Market);
+    ADD_FLAG_UTIL(wrap, AppearanceFlag::Wrap);
+    ADD_FLAG_UTIL(unwrap, AppearanceFlag::Unwrap);
+    ADD_FLAG_UTIL(topeffect, AppearanceFlag::Topeffect);
+    // TODO npcsaledata flag is not handled right now (probably not needed)
+    ADD_FLAG_UTIL(changedtoexpire, AppearanceFlag::ChangedToExpire);
+    ADD_FLAG_UTIL(corpse, AppearanceFlag::Corpse);
+    ADD_FLAG_UTIL(player_corpse, AppearanceFlag::PlayerCorpse);
+    ADD_FLAG_UTIL(cyclopediaitem, AppearanceFlag::CyclopediaItem);
 
 #undef ADD_FLAG_UTIL
 
-        if (hasFlag(AppearanceFlag::Ground))
-            flagData.groundSpeed = flags.bank().waypoints();
-        if (hasFlag(AppearanceFlag::Write))
-            flagData.maxTextLength = flags.write().max_text_length();
-        if (hasFlag(AppearanceFlag::WriteOnce))
-            flagData.maxTextLengthOnce = flags.write_once().max_text_length_once();
-        if (hasFlag(AppearanceFlag::Hook))
-        {
-            auto direction = flags.hook().direction();
-            if (direction == proto::HOOK_TYPE::HOOK_TYPE_SOUTH)
-                flagData.hookDirection = HookType::South;
-            else
-                flagData.hookDirection = HookType::East;
-        }
-        if (hasFlag(AppearanceFlag::Light))
-        {
-            flagData.brightness = flags.light().brightness();
-            flagData.color = flags.light().color();
-        }
+    if (hasFlag(AppearanceFlag::Ground))
+        flagData.groundSpeed = flags.bank().waypoints();
+    if (hasFlag(AppearanceFlag::Write))
+        flagData.maxTextLength = flags.write().max_text_length();
+    if (hasFlag(AppearanceFlag::WriteOnce))
+        flagData.maxTextLengthOnce = flags.write_once().max_text_length_once();
+    if (hasFlag(AppearanceFlag::Hook))
+    {
+        auto direction = flags.hook().direction();
+        if (direction == proto::HOOK_TYPE::HOOK_TYPE_SOUTH)
+            flagData.hookDirection = HookType::South;
+        else
+            flagData.hookDirection = HookType::East;
+    }
+    if (hasFlag(AppearanceFlag::Light))
+    {
+        flagData.brightness = flags.light().brightness();
+        flagData.color = flags.light().color();
+    }
 
-        if (hasFlag(AppearanceFlag::Shift))
-        {
-            if (flags.shift().has_x())
-                flagData.shiftX = flags.shift().x();
-            if (flags.shift().has_y())
-                flagData.shiftY = flags.shift().y();
-        }
-        if (hasFlag(AppearanceFlag::Height))
-            flagData.elevation = flags.height().elevation();
-        if (hasFlag(AppearanceFlag::Automap))
-            flagData.automapColor = flags.automap().color();
-        if (hasFlag(AppearanceFlag::Lenshelp))
-            flagData.lenshelp = flags.lenshelp().id();
-        if (hasFlag(AppearanceFlag::Clothes))
-        {
-            uint32_t slot = flags.clothes().slot();
-            DEBUG_ASSERT(slot <= 12, "Invalid slot");
-            flagData.itemSlot = static_cast<ItemSlot>(slot);
-        }
+    if (hasFlag(AppearanceFlag::Shift))
+    {
+        if (flags.shift().has_x())
+            flagData.shiftX = flags.shift().x();
+        if (flags.shift().has_y())
+            flagData.shiftY = flags.shift().y();
+    }
+    if (hasFlag(AppearanceFlag::Height))
+        flagData.elevation = flags.height().elevation();
+    if (hasFlag(AppearanceFlag::Automap))
+        flagData.automapColor = flags.automap().color();
+    if (hasFlag(AppearanceFlag::Lenshelp))
+        flagData.lenshelp = flags.lenshelp().id();
+    if (hasFlag(AppearanceFlag::Clothes))
+    {
+        uint32_t slot = flags.clothes().slot();
+        DEBUG_ASSERT(slot <= 12, "Invalid slot");
+        flagData.itemSlot = static_cast<ItemSlot>(slot);
+    }
 
-        if (hasFlag(AppearanceFlag::DefaultAction))
+    if (hasFlag(AppearanceFlag::DefaultAction))
+    {
+        switch (flags.default_action().action())
         {
-            switch (flags.default_action().action())
-            {
-                case proto::PLAYER_ACTION::PLAYER_ACTION_LOOK:
-                    flagData.defaultAction = AppearancePlayerDefaultAction::Look;
-                    break;
-                case proto::PLAYER_ACTION::PLAYER_ACTION_USE:
-                    flagData.defaultAction = AppearancePlayerDefaultAction::Use;
-                    break;
-                case proto::PLAYER_ACTION::PLAYER_ACTION_OPEN:
-                    flagData.defaultAction = AppearancePlayerDefaultAction::Open;
-                    break;
-                case proto::PLAYER_ACTION::PLAYER_ACTION_AUTOWALK_HIGHLIGHT:
-                    flagData.defaultAction = AppearancePlayerDefaultAction::AutowalkHighlight;
-                    break;
-                case proto::PLAYER_ACTION::PLAYER_ACTION_NONE:
-                default:
-                    flagData.defaultAction = AppearancePlayerDefaultAction::None;
-                    break;
-            }
+            case proto::PLAYER_ACTION::PLAYER_ACTION_LOOK:
+                flagData.defaultAction = AppearancePlayerDefaultAction::Look;
+                break;
+            case proto::PLAYER_ACTION::PLAYER_ACTION_USE:
+                flagData.defaultAction = AppearancePlayerDefaultAction::Use;
+                break;
+            case proto::PLAYER_ACTION::PLAYER_ACTION_OPEN:
+                flagData.defaultAction = AppearancePlayerDefaultAction::Open;
+                break;
+            case proto::PLAYER_ACTION::PLAYER_ACTION_AUTOWALK_HIGHLIGHT:
+                flagData.defaultAction = AppearancePlayerDefaultAction::AutowalkHighlight;
+                break;
+            case proto::PLAYER_ACTION::PLAYER_ACTION_NONE:
+            default:
+                flagData.defaultAction = AppearancePlayerDefaultAction::None;
+                break;
         }
-        if (hasFlag(AppearanceFlag::Market))
-        {
+    }
+    if (hasFlag(AppearanceFlag::Market))
+    {
 #define MAP_MARKET_FLAG(src, dst)                       \
     if (1)                                              \
     {                                                   \
@@ -455,62 +653,142 @@ ObjectAppearance::ObjectAppearance(const proto::Appearance &protobufAppearance)
     }                                                   \
     else
 
-            switch (flags.market().category())
-            {
-                MAP_MARKET_FLAG(ARMORS, AppearanceItemCategory::Armors);
-                MAP_MARKET_FLAG(AMULETS, AppearanceItemCategory::Amulets);
-                MAP_MARKET_FLAG(BOOTS, AppearanceItemCategory::Boots);
-                MAP_MARKET_FLAG(CONTAINERS, AppearanceItemCategory::Containers);
-                MAP_MARKET_FLAG(DECORATION, AppearanceItemCategory::Decoration);
-                MAP_MARKET_FLAG(FOOD, AppearanceItemCategory::Food);
-                MAP_MARKET_FLAG(HELMETS_HATS, AppearanceItemCategory::HelmetsHats);
-                MAP_MARKET_FLAG(LEGS, AppearanceItemCategory::Legs);
-                MAP_MARKET_FLAG(OTHERS, AppearanceItemCategory::Others);
-                MAP_MARKET_FLAG(POTIONS, AppearanceItemCategory::Potions);
-                MAP_MARKET_FLAG(RINGS, AppearanceItemCategory::Rings);
-                MAP_MARKET_FLAG(RUNES, AppearanceItemCategory::Runes);
-                MAP_MARKET_FLAG(SHIELDS, AppearanceItemCategory::Shields);
-                MAP_MARKET_FLAG(TOOLS, AppearanceItemCategory::Tools);
-                MAP_MARKET_FLAG(VALUABLES, AppearanceItemCategory::Valuables);
-                MAP_MARKET_FLAG(AMMUNITION, AppearanceItemCategory::Ammunition);
-                MAP_MARKET_FLAG(AXES, AppearanceItemCategory::Axes);
-                MAP_MARKET_FLAG(CLUBS, AppearanceItemCategory::Clubs);
-                MAP_MARKET_FLAG(DISTANCE_WEAPONS, AppearanceItemCategory::DistanceWeapons);
-                MAP_MARKET_FLAG(SWORDS, AppearanceItemCategory::Swords);
-                MAP_MARKET_FLAG(WANDS_RODS, AppearanceItemCategory::WandsRods);
-                MAP_MARKET_FLAG(PREMIUM_SCROLLS, AppearanceItemCategory::PremiumScrolls);
-                MAP_MARKET_FLAG(TIBIA_COINS, AppearanceItemCategory::TibiaCoins);
-                MAP_MARKET_FLAG(CREATURE_PRODUCTS, AppearanceItemCategory::CreatureProducts);
-                default:
-                    ABORT_PROGRAM("Unknown appearance flag market category: " + std::to_string(flags.market().category()));
-                    break;
-            }
+        switch (flags.market().category())
+        {
+            MAP_MARKET_FLAG(ARMORS, AppearanceItemCategory::Armors);
+            MAP_MARKET_FLAG(AMULETS, AppearanceItemCategory::Amulets);
+            MAP_MARKET_FLAG(BOOTS, AppearanceItemCategory::Boots);
+            MAP_MARKET_FLAG(CONTAINERS, AppearanceItemCategory::Containers);
+            MAP_MARKET_FLAG(DECORATION, AppearanceItemCategory::Decoration);
+            MAP_MARKET_FLAG(FOOD, AppearanceItemCategory::Food);
+            MAP_MARKET_FLAG(HELMETS_HATS, AppearanceItemCategory::HelmetsHats);
+            MAP_MARKET_FLAG(LEGS, AppearanceItemCategory::Legs);
+            MAP_MARKET_FLAG(OTHERS, AppearanceItemCategory::Others);
+            MAP_MARKET_FLAG(POTIONS, AppearanceItemCategory::Potions);
+            MAP_MARKET_FLAG(RINGS, AppearanceItemCategory::Rings);
+            MAP_MARKET_FLAG(RUNES, AppearanceItemCategory::Runes);
+            MAP_MARKET_FLAG(SHIELDS, AppearanceItemCategory::Shields);
+            MAP_MARKET_FLAG(TOOLS, AppearanceItemCategory::Tools);
+            MAP_MARKET_FLAG(VALUABLES, AppearanceItemCategory::Valuables);
+            MAP_MARKET_FLAG(AMMUNITION, AppearanceItemCategory::Ammunition);
+            MAP_MARKET_FLAG(AXES, AppearanceItemCategory::Axes);
+            MAP_MARKET_FLAG(CLUBS, AppearanceItemCategory::Clubs);
+            MAP_MARKET_FLAG(DISTANCE_WEAPONS, AppearanceItemCategory::DistanceWeapons);
+            MAP_MARKET_FLAG(SWORDS, AppearanceItemCategory::Swords);
+            MAP_MARKET_FLAG(WANDS_RODS, AppearanceItemCategory::WandsRods);
+            MAP_MARKET_FLAG(PREMIUM_SCROLLS, AppearanceItemCategory::PremiumScrolls);
+            MAP_MARKET_FLAG(TIBIA_COINS, AppearanceItemCategory::TibiaCoins);
+            MAP_MARKET_FLAG(CREATURE_PRODUCTS, AppearanceItemCategory::CreatureProducts);
+            default:
+                ABORT_PROGRAM("Unknown appearance flag market category: " + std::to_string(flags.market().category()));
+                break;
+        }
 
 #undef MAP_MARKET_FLAG
-        }
-        // This flag is probably not necessary in a map editor
-        // if (hasFlag(AppearanceFlag::NpcSaleData))
-        // {
-        // }
-        if (hasFlag(AppearanceFlag::ChangedToExpire))
-            flagData.changedToExpireFormerObjectTypeId = flags.changedtoexpire().former_object_typeid();
-        if (hasFlag(AppearanceFlag::CyclopediaItem))
-            flagData.cyclopediaClientId = flags.cyclopediaitem().cyclopedia_type();
     }
+    // This flag is probably not necessary in a map editor
+    // if (hasFlag(AppearanceFlag::NpcSaleData))
+    // {
+    // }
+    if (hasFlag(AppearanceFlag::ChangedToExpire))
+        flagData.changedToExpireFormerObjectTypeId = flags.changedtoexpire().former_object_typeid();
+    if (hasFlag(AppearanceFlag::CyclopediaItem))
+        flagData.cyclopediaClientId = flags.cyclopediaitem().cyclopedia_type();
 }
 
 ObjectAppearance::ObjectAppearance(ObjectAppearance &&other) noexcept
     : clientId(other.clientId),
-      _name(std::move(other._name)),
+      quadrantRenderType(other.quadrantRenderType),
       flagData(std::move(other.flagData)),
+      _atlases(other._atlases),
       _frameGroups(std::move(other._frameGroups)),
-      flags(std::move(other.flags)) {}
+      encodedFrameGroup(other.encodedFrameGroup),
+      frameGroupsDecoded(other.frameGroupsDecoded.load()),
+      _firstSpriteId(other._firstSpriteId),
+      flags(std::move(other.flags)),
+      _name(std::move(other._name)) {}
+
+ObjectAppearance &ObjectAppearance::operator=(ObjectAppearance &&other) noexcept
+{
+    clientId = other.clientId;
+    quadrantRenderType = other.quadrantRenderType;
+    flagData = std::move(other.flagData);
+    _atlases = other._atlases;
+    _frameGroups = std::move(other._frameGroups);
+    encodedFrameGroup = other.encodedFrameGroup;
+    frameGroupsDecoded = other.frameGroupsDecoded.load();
+    _firstSpriteId = other._firstSpriteId;
+    flags = std::move(other.flags);
+    _name = std::move(other._name);
+
+    return *this;
+}
+
+void ObjectAppearance::setFrameGroups(std::vector<FrameGroup> &&frameGroups)
+{
+    _frameGroups = std::move(frameGroups);
+    encodedFrameGroup = {};
+    frameGroupsDecoded = true;
+
+    if (!_frameGroups.empty() && !_frameGroups.front().spriteInfo.spriteIds.empty())
+    {
+        _firstSpriteId = _frameGroups.front().spriteInfo.spriteIds.front();
+    }
+}
+
+void ObjectAppearance::decodeFrameGroups() const
+{
+    if (frameGroupsDecoded.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(frameGroupDecodeMutex);
+    if (frameGroupsDecoded.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    proto::FrameGroup group;
+    if (!group.ParseFromArray(encodedFrameGroup.data(), static_cast<int>(encodedFrameGroup.size())))
+    {
+        ABORT_PROGRAM("Failed to decode the frame group of object " + std::to_string(clientId));
+    }
+
+    _frameGroups.emplace_back(static_cast<FixedFrameGroup>(group.fixed_frame_group()),
+                              static_cast<uint32_t>(group.id()),
+                              Appearances::parseSpriteInfo(group.sprite_info()));
+
+    // Published together with the frame groups, so readers of _atlases never see a partial cache
+    cacheFrameGroupAtlases();
+
+    frameGroupsDecoded.store(true, std::memory_order_release);
+}
 
 void ObjectAppearance::cacheTextureAtlases()
 {
-    for (int frameGroup = 0; frameGroup < frameGroupCount(); ++frameGroup)
+    // Serialized with decodeFrameGroups, which may run on a worker. Once the frame groups are decoded, every atlas
+    // that fits is already cached and the calls below do not write.
+    std::lock_guard<std::mutex> lock(frameGroupDecodeMutex);
+
+    // Only the first atlas is cached before the frame group is decoded. The rest follow when it is.
+    if (!frameGroupsDecoded.load(std::memory_order_relaxed))
+    {
+        if (_atlases.front() == nullptr && _firstSpriteId)
+        {
+            _atlases.front() = Appearances::getTextureAtlas(*_firstSpriteId);
+        }
+        return;
+    }
+
+    cacheFrameGroupAtlases();
+}
+
+void ObjectAppearance::cacheFrameGroupAtlases() const
+{
+    for (const auto &frameGroup : _frameGroups)
     {
-        for (const auto spriteId : getSpriteInfo(frameGroup).spriteIds)
+        for (const auto spriteId : frameGroup.spriteInfo.spriteIds)
         {
             // Stop if the cache is full
             if (_atlases.back() != nullptr)
@@ -522,7 +800,7 @@ void ObjectAppearance::cacheTextureAtlases()
     }
 }
 
-void ObjectAppearance::cacheTextureAtlas(uint32_t spriteId)
+void ObjectAppearance::cacheTextureAtlas(uint32_t spriteId) const
 {
     // If nothing is cached, cache the TextureAtlas for the first sprite ID in the appearance.
     if (_atlases.front() == nullptr)
@@ -550,12 +828,12 @@ void ObjectAppearance::cacheTextureAtlas(uint32_t spriteId)
 
 uint32_t ObjectAppearance::getFirstSpriteId() const
 {
-    return getSpriteInfo().spriteIds.at(0);
+    return _firstSpriteId ? *_firstSpriteId : getSpriteInfo().spriteIds.at(0);
 }
 
 const SpriteInfo &ObjectAppearance::getSpriteInfo(size_t frameGroup) const
 {
-    return _frameGroups.at(frameGroup).spriteInfo;
+    return frameGroups().at(frameGroup).spriteInfo;
 }
 
 const SpriteInfo &ObjectAppearance::getSpriteInfo() const
@@ -575,14 +853,20 @@ size_t ObjectAppearance::spriteCount(uint32_t frameGroup) const
 
 size_t ObjectAppearance::frameGroupCount() const
 {
-    return _frameGroups.size();
+    return frameGroups().size();
 }
 
-const std::vector<FrameGroup> &ObjectAppearance::frameGroups() const noexcept
+const std::vector<FrameGroup> &ObjectAppearance::frameGroups() const
 {
+    decodeFrameGroups();
     return _frameGroups;
 }
 
+bool ObjectAppearance::isDecoded() const noexcept
+{
+    return frameGroupsDecoded.load(std::memory_order_acquire);
+}
+
 const std::string &ObjectAppearance::name() const noexcept
 {
     return _name;
@@ -787,33 +1071,6 @@ void CreatureAppearance::cacheNonMovingRenderSizes(uint8_t postureId) const
     nonMovingCreatureRenderTypeByPosture.at(postureId) = checkTransparency(postureId);
 }
 
-bool isMagenta(int x, int y, int atlasWidth, const std::vector<uint8_t> &pixels)
-{
-    int i = (atlasWidth - y - 1) * (atlasWidth * 4) + x * 4;
-    uint8_t r = pixels.at(i);
-    uint8_t g = pixels.at(i + 1);
-    uint8_t b = pixels.at(i + 2);
-
-    return r == 255 && g == 0 && b == 255;
-}
-
-bool transparentRegion(int fromX, int fromY, int width, int height, int atlasWidth, const std::vector<uint8_t> &pixels)
-{
-    for (int y = fromY; y < fromY + height; ++y)
-    {
-        for (int x = fromX; x < fromX + width; ++x)
-        {
-            if (!isMagenta(x, y, atlasWidth, pixels))
-            {
-                // VME_LOG_D(std::format("Fail at: {}, {}", x, y));
-                return false;
-            }
-        }
-    }
-
-    return true;
-}
-
 uint32_t CreatureAppearance::getIndex(const FrameGroup &frameGroup, uint8_t creaturePosture, uint8_t addonType, Direction direction) const
 {
     return getIndex(frameGroup, creaturePosture, addonType, to_underlying(direction));
@@ -845,26 +1102,14 @@ CreatureAppearance::NonMovingCreatureRenderType CreatureAppearance::checkTranspa
     }
 
     auto spriteId = fg.getSpriteId(getIndex(fg, postureId, 0, 0));
-    TextureAtlas *atlas = getTextureAtlas(spriteId);
-
-    const auto &pixels = atlas->getOrCreateTexture().pixels();
-
-    int spriteIndex = spriteId - atlas->firstSpriteId;
-
-    auto topLeftX = atlas->spriteWidth * (spriteIndex % atlas->columns);
-    auto topLeftY = atlas->spriteHeight * (spriteIndex / atlas->rows);
-
-    int quadWidth = atlas->spriteWidth / 2;
-    int quadHeight = atlas->spriteHeight / 2;
+    const SpriteOpacity &opacity = getTextureAtlas(spriteId)->spriteOpacity(spriteId);
 
-    // Top-left
-    if (!transparentRegion(topLeftX, topLeftY, quadWidth, quadHeight, atlas->width, pixels))
+    if (!opacity.transparent(SpriteOpacity::TopLeft))
     {
         return NonMovingCreatureRenderType::Full;
     }
 
-    // Top-right
-    if (!transparentRegion(topLeftX + quadWidth, topLeftY, quadWidth, quadHeight, atlas->width, pixels))
+    if (!opacity.transparent(SpriteOpacity::TopRight))
     {
         return NonMovingCreatureRenderType::Half;
     }
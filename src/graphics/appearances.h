@@ -1,8 +1,11 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <filesystem>
 #include <memory>
+#include <optional>
+#include <span>
 #include <unordered_map>
 
 #include <sstream>
@@ -27,12 +30,15 @@
 #include "appearance_types.h"
 #include "texture_atlas.h"
 
+class MappedFile;
+
 namespace proto
 {
     using namespace tibia::protobuf;
     using Appearance = appearances::Appearance;
     using Appearances = appearances::Appearances;
     using AppearanceFlags = appearances::AppearanceFlags;
+    using FrameGroup = appearances::FrameGroup;
     using SpriteInfo = appearances::SpriteInfo;
     using SpriteAnimation = appearances::SpriteAnimation;
 
@@ -69,6 +75,10 @@ inline bool operator>(AppearanceFlag a, uint64_t b)
 
 /*
   Convenience wrapper for a tibia::protobuf Appearance
+
+  The flags, the name and the first sprite ID are read when the appearance is loaded. The frame group stays encoded
+  in the memory-mapped appearances.dat and is decoded the first time it is accessed, so objects that are never
+  drawn never build their SpriteInfo.
 */
 class ObjectAppearance
 {
@@ -76,10 +86,10 @@ class ObjectAppearance
     static constexpr size_t CachedTextureAtlasAmount = 5;
 
   public:
-    ObjectAppearance(const proto::Appearance &protobufAppearance);
+    ObjectAppearance(uint32_t clientId, std::string name, const proto::AppearanceFlags *flags, std::span<const uint8_t> encodedFrameGroup);
 
     ObjectAppearance(ObjectAppearance &&other) noexcept;
-    ObjectAppearance &operator=(ObjectAppearance &&) = default;
+    ObjectAppearance &operator=(ObjectAppearance &&other) noexcept;
 
     size_t spriteCount(uint32_t frameGroup) const;
 
@@ -89,7 +99,6 @@ class ObjectAppearance
     const SpriteInfo &getSpriteInfo() const;
 
     void cacheTextureAtlases();
-    void cacheTextureAtlas(uint32_t spriteId);
 
     bool hasFlag(AppearanceFlag flag)
     {
@@ -97,13 +106,17 @@ class ObjectAppearance
     }
 
     size_t frameGroupCount() const;
-    const std::vector<FrameGroup> &frameGroups() const noexcept;
+    const std::vector<FrameGroup> &frameGroups() const;
+
+    // True once the frame group has been decoded
+    bool isDecoded() const noexcept;
 
     const std::string &name() const noexcept;
     void setName(std::string name);
 
     const std::array<TextureAtlas *, CachedTextureAtlasAmount> &atlases() const
     {
+        decodeFrameGroups();
         return _atlases;
     }
 
@@ -143,9 +156,27 @@ class ObjectAppearance
     } flagData = {};
 
   private:
-    std::array<TextureAtlas *, CachedTextureAtlasAmount> _atlases = {};
+    friend class ClientDataCache;
+    ObjectAppearance() = default;
 
-    std::vector<FrameGroup> _frameGroups;
+    void parseFlags(const proto::AppearanceFlags &flags);
+
+    void setFrameGroups(std::vector<FrameGroup> &&frameGroups);
+    void decodeFrameGroups() const;
+
+    // Write _atlases, which is read without a lock once the frame groups are decoded. Only called with the frame
+    // group decode lock held.
+    void cacheFrameGroupAtlases() const;
+    void cacheTextureAtlas(uint32_t spriteId) const;
+
+    mutable std::array<TextureAtlas *, CachedTextureAtlasAmount> _atlases = {};
+
+    mutable std::vector<FrameGroup> _frameGroups;
+    // Points into Appearances::encodedAppearances. Empty if the object has no frame group.
+    std::span<const uint8_t> encodedFrameGroup;
+    mutable std::atomic<bool> frameGroupsDecoded = false;
+
+    std::optional<uint32_t> _firstSpriteId;
     AppearanceFlag flags;
 
     std::string _name;
@@ -171,6 +202,9 @@ class CreatureAppearance
     uint32_t getIndex(const FrameGroup &frameGroup, uint8_t creaturePosture, uint8_t addonType, Direction direction) const;
 
   private:
+    friend class ClientDataCache;
+    CreatureAppearance() = default;
+
     void cacheTextureAtlas(uint32_t spriteId);
 
     /**
@@ -242,7 +276,16 @@ class Appearances
     static size_t textureAtlasCount();
     static size_t objectCount();
 
+    /*
+		Hash of the loaded catalog file. The catalog names the appearances file and every sprite file, so the hash
+		changes whenever the client assets do.
+	*/
+    static uint64_t catalogHash() noexcept;
+
   private:
+    friend class ClientDataCache;
+    friend class SpriteOpacityCache;
+
     static vme_unordered_map<AppearanceId, ObjectAppearance> _objects;
     static vme_unordered_map<AppearanceId, CreatureAppearance> _creatures;
 
@@ -252,6 +295,8 @@ class Appearances
 	*/
     static std::set<uint32_t> catalogIndex;
 
+    static uint64_t _catalogHash;
+
     static vme_unordered_map<uint32_t, std::unique_ptr<TextureAtlas>> textureAtlases;
 
     /* 
@@ -259,6 +304,9 @@ class Appearances
 		It stores the start and end sprite id in the sprite sheet.
 	*/
     static std::vector<SpriteRange> textureAtlasSpriteRanges;
+
+    // The loaded appearances.dat. Frame groups of objects are decoded from it on first access.
+    static std::unique_ptr<MappedFile> encodedAppearances;
 };
 
 inline const vme_unordered_map<uint32_t, ObjectAppearance> &Appearances::objects()
@@ -0,0 +1,76 @@
+#include "atlas_decompressor.h"
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+#include "../thread_pool.h"
+#include "texture_atlas.h"
+
+std::vector<const TextureAtlas *> AtlasDecompressor::pending;
+std::function<void()> AtlasDecompressor::wakeUp;
+std::atomic<bool> AtlasDecompressor::wakeUpPending = false;
+
+ThreadPool &AtlasDecompressor::workers()
+{
+    // Leave a core for the UI thread
+    static ThreadPool threadPool(std::max(2u, std::thread::hardware_concurrency()) - 1);
+    return threadPool;
+}
+
+void AtlasDecompressor::request(const TextureAtlas *atlas)
+{
+    if (!atlas->isCompressed() || atlas->decompressionPending())
+    {
+        return;
+    }
+
+    std::shared_ptr<PendingDecompression> decompression = atlas->startDecompression();
+    pending.emplace_back(atlas);
+
+    workers().submit([decompression]() {
+        decompression->run();
+
+        if (wakeUp && !wakeUpPending.exchange(true))
+        {
+            wakeUp();
+        }
+    });
+}
+
+size_t AtlasDecompressor::installFinished()
+{
+    // Decompressions that finish from here on wake up the main thread again
+    wakeUpPending = false;
+
+    size_t installed = 0;
+
+    auto end = std::remove_if(pending.begin(), pending.end(), [&installed](const TextureAtlas *atlas) {
+        // Already installed by a synchronous getOrCreateTexture
+        if (!atlas->decompressionPending())
+        {
+            return true;
+        }
+
+        if (atlas->finishDecompression())
+        {
+            ++installed;
+            return true;
+        }
+
+        return false;
+    });
+    pending.erase(end, pending.end());
+
+    return installed;
+}
+
+bool AtlasDecompressor::hasPending() noexcept
+{
+    return !pending.empty();
+}
+
+void AtlasDecompressor::setWakeUp(std::function<void()> wakeUp)
+{
+    AtlasDecompressor::wakeUp = std::move(wakeUp);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+struct TextureAtlas;
+class ThreadPool;
+
+/*
+	Decompresses texture atlases on worker threads so that the first draw of a sprite does not stall the UI thread.
+
+	Workers only produce pixel data. The decompressed Texture is installed in its atlas on the main thread by
+	installFinished, so the rest of the editor never sees an atlas change under its feet. An atlas that is needed
+	right away (e.g. by TextureAtlas::getOrCreateTexture) is still decompressed synchronously; if a worker already
+	started on it, the caller waits for that worker instead of doing the work twice.
+*/
+class AtlasDecompressor
+{
+  public:
+    /*
+		Queues the atlas for decompression. Does nothing if it is already decompressed or queued.
+	*/
+    static void request(const TextureAtlas *atlas);
+
+    /*
+		Installs the atlases that finished since the last call. Must be called on the main thread.
+		Returns the number of installed atlases.
+	*/
+    static size_t installFinished();
+
+    static bool hasPending() noexcept;
+
+    /*
+		Called on a worker thread when a decompression finishes, at most once until the next installFinished. It
+		should make the main thread call installFinished, e.g. by posting an event. Must be set before the first
+		request.
+	*/
+    static void setWakeUp(std::function<void()> wakeUp);
+
+  private:
+    static ThreadPool &workers();
+
+    static std::function<void()> wakeUp;
+    static std::atomic<bool> wakeUpPending;
+
+    // Atlases with a decompression in flight. Only accessed on the main thread.
+    static std::vector<const TextureAtlas *> pending;
+};
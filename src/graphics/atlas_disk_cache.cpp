@@ -0,0 +1,145 @@
+#include "atlas_disk_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <system_error>
+
+#include "../file.h"
+#include "../logger.h"
+#include "../mapped_file.h"
+
+namespace
+{
+    constexpr std::array<char, 4> EntryMagic = {'V', 'M', 'E', 'A'};
+    constexpr auto EntryExtension = ".rgba";
+} // namespace
+
+std::optional<std::filesystem::path> AtlasDiskCache::directory;
+std::array<char, 32> AtlasDiskCache::clientVersion{};
+
+std::atomic<uint64_t> AtlasDiskCache::hits = 0;
+std::atomic<uint64_t> AtlasDiskCache::misses = 0;
+std::atomic<uint64_t> AtlasDiskCache::writeFailures = 0;
+
+void AtlasDiskCache::open(const std::filesystem::path &directory, const std::string &clientVersion)
+{
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error)
+    {
+        VME_LOG_ERROR("Could not create the texture atlas cache directory " << directory.string() << ": " << error.message());
+        close();
+        return;
+    }
+
+    AtlasDiskCache::directory = directory;
+
+    AtlasDiskCache::clientVersion.fill('\0');
+    size_t length = std::min(clientVersion.size(), AtlasDiskCache::clientVersion.size());
+    std::copy_n(clientVersion.begin(), length, AtlasDiskCache::clientVersion.begin());
+}
+
+void AtlasDiskCache::close()
+{
+    directory.reset();
+}
+
+bool AtlasDiskCache::isOpen() noexcept
+{
+    return directory.has_value();
+}
+
+std::filesystem::path AtlasDiskCache::entryPath(const std::filesystem::path &atlasFile)
+{
+    std::filesystem::path path = *directory / atlasFile.filename();
+    path += EntryExtension;
+    return path;
+}
+
+std::optional<AtlasDiskCache::EntryHeader> AtlasDiskCache::expectedHeader(const std::filesystem::path &atlasFile, uint64_t pixelBytes)
+{
+    std::error_code error;
+    auto size = std::filesystem::file_size(atlasFile, error);
+    if (error)
+    {
+        return std::nullopt;
+    }
+
+    auto modified = std::filesystem::last_write_time(atlasFile, error);
+    if (error)
+    {
+        return std::nullopt;
+    }
+
+    EntryHeader header;
+    header.magic = EntryMagic;
+    header.formatVersion = FormatVersion;
+    header.clientVersion = clientVersion;
+    header.sourceSize = static_cast<uint64_t>(size);
+    header.sourceModified = static_cast<int64_t>(modified.time_since_epoch().count());
+    header.pixelBytes = pixelBytes;
+
+    return header;
+}
+
+std::optional<std::vector<uint8_t>> AtlasDiskCache::read(const std::filesystem::path &atlasFile)
+{
+    if (!isOpen())
+    {
+        return std::nullopt;
+    }
+
+    auto file = MappedFile::open(entryPath(atlasFile));
+    if (!file || file->size() < sizeof(EntryHeader))
+    {
+        ++misses;
+        return std::nullopt;
+    }
+
+    EntryHeader header;
+    std::memcpy(&header, file->data(), sizeof(EntryHeader));
+
+    // An entry written for another client version, for an older file or cut short by a crash is ignored
+    auto expected = expectedHeader(atlasFile, file->size() - sizeof(EntryHeader));
+    if (!expected || header != *expected)
+    {
+        ++misses;
+        return std::nullopt;
+    }
+
+    ++hits;
+
+    const uint8_t *pixels = file->data() + sizeof(EntryHeader);
+    return std::vector<uint8_t>(pixels, pixels + header.pixelBytes);
+}
+
+void AtlasDiskCache::write(const std::filesystem::path &atlasFile, const std::vector<uint8_t> &pixels)
+{
+    if (!isOpen())
+    {
+        return;
+    }
+
+    auto header = expectedHeader(atlasFile, pixels.size());
+    if (!header)
+    {
+        ++writeFailures;
+        return;
+    }
+
+    // Another reader never maps a partial entry
+    auto error = File::writeAtomically(entryPath(atlasFile), [&header, &pixels](std::ostream &stream) {
+        stream.write(reinterpret_cast<const char *>(&*header), sizeof(EntryHeader));
+        stream.write(reinterpret_cast<const char *>(pixels.data()), pixels.size());
+    });
+
+    if (error)
+    {
+        ++writeFailures;
+    }
+}
+
+AtlasDiskCache::Statistics AtlasDiskCache::statistics() noexcept
+{
+    return Statistics{hits.load(), misses.load(), writeFailures.load()};
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+/*
+	An on-disk cache of decompressed texture atlas pixels. It makes every start after the first skip the LZMA
+	decompression of the atlases that were used before.
+
+	An entry is the raw pixel data of one atlas file, stored under the name of that file. The catalog names atlas
+	files after a hash of their contents, so a changed atlas gets a new entry. An entry also records the client
+	version and the size and modification time of its atlas file; it is only used if all of them match. Entries are
+	memory-mapped when read.
+
+	The cache is only configured by open (and close) on the main thread, before atlases are decompressed. read and
+	write can then be called from any thread.
+*/
+class AtlasDiskCache
+{
+  public:
+    struct Statistics
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t writeFailures = 0;
+    };
+
+    /*
+		Enables the cache. Entries are stored in the given directory, which is created if necessary.
+	*/
+    static void open(const std::filesystem::path &directory, const std::string &clientVersion);
+    static void close();
+
+    static bool isOpen() noexcept;
+
+    /*
+		Returns the cached pixels of the atlas file, or nullopt if the cache is closed or has no valid entry for it.
+	*/
+    static std::optional<std::vector<uint8_t>> read(const std::filesystem::path &atlasFile);
+
+    /*
+		Stores the decompressed pixels of the atlas file. Failing to write an entry is not an error; the atlas is
+		decompressed again on the next start.
+	*/
+    static void write(const std::filesystem::path &atlasFile, const std::vector<uint8_t> &pixels);
+
+    static Statistics statistics() noexcept;
+
+    static constexpr uint32_t FormatVersion = 1;
+    // Byte offset of the format version in an entry
+    static constexpr size_t FormatVersionOffset = 4;
+
+  private:
+    struct EntryHeader
+    {
+        std::array<char, 4> magic;
+        uint32_t formatVersion;
+        std::array<char, 32> clientVersion;
+        uint64_t sourceSize;
+        int64_t sourceModified;
+        uint64_t pixelBytes;
+
+        bool operator==(const EntryHeader &other) const = default;
+    };
+    static_assert(offsetof(EntryHeader, formatVersion) == FormatVersionOffset);
+
+    static std::optional<EntryHeader> expectedHeader(const std::filesystem::path &atlasFile, uint64_t pixelBytes);
+    static std::filesystem::path entryPath(const std::filesystem::path &atlasFile);
+
+    static std::optional<std::filesystem::path> directory;
+    static std::array<char, 32> clientVersion;
+
+    static std::atomic<uint64_t> hits;
+    static std::atomic<uint64_t> misses;
+    static std::atomic<uint64_t> writeFailures;
+};
@@ -0,0 +1,369 @@
+#include "outfit_variation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#include "../creature.h"
+#include "../debug.h"
+#include "texture_atlas_cache.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VME_OUTFIT_VARIATION_SSE2
+#include <emmintrin.h>
+#endif
+
+vme_unordered_map<uint64_t, std::weak_ptr<OutfitVariation>> OutfitVariations::variations;
+
+namespace
+{
+    // Template colors as stored in texture memory (BGRA)
+    constexpr uint32_t HeadMask = 0xFFFFFF00;
+    constexpr uint32_t BodyMask = 0xFFFF0000;
+    constexpr uint32_t LegsMask = 0xFF00FF00;
+    constexpr uint32_t FeetMask = 0xFF0000FF;
+
+    uint32_t asBgra(const Pixel &pixel)
+    {
+        return pixel.b() | (pixel.g() << 8) | (pixel.r() << 16) | (static_cast<uint32_t>(pixel.a()) << 24);
+    }
+
+    uint32_t multiply(uint32_t bgra, uint32_t color)
+    {
+        uint32_t result = 0;
+        for (int shift = 0; shift < 32; shift += 8)
+        {
+            uint32_t channel = (((bgra >> shift) & 0xFF) * ((color >> shift) & 0xFF) + 0xFF) >> 8;
+            result |= channel << shift;
+        }
+        return result;
+    }
+
+    /*
+		Byte offset of a sprite in a texture that uses the layout of a texture atlas. Rows are stored bottom-up, so
+		the first row of the image is the last one in memory.
+	*/
+    size_t spriteOffset(uint32_t textureWidth, uint32_t columns, uint32_t rows, uint32_t index, uint32_t spriteWidth, uint32_t spriteHeight)
+    {
+        uint32_t row = index / columns;
+        uint32_t col = index % columns;
+
+        return 4 * (static_cast<size_t>(rows - row - 1) * spriteHeight * textureWidth + static_cast<size_t>(col) * spriteWidth);
+    }
+} // namespace
+
+OutfitVariation::Page::Page(const TextureAtlas *atlas, uint32_t columns, uint32_t rows, std::vector<uint8_t> &&pixels)
+    : atlas(atlas), columns(columns), rows(rows), texture(columns * atlas->spriteWidth, rows * atlas->spriteHeight, std::move(pixels)) {}
+
+OutfitVariation::~OutfitVariation()
+{
+    for (const auto &page : pages)
+    {
+        TextureAtlasCache::variationRemoved(page.texture.sizeInBytes(), page.texture.id());
+    }
+}
+
+void OutfitVariation::colorizeRow(uint8_t *target, const uint8_t *source, const uint8_t *mask, size_t pixelCount, const std::array<uint32_t, 4> &colors)
+{
+    size_t i = 0;
+
+#ifdef VME_OUTFIT_VARIATION_SSE2
+    const __m128i headMask = _mm_set1_epi32(static_cast<int>(HeadMask));
+    const __m128i bodyMask = _mm_set1_epi32(static_cast<int>(BodyMask));
+    const __m128i legsMask = _mm_set1_epi32(static_cast<int>(LegsMask));
+    const __m128i feetMask = _mm_set1_epi32(static_cast<int>(FeetMask));
+
+    const __m128i head = _mm_set1_epi32(static_cast<int>(colors[0]));
+    const __m128i body = _mm_set1_epi32(static_cast<int>(colors[1]));
+    const __m128i legs = _mm_set1_epi32(static_cast<int>(colors[2]));
+    const __m128i feet = _mm_set1_epi32(static_cast<int>(colors[3]));
+
+    const __m128i white = _mm_set1_epi32(-1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rounding = _mm_set1_epi16(0xFF);
+
+    // Four pixels at a time. Pixels outside the template are multiplied by white, which leaves them unchanged.
+    for (; i + 4 <= pixelCount; i += 4)
+    {
+        __m128i maskPixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(mask + 4 * i));
+
+        __m128i isHead = _mm_cmpeq_epi32(maskPixels, headMask);
+        __m128i isBody = _mm_cmpeq_epi32(maskPixels, bodyMask);
+        __m128i isLegs = _mm_cmpeq_epi32(maskPixels, legsMask);
+        __m128i isFeet = _mm_cmpeq_epi32(maskPixels, feetMask);
+
+        __m128i color = _mm_or_si128(_mm_or_si128(_mm_and_si128(isHead, head), _mm_and_si128(isBody, body)),
+                                     _mm_or_si128(_mm_and_si128(isLegs, legs), _mm_and_si128(isFeet, feet)));
+        __m128i colored = _mm_or_si128(_mm_or_si128(isHead, isBody), _mm_or_si128(isLegs, isFeet));
+        color = _mm_or_si128(color, _mm_andnot_si128(colored, white));
+
+        __m128i sourcePixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + 4 * i));
+
+        // (source * color + 255) / 256 per channel, in 16 bits
+        __m128i low = _mm_mullo_epi16(_mm_unpacklo_epi8(sourcePixels, zero), _mm_unpacklo_epi8(color, zero));
+        __m128i high = _mm_mullo_epi16(_mm_unpackhi_epi8(sourcePixels, zero), _mm_unpackhi_epi8(color, zero));
+        low = _mm_srli_epi16(_mm_add_epi16(low, rounding), 8);
+        high = _mm_srli_epi16(_mm_add_epi16(high, rounding), 8);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(target + 4 * i), _mm_packus_epi16(low, high));
+    }
+#endif
+
+    for (; i < pixelCount; ++i)
+    {
+        uint32_t maskPixel;
+        uint32_t sourcePixel;
+        std::memcpy(&maskPixel, mask + 4 * i, sizeof(uint32_t));
+        std::memcpy(&sourcePixel, source + 4 * i, sizeof(uint32_t));
+
+        uint32_t result = sourcePixel;
+        switch (maskPixel)
+        {
+            case HeadMask:
+                result = multiply(sourcePixel, colors[0]);
+                break;
+            case BodyMask:
+                result = multiply(sourcePixel, colors[1]);
+                break;
+            case LegsMask:
+                result = multiply(sourcePixel, colors[2]);
+                break;
+            case FeetMask:
+                result = multiply(sourcePixel, colors[3]);
+                break;
+            default:
+                break;
+        }
+
+        std::memcpy(target + 4 * i, &result, sizeof(uint32_t));
+    }
+}
+
+std::array<uint32_t, 4> OutfitVariation::colors(const Outfit::Look &look)
+{
+    return {
+        asBgra(Creatures::getColorFromLookupTable(look.head())),
+        asBgra(Creatures::getColorFromLookupTable(look.body())),
+        asBgra(Creatures::getColorFromLookupTable(look.legs())),
+        asBgra(Creatures::getColorFromLookupTable(look.feet()))};
+}
+
+bool OutfitVariation::apply(TextureInfo &info, uint32_t spriteId, TextureInfo::CoordinateType coordinateType) const
+{
+    auto found = cells.find(spriteId);
+    if (found == cells.end())
+    {
+        return false;
+    }
+
+    const Cell &cell = found->second;
+    const Page &page = pages[cell.page];
+
+    if (coordinateType == TextureInfo::CoordinateType::Normalized)
+    {
+        info.window = cellWindow(page, cell.index, coordinateType);
+    }
+    else
+    {
+        // Unnormalized windows can be cut to part of the sprite, so they are moved instead of replaced
+        TextureWindow atlasWindow = page.atlas->getTextureWindow(spriteId, coordinateType);
+        TextureWindow variationWindow = cellWindow(page, cell.index, coordinateType);
+
+        info.window.x0 += variationWindow.x0 - atlasWindow.x0;
+        info.window.y0 += variationWindow.y0 - atlasWindow.y0;
+    }
+
+    info.variation = &page.texture;
+    return true;
+}
+
+TextureWindow OutfitVariation::cellWindow(const Page &page, uint32_t index, TextureInfo::CoordinateType coordinateType) const
+{
+    uint32_t row = index / page.columns;
+    uint32_t col = index % page.columns;
+
+    if (coordinateType == TextureInfo::CoordinateType::Normalized)
+    {
+        float x = static_cast<float>(col) / page.columns;
+        float y = static_cast<float>(page.rows - row) / page.rows;
+
+        return TextureWindow{x, y - 1.0f / page.rows, x + 1.0f / page.columns, y};
+    }
+    else
+    {
+        const float spriteWidth = static_cast<float>(page.atlas->spriteWidth);
+        const float spriteHeight = static_cast<float>(page.atlas->spriteHeight);
+
+        return TextureWindow{col * spriteWidth, (page.rows - row - 1) * spriteHeight, spriteWidth, spriteHeight};
+    }
+}
+
+size_t OutfitVariation::sizeInBytes() const noexcept
+{
+    size_t bytes = 0;
+    for (const auto &page : pages)
+    {
+        bytes += page.texture.sizeInBytes();
+    }
+
+    return bytes;
+}
+
+std::shared_ptr<const OutfitVariation> OutfitVariations::get(const CreatureType &creatureType)
+{
+    if (!creatureType.hasColoredOutfit())
+    {
+        return nullptr;
+    }
+
+    const Outfit &outfit = creatureType.outfit();
+
+    // Addons and mounts only select which of the sprites are drawn, so they do not need their own variation
+    uint64_t key = (static_cast<uint64_t>(outfit.look.type) << 32) | outfit.id();
+
+    auto found = variations.find(key);
+    if (found != variations.end())
+    {
+        if (auto variation = found->second.lock())
+        {
+            return variation;
+        }
+    }
+
+    pruneExpired();
+
+    auto variation = create(creatureType);
+    variations[key] = variation;
+
+    return variation;
+}
+
+std::shared_ptr<OutfitVariation> OutfitVariations::create(const CreatureType &creatureType)
+{
+    struct Sprite
+    {
+        uint32_t spriteId;
+        uint32_t templateSpriteId;
+    };
+
+    const FrameGroup &frameGroup = creatureType.frameGroup(0);
+    uint8_t postureCount = frameGroup.spriteInfo.patternDepth;
+    uint8_t addonCount = frameGroup.spriteInfo.patternHeight; // Includes "no addon (base outfit)"
+    uint8_t directionCount = frameGroup.spriteInfo.patternWidth;
+
+    // The sprites of each texture atlas end up in one page
+    std::vector<std::pair<TextureAtlas *, std::vector<Sprite>>> spritesByAtlas;
+    vme_unordered_set<uint32_t> spriteIds;
+
+    for (uint8_t postureType = 0; postureType < postureCount; ++postureType)
+    {
+        for (uint8_t addonType = 0; addonType < addonCount; ++addonType)
+        {
+            for (uint8_t direction = 0; direction < directionCount; ++direction)
+            {
+                uint32_t spriteIndex = creatureType.getIndex(frameGroup, postureType, addonType, direction);
+
+                // The color template is the layer after the sprite
+                uint32_t spriteId = frameGroup.getSpriteId(spriteIndex);
+                uint32_t templateSpriteId = frameGroup.getSpriteId(spriteIndex + 1);
+
+                if (!spriteIds.emplace(spriteId).second)
+                {
+                    continue;
+                }
+
+                TextureAtlas *atlas = creatureType.getTextureAtlas(spriteId);
+                auto found = std::find_if(spritesByAtlas.begin(), spritesByAtlas.end(), [atlas](const auto &entry) {
+                    return entry.first == atlas;
+                });
+
+                if (found == spritesByAtlas.end())
+                {
+                    spritesByAtlas.emplace_back(atlas, std::vector<Sprite>{});
+                    found = spritesByAtlas.end() - 1;
+                }
+
+                found->second.emplace_back(Sprite{spriteId, templateSpriteId});
+            }
+        }
+    }
+
+    const std::array<uint32_t, 4> colors = OutfitVariation::colors(creatureType.outfit().look);
+
+    std::shared_ptr<OutfitVariation> variation(new OutfitVariation());
+    variation->pages.reserve(spritesByAtlas.size());
+
+    for (const auto &[atlas, sprites] : spritesByAtlas)
+    {
+        // A square grid that is just large enough for the sprites
+        uint32_t spriteCount = static_cast<uint32_t>(sprites.size());
+        uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(spriteCount))));
+        uint32_t rows = (spriteCount + columns - 1) / columns;
+
+        uint32_t width = columns * atlas->spriteWidth;
+        std::vector<uint8_t> pixels(static_cast<size_t>(width) * rows * atlas->spriteHeight * 4, 0);
+
+        const Texture &source = atlas->getOrCreateTexture();
+
+        for (uint32_t i = 0; i < spriteCount; ++i)
+        {
+            const Sprite &sprite = sprites[i];
+
+            TextureAtlas *templateAtlas = creatureType.getTextureAtlas(sprite.templateSpriteId);
+            DEBUG_ASSERT(templateAtlas->spriteWidth == atlas->spriteWidth && templateAtlas->spriteHeight == atlas->spriteHeight, "The color template has a different sprite size.");
+
+            const Texture &templateTexture = templateAtlas->getOrCreateTexture();
+
+            const uint8_t *sourceSprite = source.pixels().data() + spriteOffset(atlas->width, atlas->columns, atlas->rows, sprite.spriteId - atlas->firstSpriteId, atlas->spriteWidth, atlas->spriteHeight);
+            const uint8_t *templateSprite = templateTexture.pixels().data() + spriteOffset(templateAtlas->width, templateAtlas->columns, templateAtlas->rows, sprite.templateSpriteId - templateAtlas->firstSpriteId, templateAtlas->spriteWidth, templateAtlas->spriteHeight);
+            uint8_t *targetSprite = pixels.data() + spriteOffset(width, columns, rows, i, atlas->spriteWidth, atlas->spriteHeight);
+
+            for (uint32_t y = 0; y < atlas->spriteHeight; ++y)
+            {
+                OutfitVariation::colorizeRow(targetSprite + 4 * static_cast<size_t>(y) * width,
+                                             sourceSprite + 4 * static_cast<size_t>(y) * atlas->width,
+                                             templateSprite + 4 * static_cast<size_t>(y) * templateAtlas->width,
+                                             atlas->spriteWidth,
+                                             colors);
+            }
+
+            variation->cells.emplace(sprite.spriteId, OutfitVariation::Cell{static_cast<uint16_t>(variation->pages.size()), static_cast<uint16_t>(i)});
+        }
+
+        OutfitVariation::Page &page = variation->pages.emplace_back(atlas, columns, rows, std::move(pixels));
+        page.texture.finalize();
+        TextureAtlasCache::variationAdded(page.texture.sizeInBytes());
+    }
+
+    return variation;
+}
+
+void OutfitVariations::pruneExpired()
+{
+    for (auto it = variations.begin(); it != variations.end();)
+    {
+        if (it->second.expired())
+        {
+            it = variations.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+size_t OutfitVariations::count() noexcept
+{
+    size_t result = 0;
+    for (const auto &[key, variation] : variations)
+    {
+        if (!variation.expired())
+        {
+            ++result;
+        }
+    }
+
+    return result;
+}
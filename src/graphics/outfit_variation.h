@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../outfit.h"
+#include "../util.h"
+#include "texture.h"
+#include "texture_atlas.h"
+
+class CreatureType;
+
+/*
+	The sprites of a creature outfit colored for the head, body, legs and feet colors of an Outfit::Look.
+
+	Only the colored sprites are stored. The sprites from each texture atlas are packed into a texture that is just
+	large enough to hold them, instead of copying the whole atlas. A variation is shared by every creature type
+	with the same looktype and colors (see OutfitVariations) and is released together with the last of them.
+*/
+class OutfitVariation
+{
+  public:
+    ~OutfitVariation();
+
+    OutfitVariation(const OutfitVariation &) = delete;
+    OutfitVariation &operator=(const OutfitVariation &) = delete;
+
+    /*
+		Points info, which shows spriteId in its texture atlas, at the colored copy of the sprite. Adjustments that
+		were made to an unnormalized window are kept. Returns false if the sprite is not part of the variation.
+	*/
+    bool apply(TextureInfo &info, uint32_t spriteId, TextureInfo::CoordinateType coordinateType) const;
+
+    size_t sizeInBytes() const noexcept;
+
+    /*
+		Writes source multiplied by the color that mask selects for every pixel. Yellow, red, green and blue mask
+		pixels select colors[0] to colors[3]; every other pixel is copied unchanged. All pixels are BGRA.
+	*/
+    static void colorizeRow(uint8_t *target, const uint8_t *source, const uint8_t *mask, size_t pixelCount, const std::array<uint32_t, 4> &colors);
+
+    // The head, body, legs and feet colors of look as BGRA, in the order that colorizeRow expects
+    static std::array<uint32_t, 4> colors(const Outfit::Look &look);
+
+  private:
+    friend class OutfitVariations;
+
+    // The colored sprites of one texture atlas
+    struct Page
+    {
+        Page(const TextureAtlas *atlas, uint32_t columns, uint32_t rows, std::vector<uint8_t> &&pixels);
+
+        const TextureAtlas *atlas;
+        uint32_t columns;
+        uint32_t rows;
+        Texture texture;
+    };
+
+    struct Cell
+    {
+        uint16_t page;
+        uint16_t index;
+    };
+
+    OutfitVariation() = default;
+
+    TextureWindow cellWindow(const Page &page, uint32_t index, TextureInfo::CoordinateType coordinateType) const;
+
+    std::vector<Page> pages;
+    vme_unordered_map<uint32_t, Cell> cells;
+};
+
+/*
+	Creates the outfit color variations of creature types and shares them between creature types with the same
+	looktype and colors. Only used from the main thread, like the texture atlases that the variations are colored
+	from.
+*/
+class OutfitVariations
+{
+  public:
+    /*
+		Returns the variation for the outfit of creatureType, coloring its sprites if no other creature type
+		holds it yet. Returns nullptr if the outfit does not use color templates.
+	*/
+    static std::shared_ptr<const OutfitVariation> get(const CreatureType &creatureType);
+
+    static size_t count() noexcept;
+
+  private:
+    static std::shared_ptr<OutfitVariation> create(const CreatureType &creatureType);
+
+    // Erases the entries of variations that were released by their last creature type
+    static void pruneExpired();
+
+    static vme_unordered_map<uint64_t, std::weak_ptr<OutfitVariation>> variations;
+};
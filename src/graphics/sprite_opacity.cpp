@@ -0,0 +1,265 @@
+#include "sprite_opacity.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#include "../debug.h"
+#include "../file.h"
+#include "../logger.h"
+#include "../mapped_file.h"
+#include "../thread_pool.h"
+#include "../time_util.h"
+#include "../util.h"
+#include "appearances.h"
+#include "atlas_disk_cache.h"
+#include "texture_atlas.h"
+
+namespace
+{
+    // Size of a map tile in pixels
+    constexpr uint32_t TileSize = 32;
+
+    constexpr std::array<char, 8> Magic = {'V', 'M', 'E', 'O', 'P', 'A', 'C', '\0'};
+
+    struct Header
+    {
+        std::array<char, 8> magic;
+        uint32_t formatVersion;
+        uint32_t atlasCount;
+    };
+
+    // Followed by the catalog file name of the atlas and spriteCount SpriteOpacity records
+    struct AtlasHeader
+    {
+        uint32_t nameLength;
+        uint32_t spriteCount;
+    };
+
+    static_assert(sizeof(Header) == 16);
+    static_assert(offsetof(Header, formatVersion) == SpriteOpacityCache::FormatVersionOffset);
+    static_assert(sizeof(AtlasHeader) == 8);
+
+    uint32_t spriteCount(const TextureAtlas &atlas)
+    {
+        return atlas.lastSpriteId - atlas.firstSpriteId + 1;
+    }
+} // namespace
+
+std::vector<SpriteOpacity> SpriteOpacity::analyze(const TextureAtlas &atlas, const std::vector<uint8_t> &pixels)
+{
+    DEBUG_ASSERT(pixels.size() >= atlas.sizeInBytes(), "Too few pixels for the TextureAtlas.");
+
+    const uint32_t spriteWidth = atlas.spriteWidth;
+    const uint32_t spriteHeight = atlas.spriteHeight;
+    const uint32_t quadrantWidth = spriteWidth / 2;
+    const uint32_t quadrantHeight = spriteHeight / 2;
+
+    std::vector<SpriteOpacity> result(spriteCount(atlas));
+
+    for (uint32_t i = 0; i < result.size(); ++i)
+    {
+        uint32_t left = (i % atlas.columns) * spriteWidth;
+        uint32_t top = (i / atlas.columns) * spriteHeight;
+
+        bool opaque = true;
+        bool coversTile = true;
+        uint8_t visibleQuadrants = 0;
+
+        uint32_t x0 = spriteWidth;
+        uint32_t y0 = spriteHeight;
+        uint32_t x1 = 0;
+        uint32_t y1 = 0;
+
+        for (uint32_t y = 0; y < spriteHeight; ++y)
+        {
+            // The texture is stored as a BMP, i.e. bottom-up. BGRA: alpha is the fourth byte.
+            const uint8_t *alpha = pixels.data() + 4 * (static_cast<size_t>(atlas.height - (top + y) - 1) * atlas.width + left) + 3;
+
+            for (uint32_t x = 0; x < spriteWidth; ++x)
+            {
+                uint8_t value = alpha[4 * x];
+                if (value != 0xFF)
+                {
+                    opaque = false;
+
+                    // Larger sprites extend up and to the left of their own tile
+                    if (x >= spriteWidth - TileSize && y >= spriteHeight - TileSize)
+                    {
+                        coversTile = false;
+                    }
+                }
+
+                if (value != 0)
+                {
+                    x0 = std::min(x0, x);
+                    y0 = std::min(y0, y);
+                    x1 = std::max(x1, x + 1);
+                    y1 = std::max(y1, y + 1);
+
+                    uint8_t quadrant = (x < quadrantWidth ? 0 : 1) + (y < quadrantHeight ? 0 : 2);
+                    visibleQuadrants |= static_cast<uint8_t>(1 << quadrant);
+                }
+            }
+        }
+
+        SpriteOpacity &opacity = result[i];
+        opacity.flags = (opaque ? Opaque : 0) | (coversTile ? CoversTile : 0);
+        opacity.transparentQuadrants = ~visibleQuadrants & (TopLeft | TopRight | BottomLeft | BottomRight);
+
+        if (x1 != 0)
+        {
+            opacity.x0 = static_cast<uint8_t>(x0);
+            opacity.y0 = static_cast<uint8_t>(y0);
+            opacity.x1 = static_cast<uint8_t>(x1);
+            opacity.y1 = static_cast<uint8_t>(y1);
+        }
+    }
+
+    return result;
+}
+
+size_t SpriteOpacityCache::load(const std::filesystem::path &cacheFile)
+{
+    std::vector<TextureAtlas *> atlases;
+    atlases.reserve(Appearances::textureAtlases.size());
+    for (const auto &[lastSpriteId, atlas] : Appearances::textureAtlases)
+    {
+        atlases.emplace_back(atlas.get());
+    }
+
+    return load(cacheFile, std::move(atlases));
+}
+
+size_t SpriteOpacityCache::load(const std::filesystem::path &cacheFile, std::vector<TextureAtlas *> atlases)
+{
+    TimePoint start;
+
+    // Keeps the cache file the same between runs
+    std::sort(atlases.begin(), atlases.end(), [](const TextureAtlas *a, const TextureAtlas *b) {
+        return a->firstSpriteId < b->firstSpriteId;
+    });
+
+    vme_unordered_map<std::string, std::pair<const uint8_t *, uint32_t>> cached;
+    std::optional<MappedFile> file = cacheFile.empty() ? std::nullopt : MappedFile::open(cacheFile);
+
+    if (file)
+    {
+        File::Cursor cursor(file->data(), file->size());
+
+        Header header;
+        if (cursor.read(&header, sizeof(Header)) && header.magic == Magic && header.formatVersion == FormatVersion)
+        {
+            for (uint32_t i = 0; i < header.atlasCount; ++i)
+            {
+                AtlasHeader atlasHeader;
+                std::string name;
+                if (!cursor.read(&atlasHeader, sizeof(AtlasHeader)))
+                {
+                    VME_LOG_ERROR("The sprite opacity cache " << cacheFile.string() << " is damaged.");
+                    break;
+                }
+
+                name.resize(atlasHeader.nameLength);
+                uint64_t dataSize = static_cast<uint64_t>(atlasHeader.spriteCount) * sizeof(SpriteOpacity);
+                const uint8_t *data = cursor.read(name.data(), name.size()) ? cursor.skip(dataSize) : nullptr;
+                if (!data)
+                {
+                    VME_LOG_ERROR("The sprite opacity cache " << cacheFile.string() << " is damaged.");
+                    break;
+                }
+
+                cached.emplace(std::move(name), std::make_pair(data, atlasHeader.spriteCount));
+            }
+        }
+        else
+        {
+            VME_LOG_D("Ignoring the outdated sprite opacity cache " << cacheFile.string());
+        }
+    }
+
+    std::vector<TextureAtlas *> stale;
+    for (TextureAtlas *atlas : atlases)
+    {
+        auto found = cached.find(atlas->sourceFile.string());
+        if (found == cached.end() || found->second.second != spriteCount(*atlas))
+        {
+            stale.emplace_back(atlas);
+            continue;
+        }
+
+        const auto [data, count] = found->second;
+        atlas->spriteOpacities.resize(count);
+        std::memcpy(atlas->spriteOpacities.data(), data, static_cast<size_t>(count) * sizeof(SpriteOpacity));
+    }
+
+    // The mapping is not needed once the summaries are copied
+    file.reset();
+
+    if (!stale.empty())
+    {
+        std::vector<std::vector<SpriteOpacity>> results(stale.size());
+
+        ThreadPool::parallelFor(stale.size(), [&stale, &results](size_t i) {
+            const TextureAtlas &atlas = *stale[i];
+
+            // Not written to the AtlasDiskCache: most atlases of the catalog are never drawn
+            std::vector<uint8_t> pixels;
+            if (auto cachedPixels = AtlasDiskCache::read(atlas.atlasFile))
+            {
+                pixels = std::move(*cachedPixels);
+            }
+            else
+            {
+                pixels = TextureAtlas::decompressPixels(File::read(atlas.atlasFile));
+            }
+
+            results[i] = SpriteOpacity::analyze(atlas, pixels);
+        });
+
+        for (size_t i = 0; i < stale.size(); ++i)
+        {
+            stale[i]->spriteOpacities = std::move(results[i]);
+        }
+
+        if (!cacheFile.empty())
+        {
+            write(cacheFile, atlases);
+        }
+    }
+
+    VME_LOG("Loaded the sprite opacities of " << atlases.size() << " texture atlases (" << stale.size() << " analyzed) in " << start.elapsedMillis() << " ms.");
+
+    return stale.size();
+}
+
+void SpriteOpacityCache::write(const std::filesystem::path &cacheFile, const std::vector<TextureAtlas *> &atlases)
+{
+    Header header;
+    header.magic = Magic;
+    header.formatVersion = FormatVersion;
+    header.atlasCount = static_cast<uint32_t>(atlases.size());
+
+    std::vector<uint8_t> buffer;
+    File::append(buffer, &header, sizeof(Header));
+
+    for (const TextureAtlas *atlas : atlases)
+    {
+        std::string name = atlas->sourceFile.string();
+
+        AtlasHeader atlasHeader;
+        atlasHeader.nameLength = static_cast<uint32_t>(name.size());
+        atlasHeader.spriteCount = static_cast<uint32_t>(atlas->spriteOpacities.size());
+
+        File::append(buffer, &atlasHeader, sizeof(AtlasHeader));
+        File::append(buffer, name.data(), name.size());
+        File::append(buffer, atlas->spriteOpacities.data(), atlas->spriteOpacities.size() * sizeof(SpriteOpacity));
+    }
+
+    if (auto error = File::writeAtomically(cacheFile, buffer))
+    {
+        VME_LOG_ERROR("Could not write the sprite opacity cache " << cacheFile.string() << ": " << error.message());
+    }
+}
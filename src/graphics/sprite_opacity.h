@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+struct TextureAtlas;
+
+/*
+	A summary of the alpha channel of one sprite. It is small enough to be kept for every sprite of the catalog, so
+	the renderer and the GUI can answer opacity questions without decompressing the atlas of the sprite.
+*/
+struct SpriteOpacity
+{
+    enum Flag : uint8_t
+    {
+        // Every pixel of the sprite is opaque
+        Opaque = 1 << 0,
+        // The part of the sprite that is drawn on its own tile (the bottom-right 32x32 pixels) is opaque
+        CoversTile = 1 << 1
+    };
+
+    enum Quadrant : uint8_t
+    {
+        TopLeft = 1 << 0,
+        TopRight = 1 << 1,
+        BottomLeft = 1 << 2,
+        BottomRight = 1 << 3
+    };
+
+    uint8_t flags = 0;
+
+    // The quadrants without any visible pixel
+    uint8_t transparentQuadrants = 0;
+
+    // Bounds of the visible pixels, from the top-left corner of the sprite. x1 and y1 are exclusive.
+    uint8_t x0 = 0;
+    uint8_t y0 = 0;
+    uint8_t x1 = 0;
+    uint8_t y1 = 0;
+
+    bool opaque() const noexcept
+    {
+        return flags & Opaque;
+    }
+
+    bool coversTile() const noexcept
+    {
+        return flags & CoversTile;
+    }
+
+    bool empty() const noexcept
+    {
+        return x1 <= x0;
+    }
+
+    bool transparent(Quadrant quadrant) const noexcept
+    {
+        return transparentQuadrants & quadrant;
+    }
+
+    /*
+		Summarizes every sprite of an atlas from its BMP pixel data. Does not touch the atlas state, so it is safe to
+		call from any thread.
+	*/
+    static std::vector<SpriteOpacity> analyze(const TextureAtlas &atlas, const std::vector<uint8_t> &pixels);
+};
+
+static_assert(sizeof(SpriteOpacity) == 6);
+
+/*
+	Computes the SpriteOpacity of every sprite in the catalog at load time and keeps the result on disk.
+
+	The cache file stores the summaries of each atlas under the file name that the catalog lists for it. The catalog
+	names atlas files after a hash of their contents, so the summaries of a changed atlas are not reused. Atlases
+	that are missing from the cache are analyzed in parallel and the cache file is rewritten.
+
+	FormatVersion must be increased whenever SpriteOpacity or its computation changes.
+*/
+class SpriteOpacityCache
+{
+  public:
+    /*
+		Gives every texture atlas of the catalog its sprite opacities. Must run after the catalog is loaded and
+		before the sprite opacities are first used. An empty cacheFile computes every summary without reading or
+		writing a cache. Returns the number of atlases that were analyzed.
+	*/
+    static size_t load(const std::filesystem::path &cacheFile);
+
+    // Like load, for the given atlases only. If any atlas is analyzed, the cache file is rewritten with just these.
+    static size_t load(const std::filesystem::path &cacheFile, std::vector<TextureAtlas *> atlases);
+
+    static constexpr uint32_t FormatVersion = 1;
+    // Byte offset of the format version in the cache file
+    static constexpr size_t FormatVersionOffset = 8;
+
+  private:
+    static void write(const std::filesystem::path &cacheFile, const std::vector<TextureAtlas *> &atlases);
+};
@@ -21,6 +21,9 @@ enum class SolidColor : uint32_t
 
     // https://materialui.co/colors
     MaterialUIBlue600 = 0xFF1E88E5,
+
+    // Drawn in place of sprites whose texture atlas is still being decompressed
+    Placeholder = 0x40808080,
 };
 
 struct TextureWindow
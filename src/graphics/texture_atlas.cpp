@@ -13,6 +13,7 @@
 #include "../file.h"
 #include "../logger.h"
 #include "../position.h"
+#include "atlas_disk_cache.h"
 #include "compression.h"
 
 namespace
@@ -26,8 +27,8 @@ namespace
     constexpr uint32_t OFFSET_OF_BMP_START_OFFSET = 10;
 } // namespace
 
-TextureAtlas::TextureAtlas(LZMACompressedBuffer &&buffer, uint32_t width, uint32_t height, uint32_t firstSpriteId, uint32_t lastSpriteId, SpriteLayout spriteLayout, std::filesystem::path sourceFile)
-    : sourceFile(sourceFile), width(width), height(height), firstSpriteId(firstSpriteId), lastSpriteId(lastSpriteId), texture(std::move(buffer))
+TextureAtlas::TextureAtlas(std::filesystem::path atlasFile, uint32_t width, uint32_t height, uint32_t firstSpriteId, uint32_t lastSpriteId, SpriteLayout spriteLayout, std::filesystem::path sourceFile)
+    : sourceFile(sourceFile), width(width), height(height), firstSpriteId(firstSpriteId), lastSpriteId(lastSpriteId), atlasFile(std::move(atlasFile))
 {
     switch (spriteLayout)
     {
@@ -120,86 +121,6 @@ const TextureWindow TextureAtlas::getTextureWindow(uint32_t spriteId, TextureInf
     }
 }
 
-const TextureWindow TextureAtlas::getTextureWindow(uint32_t spriteId, uint32_t variationId, TextureInfo::CoordinateType coordinateType) const
-{
-    // TODO Implement?
-    ABORT_PROGRAM("Not implemented.");
-}
-
-void TextureAtlas::overlay(TextureAtlas *templateAtlas, uint32_t variationId, uint32_t templateSpriteId, uint32_t targetSpriteId, Outfit::Look look)
-{
-    DEBUG_ASSERT(templateAtlas->width == width, "Inconsistent atlas widths.");
-    auto const [templateX, templateY] = templateAtlas->textureOffset(templateSpriteId);
-    auto const [targetX, targetY] = textureOffset(targetSpriteId);
-
-    auto atlasWidth = templateAtlas->width;
-
-    const auto &templateTexture = templateAtlas->getOrCreateTexture();
-    auto &targetTexture = getVariation(variationId)->texture;
-
-    DEBUG_ASSERT(!targetTexture.finalized(), "Target texture is finalized.");
-
-    auto head = Creatures::getColorFromLookupTable(look.head());
-    auto body = Creatures::getColorFromLookupTable(look.body());
-    auto legs = Creatures::getColorFromLookupTable(look.legs());
-    auto feet = Creatures::getColorFromLookupTable(look.feet());
-
-    for (int y = targetY; y < targetY + spriteHeight; ++y)
-    {
-        int ty = templateY + y - targetY;
-        for (int x = targetX; x < targetX + spriteWidth; ++x)
-        {
-            int tx = templateX + x - targetX;
-
-            auto pixel = templateTexture.getPixel(tx, ty);
-            if (pixel == Pixels::Yellow)
-            {
-                targetTexture.multiplyPixel(x, y, head);
-            }
-            else if (pixel == Pixels::Red)
-            {
-                targetTexture.multiplyPixel(x, y, body);
-            }
-            else if (pixel == Pixels::Green)
-            {
-                targetTexture.multiplyPixel(x, y, legs);
-            }
-            else if (pixel == Pixels::Blue)
-            {
-                targetTexture.multiplyPixel(x, y, feet);
-            }
-            else if (pixel == Pixels::Magenta)
-            {
-                // Magenta
-            }
-            else
-            {
-                VME_LOG_D(std::format("{},{}: {},{},{},{}", tx, ty, pixel.r(), pixel.g(), pixel.b(), pixel.a()));
-            }
-        }
-    }
-}
-
-TextureAtlasVariation *TextureAtlas::getVariation(uint32_t id)
-{
-    if (!variations)
-    {
-        variations = std::make_unique<std::vector<TextureAtlasVariation>>();
-    }
-
-    auto found = std::find_if(variations->begin(), variations->end(), [id](const auto &variation) {
-        return variation.id == id;
-    });
-
-    if (found != variations->end())
-    {
-        return &(*found);
-    }
-
-    auto &variation = variations->emplace_back(id, getOrCreateTexture().deepCopy());
-    return &variation;
-}
-
 std::pair<int, int> TextureAtlas::textureOffset(uint32_t spriteId)
 {
     int spriteIndex = spriteId - firstSpriteId;
@@ -260,7 +181,7 @@ uint32_t readU32(std::vector<uint8_t> &buffer, uint32_t offset)
     return value;
 }
 
-void TextureAtlas::validateBmp(std::vector<uint8_t> &decompressed) const
+void TextureAtlas::validateBmp(std::vector<uint8_t> &decompressed)
 {
     uint32_t width = readU32(decompressed, 0x12);
     if (width != TextureAtlasSize.width)
@@ -294,55 +215,115 @@ void TextureAtlas::validateBmp(std::vector<uint8_t> &decompressed) const
 
 Texture *TextureAtlas::getTexture()
 {
-    return std::holds_alternative<Texture>(texture) ? &std::get<Texture>(texture) : nullptr;
+    return texture ? &*texture : nullptr;
 }
 
 bool TextureAtlas::isCompressed() const
 {
-    return std::holds_alternative<LZMACompressedBuffer>(texture);
+    return !texture.has_value();
 }
 
 void TextureAtlas::decompressTexture() const
 {
-    DEBUG_ASSERT(std::holds_alternative<LZMACompressedBuffer>(texture), "Tried to decompress a TextureAtlas that does not contain CompressedBytes.");
+    DEBUG_ASSERT(!texture, "Tried to decompress a TextureAtlas that is already decompressed.");
 
-    std::vector<uint8_t> decompressed = LZMA::decompress(std::move(std::get<LZMACompressedBuffer>(this->texture).buffer));
+    if (pendingDecompression)
+    {
+        installTexture(pendingDecompression->takePixels());
+        return;
+    }
+
+    installTexture(loadPixels(atlasFile));
+}
+
+std::vector<uint8_t> TextureAtlas::decompressPixels(std::vector<uint8_t> &&compressed)
+{
+    std::vector<uint8_t> decompressed = LZMA::decompress(std::move(compressed));
     validateBmp(decompressed);
 
     uint32_t offset;
     std::memcpy(&offset, decompressed.data() + OFFSET_OF_BMP_START_OFFSET, sizeof(uint32_t));
 
-    texture = Texture(this->width, this->height, std::vector<uint8_t>(decompressed.begin() + offset, decompressed.end()));
+    return std::vector<uint8_t>(decompressed.begin() + offset, decompressed.end());
+}
+
+std::vector<uint8_t> TextureAtlas::loadPixels(const std::filesystem::path &atlasFile)
+{
+    if (auto cached = AtlasDiskCache::read(atlasFile))
+    {
+        return std::move(*cached);
+    }
+
+    std::vector<uint8_t> pixels = decompressPixels(File::read(atlasFile));
+    AtlasDiskCache::write(atlasFile, pixels);
+
+    return pixels;
 }
 
-Texture &TextureAtlas::getTexture(uint32_t variationId)
+void TextureAtlas::installTexture(std::vector<uint8_t> &&pixels) const
 {
-    if (!variations)
+    // Texture ids are assigned here, so this must run on the main thread.
+    texture.emplace(this->width, this->height, std::move(pixels));
+    pendingDecompression.reset();
+
+    // An atlas decompressed again after an eviction keeps its id, so renderers can reuse their slot for it.
+    if (textureId)
+    {
+        texture->_id = *textureId;
+    }
+    else
     {
-        ABORT_PROGRAM("No variations.");
+        textureId = texture->id();
     }
 
-    auto found = std::find_if(variations->begin(), variations->end(), [variationId](const auto &variation) {
-        return variation.id == variationId;
-    });
+    lastUsedFrame = TextureAtlasCache::frame;
+    TextureAtlasCache::added(*this);
+}
+
+std::shared_ptr<PendingDecompression> TextureAtlas::startDecompression() const
+{
+    DEBUG_ASSERT(isCompressed() && !pendingDecompression, "The TextureAtlas is already decompressed or being decompressed.");
+
+    pendingDecompression = std::make_shared<PendingDecompression>(atlasFile);
+    return pendingDecompression;
+}
+
+bool TextureAtlas::decompressionPending() const noexcept
+{
+    return pendingDecompression != nullptr;
+}
 
-    if (found == variations->end())
+bool TextureAtlas::finishDecompression() const
+{
+    if (!pendingDecompression || !pendingDecompression->finished())
     {
-        ABORT_PROGRAM(std::format("The TextureAtlas did not have a Texture variation with id '{}'", variationId));
+        return false;
     }
 
-    auto &result = (*found).texture;
-    return result;
+    installTexture(pendingDecompression->takePixels());
+    return true;
+}
+
+uint32_t TextureAtlas::evict() const
+{
+    DEBUG_ASSERT(texture.has_value(), "Tried to evict a TextureAtlas that is not decompressed.");
+
+    texture.reset();
+    return *textureId;
 }
 
 Texture &TextureAtlas::getOrCreateTexture() const
 {
-    if (std::holds_alternative<LZMACompressedBuffer>(texture))
+    if (texture)
+    {
+        TextureAtlasCache::hit(*this);
+    }
+    else
     {
         decompressTexture();
     }
 
-    return std::get<Texture>(this->texture);
+    return *texture;
 }
 
 Texture &TextureAtlas::getOrCreateTexture()
@@ -368,29 +349,77 @@ WorldPosition TextureAtlas::worldPosOffset() const noexcept
     return WorldPosition(drawOffset.x * SPRITE_SIZE, drawOffset.y * SPRITE_SIZE);
 }
 
-bool TextureAtlas::hasColorVariation(uint32_t variationId) const
+const SpriteOpacity &TextureAtlas::spriteOpacity(uint32_t spriteId) const
 {
-    if (!variations)
-        return false;
+    DEBUG_ASSERT(firstSpriteId <= spriteId && spriteId <= lastSpriteId, "The TextureAtlas does not contain that sprite ID.");
 
-    auto found = std::find_if(variations->begin(), variations->end(), [variationId](const auto &variation) {
-        return variation.id == variationId;
-    });
+    if (spriteOpacities.empty())
+    {
+        spriteOpacities = SpriteOpacity::analyze(*this, getOrCreateTexture().pixels());
+    }
 
-    return found != variations->end();
+    return spriteOpacities[spriteId - firstSpriteId];
 }
 
-TextureAtlasVariation::TextureAtlasVariation(uint32_t id, Texture texture)
-    : id(id), texture(texture)
+bool TextureAtlas::hasSpriteOpacity() const noexcept
 {
+    return !spriteOpacities.empty();
 }
 
-const Texture &TextureInfo::getTexture() const
+bool TextureAtlas::coversTile(uint32_t spriteId) const
 {
-    return atlas->getOrCreateTexture();
+    return spriteOpacity(spriteId).coversTile();
 }
 
-const Texture &TextureInfo::getTexture(uint32_t textureVariationId) const
+PendingDecompression::PendingDecompression(std::filesystem::path atlasFile)
+    : atlasFile(std::move(atlasFile)) {}
+
+void PendingDecompression::run()
+{
+    if (claimed.exchange(true))
+    {
+        return;
+    }
+
+    try
+    {
+        pixels = TextureAtlas::loadPixels(atlasFile);
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        _finished = true;
+    }
+    finishedCondition.notify_all();
+}
+
+bool PendingDecompression::finished() const noexcept
+{
+    return _finished;
+}
+
+std::vector<uint8_t> PendingDecompression::takePixels()
+{
+    run();
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        finishedCondition.wait(lock, [this] { return _finished.load(); });
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+
+    return std::move(pixels);
+}
+
+const Texture &TextureInfo::getTexture() const
 {
-    return atlas->getTexture(textureVariationId);
+    return variation ? *variation : atlas->getOrCreateTexture();
 }
\ No newline at end of file
@@ -1,7 +1,12 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <exception>
 #include <filesystem>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <tuple>
 #include <utility>
 #include <variant>
@@ -9,7 +14,9 @@
 #include "../const.h"
 #include "../outfit.h"
 #include "compression.h"
+#include "sprite_opacity.h"
 #include "texture.h"
+#include "texture_atlas_cache.h"
 
 struct TextureAtlas;
 struct WorldPosition;
@@ -34,8 +41,10 @@ struct TextureInfo
     TextureAtlas *atlas;
     TextureWindow window;
 
+    // Set when the window points into the colored sprites of an OutfitVariation instead of the atlas
+    const Texture *variation = nullptr;
+
     const Texture &getTexture() const;
-    const Texture &getTexture(uint32_t textureVariationId) const;
 };
 
 struct DrawOffset
@@ -44,23 +53,45 @@ struct DrawOffset
     int y;
 };
 
-struct LZMACompressedBuffer
+/*
+	The decompression of a TextureAtlas that was handed to a worker thread (see AtlasDecompressor). Whichever
+	thread claims it first loads the pixels of the atlas file; a thread that needs the result while another
+	one is working waits for it.
+*/
+struct PendingDecompression
 {
-    std::vector<uint8_t> buffer;
-};
+    explicit PendingDecompression(std::filesystem::path atlasFile);
 
-struct TextureAtlasVariation
-{
-    TextureAtlasVariation(uint32_t id, Texture texture);
+    // Loads the atlas pixels unless another thread already claimed the work.
+    void run();
+
+    bool finished() const noexcept;
+
+    /*
+		Runs the decompression on the calling thread if no worker has started it yet, otherwise waits for the
+		worker. Rethrows errors from the decompression.
+	*/
+    std::vector<uint8_t> takePixels();
 
-    uint32_t id;
-    Texture texture;
+  private:
+    std::filesystem::path atlasFile;
+    std::vector<uint8_t> pixels;
+    std::exception_ptr error;
+
+    std::atomic<bool> claimed = false;
+    std::atomic<bool> _finished = false;
+    std::mutex mutex;
+    std::condition_variable finishedCondition;
 };
 
 struct TextureAtlas
 {
   public:
-    TextureAtlas(LZMACompressedBuffer &&buffer, uint32_t width, uint32_t height, uint32_t firstSpriteId, uint32_t lastSpriteId, SpriteLayout spriteLayout, std::filesystem::path sourceFile);
+    /*
+		The atlas file is not read until the texture is needed. sourceFile is the file name as listed in the
+		catalog, atlasFile its location on disk.
+	*/
+    TextureAtlas(std::filesystem::path atlasFile, uint32_t width, uint32_t height, uint32_t firstSpriteId, uint32_t lastSpriteId, SpriteLayout spriteLayout, std::filesystem::path sourceFile);
 
     std::filesystem::path sourceFile;
 
@@ -78,16 +109,9 @@ struct TextureAtlas
 
     DrawOffset drawOffset;
 
-    TextureAtlasVariation *getVariation(uint32_t id);
-
     std::pair<int, int> textureOffset(uint32_t spriteId);
 
-    bool hasColorVariation(uint32_t variationId) const;
-
-    void overlay(TextureAtlas *templateAtlas, uint32_t variationId, uint32_t templateSpriteId, uint32_t targetSpriteId, Outfit::Look look);
-
     glm::vec4 getFragmentBounds(const TextureWindow window) const;
-    const TextureWindow getTextureWindow(uint32_t spriteId, uint32_t variationId, TextureInfo::CoordinateType coordinateType = TextureInfo::CoordinateType::Normalized) const;
     const TextureWindow getTextureWindow(uint32_t spriteId, TextureInfo::CoordinateType coordinateType = TextureInfo::CoordinateType::Normalized) const;
     const TextureWindow getTextureWindowTopLeft(uint32_t spriteId) const;
     const std::pair<TextureWindow, TextureWindow> getTextureWindowTopLeftBottomRight(uint32_t spriteId) const;
@@ -102,10 +126,47 @@ struct TextureAtlas
 
     WorldPosition worldPosOffset() const noexcept;
 
+    /*
+		Returns the opacity summary of a sprite. Decompresses the atlas unless SpriteOpacityCache already provided
+		the summaries of the atlas.
+	*/
+    const SpriteOpacity &spriteOpacity(uint32_t spriteId) const;
+
+    // True if the sprite opacities are known without decompressing the atlas
+    bool hasSpriteOpacity() const noexcept;
+
+    /*
+		Returns true if the part of the sprite that is drawn on its own tile (the bottom-right 32x32 pixels) is
+		fully opaque.
+	*/
+    bool coversTile(uint32_t spriteId) const;
+
     void decompressTexture() const;
+
+    /*
+		Creates a PendingDecompression of the atlas file that can be run on another thread. The atlas stays
+		compressed until finishDecompression or decompressTexture installs the result.
+	*/
+    std::shared_ptr<PendingDecompression> startDecompression() const;
+    bool decompressionPending() const noexcept;
+
+    // Installs the result of a finished PendingDecompression. Returns false if it has not finished yet.
+    bool finishDecompression() const;
+
+    /*
+		Decompresses atlas file data into BMP pixel data. Does not touch any TextureAtlas, so it is safe to call
+		from any thread.
+	*/
+    static std::vector<uint8_t> decompressPixels(std::vector<uint8_t> &&compressed);
+
+    /*
+		Returns the BMP pixel data of an atlas file. The pixels are taken from the AtlasDiskCache if it has them,
+		otherwise the file is decompressed and the result is stored in the cache. Safe to call from any thread.
+	*/
+    static std::vector<uint8_t> loadPixels(const std::filesystem::path &atlasFile);
+
     Texture *getTexture();
     Texture &getOrCreateTexture();
-    Texture &getTexture(uint32_t variationId);
 
   private:
     Texture &getOrCreateTexture() const;
@@ -119,9 +180,37 @@ struct TextureAtlas
     };
 
     InternalTextureInfo internalTextureInfoNormalized(uint32_t spriteId) const;
-    void validateBmp(std::vector<uint8_t> &decompressed) const;
+    static void validateBmp(std::vector<uint8_t> &decompressed);
+    void installTexture(std::vector<uint8_t> &&pixels) const;
 
-    mutable std::variant<LZMACompressedBuffer, Texture> texture;
+    friend class TextureAtlasCache;
+    friend class SpriteOpacityCache;
+    friend class GUIImageCache;
 
-    mutable std::unique_ptr<std::vector<TextureAtlasVariation>> variations;
+    // Returns the id of the evicted texture
+    uint32_t evict() const;
+
+    /*
+		The compressed atlas file. It is read (or its pixels are taken from the AtlasDiskCache) every time the atlas
+		is decompressed, so the compressed data of the whole catalog is never held in memory. An evicted atlas is
+		read again from disk.
+	*/
+    std::filesystem::path atlasFile;
+    mutable std::optional<Texture> texture;
+
+    // Id of the first texture created for this atlas. Reused when the atlas is decompressed after an eviction.
+    mutable std::optional<uint32_t> textureId;
+    mutable uint64_t lastUsedFrame = 0;
+
+    // Set while the compressed data is being decompressed on a worker thread
+    mutable std::shared_ptr<PendingDecompression> pendingDecompression;
+
+    // Index is (spriteId - firstSpriteId)
+    mutable std::vector<SpriteOpacity> spriteOpacities;
 };
+
+inline void TextureAtlasCache::hit(const TextureAtlas &atlas) noexcept
+{
+    ++_statistics.hits;
+    atlas.lastUsedFrame = frame;
+}
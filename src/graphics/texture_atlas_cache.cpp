@@ -0,0 +1,127 @@
+#include "texture_atlas_cache.h"
+
+#include <algorithm>
+
+#include "../logger.h"
+#include "../settings.h"
+#include "atlas_disk_cache.h"
+#include "texture_atlas.h"
+
+std::vector<const TextureAtlas *> TextureAtlasCache::resident;
+std::vector<const TextureAtlasCache::RendererFrames *> TextureAtlasCache::renderers;
+uint64_t TextureAtlasCache::frame = 1;
+TextureAtlasCache::Statistics TextureAtlasCache::_statistics;
+Nano::Signal<void(uint32_t)> TextureAtlasCache::textureEvicted;
+
+TextureAtlasCache::RendererFrames::RendererFrames()
+{
+    TextureAtlasCache::renderers.emplace_back(this);
+}
+
+TextureAtlasCache::RendererFrames::~RendererFrames()
+{
+    auto &renderers = TextureAtlasCache::renderers;
+    renderers.erase(std::remove(renderers.begin(), renderers.end(), this), renderers.end());
+}
+
+uint64_t TextureAtlasCache::protectedFrame() noexcept
+{
+    uint64_t oldest = frame;
+    for (const RendererFrames *renderer : renderers)
+    {
+        // A renderer that has drawn a single frame has no previous frame
+        uint64_t start = renderer->previous != 0 ? renderer->previous : renderer->current;
+        if (start != 0)
+        {
+            oldest = std::min(oldest, start);
+        }
+    }
+
+    return oldest;
+}
+
+void TextureAtlasCache::beginFrame(RendererFrames &renderer)
+{
+    ++frame;
+    renderer.previous = renderer.current;
+    renderer.current = frame;
+
+    size_t budget = Settings::TEXTURE_ATLAS_MEMORY_BUDGET;
+    if (_statistics.residentBytes <= budget)
+    {
+        return;
+    }
+
+    std::sort(resident.begin(), resident.end(), [](const TextureAtlas *a, const TextureAtlas *b) {
+        return a->lastUsedFrame < b->lastUsedFrame;
+    });
+
+    uint64_t oldestProtected = protectedFrame();
+
+    size_t evicted = 0;
+    while (evicted < resident.size() && _statistics.residentBytes > budget)
+    {
+        const TextureAtlas *atlas = resident[evicted];
+
+        // The remaining atlases were used even more recently
+        if (atlas->lastUsedFrame >= oldestProtected)
+        {
+            break;
+        }
+
+        uint32_t textureId = atlas->evict();
+        _statistics.residentBytes -= atlas->sizeInBytes();
+        ++_statistics.evictions;
+        ++evicted;
+
+        textureEvicted.fire(textureId);
+    }
+
+    resident.erase(resident.begin(), resident.begin() + evicted);
+    _statistics.residentAtlases = resident.size();
+}
+
+void TextureAtlasCache::added(const TextureAtlas &atlas)
+{
+    resident.emplace_back(&atlas);
+
+    ++_statistics.misses;
+    _statistics.residentBytes += atlas.sizeInBytes();
+    _statistics.residentAtlases = resident.size();
+}
+
+void TextureAtlasCache::variationAdded(size_t bytes) noexcept
+{
+    _statistics.variationBytes += bytes;
+}
+
+void TextureAtlasCache::variationRemoved(size_t bytes, uint32_t textureId)
+{
+    _statistics.variationBytes -= bytes;
+    textureEvicted.fire(textureId);
+}
+
+const TextureAtlasCache::Statistics &TextureAtlasCache::statistics() noexcept
+{
+    return _statistics;
+}
+
+void TextureAtlasCache::logStatistics()
+{
+    constexpr size_t MegaByte = 1024 * 1024;
+
+    VME_LOG("Texture atlases: " << _statistics.residentAtlases << " decompressed ("
+                                << _statistics.residentBytes / MegaByte << " MB, budget "
+                                << Settings::TEXTURE_ATLAS_MEMORY_BUDGET / MegaByte << " MB), "
+                                << _statistics.variationBytes / MegaByte << " MB outfit variations, "
+                                << _statistics.hits << " hits, "
+                                << _statistics.misses << " misses, "
+                                << _statistics.evictions << " evictions.");
+
+    if (AtlasDiskCache::isOpen())
+    {
+        auto diskCache = AtlasDiskCache::statistics();
+        VME_LOG("Texture atlas disk cache: " << diskCache.hits << " hits, " << diskCache.misses << " misses, "
+                                             << diskCache.writeFailures << " failed writes.");
+    }
+}
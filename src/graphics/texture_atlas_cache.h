@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../signal.h"
+
+struct TextureAtlas;
+
+/*
+	Keeps the memory used by decompressed texture atlases within Settings::TEXTURE_ATLAS_MEMORY_BUDGET.
+
+	Every renderer has its own RendererFrames. Each frame it begins advances a shared frame counter, and every
+	access to the texture of an atlas stamps the atlas with that counter. When the decompressed atlases exceed the
+	budget at the start of a frame, the least recently used ones are evicted. Atlases used in the current or previous
+	frame of any renderer are never evicted, so textures referenced by a frame that is being drawn stay valid, no
+	matter how many other renderers (map tabs, the map tile exporter) drew in between. An evicted atlas reads and
+	decompresses its file again the next time it is needed and keeps its texture id.
+
+	Outfit color variations (see OutfitVariation) cannot be recreated by the atlas itself, so they are not evicted
+	and not counted against the budget. They are released when the last creature type that uses them is gone.
+
+	Only used from the main thread, like the textures of the atlases.
+*/
+class TextureAtlasCache
+{
+  public:
+    struct Statistics
+    {
+        // Texture accesses that found the atlas decompressed
+        uint64_t hits = 0;
+        // Decompressions, including those of previously evicted atlases
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+
+        size_t residentAtlases = 0;
+        size_t residentBytes = 0;
+        size_t variationBytes = 0;
+    };
+
+    /*
+		The frames of one renderer. Registered with the cache for as long as it exists.
+	*/
+    class RendererFrames
+    {
+      public:
+        RendererFrames();
+        ~RendererFrames();
+
+        RendererFrames(const RendererFrames &) = delete;
+        RendererFrames &operator=(const RendererFrames &) = delete;
+
+      private:
+        friend class TextureAtlasCache;
+
+        uint64_t current = 0;
+        uint64_t previous = 0;
+    };
+
+    /*
+		Starts a new frame of the renderer and evicts atlases until the cache fits in the budget.
+	*/
+    static void beginFrame(RendererFrames &renderer);
+
+    static const Statistics &statistics() noexcept;
+    static void logStatistics();
+
+    /*
+		Fired with the texture id of every evicted atlas and released outfit variation. Renderers release the
+		matching GPU resources.
+	*/
+    static Nano::Signal<void(uint32_t)> textureEvicted;
+
+  private:
+    friend struct TextureAtlas;
+    friend class OutfitVariation;
+    friend class OutfitVariations;
+
+    // Atlases stamped with this frame or later were used in the current or previous frame of a renderer
+    static uint64_t protectedFrame() noexcept;
+
+    static inline void hit(const TextureAtlas &atlas) noexcept;
+    static void added(const TextureAtlas &atlas);
+    static void variationAdded(size_t bytes) noexcept;
+    static void variationRemoved(size_t bytes, uint32_t textureId);
+
+    static std::vector<const TextureAtlas *> resident;
+    static std::vector<const RendererFrames *> renderers;
+    static uint64_t frame;
+    static Statistics _statistics;
+};
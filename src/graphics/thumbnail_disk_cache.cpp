@@ -0,0 +1,296 @@
+#include "thumbnail_disk_cache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <system_error>
+
+#include "../debug.h"
+#include "../file.h"
+#include "../logger.h"
+
+namespace
+{
+    constexpr std::array<char, 8> Magic = {'V', 'M', 'E', 'T', 'H', 'M', 'B', '\0'};
+
+    // Followed by recordCount records sorted by key, then the pixels of every thumbnail
+    struct Header
+    {
+        std::array<char, 8> magic;
+        uint32_t formatVersion;
+        uint32_t recordCount;
+        std::array<char, 32> clientVersion;
+    };
+
+    static_assert(sizeof(Header) == ThumbnailDiskCache::HeaderSize);
+    static_assert(offsetof(Header, formatVersion) == ThumbnailDiskCache::FormatVersionOffset);
+
+    size_t pixelBytes(uint16_t width, uint16_t height)
+    {
+        return static_cast<size_t>(width) * height * 4;
+    }
+} // namespace
+
+ThumbnailDiskCache::ThumbnailDiskCache(std::filesystem::path file, const std::string &clientVersion)
+    : file(std::move(file))
+{
+    size_t length = std::min(clientVersion.size(), this->clientVersion.size());
+    std::copy_n(clientVersion.begin(), length, this->clientVersion.begin());
+
+    map();
+}
+
+void ThumbnailDiskCache::map()
+{
+    records = nullptr;
+    recordCount = 0;
+    mapping.reset();
+
+    std::optional<MappedFile> opened = MappedFile::open(file);
+    if (!opened)
+    {
+        return;
+    }
+    mapping = std::make_shared<const MappedFile>(std::move(*opened));
+
+    Header header;
+    if (mapping->size() < sizeof(Header))
+    {
+        mapping.reset();
+        return;
+    }
+    std::memcpy(&header, mapping->data(), sizeof(Header));
+
+    if (header.magic != Magic || header.formatVersion != FormatVersion || header.clientVersion != clientVersion)
+    {
+        VME_LOG_D("Ignoring the outdated thumbnail cache " << file.string());
+        mapping.reset();
+        return;
+    }
+
+    if (header.recordCount > (mapping->size() - sizeof(Header)) / sizeof(Record))
+    {
+        VME_LOG_ERROR("The thumbnail cache " << file.string() << " is damaged.");
+        mapping.reset();
+        return;
+    }
+
+    size_t recordsEnd = sizeof(Header) + static_cast<size_t>(header.recordCount) * sizeof(Record);
+
+    const Record *first = reinterpret_cast<const Record *>(mapping->data() + sizeof(Header));
+    for (uint32_t i = 0; i < header.recordCount; ++i)
+    {
+        // Compared without adding to offset, which a damaged file can set to any value
+        const Record &record = first[i];
+        if (record.offset < recordsEnd || record.offset > mapping->size() || pixelBytes(record.width, record.height) > mapping->size() - record.offset)
+        {
+            VME_LOG_ERROR("The thumbnail cache " << file.string() << " is damaged.");
+            mapping.reset();
+            return;
+        }
+    }
+
+    records = first;
+    recordCount = header.recordCount;
+}
+
+const ThumbnailDiskCache::Record *ThumbnailDiskCache::findRecord(uint64_t key) const
+{
+    const Record *end = records + recordCount;
+    const Record *found = std::lower_bound(records, end, key, [](const Record &record, uint64_t key) { return record.key < key; });
+
+    return found != end && found->key == key ? found : nullptr;
+}
+
+std::optional<ThumbnailDiskCache::Thumbnail> ThumbnailDiskCache::find(uint64_t key, uint64_t sourceHash) const
+{
+    auto added = unsaved.find(key);
+    if (added != unsaved.end())
+    {
+        const Unsaved &thumbnail = added->second;
+        if (thumbnail.sourceHash != sourceHash)
+        {
+            return std::nullopt;
+        }
+
+        return Thumbnail{thumbnail.pixels.data(), thumbnail.width, thumbnail.height};
+    }
+
+    if (saving)
+    {
+        auto beingSaved = saving->find(key);
+        if (beingSaved != saving->end())
+        {
+            const Unsaved &thumbnail = beingSaved->second;
+            if (thumbnail.sourceHash != sourceHash)
+            {
+                return std::nullopt;
+            }
+
+            return Thumbnail{thumbnail.pixels.data(), thumbnail.width, thumbnail.height};
+        }
+    }
+
+    const Record *record = findRecord(key);
+    if (!record || record->sourceHash != sourceHash)
+    {
+        return std::nullopt;
+    }
+
+    return Thumbnail{mapping->data() + record->offset, record->width, record->height};
+}
+
+void ThumbnailDiskCache::add(uint64_t key, uint64_t sourceHash, uint16_t width, uint16_t height, const uint8_t *pixels)
+{
+    size_t size = pixelBytes(width, height);
+
+    auto found = unsaved.find(key);
+    if (found != unsaved.end())
+    {
+        _unsavedBytes -= found->second.pixels.size();
+        unsaved.erase(found);
+    }
+
+    unsaved.emplace(key, Unsaved{sourceHash, width, height, std::vector<uint8_t>(pixels, pixels + size)});
+    _unsavedBytes += size;
+}
+
+void ThumbnailDiskCache::save()
+{
+    if (auto pending = beginSave())
+    {
+        pending->write();
+        finishSave(*pending);
+    }
+}
+
+std::shared_ptr<ThumbnailDiskCache::Save> ThumbnailDiskCache::beginSave()
+{
+    if (unsaved.empty() || saving)
+    {
+        return nullptr;
+    }
+
+    auto pending = std::make_shared<Save>();
+    pending->temporaryFile = file;
+    pending->temporaryFile += ".save";
+    pending->clientVersion = clientVersion;
+    pending->mapping = mapping;
+
+    // Found through saving until the save finishes, while the thumbnails added from now on go to unsaved
+    saving = std::make_shared<const std::map<uint64_t, Unsaved>>(std::move(unsaved));
+    unsaved.clear();
+    _unsavedBytes = 0;
+    pending->thumbnails = saving;
+
+    // Merge the stored records with the unsaved thumbnails. Both are sorted by key; unsaved ones replace stored ones.
+    std::vector<Save::Source> &sources = pending->sources;
+    sources.reserve(recordCount + saving->size());
+
+    const Record *stored = records;
+    const Record *storedEnd = records + recordCount;
+    for (const auto &[key, thumbnail] : *saving)
+    {
+        for (; stored != storedEnd && stored->key < key; ++stored)
+        {
+            sources.emplace_back(Save::Source{stored->key, stored->sourceHash, stored->width, stored->height, mapping->data() + stored->offset});
+        }
+        if (stored != storedEnd && stored->key == key)
+        {
+            ++stored;
+        }
+
+        sources.emplace_back(Save::Source{key, thumbnail.sourceHash, thumbnail.width, thumbnail.height, thumbnail.pixels.data()});
+    }
+    for (; stored != storedEnd; ++stored)
+    {
+        sources.emplace_back(Save::Source{stored->key, stored->sourceHash, stored->width, stored->height, mapping->data() + stored->offset});
+    }
+
+    return pending;
+}
+
+void ThumbnailDiskCache::Save::write()
+{
+    Header header{};
+    header.magic = Magic;
+    header.formatVersion = FormatVersion;
+    header.recordCount = static_cast<uint32_t>(sources.size());
+    header.clientVersion = clientVersion;
+
+    std::vector<Record> records;
+    records.reserve(sources.size());
+
+    uint64_t offset = sizeof(Header) + sources.size() * sizeof(Record);
+    for (const Source &source : sources)
+    {
+        records.emplace_back(Record{source.key, source.sourceHash, offset, source.width, source.height, 0});
+        offset += pixelBytes(source.width, source.height);
+    }
+
+    auto error = File::writeAtomically(temporaryFile, [this, &header, &records](std::ostream &stream) {
+        stream.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+        stream.write(reinterpret_cast<const char *>(records.data()), records.size() * sizeof(Record));
+        for (const Source &source : sources)
+        {
+            stream.write(reinterpret_cast<const char *>(source.pixels), pixelBytes(source.width, source.height));
+        }
+    });
+
+    if (error)
+    {
+        VME_LOG_ERROR("Could not write the thumbnail cache " << temporaryFile.string() << ": " << error.message());
+    }
+
+    written = !error;
+}
+
+void ThumbnailDiskCache::finishSave(Save &save)
+{
+    DEBUG_ASSERT(save.thumbnails == saving, "The save does not belong to this cache.");
+
+    // The file cannot be replaced while it is mapped on every platform
+    save.sources.clear();
+    save.mapping.reset();
+    mapping.reset();
+    records = nullptr;
+    recordCount = 0;
+
+    std::error_code error;
+    if (save.written)
+    {
+        std::filesystem::rename(save.temporaryFile, file, error);
+        if (error)
+        {
+            VME_LOG_ERROR("Could not write the thumbnail cache " << file.string() << ": " << error.message());
+            std::filesystem::remove(save.temporaryFile, error);
+        }
+    }
+
+    if (!save.written || error)
+    {
+        // Saved with the next save instead, unless they were added again since
+        for (const auto &[key, thumbnail] : *saving)
+        {
+            if (unsaved.emplace(key, thumbnail).second)
+            {
+                _unsavedBytes += thumbnail.pixels.size();
+            }
+        }
+    }
+
+    save.thumbnails.reset();
+    saving.reset();
+
+    map();
+}
+
+size_t ThumbnailDiskCache::size() const noexcept
+{
+    return recordCount;
+}
+
+size_t ThumbnailDiskCache::unsavedBytes() const noexcept
+{
+    return _unsavedBytes;
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../mapped_file.h"
+
+/*
+	A single file of small images (the 32x32 palette thumbnails) that is memory-mapped on open, so that a thumbnail
+	made in an earlier run is available without decompressing its texture atlas.
+
+	Every thumbnail is stored under a key and the hash of its source. The caller derives the source hash from
+	whatever the image was made from (e.g. the atlas file names and sprite windows); a thumbnail whose source
+	changed is not returned and is replaced on the next save. The whole file is ignored if it was written for another
+	client version or format version.
+
+	Pixels are 32-bit ARGB, stored row by row from the top.
+*/
+class ThumbnailDiskCache
+{
+  public:
+    struct Thumbnail
+    {
+        const uint8_t *pixels;
+        uint16_t width;
+        uint16_t height;
+    };
+
+    ThumbnailDiskCache(std::filesystem::path file, const std::string &clientVersion);
+
+    ThumbnailDiskCache(const ThumbnailDiskCache &) = delete;
+    ThumbnailDiskCache &operator=(const ThumbnailDiskCache &) = delete;
+
+    class Save;
+
+    /*
+		Returns the thumbnail if it is stored with the same source hash. The pixels stay valid until the next save
+		finishes.
+	*/
+    std::optional<Thumbnail> find(uint64_t key, uint64_t sourceHash) const;
+
+    // Copies the thumbnail. It is written to the file on the next save.
+    void add(uint64_t key, uint64_t sourceHash, uint16_t width, uint16_t height, const uint8_t *pixels);
+
+    /*
+		Rewrites the file with the stored thumbnails and the ones added since the last save, then maps it again.
+		Does nothing if no thumbnail was added.
+	*/
+    void save();
+
+    /*
+		save in steps, so that writing the file does not block the thread that uses the cache. beginSave and
+		finishSave run on that thread, and Save::write on any thread in between. The cache can be used as usual while
+		the file is written.
+
+		beginSave returns nullptr if no thumbnail was added since the last save or if a save is running.
+	*/
+    std::shared_ptr<Save> beginSave();
+    void finishSave(Save &save);
+
+    // The number of thumbnails in the file
+    size_t size() const noexcept;
+
+    // Memory held by thumbnails that are not saved yet
+    size_t unsavedBytes() const noexcept;
+
+    static constexpr uint32_t FormatVersion = 1;
+    // Byte offset of the format version in the file
+    static constexpr size_t FormatVersionOffset = 8;
+    // The records follow the header
+    static constexpr size_t HeaderSize = 48;
+
+  private:
+    struct Record
+    {
+        uint64_t key;
+        uint64_t sourceHash;
+        uint64_t offset;
+        uint16_t width;
+        uint16_t height;
+        uint32_t reserved;
+    };
+
+    static_assert(sizeof(Record) == 32);
+
+    struct Unsaved
+    {
+        uint64_t sourceHash;
+        uint16_t width;
+        uint16_t height;
+        std::vector<uint8_t> pixels;
+    };
+
+    void map();
+
+    const Record *findRecord(uint64_t key) const;
+
+    std::filesystem::path file;
+    std::array<char, 32> clientVersion{};
+
+    std::shared_ptr<const MappedFile> mapping;
+
+    // Sorted by key. Points into the mapping.
+    const Record *records = nullptr;
+    size_t recordCount = 0;
+
+    std::map<uint64_t, Unsaved> unsaved;
+    size_t _unsavedBytes = 0;
+
+    // The thumbnails of the running save
+    std::shared_ptr<const std::map<uint64_t, Unsaved>> saving;
+};
+
+class ThumbnailDiskCache::Save
+{
+  public:
+    // Writes the new file next to the cache file. Safe to call from any thread.
+    void write();
+
+  private:
+    friend class ThumbnailDiskCache;
+
+    struct Source
+    {
+        uint64_t key;
+        uint64_t sourceHash;
+        uint16_t width;
+        uint16_t height;
+        const uint8_t *pixels;
+    };
+
+    std::filesystem::path temporaryFile;
+    std::array<char, 32> clientVersion{};
+
+    // Sorted by key
+    std::vector<Source> sources;
+
+    // Keep the pixels of the sources alive while writing
+    std::shared_ptr<const MappedFile> mapping;
+    std::shared_ptr<const std::map<uint64_t, Unsaved>> thumbnails;
+
+    bool written = false;
+};
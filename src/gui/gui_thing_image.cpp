@@ -1,133 +1,666 @@
 #include "gui_thing_image.h"
 
+#include <algorithm>
+#include <array>
+#include <filesystem>
+
+#include <QCoreApplication>
 #include <QImage>
 #include <QPainter>
 #include <QPixmap>
 #include <QRect>
 
 #include "../creature.h"
+#include "../graphics/outfit_variation.h"
 #include "../graphics/texture_atlas.h"
+#include "../graphics/thumbnail_disk_cache.h"
 #include "../item.h"
 #include "../items.h"
-
-vme_unordered_map<uint32_t, QPixmap> GUIImageCache::serverIdToPixmap;
-vme_unordered_map<uint32_t, std::unique_ptr<QImage>> GUIImageCache::textureIdToQImage;
-std::unique_ptr<QPixmap> GUIImageCache::blackSquare;
-
-QtTextureArea::QtTextureArea(const TextureWindow &window, const Texture &texture)
-    : rect(window.x0, window.y0, window.x1, window.y1), image(GUIImageCache::getOrCreateQImageForTexture(texture)) {}
-
-QtTextureArea::QtTextureArea(QRect rect, QImage *image)
-    : rect(rect), image(image) {}
+#include "../settings.h"
+#include "../thread_pool.h"
 
 namespace
 {
     constexpr int InitialImageCacheCapacity = 4096;
+    constexpr int ThumbnailSize = 32;
+
+    constexpr uint32_t ThumbnailThreads = 2;
+
+    constexpr uint64_t CreatureKeyBit = uint64_t(1) << 63;
+
+    // FNV-1a. Keys and source hashes are stored in the disk cache, so they must be the same in every run.
+    uint64_t hashBytes(uint64_t hash, const void *data, size_t size)
+    {
+        auto bytes = static_cast<const uint8_t *>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ bytes[i]) * 0x100000001B3;
+        }
+        return hash;
+    }
+
+    template <typename T>
+    uint64_t hashValue(uint64_t hash, const T &value)
+    {
+        return hashBytes(hash, &value, sizeof(T));
+    }
+
+    constexpr uint64_t HashSeed = 0xCBF29CE484222325;
+
+    uint64_t itemKey(uint32_t serverId, uint8_t subtype)
+    {
+        return (static_cast<uint64_t>(serverId) << 8) | subtype;
+    }
+
+    // Creature types with the same outfit share a thumbnail
+    uint64_t creatureKey(const CreatureType &creatureType, Direction direction)
+    {
+        const Outfit::Look &look = creatureType.outfit().look;
+
+        uint64_t hash = HashSeed;
+        hash = hashValue(hash, look.type);
+        hash = hashValue(hash, look.mount);
+        hash = hashValue(hash, look.data.id);
+        hash = hashValue(hash, to_underlying(look.addon));
+        hash = hashValue(hash, to_underlying(direction));
+
+        return CreatureKeyBit | (hash & ~CreatureKeyBit);
+    }
+
+    QRect windowRect(const TextureWindow &window)
+    {
+        return QRect(window.x0, window.y0, window.x1, window.y1);
+    }
+
+    // Copies rect out of BMP pixel data. The result is still upside down.
+    QImage cropPixels(const std::vector<uint8_t> &pixels, int width, int height, const QRect &rect)
+    {
+        return QImage(pixels.data(), width, height, width * 4, QImage::Format::Format_ARGB32).copy(rect);
+    }
+
+    QImage fitThumbnail(QImage &&image)
+    {
+        if (image.width() > ThumbnailSize || image.height() > ThumbnailSize)
+        {
+            return image.scaled(ThumbnailSize, ThumbnailSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        }
+
+        return std::move(image);
+    }
 } // namespace
 
+/*
+	Pixels of one sprite. They are cropped on the GUI thread if the atlas is in memory, otherwise a worker crops
+	them from the atlas file.
+*/
+struct GUIImageCache::Crop
+{
+    QImage image;
+
+    // The atlas file name and the window of the sprite in it
+    uint64_t sourceHash;
+
+    std::filesystem::path atlasFile;
+    int atlasWidth = 0;
+    int atlasHeight = 0;
+    QRect rect;
+};
+
+/*
+	One sprite of a thumbnail. The sprites of colored outfits are colored when the thumbnail is composed, from the
+	crop of their color template, so that no atlas has to be decompressed on the GUI thread.
+*/
+struct GUIImageCache::Layer
+{
+    Crop sprite;
+    std::optional<Crop> colorTemplate;
+    std::array<uint32_t, 4> colors{};
+
+    uint64_t sourceHash() const
+    {
+        uint64_t hash = sprite.sourceHash;
+        if (colorTemplate)
+        {
+            hash = hashValue(hash, colorTemplate->sourceHash);
+            hash = hashValue(hash, colors);
+        }
+        return hash;
+    }
+
+    // Safe to call from any thread.
+    QImage image() const
+    {
+        if (!colorTemplate)
+        {
+            return sprite.image;
+        }
+
+        const QImage &source = sprite.image;
+        const QImage &mask = colorTemplate->image;
+
+        QImage result(source.size(), QImage::Format::Format_ARGB32);
+        for (int y = 0; y < result.height(); ++y)
+        {
+            OutfitVariation::colorizeRow(result.scanLine(y), source.constScanLine(y), mask.constScanLine(y), static_cast<size_t>(result.width()), colors);
+        }
+
+        return result;
+    }
+};
+
+/*
+	The sprites of a thumbnail, drawn in order. Items have one layer; creatures have a layer for the outfit and
+	one for each mount and addon.
+*/
+struct GUIImageCache::Job
+{
+    uint64_t key;
+    std::vector<Layer> layers;
+
+    uint64_t sourceHash() const
+    {
+        uint64_t hash = HashSeed;
+        for (const Layer &layer : layers)
+        {
+            hash = hashValue(hash, layer.sourceHash());
+        }
+        return hash;
+    }
+
+    bool ready() const
+    {
+        return std::all_of(layers.begin(), layers.end(), [](const Layer &layer) {
+            return !layer.sprite.image.isNull() && (!layer.colorTemplate || !layer.colorTemplate->image.isNull());
+        });
+    }
+
+    // The atlas file that the first missing crop is taken from
+    const std::filesystem::path &atlasFile() const
+    {
+        for (const Layer &layer : layers)
+        {
+            if (layer.sprite.image.isNull())
+            {
+                return layer.sprite.atlasFile;
+            }
+            if (layer.colorTemplate && layer.colorTemplate->image.isNull())
+            {
+                return layer.colorTemplate->atlasFile;
+            }
+        }
+
+        ABORT_PROGRAM("The thumbnail job is ready.");
+    }
+
+    // Takes the missing crops from the atlas pixels. Safe to call from any thread.
+    void cropFrom(const std::filesystem::path &file, const std::vector<uint8_t> &pixels)
+    {
+        auto cropMissing = [&file, &pixels](Crop &crop) {
+            if (crop.image.isNull() && crop.atlasFile == file)
+            {
+                crop.image = cropPixels(pixels, crop.atlasWidth, crop.atlasHeight, crop.rect);
+            }
+        };
+
+        for (Layer &layer : layers)
+        {
+            cropMissing(layer.sprite);
+            if (layer.colorTemplate)
+            {
+                cropMissing(*layer.colorTemplate);
+            }
+        }
+    }
+
+    // Safe to call from any thread.
+    QImage compose() const
+    {
+        if (layers.size() == 1)
+        {
+            return fitThumbnail(layers.front().image().mirrored());
+        }
+
+        QImage image(QSize(ThumbnailSize, ThumbnailSize), QImage::Format::Format_ARGB32);
+        image.fill(Qt::transparent);
+        {
+            QPainter painter(&image);
+            for (const Layer &layer : layers)
+            {
+                painter.drawImage(QPoint(0, 0), fitThumbnail(layer.image()));
+            }
+        }
+
+        return image.mirrored();
+    }
+};
+
+struct GUIImageCache::Made
+{
+    uint64_t key;
+    uint64_t sourceHash;
+    QImage image;
+
+    // False for the placeholder of a thumbnail that could not be made
+    bool persistent = true;
+};
+
+std::list<GUIImageCache::Entry> GUIImageCache::thumbnails;
+vme_unordered_map<uint64_t, std::list<GUIImageCache::Entry>::iterator> GUIImageCache::thumbnailsByKey;
+size_t GUIImageCache::thumbnailBytes = 0;
+std::vector<GUIImageCache::Job> GUIImageCache::pending;
+vme_unordered_set<uint64_t> GUIImageCache::inProgress;
+std::unique_ptr<ThreadPool> GUIImageCache::workers;
+std::unique_ptr<ThumbnailDiskCache> GUIImageCache::diskCache;
+std::shared_ptr<ThumbnailDiskCache::Save> GUIImageCache::runningSave;
+std::unique_ptr<QPixmap> GUIImageCache::blackSquare;
+Nano::Signal<void()> GUIImageCache::thumbnailsReady;
+
 void GUIImageCache::initialize()
 {
-    serverIdToPixmap.reserve(InitialImageCacheCapacity);
+    thumbnailsByKey.reserve(InitialImageCacheCapacity);
+    if (!workers)
+    {
+        workers = std::make_unique<ThreadPool>(ThumbnailThreads);
+    }
+}
+
+void GUIImageCache::openDiskCache(const std::filesystem::path &file, const std::string &clientVersion)
+{
+    diskCache = std::make_unique<ThumbnailDiskCache>(file, clientVersion);
+    VME_LOG_D("Thumbnail cache: " << diskCache->size() << " thumbnails in " << file.string());
 }
 
-void GUIImageCache::cachePixmapForServerId(uint32_t serverId)
+void GUIImageCache::closeDiskCache()
 {
-    get(serverId);
+    if (diskCache)
+    {
+        // The event loop may have stopped, so a running save is finished here
+        if (runningSave)
+        {
+            workers->waitIdle();
+            diskCache->finishSave(*runningSave);
+            runningSave.reset();
+        }
+
+        diskCache->save();
+        diskCache.reset();
+    }
 }
 
-const QPixmap &GUIImageCache::get(uint32_t serverId)
+void GUIImageCache::saveInBackground()
 {
-    auto found = serverIdToPixmap.find(serverId);
-    if (found == serverIdToPixmap.end())
+    runningSave = diskCache->beginSave();
+    if (!runningSave)
+    {
+        return;
+    }
+
+    if (!workers)
     {
-        serverIdToPixmap.try_emplace(serverId, GUIThingImage::itemPixmap(serverId));
+        initialize();
     }
 
-    return serverIdToPixmap.at(serverId);
+    workers->submit([save = runningSave]() {
+        save->write();
+
+        // Finished by closeDiskCache if the application is shutting down
+        if (QCoreApplication *application = QCoreApplication::instance())
+        {
+            QMetaObject::invokeMethod(
+                application, [save]() {
+                    if (diskCache && runningSave == save)
+                    {
+                        diskCache->finishSave(*save);
+                        runningSave.reset();
+                    }
+                },
+                Qt::QueuedConnection);
+        }
+    });
 }
 
-QImage *GUIImageCache::getOrCreateQImageForTexture(const Texture &texture)
+GUIImageCache::Crop GUIImageCache::crop(const TextureInfo &info)
 {
-    auto found = textureIdToQImage.find(texture.id());
-    if (found == textureIdToQImage.end())
+    Crop result;
+    result.rect = windowRect(info.window);
+
+    // Atlas files are named after a hash of their contents, so a changed sprite changes the hash
+    std::string atlasName = info.atlas->sourceFile.filename().string();
+    result.sourceHash = hashBytes(HashSeed, atlasName.data(), atlasName.size());
+    result.sourceHash = hashValue(result.sourceHash, std::array<int, 4>{result.rect.x(), result.rect.y(), result.rect.width(), result.rect.height()});
+
+    // Decompressed atlases are in memory already
+    if (const Texture *texture = info.atlas->getTexture())
+    {
+        result.image = cropPixels(texture->pixels(), texture->width(), texture->height(), result.rect);
+    }
+    else
     {
-        const uint8_t *pixelData = texture.pixels().data();
-        auto image = std::make_unique<QImage>(pixelData, 12 * 32, 12 * 32, 384 * 4, QImage::Format::Format_ARGB32);
-        textureIdToQImage.try_emplace(texture.id(), std::move(image));
+        result.atlasFile = info.atlas->atlasFile;
+        result.atlasWidth = static_cast<int>(info.atlas->width);
+        result.atlasHeight = static_cast<int>(info.atlas->height);
     }
 
-    return textureIdToQImage.at(texture.id()).get();
+    return result;
 }
 
-QImage GUIThingImage::getCreatureTypeImage(const CreatureType &creatureType, Direction direction)
+std::optional<GUIImageCache::Job> GUIImageCache::itemJob(uint32_t serverId, uint8_t subtype)
 {
-    QImage image(QSize(32, 32), QImage::Format::Format_ARGB32);
-    image.fill(QColor("transparent"));
-    QPainter painter(&image);
+    if (!Items::items.validItemType(serverId))
+    {
+        return std::nullopt;
+    }
+
+    ItemType *itemType = Items::items.getItemTypeByServerId(serverId);
+
+    TextureInfo info = subtype > 1 ? itemType->getTextureInfoForSubtype(subtype, TextureInfo::CoordinateType::Unnormalized)
+                                   : itemType->getTextureInfo(TextureInfo::CoordinateType::Unnormalized);
+
+    Job job;
+    job.key = itemKey(serverId, subtype);
+    job.layers.emplace_back(Layer{crop(info)});
 
-    auto getLayer = [&painter](const CreatureType *creatureType, int posture, int addonType, Direction direction) {
-        auto info = creatureType->getTextureInfo(0, posture, addonType, direction, TextureInfo::CoordinateType::Unnormalized);
+    return job;
+}
 
-        const Texture &texture = creatureType->hasColorVariation()
-                                     ? info.getTexture(creatureType->outfitId())
-                                     : info.getTexture();
+std::optional<GUIImageCache::Job> GUIImageCache::creatureJob(const CreatureType &creatureType, Direction direction)
+{
+    Job job;
+    job.key = creatureKey(creatureType, direction);
 
-        auto rect = QRect(info.window.x0, info.window.y0, info.window.x1, info.window.y1);
-        QImage img = GUIImageCache::getOrCreateQImageForTexture(texture)->copy(rect);
-        if (rect.width() > 32 || rect.height() > 32)
+    auto addLayer = [&job, direction](const CreatureType *creatureType, int posture, int addonType) {
+        if (!creatureType)
         {
-            img = img.scaled(32, 32, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+            return;
         }
 
-        painter.drawImage(QPoint(0, 0), img);
+        constexpr auto Unnormalized = TextureInfo::CoordinateType::Unnormalized;
+
+        // Colored sprites are colored from their template when composed, instead of through the OutfitVariation
+        Layer layer{crop(creatureType->getUncoloredTextureInfo(0, posture, addonType, direction, Unnormalized))};
+        if (auto colorTemplate = creatureType->getColorTemplateInfo(0, posture, addonType, direction, Unnormalized))
+        {
+            layer.colorTemplate = crop(*colorTemplate);
+            layer.colors = OutfitVariation::colors(creatureType->outfit().look);
+        }
+
+        job.layers.emplace_back(std::move(layer));
     };
 
-    uint8_t posture = creatureType.hasMount() ? 1 : 0;
-    // uint8_t posture = 1;
+    int posture = creatureType.hasMount() ? 1 : 0;
 
-    // Mount?
     if (creatureType.hasMount())
     {
         // Draw mount first
-        getLayer(Creatures::creatureType(creatureType.mountLooktype()), 0, 0, direction);
+        addLayer(Creatures::creatureType(creatureType.mountLooktype()), 0, 0);
+    }
+    addLayer(&creatureType, posture, 0);
 
-        getLayer(&creatureType, 1, 0, direction);
+    if (creatureType.hasAddon(Outfit::Addon::First))
+    {
+        addLayer(&creatureType, posture, 1);
     }
-    else
+    if (creatureType.hasAddon(Outfit::Addon::Second))
     {
-        // No mount, draw the base outfit
-        getLayer(&creatureType, posture, 0, direction);
+        addLayer(&creatureType, posture, 2);
     }
 
-    // Addons?
-    if (creatureType.hasAddon(Outfit::Addon::First))
+    return job;
+}
+
+const QImage *GUIImageCache::itemThumbnail(uint32_t serverId, uint8_t subtype)
+{
+    const QImage *image = find(itemKey(serverId, subtype));
+    return image ? image : request(itemJob(serverId, subtype));
+}
+
+const QImage *GUIImageCache::creatureThumbnail(const CreatureType &creatureType, Direction direction)
+{
+    const QImage *image = find(creatureKey(creatureType, direction));
+    return image ? image : request(creatureJob(creatureType, direction));
+}
+
+QImage GUIImageCache::itemThumbnailNow(uint32_t serverId, uint8_t subtype)
+{
+    if (const QImage *image = find(itemKey(serverId, subtype)))
     {
-        getLayer(&creatureType, posture, 1, direction);
+        return *image;
     }
-    if (creatureType.hasAddon(Outfit::Addon::Second))
+
+    std::optional<Job> job = itemJob(serverId, subtype);
+    if (!job)
+    {
+        return blackSquarePixmap().toImage();
+    }
+
+    if (const QImage *image = findOnDisk(*job))
+    {
+        return *image;
+    }
+
+    while (!job->ready())
     {
-        getLayer(&creatureType, posture, 2, direction);
+        std::filesystem::path file = job->atlasFile();
+        job->cropFrom(file, TextureAtlas::loadPixels(file));
     }
 
-    return image.mirrored();
+    return made(Made{job->key, job->sourceHash(), job->compose()});
 }
 
-QImage GUIThingImage::getItemTypeImage(const ItemType &itemType, uint8_t subtype)
+QImage GUIImageCache::creatureThumbnailNow(const CreatureType &creatureType, Direction direction)
 {
-    TextureInfo info = subtype > 1 ? itemType.getTextureInfoForSubtype(subtype, TextureInfo::CoordinateType::Unnormalized)
-                                   : itemType.getTextureInfo(TextureInfo::CoordinateType::Unnormalized);
+    if (const QImage *image = find(creatureKey(creatureType, direction)))
+    {
+        return *image;
+    }
 
-    QRect rect(info.window.x0, info.window.y0, info.window.x1, info.window.y1);
-    QImage *textureImage = GUIImageCache::getOrCreateQImageForTexture(info.getTexture());
+    std::optional<Job> job = creatureJob(creatureType, direction);
+    if (const QImage *image = findOnDisk(*job))
+    {
+        return *image;
+    }
 
-    QImage image = textureImage->copy(rect).mirrored();
+    while (!job->ready())
+    {
+        std::filesystem::path file = job->atlasFile();
+        job->cropFrom(file, TextureAtlas::loadPixels(file));
+    }
 
-    if (rect.width() > 32 || rect.height() > 32)
+    return made(Made{job->key, job->sourceHash(), job->compose()});
+}
+
+const QImage *GUIImageCache::find(uint64_t key)
+{
+    auto found = thumbnailsByKey.find(key);
+    if (found == thumbnailsByKey.end())
+    {
+        return nullptr;
+    }
+
+    thumbnails.splice(thumbnails.begin(), thumbnails, found->second);
+    return &found->second->second;
+}
+
+const QImage &GUIImageCache::insert(uint64_t key, QImage &&image)
+{
+    auto found = thumbnailsByKey.find(key);
+    if (found != thumbnailsByKey.end())
+    {
+        thumbnailBytes -= found->second->second.sizeInBytes();
+        thumbnails.erase(found->second);
+        thumbnailsByKey.erase(found);
+    }
+
+    thumbnailBytes += image.sizeInBytes();
+    thumbnails.emplace_front(key, std::move(image));
+    thumbnailsByKey.emplace(key, thumbnails.begin());
+
+    // The new thumbnail is never evicted, so the returned reference stays valid
+    while (thumbnailBytes > Settings::GUI_IMAGE_CACHE_MEMORY_BUDGET && thumbnails.size() > 1)
+    {
+        const Entry &oldest = thumbnails.back();
+        thumbnailBytes -= oldest.second.sizeInBytes();
+        thumbnailsByKey.erase(oldest.first);
+        thumbnails.pop_back();
+    }
+
+    return thumbnails.front().second;
+}
+
+const QImage *GUIImageCache::findOnDisk(const Job &job)
+{
+    if (!diskCache)
+    {
+        return nullptr;
+    }
+
+    auto thumbnail = diskCache->find(job.key, job.sourceHash());
+    if (!thumbnail)
+    {
+        return nullptr;
+    }
+
+    // Copied, because the mapping is replaced when the disk cache is saved
+    QImage image(thumbnail->pixels, thumbnail->width, thumbnail->height, thumbnail->width * 4, QImage::Format::Format_ARGB32);
+    return &insert(job.key, image.copy());
+}
+
+const QImage &GUIImageCache::made(Made &&thumbnail)
+{
+    if (diskCache && thumbnail.persistent)
     {
-        image = image.scaled(32, 32, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        // Rows of a 32-bit QImage are never padded, so the pixels can be stored as they are
+        QImage image = thumbnail.image.convertToFormat(QImage::Format::Format_ARGB32);
+        diskCache->add(thumbnail.key, thumbnail.sourceHash, static_cast<uint16_t>(image.width()), static_cast<uint16_t>(image.height()), image.constBits());
+
+        // Thumbnails that are not saved yet are held in memory twice
+        if (diskCache->unsavedBytes() > Settings::GUI_IMAGE_CACHE_MEMORY_BUDGET && !runningSave)
+        {
+            saveInBackground();
+        }
     }
 
-    return image;
+    return insert(thumbnail.key, std::move(thumbnail.image));
+}
+
+const QImage *GUIImageCache::request(std::optional<Job> &&job)
+{
+    if (!job)
+    {
+        static QImage blackSquareImage = blackSquarePixmap().toImage();
+        return &blackSquareImage;
+    }
+
+    if (const QImage *image = findOnDisk(*job))
+    {
+        return image;
+    }
+
+    if (job->ready())
+    {
+        return &made(Made{job->key, job->sourceHash(), job->compose()});
+    }
+
+    if (inProgress.contains(job->key))
+    {
+        return nullptr;
+    }
+
+    inProgress.emplace(job->key);
+    if (pending.empty())
+    {
+        // Jobs requested while painting are collected so that each atlas is only loaded once
+        QMetaObject::invokeMethod(QCoreApplication::instance(), &GUIImageCache::submitPending, Qt::QueuedConnection);
+    }
+    pending.emplace_back(std::move(*job));
+
+    return nullptr;
+}
+
+void GUIImageCache::submitPending()
+{
+    if (!workers)
+    {
+        initialize();
+    }
+
+    vme_unordered_map<std::string, std::vector<Job>> jobsByAtlas;
+    for (Job &job : pending)
+    {
+        std::string file = job.atlasFile().string();
+        jobsByAtlas[file].emplace_back(std::move(job));
+    }
+    pending.clear();
+
+    for (auto &[_, jobs] : jobsByAtlas)
+    {
+        workers->submit([jobs = std::move(jobs)]() mutable {
+            std::vector<Made> result;
+            result.reserve(jobs.size());
+
+            for (Job &job : jobs)
+            {
+                try
+                {
+                    // Creature jobs can need more than one atlas. The pixels of each atlas are dropped after use.
+                    while (!job.ready())
+                    {
+                        std::filesystem::path file = job.atlasFile();
+                        std::vector<uint8_t> pixels = TextureAtlas::loadPixels(file);
+                        for (Job &other : jobs)
+                        {
+                            other.cropFrom(file, pixels);
+                        }
+                    }
+
+                    result.emplace_back(Made{job.key, job.sourceHash(), job.compose()});
+                }
+                catch (const std::exception &exception)
+                {
+                    VME_LOG_ERROR("Could not make the thumbnail " << job.key << ": " << exception.what());
+
+                    // Not retried on every repaint
+                    QImage blackSquare(ThumbnailSize, ThumbnailSize, QImage::Format::Format_ARGB32);
+                    blackSquare.fill(QColor(0, 0, 0, 255));
+                    result.emplace_back(Made{job.key, job.sourceHash(), std::move(blackSquare), false});
+                }
+            }
+
+            // Dropped if the application is shutting down
+            if (QCoreApplication *application = QCoreApplication::instance())
+            {
+                auto shared = std::make_shared<std::vector<Made>>(std::move(result));
+                QMetaObject::invokeMethod(
+                    application, [shared]() { received(std::move(*shared)); }, Qt::QueuedConnection);
+            }
+        });
+    }
+}
+
+void GUIImageCache::received(std::vector<Made> &&thumbnails)
+{
+    for (Made &thumbnail : thumbnails)
+    {
+        inProgress.erase(thumbnail.key);
+        made(std::move(thumbnail));
+    }
+
+    thumbnailsReady.fire();
+}
+
+size_t GUIImageCache::sizeInBytes() noexcept
+{
+    return thumbnailBytes;
+}
+
+QImage GUIThingImage::getCreatureTypeImage(const CreatureType &creatureType, Direction direction)
+{
+    return GUIImageCache::creatureThumbnailNow(creatureType, direction);
+}
+
+QImage GUIThingImage::getItemTypeImage(const ItemType &itemType, uint8_t subtype)
+{
+    return GUIImageCache::itemThumbnailNow(itemType.id, subtype);
 }
 
 QImage GUIThingImage::getItemTypeImage(uint32_t serverId, uint8_t subtype)
@@ -164,7 +697,7 @@ QPixmap GUIThingImage::thingPixmap(const TextureWindow &textureWindow, const Tex
 
     QRect textureRegion(textureWindow.x0, textureWindow.y0, textureWindow.x1, textureWindow.y1);
 
-    QImage sprite = QImage(pixelData, 12 * 32, 12 * 32, 384 * 4, QImage::Format::Format_ARGB32)
+    QImage sprite = QImage(pixelData, texture.width(), texture.height(), texture.width() * 4, QImage::Format::Format_ARGB32)
                         .copy(textureRegion)
                         .mirrored();
 
@@ -196,7 +729,7 @@ QPixmap GUIThingImage::thingPixmap(const TextureWindow &textureWindow, const Tex
 
 QPixmap GUIThingImage::thingPixmap(const TextureInfo &info)
 {
-    return thingPixmap(info.window, info.atlas->getOrCreateTexture(), info.atlas->spriteWidth, info.atlas->spriteHeight);
+    return thingPixmap(info.window, info.getTexture(), info.atlas->spriteWidth, info.atlas->spriteHeight);
 }
 
 QPixmap GUIImageCache::blackSquarePixmap()
@@ -222,16 +755,7 @@ QPixmap GUIThingImage::creaturePixmap(const CreatureType *creatureType, Directio
     }
 
     auto info = creatureType->getTextureInfo(0, direction, TextureInfo::CoordinateType::Unnormalized);
-
-    if (creatureType->hasColorVariation())
-    {
-        TextureAtlas *atlas = info.atlas;
-        return thingPixmap(info.window, atlas->getTexture(creatureType->outfitId()), atlas->spriteWidth, atlas->spriteHeight);
-    }
-    else
-    {
-        return thingPixmap(info);
-    }
+    return thingPixmap(info);
 }
 
 QPixmap GUIThingImage::creaturePixmap(uint32_t looktype, Direction direction)
@@ -243,16 +767,7 @@ QPixmap GUIThingImage::creaturePixmap(uint32_t looktype, Direction direction)
     }
 
     auto info = creatureType->getTextureInfo(0, direction, TextureInfo::CoordinateType::Unnormalized);
-
-    if (creatureType->hasColorVariation())
-    {
-        TextureAtlas *atlas = info.atlas;
-        return thingPixmap(info.window, atlas->getTexture(creatureType->outfitId()), atlas->spriteWidth, atlas->spriteHeight);
-    }
-    else
-    {
-        return thingPixmap(info);
-    }
+    return thingPixmap(info);
 }
 
 //>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
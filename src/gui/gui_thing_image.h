@@ -1,11 +1,20 @@
 #pragma once
 
+#include <filesystem>
+#include <list>
 #include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include <QImage>
 #include <QQuickImageProvider>
 #include <QRect>
 
 #include "../graphics/texture.h"
+#include "../graphics/thumbnail_disk_cache.h"
+#include "../signal.h"
 #include "../util.h"
 
 class QImage;
@@ -21,26 +30,87 @@ enum class Direction;
 struct TextureInfo;
 struct TextureWindow;
 
-struct QtTextureArea
-{
-    QtTextureArea(const TextureWindow &window, const Texture &texture);
-    QtTextureArea(QRect rect, QImage *image);
+class ThreadPool;
 
-    QRect rect;
-    QImage *image;
-};
+/*
+	Thumbnails (at most 32x32 pixels) of item types and creature types for the GUI.
 
-struct GUIImageCache
-{
+	A thumbnail is cropped straight from the pixels of its sprite's atlas. If the atlas is decompressed, that happens
+	right away. Otherwise a worker thread loads the atlas pixels, crops every thumbnail that was waiting for the
+	atlas and drops the pixels again; the atlas itself stays compressed. Colored outfits are colored from the crops
+	of their color templates, without an OutfitVariation. thumbnailsReady fires on the GUI thread when thumbnails
+	from a worker arrive.
 
+	The least recently used thumbnails are dropped once they take more than Settings::GUI_IMAGE_CACHE_MEMORY_BUDGET.
+	With a disk cache open, thumbnails made in earlier runs are read from there instead, as long as the atlas files
+	and sprites they were made from are the same. New thumbnails are written to the disk cache on a worker once they
+	take more than the budget as well, and on closeDiskCache. Must only be used from the GUI thread.
+*/
+class GUIImageCache
+{
+  public:
     static void initialize();
-    static const QPixmap &get(uint32_t serverId);
-    static void cachePixmapForServerId(uint32_t serverId);
-    static QImage *getOrCreateQImageForTexture(const Texture &texture);
+
+    static void openDiskCache(const std::filesystem::path &file, const std::string &clientVersion);
+    // Writes the thumbnails made since the disk cache was opened
+    static void closeDiskCache();
+
+    /*
+		Returns nullptr if the thumbnail is not ready yet; it is then made in the background. The pointer is valid
+		until the next call into GUIImageCache.
+	*/
+    static const QImage *itemThumbnail(uint32_t serverId, uint8_t subtype = 0);
+    static const QImage *creatureThumbnail(const CreatureType &creatureType, Direction direction);
+
+    // Returns the thumbnail, making it on the calling thread if it is not ready yet.
+    static QImage itemThumbnailNow(uint32_t serverId, uint8_t subtype = 0);
+    static QImage creatureThumbnailNow(const CreatureType &creatureType, Direction direction);
+
     static QPixmap blackSquarePixmap();
 
-    static vme_unordered_map<uint32_t, QPixmap> serverIdToPixmap;
-    static vme_unordered_map<uint32_t, std::unique_ptr<QImage>> textureIdToQImage;
+    static size_t sizeInBytes() noexcept;
+
+    static Nano::Signal<void()> thumbnailsReady;
+
+  private:
+    struct Crop;
+    struct Layer;
+    struct Job;
+    struct Made;
+
+    static std::optional<Job> itemJob(uint32_t serverId, uint8_t subtype);
+    static std::optional<Job> creatureJob(const CreatureType &creatureType, Direction direction);
+    static Crop crop(const TextureInfo &info);
+
+    static const QImage *request(std::optional<Job> &&job);
+    static const QImage *findOnDisk(const Job &job);
+    static const QImage *find(uint64_t key);
+    static const QImage &insert(uint64_t key, QImage &&image);
+
+    // Sends the jobs waiting for an atlas to the workers
+    static void submitPending();
+    static void received(std::vector<Made> &&thumbnails);
+
+    // Caches a thumbnail that was just made, and stores it in the disk cache if persistent
+    static const QImage &made(Made &&thumbnail);
+
+    // Writes the disk cache on a worker; the file is replaced on the GUI thread once it is written
+    static void saveInBackground();
+
+    using Entry = std::pair<uint64_t, QImage>;
+
+    // Most recently used first
+    static std::list<Entry> thumbnails;
+    static vme_unordered_map<uint64_t, std::list<Entry>::iterator> thumbnailsByKey;
+    static size_t thumbnailBytes;
+
+    // Jobs that are not submitted yet, and the keys of every job that has not finished
+    static std::vector<Job> pending;
+    static vme_unordered_set<uint64_t> inProgress;
+
+    static std::unique_ptr<ThreadPool> workers;
+    static std::unique_ptr<ThumbnailDiskCache> diskCache;
+    static std::shared_ptr<ThumbnailDiskCache::Save> runningSave;
     static std::unique_ptr<QPixmap> blackSquare;
 };
 
@@ -60,8 +130,6 @@ class GUIThingImage
   private:
     static QPixmap thingPixmap(const TextureInfo &info);
     static QPixmap thingPixmap(const TextureWindow &textureWindow, const Texture &texture, uint16_t spriteWidth, uint16_t spriteHeight);
-
-    static QtTextureArea getTextureArea();
 };
 
 class ItemTypeImageProvider : public QQuickImageProvider
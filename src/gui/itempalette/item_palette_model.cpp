@@ -25,6 +25,9 @@ namespace
 {
     const int PaddingPx = 1;
     const int ItemDelegateSideSize = 32 + PaddingPx * 2;
+
+    // Drawn while the thumbnail of a brush is made
+    const QColor PlaceholderColor("#1c1c1c");
 } // namespace
 
 TilesetModel::TilesetModel(QObject *parent)
@@ -113,17 +116,6 @@ void ItemDelegate::setHighlightPenOpacity(float opacity) const
     highlightBorderPen.setColor(color);
 }
 
-void ItemDelegate::paintTextureArea(QPainter *painter, const QPoint topLeft, const QtTextureArea &textureArea) const
-{
-    QImage image = textureArea.image->copy(textureArea.rect).mirrored();
-    if (textureArea.rect.width() > 32 || textureArea.rect.height() > 32)
-    {
-        image = image.scaled(32, 32, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-    }
-
-    painter->drawImage(topLeft, image);
-}
-
 void ItemDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
 {
     // TODO Add option for rendering as a list with names
@@ -135,61 +127,44 @@ void ItemDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
 
     Brush *b = qvariant_cast<Brush *>(index.data(TilesetModel::BrushRole));
 
+    // Thumbnails that are not ready yet are made in the background. The view repaints when they arrive.
+    const QImage *image = nullptr;
     switch (b->type())
     {
         case BrushType::Raw:
-        {
-            auto brush = static_cast<RawBrush *>(b);
-            QImage image = GUIThingImage::getItemTypeImage(*brush->itemType());
-            painter->drawImage(topLeft, image);
+            image = GUIImageCache::itemThumbnail(static_cast<RawBrush *>(b)->serverId());
             break;
-        }
         case BrushType::Ground:
-        {
-            auto brush = static_cast<GroundBrush *>(b);
-            QImage image = GUIThingImage::getItemTypeImage(brush->iconServerId());
-            painter->drawImage(topLeft, image);
+            image = GUIImageCache::itemThumbnail(static_cast<GroundBrush *>(b)->iconServerId());
             break;
-        }
         case BrushType::Border:
-        {
-            auto brush = static_cast<BorderBrush *>(b);
-            QImage image = GUIThingImage::getItemTypeImage(brush->iconServerId());
-            painter->drawImage(topLeft, image);
+            image = GUIImageCache::itemThumbnail(static_cast<BorderBrush *>(b)->iconServerId());
             break;
-        }
         case BrushType::Wall:
-        {
-            auto brush = static_cast<WallBrush *>(b);
-            QImage image = GUIThingImage::getItemTypeImage(brush->iconServerId());
-            painter->drawImage(topLeft, image);
+            image = GUIImageCache::itemThumbnail(static_cast<WallBrush *>(b)->iconServerId());
             break;
-        }
         case BrushType::Mountain:
-        {
-            auto brush = static_cast<MountainBrush *>(b);
-            QImage image = GUIThingImage::getItemTypeImage(brush->iconServerId());
-            painter->drawImage(topLeft, image);
+            image = GUIImageCache::itemThumbnail(static_cast<MountainBrush *>(b)->iconServerId());
             break;
-        }
         case BrushType::Doodad:
-        {
-            auto brush = static_cast<DoodadBrush *>(b);
-            QImage image = GUIThingImage::getItemTypeImage(brush->iconServerId());
-            painter->drawImage(topLeft, image);
+            image = GUIImageCache::itemThumbnail(static_cast<DoodadBrush *>(b)->iconServerId());
             break;
-        }
         case BrushType::Creature:
-        {
-            auto brush = static_cast<CreatureBrush *>(b);
-            QImage image = GUIThingImage::getCreatureTypeImage(*brush->creatureType, Direction::South);
-            painter->drawImage(topLeft, image);
+            image = GUIImageCache::creatureThumbnail(*static_cast<CreatureBrush *>(b)->creatureType, Direction::South);
             break;
-        }
         default:
             break;
     }
 
+    if (image)
+    {
+        painter->drawImage(topLeft, *image);
+    }
+    else
+    {
+        painter->fillRect(QRect(topLeft, QSize(32, 32)), PlaceholderColor);
+    }
+
     bool ok;
     int highlightOpacity = index.data(TilesetModel::HighlightRole).toInt(&ok);
     if (ok && highlightOpacity > 0)
@@ -9,7 +9,6 @@
 class ItemType;
 class Tileset;
 class Brush;
-struct QtTextureArea;
 class QPainter;
 class QPoint;
 
@@ -67,8 +66,6 @@ namespace ItemPaletteUI
       public:
         explicit ItemDelegate(QObject *parent = nullptr);
 
-        void paintTextureArea(QPainter *painter, const QPoint topLeft, const QtTextureArea &textureArea) const;
-
         void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const;
         QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const;
 
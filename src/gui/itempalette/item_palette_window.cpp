@@ -10,6 +10,7 @@
 #include "../../logger.h"
 #include "../../qt/logging.h"
 #include "../../settings.h"
+#include "../gui_thing_image.h"
 #include "../main_application.h"
 
 
@@ -212,6 +213,18 @@ TilesetListView::TilesetListView(QWidget *parent)
     QPalette stylePalette = palette();
     stylePalette.setColor(QPalette::Base, "#000000");
     setPalette(stylePalette);
+
+    GUIImageCache::thumbnailsReady.connect<&TilesetListView::thumbnailsReady>(this);
+}
+
+TilesetListView::~TilesetListView()
+{
+    GUIImageCache::thumbnailsReady.disconnect<&TilesetListView::thumbnailsReady>(this);
+}
+
+void TilesetListView::thumbnailsReady()
+{
+    viewport()->update();
 }
 
 void TilesetListView::setTileset(Tileset *tileset)
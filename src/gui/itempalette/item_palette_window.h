@@ -24,6 +24,7 @@ class TilesetListView : public QListView
 {
   public:
     TilesetListView(QWidget *parent = nullptr);
+    ~TilesetListView();
 
     Brush *brushAtIndex(QModelIndex index) const;
 
@@ -41,6 +42,8 @@ class TilesetListView : public QListView
     void leaveEvent(QEvent *e) override;
 
   private:
+    void thumbnailsReady();
+
     ItemPaletteUI::TilesetModel *_model;
 
     bool mayOpenTooltip;
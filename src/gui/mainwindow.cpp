@@ -5,15 +5,23 @@
 #pragma clang diagnostic ignored "-Wnonportable-include-path"
 #endif
 
+#include <limits>
+#include <optional>
+
+#include <QApplication>
+#include <QFileDialog>
+#include <QInputDialog>
 #include <QLabel>
 #include <QMenu>
 #include <QMenuBar>
 #include <QMouseEvent>
 #include <QPlainTextEdit>
+#include <QProgressDialog>
 #include <QQuickView>
 #include <QShortcut>
 #include <QSlider>
 #include <QStackedLayout>
+#include <QTimer>
 #include <QVBoxLayout>
 #include <QVariant>
 #include <QVulkanInstance>
@@ -32,10 +40,15 @@
 #include "../brushes/mountain_brush.h"
 #include "../brushes/wall_brush.h"
 #include "../graphics/appearance_types.h"
+#include "../graphics/texture_atlas_cache.h"
 #include "../item_location.h"
+#include "../lua/lua_generation.h"
+#include "../lua/luascript_interface.h"
+#include "../map_tile_exporter.h"
 #include "../qt/logging.h"
 #include "../save_map.h"
 #include "../settings.h"
+#include "../trace.h"
 #include "../util.h"
 #include "border_layout.h"
 #include "gui_thing_image.h"
@@ -158,6 +171,11 @@ void MainWindow::addMapTab(std::shared_ptr<Map> map)
             this,
             &MainWindow::mapViewUndoRedoEvent);
 
+    connect(widget,
+            &MapViewWidget::mapChangedEvent,
+            this,
+            &MainWindow::mapViewMapChangedEvent);
+
     vulkanWindow->getMapView()->onSelectedTileThingClicked<&MainWindow::mapViewSelectedTileThingClicked>(this);
 
     if (map->name().empty())
@@ -185,10 +203,8 @@ void MainWindow::mapTabCloseEvent(int index, QVariant data)
 
 void MainWindow::mapTabChangedEvent(int index)
 {
-    if (index == -1)
-        return;
-
-    // Empty for now
+    // Scripts edit the map of the current tab
+    LuaScriptInterface::get()->registerMap(index == -1 ? nullptr : currentMapView());
 }
 
 MainWindow::MainWindow(QWidget *parent)
@@ -198,6 +214,8 @@ MainWindow::MainWindow(QWidget *parent)
       positionStatus(new QLabel),
       zoomStatus(new QLabel),
       topItemInfo(new QLabel),
+      frameStatisticsStatus(new QLabel),
+      frameStatisticsTimer(new QTimer(this)),
       _minimapWidget(new MinimapWidget(this)),
       lastUiToggleTime(TimePoint::now()) {}
 
@@ -265,6 +283,17 @@ void MainWindow::mapViewUndoRedoEvent(MapView &mapView)
     propertyWindow->refresh();
 }
 
+void MainWindow::mapViewMapChangedEvent(MapView &mapView, const MapChanges &changes)
+{
+    if (&mapView != currentMapView())
+    {
+        return;
+    }
+
+    _minimapWidget->mapChanged(changes);
+    propertyWindow->mapChanged(changes);
+}
+
 void MainWindow::mapViewMousePosEvent(MapView &mapView, util::Point<float> mousePos)
 {
     Position pos = mapView.toPosition(mousePos);
@@ -439,6 +468,12 @@ void MainWindow::initializeUI()
     topItemInfo->setText("");
     bottomLayout->addWidget(topItemInfo);
 
+    frameStatisticsStatus->setVisible(false);
+    bottomLayout->addWidget(frameStatisticsStatus);
+
+    frameStatisticsTimer->setInterval(500);
+    connect(frameStatisticsTimer, &QTimer::timeout, [this] { updateFrameStatisticsStatus(); });
+
     rootLayout->addWidget(bottomStatusBar);
 
     searchPopupWidget = new SearchPopupWidget(this);
@@ -766,6 +801,7 @@ QMenuBar *MainWindow::createMenuBar()
 
         addMenuItem(fileMenu, "New Map", Qt::CTRL | Qt::Key_N, [this] { this->addMapTab(); });
         addMenuItem(fileMenu, "Save", Qt::CTRL | Qt::Key_S, [this] { SaveMap::saveMap(*(currentMapView()->map())); });
+        addMenuItem(fileMenu, "Export Map Tiles...", 0, [this] { exportMapTiles(); });
         addMenuItem(fileMenu, "Close", Qt::CTRL | Qt::Key_W, [this] { mapTabs->removeCurrentTab(); });
     }
 
@@ -858,6 +894,7 @@ QMenuBar *MainWindow::createMenuBar()
         auto mapMenu = menuBar->addMenu(tr("Map"));
 
         addMenuItem(mapMenu, "Edit Towns", Qt::CTRL | Qt::Key_T, []() {});
+        addMenuItem(mapMenu, "Run Generation Script...", 0, [this] { runGenerationScript(); });
     }
 
     // View
@@ -910,6 +947,20 @@ QMenuBar *MainWindow::createMenuBar()
                 }
             }
         });
+
+        addMenuItem(viewMenu, "Show Frame Timing", Qt::Key_F3, [this]() {
+            setFrameStatisticsVisible(!frameStatisticsStatus->isVisible());
+        });
+
+        addMenuItem(viewMenu, "Log Frame Timing", Qt::SHIFT | Qt::Key_F3, [this]() {
+            VulkanWindow *window = currentVulkanWindow();
+            if (window && window->frameStatistics())
+            {
+                window->frameStatistics()->logSummary();
+            }
+        });
+
+        addMenuItem(viewMenu, "Log Texture Memory", 0, []() { TextureAtlasCache::logStatistics(); });
     }
 
     // Window
@@ -947,6 +998,28 @@ QMenuBar *MainWindow::createMenuBar()
         menuBar->addAction(debug);
     }
 
+    {
+        QAction *trace = new QAction(tr("Start Trace"), this);
+        connect(trace, &QAction::triggered, [=] {
+            if (!Trace::enabled())
+            {
+                Trace::start();
+                trace->setText(tr("Stop Trace"));
+                return;
+            }
+
+            Trace::stop();
+            trace->setText(tr("Start Trace"));
+
+            std::filesystem::path path = std::filesystem::absolute("vme_trace.json");
+            if (Trace::write(path))
+            {
+                VME_LOG("Wrote the trace to " << path.string() << " (open it in https://ui.perfetto.dev).");
+            }
+        });
+        menuBar->addAction(trace);
+    }
+
     {
         QAction *runBorderTest = new QAction(tr("Run Border Test"), this);
         connect(runBorderTest, &QAction::triggered, [=] { currentMapView()->testBordering(); });
@@ -962,6 +1035,48 @@ QMenuBar *MainWindow::createMenuBar()
     return menuBar;
 }
 
+void MainWindow::setFrameStatisticsVisible(bool visible)
+{
+    frameStatisticsStatus->setVisible(visible);
+    if (visible)
+    {
+        updateFrameStatisticsStatus();
+        frameStatisticsTimer->start();
+    }
+    else
+    {
+        frameStatisticsTimer->stop();
+    }
+}
+
+void MainWindow::updateFrameStatisticsStatus()
+{
+    VulkanWindow *window = currentVulkanWindow();
+    const FrameStatistics *statistics = window ? window->frameStatistics() : nullptr;
+    if (!statistics || statistics->frameCount() == 0)
+    {
+        frameStatisticsStatus->setText("");
+        return;
+    }
+
+    auto frame = statistics->millis(RenderPhase::Frame);
+    auto map = statistics->millis(RenderPhase::Map);
+    const FrameCounters &counters = statistics->lastCounters();
+
+    frameStatisticsStatus->setText(
+        QString("Frame %1/%2/%3 ms (map %4/%5/%6)  Tiles: %7  Sprites: %8  Binds: %9  Animated: %10")
+            .arg(frame.p50, 0, 'f', 2)
+            .arg(frame.p95, 0, 'f', 2)
+            .arg(frame.p99, 0, 'f', 2)
+            .arg(map.p50, 0, 'f', 2)
+            .arg(map.p95, 0, 'f', 2)
+            .arg(map.p99, 0, 'f', 2)
+            .arg(counters.tilesVisited)
+            .arg(counters.spritesIssued)
+            .arg(counters.descriptorBinds)
+            .arg(counters.animatedItems));
+}
+
 void MainWindow::setPropertyPanelVisible(bool visible)
 {
     if (visible)
@@ -996,6 +1111,89 @@ void MainWindow::copySelection()
     }
 }
 
+void MainWindow::exportMapTiles()
+{
+    MapView *mapView = currentMapView();
+    if (!mapView)
+    {
+        return;
+    }
+
+    QString directory = QFileDialog::getExistingDirectory(this, tr("Export Map Tiles"));
+    if (directory.isEmpty())
+    {
+        return;
+    }
+
+    // The modal dialog keeps the map from being edited during the export
+    QProgressDialog progressDialog(tr("Exporting map tiles..."), tr("Cancel"), 0, 0, this);
+    progressDialog.setWindowTitle(tr("Export Map Tiles"));
+    progressDialog.setWindowModality(Qt::WindowModal);
+    progressDialog.setMinimumDuration(0);
+
+    MapTileExporter::Options options;
+    options.outputDirectory = directory.toStdString();
+    options.progress = [&progressDialog](uint32_t done, uint32_t total) {
+        progressDialog.setMaximum(static_cast<int>(total));
+        // Processes events of the modal dialog, including the cancel button
+        progressDialog.setValue(static_cast<int>(done));
+        return !progressDialog.wasCanceled();
+    };
+
+    MapTileExporter(mapView->sharedMap(), options).exportTiles();
+}
+
+void MainWindow::runGenerationScript()
+{
+    MapView *mapView = currentMapView();
+    if (!mapView)
+    {
+        return;
+    }
+
+    QString script = QFileDialog::getOpenFileName(this, tr("Run Generation Script"), QString(), tr("Lua scripts (*.lua)"));
+    if (script.isEmpty())
+    {
+        return;
+    }
+
+    bool ok = false;
+    int seed = QInputDialog::getInt(this, tr("Run Generation Script"), tr("Seed:"), 0, 0, std::numeric_limits<int>::max(), 1, &ok);
+    if (!ok)
+    {
+        return;
+    }
+
+    Position from(0, 0, mapView->z());
+    Position to(mapView->mapWidth() - 1, mapView->mapHeight() - 1, mapView->z());
+
+    const Selection &selection = mapView->selection();
+    if (!selection.empty())
+    {
+        from = selection.getCorner(false, false, false).value();
+        to = selection.getCorner(true, true, true).value();
+    }
+
+    LuaChunkGenerator::Options options;
+    options.script = script.toStdString();
+    options.seed = static_cast<uint32_t>(seed);
+
+    LuaChunkGenerator generator(options);
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    std::optional<size_t> changedTiles = generator.run(*mapView, from, to);
+    QApplication::restoreOverrideCursor();
+
+    if (changedTiles)
+    {
+        VME_LOG("Generation script " << options.script.filename().string() << " changed " << *changedTiles << " tiles.");
+    }
+    else
+    {
+        VME_LOG_ERROR("Generation script " << options.script.filename().string() << " failed: " << generator.error());
+    }
+}
+
 bool MainWindow::hasCopyBuffer() const
 {
     return !mapCopyBuffer.empty();
@@ -76,6 +76,15 @@ class MainWindow : public QWidget
 
     void copySelection();
 
+    // Asks for a directory and exports the floors of the current map to it as a tile pyramid
+    void exportMapTiles();
+
+    /*
+		Asks for a Lua generation script and a seed, and runs the script over the selection of the current map (see
+		LuaChunkGenerator). Without a selection, the script runs over the whole current floor.
+	*/
+    void runGenerationScript();
+
   protected:
     void mousePressEvent(QMouseEvent *event) override;
     bool event(QEvent *event) override;
@@ -89,6 +98,7 @@ class MainWindow : public QWidget
     void mapViewSelectionChangedEvent(MapView &mapView);
     void mapViewSelectedTileThingClicked(MapView *mapView, const Tile *tile, TileThing tileThing);
     void mapViewUndoRedoEvent(MapView &mapView);
+    void mapViewMapChangedEvent(MapView &mapView, const MapChanges &changes);
     void mapViewViewportEvent(MapView &mapView, const Camera::Viewport &viewport);
     void mapTabCloseEvent(int index, QVariant data);
     void mapTabChangedEvent(int index);
@@ -100,6 +110,9 @@ class MainWindow : public QWidget
 
     void registerPropertyItemListeners();
 
+    void setFrameStatisticsVisible(bool visible);
+    void updateFrameStatisticsStatus();
+
     MapTabWidget *mapTabs = nullptr;
     ItemPropertyWindow *propertyWindow = nullptr;
     QWidget *propertyWindowContainer = nullptr;
@@ -113,6 +126,10 @@ class MainWindow : public QWidget
     QLabel *zoomStatus = nullptr;
     QLabel *topItemInfo = nullptr;
 
+    // Frame timing overlay. Refreshed by frameStatisticsTimer while visible.
+    QLabel *frameStatisticsStatus = nullptr;
+    QTimer *frameStatisticsTimer = nullptr;
+
     uint32_t highestUntitledId = 0;
     std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> untitledIds;
 
@@ -77,6 +77,7 @@ MapViewWidget::MapViewWidget(VulkanWindow *window, QWidget *parent)
     mapView->onDrawMinimapRequest<&MapViewWidget::mapViewMinimapDrawRequested>(this);
     mapView->selection().onChanged<&MapViewWidget::selectionChanged>(this);
     mapView->onUndoRedo<&MapViewWidget::undoRedoPerformed>(this);
+    mapView->onMapChanged<&MapViewWidget::mapChanged>(this);
 
     {
         auto l = new BorderLayout;
@@ -187,6 +188,11 @@ void MapViewWidget::undoRedoPerformed()
     emit undoRedoEvent(*mapView);
 }
 
+void MapViewWidget::mapChanged(const MapChanges &changes)
+{
+    emit mapChangedEvent(*mapView, changes);
+}
+
 /*
 ********************************
 ********************************
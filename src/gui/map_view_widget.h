@@ -39,6 +39,7 @@ class MapViewWidget : public QWidget, public Nano::Observer<>
     void mapViewMinimapDrawRequested();
     void selectionChanged();
     void undoRedoPerformed();
+    void mapChanged(const MapChanges &changes);
 
     VulkanWindow *getVulkanWindow() const
     {
@@ -51,6 +52,7 @@ class MapViewWidget : public QWidget, public Nano::Observer<>
     void viewportChangedEvent(const Camera::Viewport &viewport);
     void selectionChangedEvent(MapView &mapView);
     void undoRedoEvent(MapView &mapView);
+    void mapChangedEvent(MapView &mapView, const MapChanges &changes);
 
   private:
     // QT calls delete for this value when the MapViewWidget is destroyed.
@@ -1,5 +1,7 @@
 #include "minimap.h"
 
+#include <algorithm>
+
 #include <QHBoxLayout>
 #include <QLabel>
 #include <QResizeEvent>
@@ -79,7 +81,50 @@ void MinimapWidget::update()
     auto from = Position(std::max(0, offsetX), std::max(0, offsetY), viewportMidPoint.z);
     auto to = viewportMidPoint + delta;
 
-    for (auto &tileLocation : mapView->map()->getRegion(from, to))
+    canvasOrigin = Position(offsetX, offsetY, viewportMidPoint.z);
+    drawTiles(*mapView, from, to);
+
+    imageContainer->setPixmap(QPixmap::fromImage(canvas));
+}
+
+void MinimapWidget::mapChanged(const MapChanges &changes)
+{
+    if (!isVisible() || !canvasOrigin || changes.tileCount == 0)
+        return;
+
+    const Position &origin = *canvasOrigin;
+    if (origin.z < changes.from.z || changes.to.z < origin.z)
+        return;
+
+    // The changed tiles that are on the canvas
+    auto from = Position(std::max({0, changes.from.x, origin.x}), std::max({0, changes.from.y, origin.y}), origin.z);
+    auto to = Position(std::min(changes.to.x, origin.x + canvas.width() - 1), std::min(changes.to.y, origin.y + canvas.height() - 1), origin.z);
+    if (from.x > to.x || from.y > to.y)
+        return;
+
+    MapView *mapView = mainWindow->currentMapView();
+    if (!mapView)
+        return;
+
+    // Removed tiles are not part of the region, so their pixels are cleared first
+    for (int y = from.y; y <= to.y; ++y)
+    {
+        for (int x = from.x; x <= to.x; ++x)
+        {
+            canvas.setPixel(x - origin.x, y - origin.y, qRgb(0, 0, 0));
+        }
+    }
+
+    drawTiles(*mapView, from, to);
+
+    imageContainer->setPixmap(QPixmap::fromImage(canvas));
+}
+
+void MinimapWidget::drawTiles(const MapView &mapView, const Position &from, const Position &to)
+{
+    const Position &origin = *canvasOrigin;
+
+    for (auto &tileLocation : mapView.map()->getRegion(from, to))
     {
         if (!tileLocation.hasTile())
             continue;
@@ -91,14 +136,12 @@ void MinimapWidget::update()
             auto color = MinimapColors::colors[tile->minimapColor()];
 
             Position tilePos = tile->position();
-            int x = tilePos.x - offsetX;
-            int y = tilePos.y - offsetY;
+            int x = tilePos.x - origin.x;
+            int y = tilePos.y - origin.y;
 
             canvas.setPixel(x, y, (color.a << 24) | (color.r << 16) | (color.g << 8) | color.b);
         }
     }
-
-    imageContainer->setPixmap(QPixmap::fromImage(canvas));
 }
 
 void MinimapWidget::resizeEvent(QResizeEvent *event)
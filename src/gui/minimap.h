@@ -6,6 +6,7 @@
 
 #include <optional>
 
+#include "../position.h"
 #include "../time_util.h"
 
 class QResizeEvent;
@@ -14,6 +15,7 @@ class QImage;
 class QLabel;
 class MapView;
 class MainWindow;
+struct MapChanges;
 
 class MinimapWidget : public QWidget
 {
@@ -23,15 +25,23 @@ class MinimapWidget : public QWidget
     void update();
     void toggle();
 
+    // Redraws the changed tiles that are shown, without drawing the rest of the minimap again
+    void mapChanged(const MapChanges &changes);
+
   protected:
     void resizeEvent(QResizeEvent *event) override;
     void showEvent(QShowEvent *event) override;
 
   private:
+    void drawTiles(const MapView &mapView, const Position &from, const Position &to);
+
     uint32_t refreshCooldownMs = 16;
     QSize _size;
 
     QImage canvas;
+
+    // The map position of the top left pixel of the canvas. The z is the floor that is shown.
+    std::optional<Position> canvasOrigin;
     QLabel *imageContainer;
 
     MainWindow *mainWindow;
@@ -155,6 +155,7 @@ void ItemPropertyWindow::focusGround(Item *item, Position &position, MapView &ma
 
     resetFocus();
 
+    setSelectedPosition(position);
     setMapView(mapView);
 
     DEBUG_ASSERT(item != nullptr, "Can not focus nullptr ground.");
@@ -651,6 +652,52 @@ void ItemPropertyWindow::refresh()
     }
 }
 
+void ItemPropertyWindow::mapChanged(const MapChanges &changes)
+{
+    if (!state.mapView)
+    {
+        return;
+    }
+
+    if (changes.dirty(state.selectedPosition))
+    {
+        const Tile *tile = state.mapView->getTile(state.selectedPosition);
+        if (!tile || !focusedThingIsOn(*tile))
+        {
+            resetFocus();
+            return;
+        }
+
+        refresh();
+    }
+    else if (!changes.changedGuids.empty())
+    {
+        refresh();
+    }
+}
+
+bool ItemPropertyWindow::focusedThingIsOn(const Tile &tile)
+{
+    if (state.holds<FocusedGround>())
+    {
+        return tile.ground() == state.focusedAs<FocusedGround>().item();
+    }
+    else if (state.holds<FocusedItem>())
+    {
+        return tile.indexOf(state.focusedAs<FocusedItem>().item).has_value();
+    }
+    else if (state.holds<FocusedContainer>())
+    {
+        return tile.indexOf(state.focusedAs<FocusedContainer>().containerItem()).has_value();
+    }
+    else if (state.holds<FocusedCreature>())
+    {
+        return tile.creature() == state.focusedAs<FocusedCreature>().creature;
+    }
+
+    return false;
+}
+
 bool ItemPropertyWindow::containerItemSelectedEvent(PropertiesUI::ContainerNode *treeNode, int index)
 {
     DEBUG_ASSERT(state.holds<FocusedContainer>(), "Must be a focused container.");
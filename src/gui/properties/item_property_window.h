@@ -21,6 +21,7 @@
 
 class MainWindow;
 class ItemPropertyWindow;
+struct MapChanges;
 struct ItemLocation;
 
 namespace PropertiesUI
@@ -100,6 +101,9 @@ class ItemPropertyWindow : public QQuickView
 
     void refresh();
 
+    // Refreshes the shown values if the change touched the focused thing, and drops the focus if it was removed
+    void mapChanged(const MapChanges &changes);
+
     void focusItem(Item *item, Position &position, MapView &mapView);
     void focusCreature(Creature *creature, Position &position, MapView &mapView);
     void focusGround(Item *item, Position &position, MapView &mapView);
@@ -147,8 +151,6 @@ class ItemPropertyWindow : public QQuickView
             DEBUG_ASSERT(item->isContainer(), "Item must be a container.");
         }
 
-        FocusedContainer(const FocusedContainer &other) = default;
-        FocusedContainer &operator=(const FocusedContainer &other) = default;
         FocusedContainer(FocusedContainer &&other) = default;
 
         Item *containerItem() const noexcept
@@ -166,8 +168,6 @@ class ItemPropertyWindow : public QQuickView
         FocusedGround(Position position, Item *ground)
             : trackedGround(ground) {}
 
-        FocusedGround(const FocusedGround &other) = default;
-        FocusedGround &operator=(const FocusedGround &other) = default;
         FocusedGround(FocusedGround &&other) = default;
 
         Item *item() const noexcept
@@ -203,6 +203,8 @@ class ItemPropertyWindow : public QQuickView
     void setPropertyItem(Item *item);
     void setPropertyCreature(Creature *creature);
 
+    bool focusedThingIsOn(const Tile &tile);
+
     /**
    * Returns a child from QML with objectName : name
    */
@@ -7,6 +7,7 @@
 #include <QQuickItem>
 #include <QWidget>
 
+#include "../brushes/brush_search.h"
 #include "gui_thing_image.h"
 #include "mainwindow.h"
 #include "qt_util.h"
@@ -33,6 +34,14 @@ SearchPopupView::SearchPopupView(QUrl filepath, MainWindow *mainWindow)
     engine()->rootContext()->setContextProperty("applicationContext", applicationContext);
 }
 
+SearchPopupView::~SearchPopupView()
+{
+    if (activeSearch)
+    {
+        activeSearch->cancel();
+    }
+}
+
 void SearchPopupView::focus()
 {
     _wrapperWidget->setFocus();
@@ -72,15 +81,71 @@ void SearchPopupView::hideEvent(QHideEvent *e)
 
 void SearchPopupView::search(std::string searchTerm)
 {
-    if (searchTerm.size() > 2)
+    if (activeSearch)
     {
-        auto results = Brush::search(searchTerm);
-        searchResultModel.setSearchResults(std::move(results));
+        activeSearch->cancel();
+        activeSearch.reset();
+    }
+
+    if (searchTerm.size() <= 2)
+    {
+        lastFinishedSearch.reset();
+        searchResultModel.clear();
+        return;
+    }
+
+    auto search = std::make_shared<BrushSearch>(Brush::searchIndex(), std::move(searchTerm), lastFinishedSearch);
+    activeSearch = search;
+    activeSearchHasResults = false;
+
+    // The matches are passed back to the GUI thread. Qt drops them if the view is gone by then.
+    searchWorker.submit([this, search]() {
+        bool finished = search->run([this, search](BrushSearchResult &&results) {
+            auto shared = std::make_shared<BrushSearchResult>(std::move(results));
+            QMetaObject::invokeMethod(
+                this, [this, search, shared]() { searchResultsReceived(search, std::move(*shared)); }, Qt::QueuedConnection);
+        });
+
+        if (finished)
+        {
+            QMetaObject::invokeMethod(
+                this, [this, search]() { searchFinished(search); }, Qt::QueuedConnection);
+        }
+    });
+}
+
+void SearchPopupView::searchResultsReceived(const std::shared_ptr<BrushSearch> &search, BrushSearchResult &&results)
+{
+    if (search != activeSearch)
+    {
+        return;
+    }
+
+    if (activeSearchHasResults)
+    {
+        searchResultModel.appendSearchResults(std::move(results));
     }
     else
+    {
+        searchResultModel.setSearchResults(std::move(results));
+        activeSearchHasResults = true;
+    }
+}
+
+void SearchPopupView::searchFinished(const std::shared_ptr<BrushSearch> &search)
+{
+    if (search != activeSearch)
+    {
+        return;
+    }
+
+    if (!activeSearchHasResults)
     {
         searchResultModel.clear();
     }
+
+    lastFinishedSearch = search;
+    activeSearch.reset();
 }
 
 SearchWrapperEventFilter::SearchWrapperEventFilter(SearchPopupView *parent)
@@ -193,6 +258,31 @@ void SearchResultModel::setSearchResults(BrushSearchResult &&brushes)
     endResetModel();
 }
 
+void SearchResultModel::appendSearchResults(BrushSearchResult &&brushes)
+{
+    if (!_searchResults)
+    {
+        setSearchResults(std::move(brushes));
+        return;
+    }
+
+    if (brushes.matches->empty())
+    {
+        return;
+    }
+
+    auto &matches = *_searchResults->matches;
+    int first = static_cast<int>(matches.size());
+
+    beginInsertRows(QModelIndex(), first, first + static_cast<int>(brushes.matches->size()) - 1);
+    matches.insert(matches.end(), brushes.matches->begin(), brushes.matches->end());
+    _searchResults->rawCount += brushes.rawCount;
+    _searchResults->groundCount += brushes.groundCount;
+    _searchResults->doodadCount += brushes.doodadCount;
+    _searchResults->creatureCount += brushes.creatureCount;
+    endInsertRows();
+}
+
 QVariant SearchResultModel::data(const QModelIndex &index, int role) const
 {
     if (index.row() < 0 || index.row() >= _searchResults->matches->size())
@@ -237,6 +327,9 @@ void FilteredSearchModel::setSourceModel(QAbstractItemModel *model)
     connect(this, &SearchResultModel::modelReset, [this]() {
         emit searchModelChanged();
     });
+    connect(model, &QAbstractItemModel::rowsInserted, this, [this]() {
+        emit searchModelChanged();
+    });
     QSortFilterProxyModel::setSourceModel(model);
 }
 
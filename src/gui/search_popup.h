@@ -9,15 +9,18 @@
 #include <QWidget>
 
 #include <functional>
+#include <memory>
 #include <optional>
 
 #include "../brushes/brush.h"
+#include "../thread_pool.h"
 
 class MainWindow;
 class Brush;
 class QHideEvent;
 class SearchResultModel;
 class ItemTypeImageProvider;
+class BrushSearch;
 
 class FilteredSearchModel : public QSortFilterProxyModel
 {
@@ -80,6 +83,8 @@ class SearchResultModel : public QAbstractListModel
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
 
     void setSearchResults(BrushSearchResult &&brushes);
+    // Adds the matches to the end of the current results, and their counts to the current counts.
+    void appendSearchResults(BrushSearchResult &&brushes);
     const std::optional<BrushSearchResult> &searchResults() const
     {
         return _searchResults;
@@ -107,6 +112,7 @@ class SearchPopupView : public QQuickView
 
   public:
     SearchPopupView(QUrl filepath, MainWindow *mainWindow);
+    ~SearchPopupView();
 
     Q_INVOKABLE void searchEvent(QString searchTerm);
     Q_INVOKABLE void setHeight(int height);
@@ -136,6 +142,19 @@ class SearchPopupView : public QQuickView
     SearchResultModel searchResultModel;
     FilteredSearchModel filteredSearchModel;
     QObject *child(const char *name);
+
+    void searchResultsReceived(const std::shared_ptr<BrushSearch> &search, BrushSearchResult &&results);
+    void searchFinished(const std::shared_ptr<BrushSearch> &search);
+
+    std::shared_ptr<BrushSearch> activeSearch;
+    // The results of the active search replace the current results when its first matches arrive
+    bool activeSearchHasResults = false;
+
+    // The last search that ran to completion. A search for a longer query only looks at its matches.
+    std::shared_ptr<const BrushSearch> lastFinishedSearch;
+
+    // Runs the searches off the GUI thread. Declared last so that it is joined before the rest is destroyed.
+    ThreadPool searchWorker{1};
 };
 
 /**
@@ -5,6 +5,7 @@
 #include <memory>
 
 #include <QAction>
+#include <QCoreApplication>
 #include <QDialog>
 #include <QDrag>
 #include <QFocusEvent>
@@ -23,6 +24,7 @@
 #include "../brushes/ground_brush.h"
 #include "../brushes/mountain_brush.h"
 #include "../brushes/wall_brush.h"
+#include "../graphics/atlas_decompressor.h"
 #include "../item_location.h"
 #include "../logger.h"
 #include "../map_renderer.h"
@@ -30,6 +32,7 @@
 #include "../position.h"
 #include "../qt/logging.h"
 #include "../settings.h"
+#include "../trace.h"
 #include "gui.h"
 #include "mainwindow.h"
 #include "qt_util.h"
@@ -688,6 +691,16 @@ util::Size VulkanWindow::vulkanSwapChainImageSize() const
     return util::Size(size.width(), size.height());
 }
 
+const FrameStatistics *VulkanWindow::frameStatistics() const
+{
+    if (!renderer)
+    {
+        return nullptr;
+    }
+
+    return &static_cast<const VulkanWindow::Renderer *>(renderer)->mapRenderer().frameStatistics();
+}
+
 void VulkanWindow::updateVulkanInfo()
 {
     vulkanInfo.update();
@@ -798,9 +811,44 @@ QRect QtContextMenu::relativeGeometry() const
 //>>>>>>>>>>>>>>>>>>>>>>
 //>>>>>>>>>>>>>>>>>>>>>>
 
+std::unordered_set<VulkanWindow::Renderer *> VulkanWindow::Renderer::waitingForAtlases;
+
 VulkanWindow::Renderer::Renderer(VulkanWindow &window)
     : window(window),
-      renderer(window.vulkanInfo, window.mapView.get()) {}
+      renderer(window.vulkanInfo, window.mapView.get())
+{
+    redrawTimer.setSingleShot(true);
+    QObject::connect(&redrawTimer, &QTimer::timeout, [this]() { this->window.requestUpdate(); });
+
+    static bool wakeUpSet = false;
+    if (!wakeUpSet)
+    {
+        AtlasDecompressor::setWakeUp([]() {
+            if (QCoreApplication *application = QCoreApplication::instance())
+            {
+                QMetaObject::invokeMethod(application, &Renderer::atlasesDecompressed, Qt::QueuedConnection);
+            }
+        });
+        wakeUpSet = true;
+    }
+}
+
+VulkanWindow::Renderer::~Renderer()
+{
+    waitingForAtlases.erase(this);
+}
+
+void VulkanWindow::Renderer::atlasesDecompressed()
+{
+    AtlasDecompressor::installFinished();
+
+    // A frame of another renderer can have installed the atlases already, so the waiting renderers are always redrawn
+    for (Renderer *renderer : waitingForAtlases)
+    {
+        renderer->window.requestUpdate();
+    }
+    waitingForAtlases.clear();
+}
 
 void VulkanWindow::Renderer::initResources()
 {
@@ -824,6 +872,7 @@ void VulkanWindow::Renderer::releaseResources()
 
 void VulkanWindow::Renderer::startNextFrame()
 {
+    VME_TRACE_SCOPE("VulkanWindow::startNextFrame");
     renderer.setCurrentFrame(window.currentFrame());
     auto frame = renderer.currentFrame();
     frame->currentFrameIndex = window.currentFrame();
@@ -832,8 +881,23 @@ void VulkanWindow::Renderer::startNextFrame()
     frame->mouseAction = window.mapView->editorAction.action();
 
     renderer.startNextFrame();
-    if (renderer._containsAnimation && Settings::RENDER_ANIMATIONS)
+
+    // Placeholders are replaced by the frame after the decompression of their atlases finishes
+    if (AtlasDecompressor::hasPending())
+    {
+        waitingForAtlases.emplace(this);
+    }
+
+    // Wake up exactly when the next visible animation changes phase. Restarting the timer replaces any earlier
+    // wake-up, so at most one is pending.
+    auto delay = renderer.animationScheduler().millisUntilNextDeadline();
+
+    if (delay)
+    {
+        redrawTimer.start(static_cast<int>(*delay));
+    }
+    else
     {
-        QTimer::singleShot(50, [this]() { window.requestUpdate(); });
+        redrawTimer.stop();
     }
 }
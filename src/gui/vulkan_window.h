@@ -12,6 +12,7 @@
 #include <QMenu>
 #include <QMimeData>
 #include <QPixmap>
+#include <QTimer>
 #include <QVulkanWindow>
 
 #include "../graphics/vulkan_helpers.h"
@@ -53,15 +54,31 @@ class VulkanWindow : public QVulkanWindow
     {
       public:
         Renderer(VulkanWindow &window);
+        ~Renderer();
+
         void initResources() override;
         void initSwapChainResources() override;
         void releaseSwapChainResources() override;
         void releaseResources() override;
         void startNextFrame() override;
 
+        const MapRenderer &mapRenderer() const noexcept
+        {
+            return renderer;
+        }
+
       private:
         VulkanWindow &window;
         MapRenderer renderer;
+
+        // Triggers a redraw when the next visible animation changes phase
+        QTimer redrawTimer;
+
+        // Installs the atlases that were decompressed in the background and redraws the renderers that waited for them
+        static void atlasesDecompressed();
+
+        // Renderers that drew placeholders for atlases that were still being decompressed. Only used on the GUI thread.
+        static std::unordered_set<Renderer *> waitingForAtlases;
     };
 
     VulkanWindow(std::shared_ptr<Map> map, EditorAction &editorAction);
@@ -93,6 +110,11 @@ class VulkanWindow : public QVulkanWindow
 
     util::Size vulkanSwapChainImageSize() const;
 
+    /*
+		Returns nullptr if the window has not created its renderer yet.
+	*/
+    const FrameStatistics *frameStatistics() const;
+
     inline static bool isInstance(const VulkanWindow *pointer)
     {
         return instances.find(pointer) != instances.end();
@@ -2,6 +2,7 @@
 
 #include "../debug.h"
 #include "../map_view.h"
+#include "../trace.h"
 #include "../util.h"
 
 namespace
@@ -36,6 +37,7 @@ namespace MapHistory
 
     void History::commit(Action &&action)
     {
+        VME_TRACE_SCOPE("History::commit");
         DEBUG_ASSERT(currentTransaction.has_value(), "There is no current transaction.");
 
         if (!action.committed)
@@ -71,10 +73,12 @@ namespace MapHistory
         }
 
         currentTransaction.emplace(type);
+        mapView->beginNotificationBatch();
     }
 
     void History::endTransaction(TransactionType type)
     {
+        VME_TRACE_SCOPE("History::endTransaction");
         // VME_LOG_D("History::endTransaction: " << type);
         DEBUG_ASSERT(currentTransaction.has_value(), "There is no current transaction to end.");
         DEBUG_ASSERT(currentTransaction.value().type == type, "The current transaction type differs from the passed in transaction type.");
@@ -93,10 +97,12 @@ namespace MapHistory
         currentTransaction.reset();
 
         mapView->selection().update();
+        mapView->endNotificationBatch();
     }
 
     bool History::undo()
     {
+        VME_TRACE_SCOPE("History::undo");
         if (currentTransaction.has_value())
         {
             endTransaction(currentTransaction.value().type);
@@ -108,7 +114,9 @@ namespace MapHistory
         }
         else
         {
+            mapView->beginNotificationBatch();
             transactions.at(insertionIndex - 1).undo(*mapView);
+            mapView->endNotificationBatch();
             --insertionIndex;
 
             return true;
@@ -117,10 +125,13 @@ namespace MapHistory
 
     bool History::redo()
     {
+        VME_TRACE_SCOPE("History::redo");
         if (insertionIndex == transactions.size())
             return false;
 
+        mapView->beginNotificationBatch();
         transactions.at(insertionIndex).redo(*mapView);
+        mapView->endNotificationBatch();
         ++insertionIndex;
 
         return true;
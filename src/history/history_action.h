@@ -22,7 +22,8 @@ enum class TransactionType
     RemoveMapItem,
     MoveItems,
     ModifyItem,
-    ModifyCreature
+    ModifyCreature,
+    Script
 };
 
 namespace MapHistory
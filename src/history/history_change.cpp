@@ -12,6 +12,9 @@ namespace MapHistory
     void ChangeItem::updateSelection(MapView &mapView, const Position &position)
     {
         mapView.selection().updatePosition(position);
+
+        // The tile itself is unchanged, so tileChanged does not request the draw of the new selection
+        mapView.requestDraw();
     }
 
     void ChangeItem::swapMapTile(MapView &mapView, std::unique_ptr<Tile> &&tile)
@@ -34,6 +37,7 @@ namespace MapHistory
         // location.tile()->movedInMap();
 
         mapView.selection().setSelected(position, selected);
+        mapView.tileChanged(position);
     }
 
     std::unique_ptr<Tile> ChangeItem::setMapTile(MapView &mapView, Tile &&tile)
@@ -45,6 +49,7 @@ namespace MapHistory
         std::unique_ptr<Tile> oldTilePointer = location.replaceTile(std::move(tile));
 
         mapView.selection().setSelected(position, selected);
+        mapView.tileChanged(position);
 
         return oldTilePointer;
     }
@@ -59,6 +64,7 @@ namespace MapHistory
             mapView.selection().deselect(oldTile->position());
         }
 
+        mapView.tileChanged(position);
         return map->dropTile(position);
     }
 
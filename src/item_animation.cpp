@@ -1,5 +1,6 @@
 #include "item_animation.h"
 
+#include <algorithm>
 #include <chrono>
 #include <numeric>
 
@@ -93,6 +94,22 @@ uint32_t ItemAnimation::getNextPhaseMaxDuration() const
     return phase.maxDuration;
 }
 
+bool ItemAnimation::finished() const noexcept
+{
+    return animationInfo->loopType == AnimationLoopType::Counted && std::get<uint32_t>(state.info) == animationInfo->loopCount;
+}
+
+std::optional<TimePoint> ItemAnimation::nextPhaseTime() const
+{
+    if (finished())
+    {
+        return std::nullopt;
+    }
+
+    // update() changes phase once strictly more than phaseDurationMs has elapsed, hence the + 1.
+    return state.lastUpdateTime.forwardMs(static_cast<TimePoint::time_t>(state.phaseDurationMs) + 1);
+}
+
 void ItemAnimation::setPhase(size_t phaseIndex, TimePoint updateTime)
 {
     SpritePhase phase = animationInfo->phases.at(phaseIndex);
@@ -201,4 +218,44 @@ void ItemAnimation::updateCounted()
 
         setPhase(0, currentTime);
     }
-}
\ No newline at end of file
+}
+
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+//>>>>>AnimationScheduler>>>>>>>
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+
+void AnimationScheduler::beginFrame() noexcept
+{
+    deadline.reset();
+}
+
+void AnimationScheduler::add(const ItemAnimation &animation)
+{
+    std::optional<TimePoint> next = animation.nextPhaseTime();
+    if (next && (!deadline || *next < *deadline))
+    {
+        deadline = next;
+    }
+}
+
+bool AnimationScheduler::hasDeadline() const noexcept
+{
+    return deadline.has_value();
+}
+
+std::optional<TimePoint> AnimationScheduler::nextDeadline() const noexcept
+{
+    return deadline;
+}
+
+std::optional<long long> AnimationScheduler::millisUntilNextDeadline() const
+{
+    if (!deadline)
+    {
+        return std::nullopt;
+    }
+
+    return std::max<long long>(deadline->timeSince<std::chrono::milliseconds>(TimePoint::now()), 0);
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <optional>
 #include <variant>
 #include <vector>
 
@@ -55,6 +56,13 @@ struct ItemAnimation
 
     uint32_t getNextPhaseMaxDuration() const;
 
+    /*
+        The earliest time at which update() will change the phase. Empty if the animation has finished.
+    */
+    std::optional<TimePoint> nextPhaseTime() const;
+
+    bool finished() const noexcept;
+
     inline size_t nextPhase() const
     {
         return (static_cast<size_t>(state.phaseIndex) + 1) % animationInfo->phases.size();
@@ -93,4 +101,26 @@ struct ItemAnimation
     void updateCounted();
 
     uint32_t loopTime = 0;
-};
\ No newline at end of file
+};
+
+/*
+    Tracks the earliest next phase change among the animations seen while rendering a frame. The renderer uses it
+    to redraw exactly when the next visible animation changes, instead of redrawing continuously.
+*/
+class AnimationScheduler
+{
+  public:
+    void beginFrame() noexcept;
+    void add(const ItemAnimation &animation);
+
+    bool hasDeadline() const noexcept;
+    std::optional<TimePoint> nextDeadline() const noexcept;
+
+    /*
+        Milliseconds from now until the next deadline (never negative). Empty if nothing needs to be redrawn.
+    */
+    std::optional<long long> millisUntilNextDeadline() const;
+
+  private:
+    std::optional<TimePoint> deadline;
+};
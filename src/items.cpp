@@ -62,7 +62,7 @@ namespace
 } // namespace
 
 Items::Items()
-    : guidRefCounts(InitialMaxGuids)
+    : guidSlots(InitialMaxGuids)
 {
 }
 
@@ -79,19 +79,19 @@ uint32_t Items::createItemGid()
         freedItemGuids.pop();
     }
 
-    if (guidRefCounts.size() <= id)
+    if (guidSlots.size() <= id)
     {
-        guidRefCounts.resize(guidRefCounts.size() * 4);
+        guidSlots.resize(guidSlots.size() * 4);
     }
 
-    guidRefCounts.at(id) = 1;
+    guidSlots[id].refCount = 1;
 
     return id;
 }
 
 void Items::guidRefCreated(uint32_t id)
 {
-    uint16_t &refCount = guidRefCounts.at(id);
+    uint16_t &refCount = guidSlots.at(id).refCount;
     DEBUG_ASSERT(refCount != 0, "There is no item with that uid.");
     ++refCount;
 }
@@ -99,15 +99,20 @@ void Items::guidRefCreated(uint32_t id)
 void Items::guidRefDestroyed(uint32_t id)
 {
     // Happens for example when a creature with an item look is destructured
-    if (id >= guidRefCounts.size())
+    if (id >= guidSlots.size())
     {
         return;
     }
 
-    uint16_t &refCount = guidRefCounts.at(id);
-    --refCount;
-    if (refCount == 0)
+    GuidSlot &slot = guidSlots[id];
+    --slot.refCount;
+    if (slot.refCount == 0)
     {
+        // Signals of the item are released when their observers disconnect
+        ++slot.generation;
+        slot.itemSignal = NoSignal;
+        slot.containerSignal = NoSignal;
+
         freedItemGuids.emplace(id);
     }
 }
@@ -189,28 +194,106 @@ void Items::loadFromXml(const std::filesystem::path path)
 
 void Items::itemAddressChanged(Item *item)
 {
-    auto found = itemSignals.find(item->guid());
-    if (found != itemSignals.end())
+    // Bulk moves call this for every item, and usually nothing is observed
+    if (itemSignals.empty())
     {
-        found->second.address.fire(item);
+        return;
+    }
+
+    uint32_t index = guidSlots[item->guid()].itemSignal;
+    if (index != NoSignal)
+    {
+        itemSignals[index].signal.address.fire(item);
     }
 }
 
 void Items::itemPropertyChanged(Item *item, const ItemChangeType changeType)
 {
-    auto found = itemSignals.find(item->guid());
-    if (found != itemSignals.end())
+    if (itemSignals.empty())
+    {
+        return;
+    }
+
+    uint32_t index = guidSlots[item->guid()].itemSignal;
+    if (index == NoSignal)
+    {
+        return;
+    }
+
+    ItemSignal &signal = itemSignals[index].signal;
+    if (notificationBatchDepth == 0)
+    {
+        signal.property.fire(changeType);
+        return;
+    }
+
+    if (signal.pendingProperties == 0)
+    {
+        pendingPropertyChanges.emplace_back(index);
+    }
+    signal.pendingProperties |= 1 << to_underlying(changeType);
+}
+
+void Items::beginNotificationBatch()
+{
+    ++notificationBatchDepth;
+}
+
+void Items::endNotificationBatch(std::vector<uint32_t> *changedGuids)
+{
+    DEBUG_ASSERT(notificationBatchDepth != 0, "There is no notification batch to end.");
+
+    if (--notificationBatchDepth == 0)
     {
-        found->second.property.fire(changeType);
+        flushNotifications(changedGuids);
+    }
+}
+
+void Items::flushNotifications(std::vector<uint32_t> *changedGuids)
+{
+    // Observers may change item properties while they are notified
+    std::vector<uint32_t> pending;
+    std::swap(pending, pendingPropertyChanges);
+
+    for (uint32_t index : pending)
+    {
+        auto &entry = itemSignals[index];
+        uint8_t properties = entry.signal.pendingProperties;
+        entry.signal.pendingProperties = 0;
+
+        // Released, or the item is gone
+        const GuidSlot &slot = guidSlots[entry.guid];
+        if (properties == 0 || slot.generation != entry.generation || slot.itemSignal != index)
+        {
+            continue;
+        }
+
+        if (changedGuids)
+        {
+            changedGuids->emplace_back(entry.guid);
+        }
+
+        for (ItemChangeType changeType : {ItemChangeType::Count, ItemChangeType::ActionId, ItemChangeType::UniqueId})
+        {
+            if (properties & (1 << to_underlying(changeType)))
+            {
+                entry.signal.property.fire(changeType);
+            }
+        }
     }
 }
 
 void Items::containerChanged(Item *containerItem, const ContainerChange &containerChange)
 {
-    auto found = containerSignals.find(containerItem->guid());
-    if (found != containerSignals.end())
+    if (containerSignals.empty())
     {
-        found->second.fire(containerChange);
+        return;
+    }
+
+    uint32_t index = guidSlots[containerItem->guid()].containerSignal;
+    if (index != NoSignal)
+    {
+        containerSignals[index].signal.fire(containerChange);
     }
 }
 
@@ -501,6 +584,17 @@ void Items::loadMissingItemTypes()
     }
 }
 
+void Items::cacheTextureAtlases()
+{
+    for (auto &itemType : items.itemTypes)
+    {
+        if (itemType.isValid())
+        {
+            itemType.cacheTextureAtlases();
+        }
+    }
+}
+
 void Items::loadFromOtb(const std::filesystem::path path)
 {
     OtbReader reader(path.string());
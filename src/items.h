@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <deque>
 #include <filesystem>
 #include <memory>
 #include <pugixml.hpp>
@@ -33,21 +34,93 @@ struct ItemSignal
     Nano::Signal<void(Item *)> address;
     Nano::Signal<void(ItemChangeType)> property;
 
+    // Property changes gathered during a notification batch. One bit per ItemChangeType.
+    uint8_t pendingProperties = 0;
+
     ItemSignal() {}
 };
 
+/*
+	Dense storage for the signals of observed item guids. A signal is found through the index stored in the slot of
+	its guid, so there is no hashing. Signals are never moved; the index of a released signal is reused.
+
+	Each signal remembers the guid and guid generation it was created for. A signal whose item is gone stays alive
+	until its last observer disconnects, but it is no longer reachable from the guid.
+*/
+template <typename S>
+class GuidSignals
+{
+  public:
+    struct Entry
+    {
+        S signal;
+        uint32_t guid = 0;
+        uint16_t generation = 0;
+    };
+
+    uint32_t acquire(uint32_t guid, uint16_t generation)
+    {
+        uint32_t index;
+        if (freeIndices.empty())
+        {
+            index = static_cast<uint32_t>(entries.size());
+            entries.emplace_back();
+        }
+        else
+        {
+            index = freeIndices.back();
+            freeIndices.pop_back();
+        }
+
+        Entry &entry = entries[index];
+        entry.guid = guid;
+        entry.generation = generation;
+        ++_size;
+
+        return index;
+    }
+
+    // The signal must have no connections
+    void release(uint32_t index)
+    {
+        freeIndices.emplace_back(index);
+        --_size;
+    }
+
+    Entry &operator[](uint32_t index)
+    {
+        return entries[index];
+    }
+
+    // The number of signals in use
+    size_t size() const noexcept
+    {
+        return _size;
+    }
+
+    bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+
+  private:
+    std::deque<Entry> entries;
+    std::vector<uint32_t> freeIndices;
+    size_t _size = 0;
+};
+
 class Items
 {
   public:
     static Items items;
 
     // Used to track (observe) items and be notified if the address of an item
-    // with a given entity ID changes. The key is an entity ID.
-    std::unordered_map<uint32_t, ItemSignal> itemSignals;
+    // with a given entity ID changes. Indexed through the guid slots.
+    GuidSignals<ItemSignal> itemSignals;
 
     // Used to track changes in a container (insert/remove item).
-    // The key is an entity ID for the container item.
-    std::unordered_map<uint32_t, Nano::Signal<void(ContainerChange)>> containerSignals;
+    // Indexed through the guid slot of the container item.
+    GuidSignals<Nano::Signal<void(ContainerChange)>> containerSignals;
 
     uint32_t highestServerId = 0;
 
@@ -68,6 +141,17 @@ class Items
     void itemPropertyChanged(Item *item, const ItemChangeType changeType);
     void containerChanged(Item *containerItem, const ContainerChange &containerChange);
 
+    /*
+		While a batch is open, property changes are gathered and every observed item is notified once per change type
+		when the outermost batch ends. Address and container changes are not batched: observers need the current
+		address, and container changes must arrive in order.
+	*/
+    void beginNotificationBatch();
+    void endNotificationBatch(std::vector<uint32_t> *changedGuids = nullptr);
+
+    // Sends the gathered property changes without ending the batch. Appends the guids of the notified items to changedGuids.
+    void flushNotifications(std::vector<uint32_t> *changedGuids = nullptr);
+
     const std::vector<ItemType> &getItemTypes() const;
 
     /**
@@ -75,6 +159,12 @@ class Items
    */
     static void loadMissingItemTypes();
 
+    /**
+   * Caches the texture atlases of every item type. Used when the item types were loaded from the
+   * ClientDataCache, which does not store atlas pointers.
+   */
+    static void cacheTextureAtlases();
+
     bool reload();
     void clear();
 
@@ -95,6 +185,8 @@ class Items
     const OTB::VersionInfo otbVersionInfo() const;
 
   private:
+    friend class ClientDataCache;
+
     class OtbReader
     {
       public:
@@ -151,39 +243,71 @@ class Items
 
     OTB::VersionInfo _otbVersionInfo;
 
+    static constexpr uint32_t NoSignal = UINT32_MAX;
+
+    /*
+		Guids index guidSlots directly. The generation is increased whenever the guid is freed, so a signal of an
+		earlier item with the same guid is never fired for a new one.
+	*/
+    struct GuidSlot
+    {
+        uint16_t refCount = 0;
+        uint16_t generation = 0;
+        uint32_t itemSignal = NoSignal;
+        uint32_t containerSignal = NoSignal;
+    };
+
+    template <typename S>
+    void releaseSignal(GuidSignals<S> &signals, uint32_t index, uint32_t GuidSlot::*slotSignal);
+
     uint32_t nextItemGuid = 0;
     std::queue<uint32_t> freedItemGuids;
 
-    std::vector<uint16_t> guidRefCounts;
+    std::vector<GuidSlot> guidSlots;
+
+    uint32_t notificationBatchDepth = 0;
+    // Indices into itemSignals
+    std::vector<uint32_t> pendingPropertyChanges;
 };
 
+template <typename S>
+void Items::releaseSignal(GuidSignals<S> &signals, uint32_t index, uint32_t GuidSlot::*slotSignal)
+{
+    auto &entry = signals[index];
+    GuidSlot &slot = guidSlots[entry.guid];
+    if (slot.generation == entry.generation && slot.*slotSignal == index)
+    {
+        slot.*slotSignal = NoSignal;
+    }
+
+    signals.release(index);
+}
+
 template <auto AddressFunction, auto PropertyFunction, typename T>
 ItemGuidDisconnect Items::trackItem(uint32_t itemGuid, T *instance)
 {
-    auto outerFound = itemSignals.find(itemGuid);
-    if (outerFound == itemSignals.end())
+    GuidSlot &slot = guidSlots.at(itemGuid);
+    if (slot.itemSignal == NoSignal)
     {
-        itemSignals.try_emplace(itemGuid);
-        outerFound = itemSignals.find(itemGuid);
+        slot.itemSignal = itemSignals.acquire(itemGuid, slot.generation);
     }
 
-    auto itemMoveSignals = &itemSignals;
+    uint32_t index = slot.itemSignal;
 
-    std::function<void()> disconnect = [itemMoveSignals, instance, itemGuid]() {
-        auto found = itemMoveSignals->find(itemGuid);
-        if (found != itemMoveSignals->end())
+    std::function<void()> disconnect = [this, instance, index]() {
+        ItemSignal &signal = itemSignals[index].signal;
+        signal.address.disconnect<AddressFunction>(instance);
+        signal.property.disconnect<PropertyFunction>(instance);
+        if (signal.address.is_empty() && signal.property.is_empty())
         {
-            found->second.address.disconnect<AddressFunction>(instance);
-            found->second.property.disconnect<PropertyFunction>(instance);
-            if (found->second.address.is_empty() && found->second.property.is_empty())
-            {
-                itemMoveSignals->erase(itemGuid);
-            }
+            signal.pendingProperties = 0;
+            releaseSignal(itemSignals, index, &GuidSlot::itemSignal);
         }
     };
 
-    outerFound->second.address.connect<AddressFunction>(instance);
-    outerFound->second.property.connect<PropertyFunction>(instance);
+    ItemSignal &signal = itemSignals[index].signal;
+    signal.address.connect<AddressFunction>(instance);
+    signal.property.connect<PropertyFunction>(instance);
 
     return ItemGuidDisconnect(disconnect);
 }
@@ -191,28 +315,24 @@ ItemGuidDisconnect Items::trackItem(uint32_t itemGuid, T *instance)
 template <auto MemberFunction, typename T>
 ItemGuidDisconnect Items::trackContainer(uint32_t itemGuid, T *instance)
 {
-    auto outerFound = containerSignals.find(itemGuid);
-    if (outerFound == containerSignals.end())
+    GuidSlot &slot = guidSlots.at(itemGuid);
+    if (slot.containerSignal == NoSignal)
     {
-        containerSignals.try_emplace(itemGuid);
-        outerFound = containerSignals.find(itemGuid);
+        slot.containerSignal = containerSignals.acquire(itemGuid, slot.generation);
     }
 
-    auto containerMoveSignals = &containerSignals;
+    uint32_t index = slot.containerSignal;
 
-    std::function<void()> disconnect = [containerMoveSignals, instance, itemGuid]() {
-        auto found = containerMoveSignals->find(itemGuid);
-        if (found != containerMoveSignals->end())
+    std::function<void()> disconnect = [this, instance, index]() {
+        auto &signal = containerSignals[index].signal;
+        signal.template disconnect<MemberFunction>(instance);
+        if (signal.is_empty())
         {
-            found->second.disconnect<MemberFunction>(instance);
-            if (found->second.is_empty())
-            {
-                containerMoveSignals->erase(itemGuid);
-            }
+            releaseSignal(containerSignals, index, &GuidSlot::containerSignal);
         }
     };
 
-    outerFound->second.connect<MemberFunction>(instance);
+    containerSignals[index].signal.template connect<MemberFunction>(instance);
 
     return ItemGuidDisconnect(disconnect);
 }
@@ -5,6 +5,7 @@
 #include "items.h"
 #include "otb.h"
 #include "time_util.h"
+#include "trace.h"
 
 namespace
 {
@@ -35,6 +36,7 @@ namespace
 
 std::variant<Map, std::string> LoadMap::loadMap(std::filesystem::path &path)
 {
+    VME_TRACE_SCOPE("LoadMap::loadMap");
     TimePoint start;
     if (!std::filesystem::exists(path) || std::filesystem::is_directory(path))
     {
@@ -166,6 +168,8 @@ std::variant<Map, std::string> LoadMap::loadMap(std::filesystem::path &path)
         ABORT_PROGRAM("Expected end.");
     }
 
+    // The tail of a burst of LoadMap and deserializer warnings
+    Logger::reportSuppressed();
     VME_LOG("Loaded map in " << start.elapsedMillis() << " ms.");
 
     return map;
@@ -313,11 +317,12 @@ bool LoadMap::isValidOTBMVersion(uint32_t value)
 
 void LoadMap::logWarning(std::string message)
 {
-    VME_LOG("[LoadMap warning] " << message);
+    VME_LOG_W("[LoadMap warning] " << message);
 }
 
 std::variant<Map, std::string> LoadMap::error(std::string message)
 {
+    Logger::reportSuppressed();
     return message;
 }
 
@@ -539,7 +544,7 @@ std::unique_ptr<OTBM::Deserializer> OTBM::Deserializer::create(OTBMVersion versi
 
 void OTBM::OTBM1Deserializer::logWarning(std::string message)
 {
-    VME_LOG("[OTBM::DefaultDeserializer warning] " << message);
+    VME_LOG_W("[OTBM::DefaultDeserializer warning] " << message);
 }
 
 Item OTBM::OTBM1Deserializer::deserializeCompactItem()
@@ -1,5 +1,9 @@
 #include "logger.h"
 
+#include <chrono>
+#include <thread>
+
+#include "bounded_queue.h"
 #include "debug.h"
 
 #ifdef QT_CORE_LIB
@@ -8,54 +12,303 @@
 
 constexpr std::string_view InfoString = "[INFO] ";
 constexpr std::string_view DebugString = "[DEBUG] ";
+constexpr std::string_view WarningString = "[WARNING] ";
 constexpr std::string_view ErrorString = "[ERROR] ";
 
 #ifdef QT_CORE_LIB
 QString INFO_STRING = QStringLiteral("[Info] ");
 QString DEBUG_STRING = QStringLiteral("[Debug] ");
+QString WARNING_STRING = QStringLiteral("[Warning] ");
 QString ERROR_STRING = QStringLiteral("[Error] ");
+#endif
 
-// void Logger::info(const char *s)
-// {
-//     qDebug().noquote() << INFO_STRING << QString(s);
-// }
+namespace
+{
+    constexpr size_t QueueCapacity = 8192;
 
-void Logger::info(std::ostringstream &s)
+    std::atomic<Logger::Sink> customSink = nullptr;
+
+    // Writes a message on the calling thread
+    void sink(Logger::Level level, const std::string &message)
+    {
+        if (Logger::Sink custom = customSink.load(std::memory_order_acquire))
+        {
+            custom(level, message);
+            return;
+        }
+
+#ifdef QT_CORE_LIB
+        const QString *prefix;
+        switch (level)
+        {
+            case Logger::Level::Debug:
+                prefix = &DEBUG_STRING;
+                break;
+            case Logger::Level::Warning:
+                prefix = &WARNING_STRING;
+                break;
+            case Logger::Level::Error:
+                prefix = &ERROR_STRING;
+                break;
+            default:
+                prefix = &INFO_STRING;
+                break;
+        }
+
+        qDebug().noquote() << *prefix << QString::fromStdString(message);
+#else
+        switch (level)
+        {
+            case Logger::Level::Debug:
+                std::clog << DebugString << message << std::endl;
+                break;
+            case Logger::Level::Warning:
+                std::cerr << WarningString << message << std::endl;
+                break;
+            case Logger::Level::Error:
+                std::cerr << ErrorString << message << std::endl;
+                break;
+            default:
+                std::clog << InfoString << message << std::endl;
+                break;
+        }
+#endif
+    }
+
+    // False after the backend is destroyed. Messages are then written synchronously.
+    std::atomic<bool> backendAlive = false;
+
+    class Backend
+    {
+      public:
+        Backend()
+            : queue(QueueCapacity)
+        {
+            writer = std::thread([this]() { run(); });
+            backendAlive = true;
+        }
+
+        ~Backend()
+        {
+            backendAlive = false;
+
+            stopping = true;
+            ++wakeups;
+            wakeups.notify_one();
+
+            writer.join();
+        }
+
+        void write(Logger::Level level, std::string &&message)
+        {
+            Entry entry{level, std::move(message)};
+
+            // push only takes the entry if it succeeds
+            while (!queue.push(std::move(entry)))
+            {
+                if (level < Logger::Level::Error)
+                {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+
+                std::this_thread::yield();
+            }
+
+            pushed.fetch_add(1, std::memory_order_release);
+
+            wakeups.fetch_add(1, std::memory_order_release);
+            wakeups.notify_one();
+        }
+
+        void flush()
+        {
+            if (std::this_thread::get_id() == writer.get_id())
+            {
+                return;
+            }
+
+            uint64_t target = pushed.load(std::memory_order_acquire);
+            uint64_t current = written.load(std::memory_order_acquire);
+            while (current < target)
+            {
+                written.wait(current, std::memory_order_acquire);
+                current = written.load(std::memory_order_acquire);
+            }
+        }
+
+      private:
+        struct Entry
+        {
+            Logger::Level level = Logger::Level::Info;
+            std::string message;
+        };
+
+        void run()
+        {
+            Entry entry;
+            while (true)
+            {
+                // Loaded before draining, so that a message pushed while draining wakes the wait below
+                uint32_t observed = wakeups.load(std::memory_order_acquire);
+
+                while (queue.pop(entry))
+                {
+                    sink(entry.level, entry.message);
+                    entry.message.clear();
+
+                    written.fetch_add(1, std::memory_order_release);
+                    written.notify_all();
+                }
+
+                uint64_t droppedCount = dropped.exchange(0, std::memory_order_relaxed);
+                if (droppedCount != 0)
+                {
+                    sink(Logger::Level::Warning, std::to_string(droppedCount) + " log messages were dropped because the log queue was full.");
+                }
+
+                if (stopping)
+                {
+                    break;
+                }
+
+                wakeups.wait(observed, std::memory_order_acquire);
+            }
+        }
+
+        BoundedQueue<Entry> queue;
+
+        std::atomic<uint32_t> wakeups = 0;
+        std::atomic<uint64_t> pushed = 0;
+        std::atomic<uint64_t> written = 0;
+        std::atomic<uint64_t> dropped = 0;
+        std::atomic<bool> stopping = false;
+
+        std::thread writer;
+    };
+
+    Backend &backend()
+    {
+        static Backend backend;
+        return backend;
+    }
+
+    std::atomic<Logger::RateLimit *> rateLimits = nullptr;
+} // namespace
+
+void Logger::write(Level level, std::string &&message)
 {
-    qDebug().noquote() << INFO_STRING << QString(s.str().c_str());
+    // Constructs the backend on first use
+    Backend &instance = backend();
+
+    // At exit, after the backend is destroyed
+    if (!backendAlive.load(std::memory_order_acquire))
+    {
+        sink(level, message);
+        return;
+    }
+
+    instance.write(level, std::move(message));
+
+    if (level == Level::Error)
+    {
+        instance.flush();
+    }
 }
 
-void Logger::debug(std::ostringstream &s)
+void Logger::flush()
 {
-    qDebug().noquote() << DEBUG_STRING << QString(s.str().c_str());
+    if (backendAlive.load(std::memory_order_acquire))
+    {
+        backend().flush();
+    }
 }
 
-void Logger::error(std::ostringstream &s)
+Logger::Sink Logger::setSink(Sink sink)
 {
-    qDebug().noquote() << ERROR_STRING << QString(s.str().c_str());
+    return customSink.exchange(sink, std::memory_order_acq_rel);
 }
 
-Logger::MainLogger Logger::info()
+Logger::RateLimit::RateLimit(const char *file, int line)
+    : file(file), line(line)
 {
-    qDebug() << QString(std::string(DebugString).c_str());
-    return qDebug();
+    RateLimit *head = rateLimits.load(std::memory_order_relaxed);
+    do
+    {
+        next = head;
+    } while (!rateLimits.compare_exchange_weak(head, this, std::memory_order_release, std::memory_order_relaxed));
 }
-#else
+
+void Logger::reportSuppressed()
+{
+    for (RateLimit *limit = rateLimits.load(std::memory_order_acquire); limit; limit = limit->next)
+    {
+        uint32_t suppressed = limit->suppressedCount.exchange(0, std::memory_order_relaxed);
+        if (suppressed != 0)
+        {
+            std::string_view file(limit->file);
+            file.remove_prefix(file.find_last_of("/\\") + 1);
+
+            std::ostringstream s;
+            s << suppressed << " similar warnings from " << file << ":" << limit->line << " were suppressed.";
+            write(Level::Warning, s.str());
+        }
+    }
+}
+
+bool Logger::RateLimit::allow(uint32_t &suppressed)
+{
+    using namespace std::chrono;
+    int64_t now = duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+
+    int64_t start = windowStart.load(std::memory_order_relaxed);
+    if (now - start >= WindowMilliseconds && windowStart.compare_exchange_strong(start, now, std::memory_order_relaxed))
+    {
+        count.store(0, std::memory_order_relaxed);
+    }
+
+    if (count.fetch_add(1, std::memory_order_relaxed) < MessagesPerWindow)
+    {
+        suppressed = suppressedCount.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    suppressedCount.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
 void Logger::info(std::ostringstream &s)
 {
-    Logger::info() << s.str() << std::endl;
+    write(Level::Info, s.str());
 }
 
 void Logger::debug(std::ostringstream &s)
 {
-    Logger::debug() << s.str() << std::endl;
+    write(Level::Debug, s.str());
+}
+
+void Logger::warning(std::ostringstream &s)
+{
+    write(Level::Warning, s.str());
 }
 
 void Logger::error(std::ostringstream &s)
 {
-    Logger::error() << s.str() << std::endl;
+    write(Level::Error, s.str());
 }
 
+#ifdef QT_CORE_LIB
+Logger::MainLogger Logger::info()
+{
+    qDebug() << QString(std::string(DebugString).c_str());
+    return qDebug();
+}
+Logger::MainLogger Logger::debug()
+{
+    qDebug() << QString(std::string(DebugString).c_str());
+    return qDebug();
+}
+#else
 Logger::MainLogger &Logger::info()
 {
     std::clog << InfoString;
@@ -77,26 +330,26 @@ std::ostream &Logger::error()
 void Logger::debug(const char *s)
 {
 #ifdef _DEBUG
-    std::clog << DebugString << s << std::endl;
+    write(Level::Debug, std::string(s));
 #endif
 }
 void Logger::debug(std::string s)
 {
 #ifdef _DEBUG
-    std::clog << DebugString << s << std::endl;
+    write(Level::Debug, std::move(s));
 #endif
 }
 
 void Logger::info(std::string &s)
 {
-    std::cout << InfoString << s << std::endl;
+    write(Level::Info, std::string(s));
 }
 
 void Logger::error(std::string &s)
 {
-    std::cerr << ErrorString << s << std::endl;
+    write(Level::Error, std::string(s));
 }
 void Logger::error(std::string s)
 {
-    std::cerr << ErrorString << s << std::endl;
+    write(Level::Error, std::move(s));
 }
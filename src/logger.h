@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -12,8 +14,99 @@
 
 #include "definitions.h"
 
+/*
+	Messages below this level are compiled out of VME_LOG* call sites. 0 = debug, 1 = info, 2 = warning, 3 = error.
+	Can be overridden with e.g. -DVME_LOG_LEVEL=2.
+*/
+#ifndef VME_LOG_LEVEL
+#ifdef _DEBUG_VME
+#define VME_LOG_LEVEL 0
+#else
+#define VME_LOG_LEVEL 1
+#endif
+#endif
+
+/*
+	Messages are formatted on the calling thread and pushed to a lock-free queue. A background thread writes them to
+	QDebug or the std streams, so logging does not block loaders or worker threads on I/O.
+
+	If the queue is full, debug, info and warning messages are dropped (and the number of dropped messages is logged
+	later). Error messages wait until there is room, and are written before the call returns: an error is often the
+	last thing logged before a crash.
+*/
 namespace Logger
 {
+    enum class Level : uint8_t
+    {
+        Debug,
+        Info,
+        Warning,
+        Error,
+        None
+    };
+
+    constexpr Level CompiledLevel = static_cast<Level>(VME_LOG_LEVEL);
+
+    namespace detail
+    {
+        inline std::atomic<Level> runtimeLevel = CompiledLevel;
+    }
+
+    // Messages below level are discarded at run time. Levels below CompiledLevel can not be enabled.
+    inline void setLevel(Level level)
+    {
+        detail::runtimeLevel.store(level, std::memory_order_relaxed);
+    }
+
+    inline bool enabled(Level level)
+    {
+        return level >= CompiledLevel && level >= detail::runtimeLevel.load(std::memory_order_relaxed);
+    }
+
+    void write(Level level, std::string &&message);
+
+    // Blocks until every message that was logged before the call has been written
+    void flush();
+
+    using Sink = void (*)(Level level, const std::string &message);
+
+    /*
+		Replaces the function that writes messages, e.g. to capture them in tests. The sink is called on the writer
+		thread, in the order that the messages were logged. nullptr restores writing to QDebug or the std streams.
+		Returns the previous sink.
+	*/
+    Sink setSink(Sink sink);
+
+    /*
+		Lets through at most MessagesPerWindow messages per window. Used by VME_LOG_W to limit one call site.
+		The number of suppressed messages is returned with the next message that is let through, or logged by
+		reportSuppressed.
+
+		Every RateLimit is linked into a list when constructed, so it must have static storage duration.
+	*/
+    struct RateLimit
+    {
+        static constexpr uint32_t MessagesPerWindow = 20;
+        static constexpr int64_t WindowMilliseconds = 1000;
+
+        RateLimit(const char *file, int line);
+
+        bool allow(uint32_t &suppressed);
+
+        std::atomic<int64_t> windowStart = 0;
+        std::atomic<uint32_t> count = 0;
+        std::atomic<uint32_t> suppressedCount = 0;
+
+        const char *file;
+        int line;
+        RateLimit *next = nullptr;
+    };
+
+    /*
+		Logs the number of messages that each RateLimit suppressed since the last message it let through.
+		Call it at the end of a burst of warnings (e.g. after loading a map), where no later message would report them.
+	*/
+    void reportSuppressed();
 
 #ifdef QT_CORE_LIB
     using MainLogger = QDebug;
@@ -28,6 +121,7 @@ namespace Logger
     void info(std::string &s);
     void info(std::ostringstream &s);
     void debug(std::ostringstream &s);
+    void warning(std::ostringstream &s);
     void error(std::ostringstream &s);
 
     void debug(const char *s);
@@ -39,36 +133,66 @@ namespace Logger
 
 } // namespace Logger
 
-#define VME_LOG(expr)             \
-    do                            \
-    {                             \
-                                  \
-        std::ostringstream __s__; \
-        __s__ << expr;            \
-        Logger::info(__s__);      \
+#define VME_LOG(expr)                                  \
+    do                                                 \
+    {                                                  \
+        if (Logger::enabled(Logger::Level::Info))      \
+        {                                              \
+            std::ostringstream __s__;                  \
+            __s__ << expr;                             \
+            Logger::info(__s__);                       \
+        }                                              \
     } while (false)
 
-#define VME_LOG_ERROR(expr)       \
-    do                            \
-    {                             \
-                                  \
-        std::ostringstream __s__; \
-        __s__ << expr;            \
-        Logger::error(__s__);     \
+/*
+	A warning that is rate limited per call site, for warnings that can repeat thousands of times (e.g. while loading
+	a map).
+*/
+#define VME_LOG_W(expr)                                                                  \
+    do                                                                                   \
+    {                                                                                    \
+        if (Logger::enabled(Logger::Level::Warning))                                     \
+        {                                                                                \
+            static Logger::RateLimit __limit__(__FILE__, __LINE__);                      \
+            uint32_t __suppressed__ = 0;                                                 \
+            if (__limit__.allow(__suppressed__))                                         \
+            {                                                                            \
+                std::ostringstream __s__;                                                \
+                __s__ << expr;                                                           \
+                if (__suppressed__ != 0)                                                 \
+                {                                                                        \
+                    __s__ << " (" << __suppressed__ << " similar warnings were suppressed)"; \
+                }                                                                        \
+                Logger::warning(__s__);                                                  \
+            }                                                                            \
+        }                                                                                \
+    } while (false)
+
+#define VME_LOG_ERROR(expr)                            \
+    do                                                 \
+    {                                                  \
+        if (Logger::enabled(Logger::Level::Error))     \
+        {                                              \
+            std::ostringstream __s__;                  \
+            __s__ << expr;                             \
+            Logger::error(__s__);                      \
+        }                                              \
     } while (false)
 
 #ifdef _DEBUG_VME
-#define VME_LOG_D(expr)           \
-    do                            \
-    {                             \
-                                  \
-        std::ostringstream __s__; \
-        __s__ << expr;            \
-        Logger::debug(__s__);     \
+#define VME_LOG_D(expr)                                \
+    do                                                 \
+    {                                                  \
+        if (Logger::enabled(Logger::Level::Debug))     \
+        {                                              \
+            std::ostringstream __s__;                  \
+            __s__ << expr;                             \
+            Logger::debug(__s__);                      \
+        }                                              \
     } while (false)
 #else
 #define VME_LOG_D(expr) \
     do                  \
     {                   \
     } while (0)
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,355 @@
+#include "lua_generation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include "../brushes/brush.h"
+#include "../brushes/ground_brush.h"
+#include "../history/history_action.h"
+#include "../items.h"
+#include "../map.h"
+#include "../map_view.h"
+#include "../settings.h"
+#include "../thread_pool.h"
+#include "../tile.h"
+#include "lua_map.h"
+#include "lua_profiler.h"
+#include "lua_state.h"
+
+namespace
+{
+    uint64_t splitMix64(uint64_t x)
+    {
+        x += 0x9E3779B97F4A7C15;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+        return x ^ (x >> 31);
+    }
+
+    int luaItemExists(lua_State *L)
+    {
+        auto serverId = static_cast<uint32_t>(luaL_checkinteger(L, 1));
+        lua_pushboolean(L, Items::items.validItemType(serverId));
+        return 1;
+    }
+
+    int luaItemIsGround(lua_State *L)
+    {
+        auto serverId = static_cast<uint32_t>(luaL_checkinteger(L, 1));
+        lua_pushboolean(L, Items::items.validItemType(serverId) && Items::items.getItemTypeByServerId(serverId)->isGround());
+        return 1;
+    }
+
+    // Returns the items of a ground brush as { { id=<uint>, weight=<uint> }, ... }, or nil if there is no such brush.
+    int luaGroundBrushItems(lua_State *L)
+    {
+        const GroundBrush *brush = Brush::getGroundBrush(luaL_checkstring(L, 1));
+        if (!brush)
+        {
+            lua_pushnil(L);
+            return 1;
+        }
+
+        const auto &weightedIds = brush->weightedIds();
+        lua_createtable(L, static_cast<int>(weightedIds.size()), 0);
+
+        int i = 1;
+        for (const WeightedItemId &weightedId : weightedIds)
+        {
+            lua_createtable(L, 0, 2);
+            lua_pushinteger(L, weightedId.id);
+            lua_setfield(L, -2, "id");
+            lua_pushinteger(L, weightedId.weight);
+            lua_setfield(L, -2, "weight");
+            lua_rawseti(L, -2, i++);
+        }
+
+        return 1;
+    }
+
+    /*
+		Called under lua_pcall with the generation function, the region and the seed. Seeds math.random first, so
+		that a script that replaced math.randomseed raises a Lua error instead of a panic.
+	*/
+    int luaGenerateChunk(lua_State *L)
+    {
+        lua_getglobal(L, "math");
+        lua_getfield(L, -1, "randomseed");
+        lua_pushvalue(L, 3);
+        lua_call(L, 1, 0);
+        lua_pop(L, 1);
+
+        lua_call(L, 2, 0);
+        return 0;
+    }
+
+    void registerTable(lua_State *L, const char *name, const luaL_Reg *functions)
+    {
+        lua_newtable(L);
+        for (; functions->name; ++functions)
+        {
+            lua_pushcfunction(L, functions->func);
+            lua_setfield(L, -2, functions->name);
+        }
+        lua_setglobal(L, name);
+    }
+
+    struct Chunk
+    {
+        MapRegionBuffer buffer;
+        uint32_t seed;
+    };
+
+    /*
+		The lua_State of one worker thread. Brushes and items may only be read while workers are running.
+	*/
+    class Worker
+    {
+      public:
+        Worker()
+        {
+            L = luaL_newstate();
+        }
+
+        ~Worker()
+        {
+            if (profiler)
+            {
+                profiler->detach();
+            }
+
+            if (L)
+            {
+                lua_close(L);
+            }
+        }
+
+        Worker(const Worker &) = delete;
+        Worker &operator=(const Worker &) = delete;
+
+        bool load(const std::filesystem::path &script, LuaProfiler *profiler, std::string &error)
+        {
+            if (!L)
+            {
+                error = "Not enough memory to create a Lua state.";
+                return false;
+            }
+
+            luaL_openlibs(L);
+
+            if (profiler)
+            {
+                profiler->attach(L);
+                this->profiler = profiler;
+            }
+
+            // No map view: the chunks are only written by the generator
+            LuaMapRegion::luaRegister(L, nullptr);
+
+            const luaL_Reg items[] = {
+                {"exists", luaItemExists},
+                {"isGround", luaItemIsGround},
+                {nullptr, nullptr}};
+            registerTable(L, "Items", items);
+
+            const luaL_Reg brushes[] = {
+                {"groundItems", luaGroundBrushItems},
+                {nullptr, nullptr}};
+            registerTable(L, "Brushes", brushes);
+
+            LuaProfiler::Scope scope(L, script.filename().string());
+            if (luaL_dofile(L, script.string().c_str()) != 0)
+            {
+                error = LuaState::toString(L, -1);
+                lua_pop(L, 1);
+                return false;
+            }
+
+            return true;
+        }
+
+        bool generate(const std::string &function, Chunk &chunk, std::string &error)
+        {
+            lua_pushcfunction(L, luaGenerateChunk);
+
+            lua_getglobal(L, function.c_str());
+            if (!lua_isfunction(L, -1))
+            {
+                lua_pop(L, 2);
+                error = "The script has no function '" + function + "'.";
+                return false;
+            }
+
+            MapRegionBuffer **view = LuaMapRegion::pushView(L, &chunk.buffer);
+            lua_pushinteger(L, chunk.seed);
+
+            int status;
+            {
+                LuaProfiler::Scope scope(L, function);
+                status = lua_pcall(L, 3, 0, 0);
+            }
+
+            // The buffer outlives the state, but the script may have kept the region
+            *view = nullptr;
+
+            if (status != 0)
+            {
+                error = LuaState::toString(L, -1);
+                lua_pop(L, 1);
+                return false;
+            }
+
+            return true;
+        }
+
+      private:
+        lua_State *L;
+        LuaProfiler *profiler = nullptr;
+    };
+} // namespace
+
+LuaChunkGenerator::LuaChunkGenerator(Options options)
+    : options(std::move(options)) {}
+
+uint32_t LuaChunkGenerator::chunkSeed(uint32_t seed, const Position &chunkOrigin)
+{
+    uint64_t position = (static_cast<uint64_t>(static_cast<uint32_t>(chunkOrigin.x)) << 32) ^
+                        (static_cast<uint64_t>(static_cast<uint32_t>(chunkOrigin.y)) << 8) ^
+                        static_cast<uint8_t>(chunkOrigin.z);
+
+    return static_cast<uint32_t>(splitMix64(splitMix64(seed) ^ position));
+}
+
+std::optional<size_t> LuaChunkGenerator::run(MapView &mapView, const Position &from, const Position &to)
+{
+    _error.clear();
+
+    const Map &map = *mapView.map();
+    const int chunkSize = std::max<int>(options.chunkSize, 1);
+
+    // The chunks are read from the map before the workers start
+    std::vector<Chunk> chunks;
+    for (int z = std::min(from.z, to.z); z <= std::max(from.z, to.z); ++z)
+    {
+        for (int y = std::min(from.y, to.y); y <= std::max(from.y, to.y); y += chunkSize)
+        {
+            for (int x = std::min(from.x, to.x); x <= std::max(from.x, to.x); x += chunkSize)
+            {
+                auto width = static_cast<uint16_t>(std::min(chunkSize, std::max(from.x, to.x) - x + 1));
+                auto height = static_cast<uint16_t>(std::min(chunkSize, std::max(from.y, to.y) - y + 1));
+                Position origin(x, y, static_cast<Position::z_type>(z));
+
+                chunks.emplace_back(Chunk{MapRegionBuffer::read(map, origin, width, height), chunkSeed(options.seed, origin)});
+            }
+        }
+    }
+
+    std::atomic<size_t> nextChunk = 0;
+    std::atomic<bool> failed = false;
+    std::mutex errorMutex;
+
+    // The profile of every worker is merged into this one
+    std::optional<LuaProfiler> profile;
+    std::mutex profileMutex;
+    if (Settings::PROFILE_LUA_SCRIPTS)
+    {
+        profile.emplace();
+    }
+
+    auto fail = [&](std::string &&error) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!failed.exchange(true))
+        {
+            _error = std::move(error);
+        }
+    };
+
+    {
+        ThreadPool workers(options.threadCount);
+        uint32_t workerCount = std::min<uint32_t>(workers.threadCount(), static_cast<uint32_t>(chunks.size()));
+
+        // Every task is one worker with its own state. It takes chunks until there are none left.
+        for (uint32_t i = 0; i < workerCount; ++i)
+        {
+            workers.submit([&]() {
+                // Outlives the worker, which detaches it before closing its state
+                std::optional<LuaProfiler> profiler;
+                if (profile)
+                {
+                    profiler.emplace();
+                }
+
+                {
+                    Worker worker;
+                    std::string error;
+                    bool loaded = worker.load(options.script, profiler ? &*profiler : nullptr, error);
+                    if (!loaded)
+                    {
+                        fail(std::move(error));
+                    }
+
+                    for (size_t chunk = nextChunk++; loaded && chunk < chunks.size() && !failed; chunk = nextChunk++)
+                    {
+                        if (!worker.generate(options.function, chunks[chunk], error))
+                        {
+                            fail(std::move(error));
+                            break;
+                        }
+                    }
+                }
+
+                if (profiler)
+                {
+                    std::lock_guard<std::mutex> lock(profileMutex);
+                    profile->merge(*profiler);
+                }
+            });
+        }
+
+        workers.waitIdle();
+    }
+
+    if (profile)
+    {
+        std::ostringstream report;
+        profile->writeReport(report);
+        VME_LOG("Lua profile of " << options.script.string() << ":\n"
+                                  << report.str());
+
+        std::filesystem::path foldedStacks = options.script;
+        foldedStacks += ".folded";
+        profile->writeFoldedStacks(foldedStacks);
+    }
+
+    if (failed)
+    {
+        VME_LOG_ERROR("Generation with " << options.script.string() << " failed: " << _error);
+        return std::nullopt;
+    }
+
+    std::vector<Tile> tiles;
+    for (Chunk &chunk : chunks)
+    {
+        std::vector<Tile> changed = chunk.buffer.takeChangedTiles(map);
+        std::move(changed.begin(), changed.end(), std::back_inserter(tiles));
+    }
+
+    size_t changedTiles = tiles.size();
+    if (changedTiles != 0)
+    {
+        mapView.beginTransaction(TransactionType::Script);
+        mapView.replaceTiles(std::move(tiles));
+        mapView.endTransaction(TransactionType::Script);
+    }
+
+    return changedTiles;
+}
+
+const std::string &LuaChunkGenerator::error() const noexcept
+{
+    return _error;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+#include "../position.h"
+
+class MapView;
+
+/*
+	Runs a procedural generation script over a region of the map, one chunk at a time on several worker threads.
+
+	Every worker has its own lua_State that loads the script once. For each chunk, the worker calls the global
+	function of the script with a MapRegion of the chunk and the seed of the chunk:
+
+		function generateChunk(region, seed)
+			...
+		end
+
+	The worker states have no access to the map view (region:write() fails). They can read items and ground brushes
+	through the Items and Brushes tables, and math.random is seeded with the chunk seed before each call. The seed
+	only depends on the seed of the run and the position of the chunk.
+
+	A worker state is reused for the chunks it takes, and which chunks that are depends on the thread timing. Globals
+	that generateChunk writes are therefore visible to later chunks of the same worker. A script that keeps its
+	per-chunk state in locals (and only reads globals) gives the same result on any number of threads.
+
+	When every chunk is done, the changed tiles of all chunks are committed as one transaction.
+*/
+class LuaChunkGenerator
+{
+  public:
+    struct Options
+    {
+        std::filesystem::path script;
+        std::string function = "generateChunk";
+        uint16_t chunkSize = 64;
+        uint32_t seed = 0;
+        // 0 uses one thread per hardware thread
+        uint32_t threadCount = 0;
+    };
+
+    LuaChunkGenerator(Options options);
+
+    /*
+		Generates the rectangle from-to (inclusive, on every floor between from.z and to.z). Blocks until all chunks
+		are done. Returns the number of changed tiles, or nothing if the script could not be loaded or a chunk
+		failed; the map is not changed in that case.
+	*/
+    std::optional<size_t> run(MapView &mapView, const Position &from, const Position &to);
+
+    // The message of the first error of the last run
+    const std::string &error() const noexcept;
+
+    static uint32_t chunkSeed(uint32_t seed, const Position &chunkOrigin);
+
+  private:
+    Options options;
+    std::string _error;
+};
@@ -0,0 +1,418 @@
+#include "lua_map.h"
+
+#include "../history/history_action.h"
+#include "../items.h"
+#include "../map.h"
+#include "../map_view.h"
+#include "../tile.h"
+#include "lua_state.h"
+
+namespace
+{
+    constexpr auto MapViewRegistryKey = "vme.MapView";
+
+    /*
+		The userdata of a MapRegion. buffer is the first member, so LuaState::checkUserData<MapRegionBuffer> reads it.
+		Views (LuaMapRegion::pushView) do not own their buffer, and __gc must not delete it.
+	*/
+    struct RegionUserData
+    {
+        MapRegionBuffer *buffer;
+        bool owned;
+    };
+
+    RegionUserData *pushRegion(lua_State *L, MapRegionBuffer *buffer, bool owned)
+    {
+        auto userdata = static_cast<RegionUserData *>(lua_newuserdata(L, sizeof(RegionUserData)));
+        userdata->buffer = buffer;
+        userdata->owned = owned;
+        LuaState::setMetaTable(L, -1, LuaMapRegion::LuaName);
+
+        return userdata;
+    }
+
+    bool validGround(uint32_t serverId)
+    {
+        return Items::items.validItemType(serverId) && Items::items.getItemTypeByServerId(serverId)->isGround();
+    }
+
+    bool validTopItem(uint32_t serverId)
+    {
+        return Items::items.validItemType(serverId) && !Items::items.getItemTypeByServerId(serverId)->isGround();
+    }
+
+    uint32_t topItemId(const Tile &tile)
+    {
+        const auto &items = tile.items();
+        return items.empty() ? 0 : items.back()->serverId();
+    }
+} // namespace
+
+MapRegionBuffer MapRegionBuffer::read(const Map &map, Position origin, uint16_t width, uint16_t height)
+{
+    MapRegionBuffer buffer;
+    buffer.origin = origin;
+    buffer.width = width;
+    buffer.height = height;
+
+    size_t size = static_cast<size_t>(width) * height;
+    buffer.ground.resize(size, 0);
+    buffer.topItem.resize(size, 0);
+    buffer.flags.resize(size, 0);
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            // getTile does not check the bounds, and would read another tile for a position outside of the map
+            Position position(origin.x + x, origin.y + y, origin.z);
+            if (!map.contains(position))
+            {
+                continue;
+            }
+
+            const Tile *tile = map.getTile(position);
+            if (!tile)
+            {
+                continue;
+            }
+
+            size_t i = buffer.index(x, y);
+            buffer.ground[i] = tile->ground() ? tile->ground()->serverId() : 0;
+            buffer.topItem[i] = topItemId(*tile);
+            buffer.flags[i] = tile->flags();
+        }
+    }
+
+    buffer.writtenGround = buffer.ground;
+    buffer.writtenTopItem = buffer.topItem;
+    buffer.writtenFlags = buffer.flags;
+
+    return buffer;
+}
+
+size_t MapRegionBuffer::write(MapView &mapView)
+{
+    std::vector<Tile> tiles = takeChangedTiles(*mapView.map());
+
+    size_t written = tiles.size();
+    if (written != 0)
+    {
+        mapView.beginTransaction(TransactionType::Script);
+        mapView.replaceTiles(std::move(tiles));
+        mapView.endTransaction(TransactionType::Script);
+    }
+
+    return written;
+}
+
+std::vector<Tile> MapRegionBuffer::takeChangedTiles(const Map &map)
+{
+    std::vector<Tile> tiles;
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            size_t i = index(x, y);
+            bool groundChanged = ground[i] != writtenGround[i];
+            bool topItemChanged = topItem[i] != writtenTopItem[i];
+            bool flagsChanged = flags[i] != writtenFlags[i];
+
+            if (!(groundChanged || topItemChanged || flagsChanged))
+            {
+                continue;
+            }
+
+            Position position(origin.x + x, origin.y + y, origin.z);
+            if (!map.contains(position))
+            {
+                continue;
+            }
+
+            const Tile *current = map.getTile(position);
+            Tile tile = current ? current->deepCopy() : Tile(position);
+
+            if (groundChanged)
+            {
+                if (ground[i] == 0)
+                {
+                    tile.removeGround();
+                }
+                else if (validGround(ground[i]))
+                {
+                    tile.addItem(ground[i]);
+                }
+            }
+
+            if (topItemChanged && (topItem[i] == 0 || validTopItem(topItem[i])))
+            {
+                if (!tile.items().empty())
+                {
+                    tile.removeItem(tile.items().size() - 1);
+                }
+
+                if (topItem[i] != 0)
+                {
+                    tile.addItem(topItem[i]);
+                }
+            }
+
+            if (flagsChanged)
+            {
+                tile.setFlags(flags[i]);
+            }
+
+            // The tile decides where an item is stacked, so the buffer takes the values that ended up on the tile
+            ground[i] = tile.ground() ? tile.ground()->serverId() : 0;
+            topItem[i] = topItemId(tile);
+
+            writtenGround[i] = ground[i];
+            writtenTopItem[i] = topItem[i];
+            writtenFlags[i] = flags[i];
+
+            tiles.emplace_back(std::move(tile));
+        }
+    }
+
+    return tiles;
+}
+
+bool MapRegionBuffer::contains(int x, int y) const noexcept
+{
+    return 0 <= x && x < width && 0 <= y && y < height;
+}
+
+size_t MapRegionBuffer::index(int x, int y) const noexcept
+{
+    return static_cast<size_t>(y) * width + x;
+}
+
+void LuaMapRegion::luaRegister(lua_State *L, MapView *mapView)
+{
+    setMapView(L, mapView);
+
+    LuaState::registerClass(L, LuaName, luaCreate);
+    LuaState::registerFunction(L, LuaName, "__gc", luaDestroy);
+
+    LuaState::registerFunction(L, LuaName, "write", luaWrite);
+
+    LuaState::registerFunction(L, LuaName, "ground", luaGetGround);
+    LuaState::registerFunction(L, LuaName, "setGround", luaSetGround);
+    LuaState::registerFunction(L, LuaName, "topItem", luaGetTopItem);
+    LuaState::registerFunction(L, LuaName, "setTopItem", luaSetTopItem);
+    LuaState::registerFunction(L, LuaName, "flags", luaGetFlags);
+    LuaState::registerFunction(L, LuaName, "setFlags", luaSetFlags);
+
+    LuaState::registerFunction(L, LuaName, "groundData", luaGroundData);
+    LuaState::registerFunction(L, LuaName, "topItemData", luaTopItemData);
+    LuaState::registerFunction(L, LuaName, "flagsData", luaFlagsData);
+
+    LuaState::registerField(L, LuaName, "x", luaGetX);
+    LuaState::registerField(L, LuaName, "y", luaGetY);
+    LuaState::registerField(L, LuaName, "z", luaGetZ);
+    LuaState::registerField(L, LuaName, "width", luaGetWidth);
+    LuaState::registerField(L, LuaName, "height", luaGetHeight);
+}
+
+void LuaMapRegion::setMapView(lua_State *L, MapView *mapView)
+{
+    lua_pushlightuserdata(L, mapView);
+    lua_setfield(L, LUA_REGISTRYINDEX, MapViewRegistryKey);
+}
+
+MapView *LuaMapRegion::mapView(lua_State *L)
+{
+    lua_getfield(L, LUA_REGISTRYINDEX, MapViewRegistryKey);
+    auto mapView = static_cast<MapView *>(lua_touserdata(L, -1));
+    lua_pop(L, 1);
+
+    if (!mapView)
+    {
+        luaL_error(L, "There is no map to access.");
+    }
+
+    return mapView;
+}
+
+int LuaMapRegion::luaCreate(lua_State *L)
+{
+    // Argument 1 is the MapRegion table (__call)
+    int x = static_cast<int>(luaL_checkinteger(L, 2));
+    int y = static_cast<int>(luaL_checkinteger(L, 3));
+    int z = static_cast<int>(luaL_checkinteger(L, 4));
+    int width = static_cast<int>(luaL_checkinteger(L, 5));
+    int height = static_cast<int>(luaL_checkinteger(L, 6));
+
+    luaL_argcheck(L, 0 <= z && z < 16, 4, "z must be in [0, 15].");
+    luaL_argcheck(L, 0 < width && width <= UINT16_MAX, 5, "Invalid width.");
+    luaL_argcheck(L, 0 < height && height <= UINT16_MAX, 6, "Invalid height.");
+
+    const Map &map = *mapView(L)->map();
+    if (width > map.width())
+    {
+        luaL_argerror(L, 5, "The region is wider than the map.");
+    }
+    if (height > map.height())
+    {
+        luaL_argerror(L, 6, "The region is taller than the map.");
+    }
+
+    auto region = new MapRegionBuffer(MapRegionBuffer::read(map, Position(x, y, static_cast<Position::z_type>(z)), width, height));
+
+    pushRegion(L, region, true);
+
+    return 1;
+}
+
+MapRegionBuffer **LuaMapRegion::pushView(lua_State *L, MapRegionBuffer *buffer)
+{
+    return &pushRegion(L, buffer, false)->buffer;
+}
+
+int LuaMapRegion::luaDestroy(lua_State *L)
+{
+    auto userdata = static_cast<RegionUserData *>(luaL_checkudata(L, 1, LuaName));
+    if (userdata->owned)
+    {
+        delete userdata->buffer;
+    }
+    userdata->buffer = nullptr;
+
+    return 0;
+}
+
+MapRegionBuffer *LuaMapRegion::checkSelf(lua_State *L)
+{
+    auto self = LuaState::checkUserData<MapRegionBuffer>(L, 1, LuaName);
+    if (!self)
+    {
+        luaL_error(L, "The MapRegion was destroyed.");
+    }
+
+    return self;
+}
+
+size_t LuaMapRegion::checkIndex(lua_State *L, MapRegionBuffer *self)
+{
+    int x = static_cast<int>(luaL_checkinteger(L, 2)) - self->origin.x;
+    int y = static_cast<int>(luaL_checkinteger(L, 3)) - self->origin.y;
+    luaL_argcheck(L, self->contains(x, y), 2, "The position is outside of the region.");
+
+    return self->index(x, y);
+}
+
+int LuaMapRegion::luaWrite(lua_State *L)
+{
+    auto self = checkSelf(L);
+
+    size_t written = self->write(*mapView(L));
+    lua_pushinteger(L, static_cast<lua_Integer>(written));
+
+    return 1;
+}
+
+int LuaMapRegion::luaGetGround(lua_State *L)
+{
+    auto self = checkSelf(L);
+    lua_pushinteger(L, self->ground[checkIndex(L, self)]);
+
+    return 1;
+}
+
+int LuaMapRegion::luaSetGround(lua_State *L)
+{
+    auto self = checkSelf(L);
+    size_t i = checkIndex(L, self);
+    auto serverId = static_cast<uint32_t>(luaL_checkinteger(L, 4));
+    luaL_argcheck(L, serverId == 0 || validGround(serverId), 4, "Expected 0 or the server ID of a ground item.");
+
+    self->ground[i] = serverId;
+
+    return 0;
+}
+
+int LuaMapRegion::luaGetTopItem(lua_State *L)
+{
+    auto self = checkSelf(L);
+    lua_pushinteger(L, self->topItem[checkIndex(L, self)]);
+
+    return 1;
+}
+
+int LuaMapRegion::luaSetTopItem(lua_State *L)
+{
+    auto self = checkSelf(L);
+    size_t i = checkIndex(L, self);
+    auto serverId = static_cast<uint32_t>(luaL_checkinteger(L, 4));
+    luaL_argcheck(L, serverId == 0 || validTopItem(serverId), 4, "Expected 0 or the server ID of an item that is not a ground.");
+
+    self->topItem[i] = serverId;
+
+    return 0;
+}
+
+int LuaMapRegion::luaGetFlags(lua_State *L)
+{
+    auto self = checkSelf(L);
+    lua_pushinteger(L, self->flags[checkIndex(L, self)]);
+
+    return 1;
+}
+
+int LuaMapRegion::luaSetFlags(lua_State *L)
+{
+    auto self = checkSelf(L);
+    size_t i = checkIndex(L, self);
+    self->flags[i] = static_cast<uint32_t>(luaL_checkinteger(L, 4));
+
+    return 0;
+}
+
+int LuaMapRegion::luaGroundData(lua_State *L)
+{
+    lua_pushlightuserdata(L, checkSelf(L)->ground.data());
+    return 1;
+}
+
+int LuaMapRegion::luaTopItemData(lua_State *L)
+{
+    lua_pushlightuserdata(L, checkSelf(L)->topItem.data());
+    return 1;
+}
+
+int LuaMapRegion::luaFlagsData(lua_State *L)
+{
+    lua_pushlightuserdata(L, checkSelf(L)->flags.data());
+    return 1;
+}
+
+int LuaMapRegion::luaGetX(lua_State *L)
+{
+    lua_pushinteger(L, checkSelf(L)->origin.x);
+    return 1;
+}
+
+int LuaMapRegion::luaGetY(lua_State *L)
+{
+    lua_pushinteger(L, checkSelf(L)->origin.y);
+    return 1;
+}
+
+int LuaMapRegion::luaGetZ(lua_State *L)
+{
+    lua_pushinteger(L, checkSelf(L)->origin.z);
+    return 1;
+}
+
+int LuaMapRegion::luaGetWidth(lua_State *L)
+{
+    lua_pushinteger(L, checkSelf(L)->width);
+    return 1;
+}
+
+int LuaMapRegion::luaGetHeight(lua_State *L)
+{
+    lua_pushinteger(L, checkSelf(L)->height);
+    return 1;
+}
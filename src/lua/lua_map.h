@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../position.h"
+
+class Map;
+class MapView;
+class Tile;
+struct lua_State;
+
+/*
+	A copy of the ground, top item and flags of every tile in a rectangle of one floor, stored as flat arrays that
+	are indexed by y * width + x (x and y relative to the origin). A tile without a ground or top item has 0 there,
+	and so has a position outside of the map.
+
+	Scripts edit the arrays and write the whole buffer back at once. Only tiles whose values differ from the values
+	that were read are written.
+*/
+class MapRegionBuffer
+{
+  public:
+    static MapRegionBuffer read(const Map &map, Position origin, uint16_t width, uint16_t height);
+
+    /*
+		Writes the changed tiles to the map as one undoable transaction and returns the number of tiles that were
+		written. Tiles outside of the map and item ids that are not valid are skipped.
+
+		A new top item replaces the top item of the tile, but is stacked like any other item: an item with a lower
+		stack order than the items below ends up under them. The buffer is updated with the ground and top item that
+		the written tiles end up with.
+	*/
+    size_t write(MapView &mapView);
+
+    /*
+		Returns copies of the changed tiles with the changes applied, and treats them as written. Used to commit
+		several buffers as one transaction.
+	*/
+    std::vector<Tile> takeChangedTiles(const Map &map);
+
+    bool contains(int x, int y) const noexcept;
+    size_t index(int x, int y) const noexcept;
+
+    Position origin;
+    uint16_t width = 0;
+    uint16_t height = 0;
+
+    std::vector<uint32_t> ground;
+    std::vector<uint32_t> topItem;
+    std::vector<uint32_t> flags;
+
+  private:
+    // The values as they were read or last written
+    std::vector<uint32_t> writtenGround;
+    std::vector<uint32_t> writtenTopItem;
+    std::vector<uint32_t> writtenFlags;
+};
+
+/*
+	Lua binding for MapRegionBuffer:
+
+		local region = MapRegion(x, y, z, width, height)
+		region:setGround(x, y, id)
+		region:write()
+
+	The methods take map positions. groundData, topItemData and flagsData return the arrays as pointers, so a LuaJIT
+	script can fill a region through ffi.cast("uint32_t *", ...) without crossing into C for every tile. The pointers
+	are only valid while the script holds a reference to the region: they dangle once the region is collected (and
+	for the region of a generation chunk, once the chunk function returns).
+*/
+class LuaMapRegion
+{
+  public:
+    static constexpr auto LuaName = "MapRegion";
+
+    // The map view is used by every MapRegion of the state
+    static void luaRegister(lua_State *L, MapView *mapView);
+
+    // Replaces the map view of the state. MapRegion(...) fails while it is nullptr.
+    static void setMapView(lua_State *L, MapView *mapView);
+
+    /*
+		Pushes a MapRegion that does not own the buffer; collecting it does not delete the buffer. The caller must set
+		the returned slot to nullptr before the buffer is destroyed; the MapRegion is unusable from then on.
+	*/
+    static MapRegionBuffer **pushView(lua_State *L, MapRegionBuffer *buffer);
+
+    static int luaCreate(lua_State *L);
+    static int luaDestroy(lua_State *L);
+    static int luaWrite(lua_State *L);
+
+    static int luaGetGround(lua_State *L);
+    static int luaSetGround(lua_State *L);
+    static int luaGetTopItem(lua_State *L);
+    static int luaSetTopItem(lua_State *L);
+    static int luaGetFlags(lua_State *L);
+    static int luaSetFlags(lua_State *L);
+
+    static int luaGroundData(lua_State *L);
+    static int luaTopItemData(lua_State *L);
+    static int luaFlagsData(lua_State *L);
+
+    static int luaGetX(lua_State *L);
+    static int luaGetY(lua_State *L);
+    static int luaGetZ(lua_State *L);
+    static int luaGetWidth(lua_State *L);
+    static int luaGetHeight(lua_State *L);
+
+    static MapRegionBuffer *checkSelf(lua_State *L);
+
+  private:
+    static MapView *mapView(lua_State *L);
+    static size_t checkIndex(lua_State *L, MapRegionBuffer *self);
+};
@@ -0,0 +1,351 @@
+#include "lua_profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+
+#include "../debug.h"
+#include "lua_state.h"
+
+namespace
+{
+    // The address is the registry key of the profiler of a state
+    char RegistryKey;
+
+    // The number of attached profilers. Scopes do nothing while it is 0.
+    std::atomic<uint32_t> attachedProfilers = 0;
+
+    double milliseconds(LuaProfiler::Clock::duration duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+} // namespace
+
+LuaProfiler::Scope::Scope(lua_State *L, const std::string &name)
+    : profiler(attachedProfilers == 0 ? nullptr : LuaProfiler::get(L))
+{
+    if (profiler)
+    {
+        // The time between outermost scopes (e.g. between chunks) is not part of any sampled stack
+        if (profiler->frames.empty())
+        {
+            profiler->lastSample = Clock::now();
+        }
+
+        profiler->enter(profiler->functionIndex("[" + name + "]"), true);
+    }
+}
+
+LuaProfiler::Scope::~Scope()
+{
+    if (profiler)
+    {
+        profiler->leaveScope();
+    }
+}
+
+LuaProfiler::LuaProfiler(uint32_t instructionsPerSample)
+    : instructionsPerSample(std::max<uint32_t>(instructionsPerSample, 1)) {}
+
+LuaProfiler::~LuaProfiler()
+{
+    detach();
+}
+
+LuaProfiler *LuaProfiler::get(lua_State *L)
+{
+    lua_pushlightuserdata(L, &RegistryKey);
+    lua_rawget(L, LUA_REGISTRYINDEX);
+    auto profiler = static_cast<LuaProfiler *>(lua_touserdata(L, -1));
+    lua_pop(L, 1);
+
+    return profiler;
+}
+
+void LuaProfiler::attach(lua_State *L)
+{
+    DEBUG_ASSERT(this->L == nullptr, "The profiler is already attached to a state.");
+
+    this->L = L;
+
+    lua_pushlightuserdata(L, &RegistryKey);
+    lua_pushlightuserdata(L, this);
+    lua_rawset(L, LUA_REGISTRYINDEX);
+
+    lastSample = Clock::now();
+    lua_sethook(L, hook, LUA_MASKCALL | LUA_MASKRET | LUA_MASKCOUNT, static_cast<int>(instructionsPerSample));
+
+    ++attachedProfilers;
+}
+
+void LuaProfiler::detach()
+{
+    if (!L)
+    {
+        return;
+    }
+
+    lua_sethook(L, nullptr, 0, 0);
+
+    lua_pushlightuserdata(L, &RegistryKey);
+    lua_pushnil(L);
+    lua_rawset(L, LUA_REGISTRYINDEX);
+
+    Clock::time_point now = Clock::now();
+    while (!frames.empty())
+    {
+        leave(now);
+    }
+
+    L = nullptr;
+    functionsByPointer.clear();
+
+    --attachedProfilers;
+}
+
+void LuaProfiler::hook(lua_State *L, lua_Debug *ar)
+{
+    LuaProfiler *profiler = get(L);
+    if (!profiler)
+    {
+        return;
+    }
+
+    switch (ar->event)
+    {
+        case LUA_HOOKCALL:
+#ifdef LUA_HOOKTAILCALL
+        case LUA_HOOKTAILCALL:
+#endif
+        {
+            // A frame at the same depth or deeper was replaced by a tail call and does not return
+            int depth = stackDepth(L);
+            profiler->leaveDepth(depth, Clock::now());
+            profiler->enter(profiler->functionIndex(L, ar), false, depth);
+            break;
+        }
+        case LUA_HOOKRET:
+            // Frames that were entered before the profiler was attached are not on the stack, and are not left
+            profiler->leaveDepth(stackDepth(L), Clock::now());
+            break;
+        case LUA_HOOKCOUNT:
+            profiler->sample();
+            break;
+        default:
+            // LUA_HOOKTAILRET (Lua 5.1): the frames of the tail calls were already left when they were replaced
+            break;
+    }
+}
+
+int LuaProfiler::stackDepth(lua_State *L)
+{
+    // The number of active functions. lua_getstack succeeds for levels below it; search for the first that fails.
+    lua_Debug ar;
+    int low = 0;
+    int high = 1;
+    while (lua_getstack(L, high, &ar))
+    {
+        low = high;
+        high *= 2;
+    }
+
+    while (high - low > 1)
+    {
+        int middle = low + (high - low) / 2;
+        if (lua_getstack(L, middle, &ar))
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return high;
+}
+
+uint32_t LuaProfiler::functionIndex(const std::string &name)
+{
+    auto found = functionsByName.find(name);
+    if (found != functionsByName.end())
+    {
+        return found->second;
+    }
+
+    uint32_t index = static_cast<uint32_t>(functions.size());
+    functions.emplace_back(FunctionStats{name});
+    activeFrames.emplace_back(0);
+    functionsByName.emplace(name, index);
+
+    return index;
+}
+
+uint32_t LuaProfiler::functionIndex(lua_State *L, lua_Debug *ar)
+{
+    lua_getinfo(L, "f", ar);
+    const void *function = lua_topointer(L, -1);
+    lua_pop(L, 1);
+
+    auto found = functionsByPointer.find(function);
+    if (found != functionsByPointer.end())
+    {
+        return found->second;
+    }
+
+    lua_getinfo(L, "nS", ar);
+
+    std::string name = ar->name ? ar->name : "?";
+    std::string what = ar->what ? ar->what : "";
+    if (what == "C")
+    {
+        name = "[C] " + name;
+    }
+    else if (what == "main")
+    {
+        name = "main (" + std::string(ar->short_src) + ")";
+    }
+    else
+    {
+        name += " (" + std::string(ar->short_src) + ":" + std::to_string(ar->linedefined) + ")";
+    }
+
+    uint32_t index = functionIndex(name);
+    functionsByPointer.emplace(function, index);
+
+    return index;
+}
+
+void LuaProfiler::enter(uint32_t function, bool scope, int depth)
+{
+    ++functions[function].calls;
+    ++activeFrames[function];
+
+    frames.emplace_back(Frame{function, Clock::now(), Clock::duration{}, scope, depth});
+}
+
+void LuaProfiler::leave(Clock::time_point now)
+{
+    Frame frame = frames.back();
+    frames.pop_back();
+
+    Clock::duration elapsed = now - frame.start;
+
+    FunctionStats &stats = functions[frame.function];
+    stats.selfTime += elapsed - frame.children;
+
+    // Only the outermost frame of a recursive function adds to its total time
+    if (--activeFrames[frame.function] == 0)
+    {
+        stats.totalTime += elapsed;
+    }
+
+    if (!frames.empty())
+    {
+        frames.back().children += elapsed;
+    }
+}
+
+void LuaProfiler::leaveDepth(int depth, Clock::time_point now)
+{
+    while (!frames.empty() && !frames.back().scope && frames.back().depth >= depth)
+    {
+        leave(now);
+    }
+}
+
+void LuaProfiler::leaveScope()
+{
+    // A Lua error unwinds the Lua frames above the scope without return hooks
+    Clock::time_point now = Clock::now();
+    while (!frames.empty())
+    {
+        bool scope = frames.back().scope;
+        leave(now);
+        if (scope)
+        {
+            break;
+        }
+    }
+}
+
+void LuaProfiler::sample()
+{
+    Clock::time_point now = Clock::now();
+
+    std::string stack;
+    for (const Frame &frame : frames)
+    {
+        if (!stack.empty())
+        {
+            stack += ';';
+        }
+        stack += functions[frame.function].name;
+    }
+
+    stacks[stack] += now - lastSample;
+    lastSample = now;
+}
+
+void LuaProfiler::merge(const LuaProfiler &other)
+{
+    for (const FunctionStats &stats : other.functions)
+    {
+        FunctionStats &merged = functions[functionIndex(stats.name)];
+        merged.calls += stats.calls;
+        merged.totalTime += stats.totalTime;
+        merged.selfTime += stats.selfTime;
+    }
+
+    for (const auto &[stack, time] : other.stacks)
+    {
+        stacks[stack] += time;
+    }
+}
+
+std::vector<LuaProfiler::FunctionStats> LuaProfiler::functionStats() const
+{
+    std::vector<FunctionStats> result = functions;
+    std::sort(result.begin(), result.end(), [](const FunctionStats &lhs, const FunctionStats &rhs) { return lhs.selfTime > rhs.selfTime; });
+
+    return result;
+}
+
+void LuaProfiler::writeReport(std::ostream &stream) const
+{
+    stream << std::setw(10) << "calls" << std::setw(12) << "total ms" << std::setw(12) << "self ms"
+           << "  function\n";
+
+    stream << std::fixed << std::setprecision(3);
+    for (const FunctionStats &stats : functionStats())
+    {
+        stream << std::setw(10) << stats.calls
+               << std::setw(12) << milliseconds(stats.totalTime)
+               << std::setw(12) << milliseconds(stats.selfTime)
+               << "  " << stats.name << '\n';
+    }
+}
+
+bool LuaProfiler::writeFoldedStacks(const std::filesystem::path &file) const
+{
+    std::ofstream stream(file, std::ios::out | std::ios::trunc);
+    for (const auto &[stack, time] : stacks)
+    {
+        auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(time).count();
+        if (stack.empty() || microseconds == 0)
+        {
+            continue;
+        }
+
+        stream << stack << ' ' << microseconds << '\n';
+    }
+
+    if (!stream)
+    {
+        VME_LOG_ERROR("Could not write the Lua profile " << file.string());
+        return false;
+    }
+
+    return true;
+}
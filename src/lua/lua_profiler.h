@@ -0,0 +1,128 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "../util.h"
+
+struct lua_State;
+struct lua_Debug;
+
+/*
+	Profiles the Lua code of one lua_State while it is attached. Nothing is installed on a state without a profiler,
+	so profiling costs nothing while it is off.
+
+	Two debug hooks are used:
+		- Call and return hooks time every function call, including calls from Lua into C functions. They give the
+		  call count and the total and self time of every function. Frames are matched by their stack depth, because
+		  a tail call replaces the frame of its caller and LuaJIT reports it as an ordinary call with no return for
+		  the caller.
+		- A count hook takes a sample of the call stack every instructionsPerSample VM instructions. The time since the
+		  previous sample is added to the stack, which gives the folded stacks of a flamegraph.
+
+	Calls from C++ into Lua (doFile, script callbacks) are marked with a Scope. A scope is a frame of its own, so the
+	functions it runs are nested under it.
+
+	LuaJIT does not call hooks from compiled traces. Enable the profiler with the JIT off (jit.off()) for exact numbers.
+*/
+class LuaProfiler
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    struct FunctionStats
+    {
+        std::string name;
+        uint64_t calls = 0;
+        Clock::duration totalTime{};
+        Clock::duration selfTime{};
+    };
+
+    /*
+		Times a call from C++ into Lua on a profiled state. Does nothing if no profiler is attached anywhere.
+	*/
+    class Scope
+    {
+      public:
+        Scope(lua_State *L, const std::string &name);
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+      private:
+        LuaProfiler *profiler;
+    };
+
+    LuaProfiler(uint32_t instructionsPerSample = 1000);
+    ~LuaProfiler();
+
+    LuaProfiler(const LuaProfiler &) = delete;
+    LuaProfiler &operator=(const LuaProfiler &) = delete;
+
+    // Installs the hooks on L. The profiler can be attached to one state at a time.
+    void attach(lua_State *L);
+    void detach();
+
+    // Adds the results of another profiler, e.g. of another worker state. Functions are matched by name.
+    void merge(const LuaProfiler &other);
+
+    // Sorted by self time, slowest first
+    std::vector<FunctionStats> functionStats() const;
+
+    // A table of the function stats
+    void writeReport(std::ostream &stream) const;
+
+    /*
+		Writes one line per sampled stack: the frames from the root, separated by ';', then the time in microseconds.
+		This is the input format of flamegraph.pl and speedscope.
+	*/
+    bool writeFoldedStacks(const std::filesystem::path &file) const;
+
+    static LuaProfiler *get(lua_State *L);
+
+  private:
+    struct Frame
+    {
+        uint32_t function;
+        Clock::time_point start;
+        Clock::duration children{};
+        // Pushed by a Scope. Not popped by return hooks.
+        bool scope;
+        // The Lua stack depth of the function. Not used for scopes.
+        int depth = 0;
+    };
+
+    static void hook(lua_State *L, lua_Debug *ar);
+    static int stackDepth(lua_State *L);
+
+    uint32_t functionIndex(const std::string &name);
+    uint32_t functionIndex(lua_State *L, lua_Debug *ar);
+
+    void enter(uint32_t function, bool scope, int depth = 0);
+    void leave(Clock::time_point now);
+    // Leaves the function frames at depth or deeper, down to the innermost scope
+    void leaveDepth(int depth, Clock::time_point now);
+    void leaveScope();
+    void sample();
+
+    lua_State *L = nullptr;
+    uint32_t instructionsPerSample;
+
+    std::vector<FunctionStats> functions;
+    std::map<std::string, uint32_t> functionsByName;
+    vme_unordered_map<const void *, uint32_t> functionsByPointer;
+
+    // How many frames of each function are on the stack, to count the total time of recursive calls once
+    std::vector<uint32_t> activeFrames;
+
+    std::vector<Frame> frames;
+
+    std::map<std::string, Clock::duration> stacks;
+    Clock::time_point lastSample;
+};
@@ -3,6 +3,7 @@
 #include "../debug.h"
 #include "../util.h"
 #include "lua_brush.h"
+#include "lua_profiler.h"
 
 #if !defined LUA_VERSION_NUM || LUA_VERSION_NUM == 501
 // From http://lua-users.org/wiki/CompatibilityWithLuaFive
@@ -280,6 +281,7 @@ void LuaState::pushNumber(lua_Number number)
 
 bool LuaState::doFile(std::string file)
 {
+    LuaProfiler::Scope scope(L, file);
     return luaL_dofile(L, file.c_str()) == 0;
 }
 
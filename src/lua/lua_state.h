@@ -155,7 +155,7 @@ class LuaState
     LuaType getGlobal(const char *name);
     LuaType getGlobal(const std::string &name);
 
-    lua_State *L;
+    lua_State *L = nullptr;
 
   private:
     friend class LuaScriptInterface;
@@ -8,14 +8,18 @@
 
 #include <initializer_list>
 #include <iostream>
+#include <sstream>
 #include <string>
 
 #include "../brushes/brush.h"
 #include "../brushes/ground_brush.h"
 #include "../debug.h"
+#include "../settings.h"
 #include "../time_util.h"
 
 #include "lua_brush.h"
+#include "lua_map.h"
+#include "lua_profiler.h"
 
 LuaScriptInterface LuaScriptInterface::g_luaInterface;
 
@@ -28,7 +32,14 @@ bool LuaScriptInterface::initialize()
 
 bool LuaScriptInterface::initState()
 {
-    return L.initialize();
+    if (!L.initialize())
+    {
+        return false;
+    }
+
+    LuaMapRegion::luaRegister(L.L, mapView);
+
+    return true;
 }
 
 void LuaScriptInterface::errorAbort(const std::string &error)
@@ -54,14 +65,34 @@ void LuaScriptInterface::test()
 
     LuaGroundBrush::luaRegister(L.L);
 
-    if (!L.doFile("test.lua"))
+    std::optional<LuaProfiler> profiler;
+    if (Settings::PROFILE_LUA_SCRIPTS)
+    {
+        profiler.emplace();
+        profiler->attach(L.L);
+    }
+
+    bool ok = L.doFile("test.lua");
+    if (!ok)
     {
         VME_LOG("[Error - Lua load] " << L.toString(-1));
-        L.close();
-        return;
     }
 
-    VME_LOG("Finished running test.lua.");
+    if (profiler)
+    {
+        profiler->detach();
+
+        std::ostringstream report;
+        profiler->writeReport(report);
+        VME_LOG("Lua profile of test.lua:\n"
+                << report.str());
+        profiler->writeFoldedStacks("test.lua.folded");
+    }
+
+    if (ok)
+    {
+        VME_LOG("Finished running test.lua.");
+    }
 
     L.close();
 }
@@ -76,6 +107,15 @@ void LuaScriptInterface::registerTable(const std::string &tableName)
 //     L.registerMethod(globalName, methodName, function);
 // }
 
+void LuaScriptInterface::registerMap(MapView *mapView)
+{
+    this->mapView = mapView;
+    if (L.L)
+    {
+        LuaMapRegion::setMapView(L.L, mapView);
+    }
+}
+
 lua_State *LuaScriptInterface::luaState() const noexcept
 {
     return L.L;
@@ -13,6 +13,7 @@
 
 class GroundBrush;
 class LuaState;
+class MapView;
 
 class LuaScriptInterface
 {
@@ -27,6 +28,12 @@ class LuaScriptInterface
 
     [[nodiscard]] lua_State *luaState() const noexcept;
 
+    /*
+		Gives scripts access to the map of the map view (see LuaMapRegion), or takes it away if mapView is nullptr.
+		Can be called before the state is initialized.
+	*/
+    void registerMap(MapView *mapView);
+
     void test();
 
     static LuaScriptInterface g_luaInterface;
@@ -38,6 +45,7 @@ class LuaScriptInterface
     bool initState();
 
     LuaState L;
+    MapView *mapView = nullptr;
 
     void errorAbort(const std::string &error);
 };
@@ -20,6 +20,7 @@
 #include "config.h"
 #include "file.h"
 #include "graphics/appearances.h"
+#include "gui/gui_thing_image.h"
 #include "gui/main_application.h"
 #include "gui/map_tab_widget.h"
 #include "gui/map_view_widget.h"
@@ -31,6 +32,8 @@
 #include "observable_item.h"
 #include "qt/logging.h"
 #include "random.h"
+#include "settings.h"
+#include "task_graph.h"
 #include "time_util.h"
 #include "util.h"
 
@@ -42,6 +45,7 @@
 
 #include "lua/luascript_interface.h"
 
+#include "brushes/brush_database.h"
 #include "brushes/brush_loader.h"
 #include "item_palette.h"
 
@@ -78,19 +82,38 @@ int main(int argc, char *argv[])
     QQuickStyle::setStyle("Fusion");
 
     Config config = configResult.unwrap();
-    config.loadOrTerminate();
+
+    TaskGraph startup;
+    auto configError = config.addLoadTasks(startup);
+    if (configError)
+    {
+        ABORT_PROGRAM(configError.value().show());
+    }
 
     // testApplyAtlasTemplate();
 
-    BrushLoader brushLoader;
-    brushLoader.load(std::format("{}/palettes/palettes.json", clientPath));
-    brushLoader.load(std::format("{}/palettes/borders.json", clientPath));
-    brushLoader.load(std::format("{}/palettes/grounds.json", clientPath));
-    brushLoader.load(std::format("{}/palettes/walls.json", clientPath));
-    brushLoader.load(std::format("{}/palettes/doodads.json", clientPath));
-    brushLoader.load(std::format("{}/palettes/mountains.json", clientPath));
-    brushLoader.load(std::format("{}/palettes/creatures.json", clientPath));
-    brushLoader.load(std::format("{}/palettes/tilesets.json", clientPath));
+    std::vector<std::filesystem::path> brushFiles;
+    for (auto name : {"palettes", "borders", "grounds", "walls", "doodads", "mountains", "creatures", "tilesets"})
+    {
+        brushFiles.emplace_back(std::format("{}/palettes/{}.json", clientPath, name));
+    }
+
+    std::filesystem::path brushDatabaseFile = Settings::COMPILE_BRUSHES ? std::format("{}/cache/brushes.bin", clientPath) : "";
+    BrushDatabase brushDatabase(brushDatabaseFile, std::move(brushFiles));
+
+    // The brush files do not depend on anything, so they are compiled while the client files load
+    startup.add("brush files", [&brushDatabase]() { brushDatabase.compile(); });
+
+    // Brushes refer to item types, and later palette files refer to brushes from earlier ones
+    startup.add(
+        "brushes", [&brushDatabase]() {
+            BrushLoader brushLoader;
+            brushDatabase.load(brushLoader);
+        },
+        {Config::ItemsLoadedTask, "brush files"});
+
+    startup.run();
+    startup.logTimings("Startup");
 
     // TemporaryTest::loadAllTexturesIntoMemory();
 
@@ -106,6 +129,11 @@ int main(int argc, char *argv[])
     Map loadedMap = std::move(std::get<Map>(result));
     std::shared_ptr<Map> sharedMap = std::make_shared<Map>(std::move(loadedMap));
 
+    if (Settings::CACHE_THUMBNAILS)
+    {
+        GUIImageCache::openDiskCache(std::format("{}/cache/thumbnails.bin", clientPath), version);
+    }
+
     app.initializeUI();
     app.mainWindow.addMapTab(sharedMap);
     // app.mainWindow.addMapTab(TemporaryTest::makeTestMap1());
@@ -179,7 +207,11 @@ int main(int argc, char *argv[])
     // int cyclops = 22;
     // checkCreature(cyclops);
 
-    return app.run();
+    int exitCode = app.run();
+
+    GUIImageCache::closeDiskCache();
+
+    return exitCode;
 }
 
 // void testApplyAtlasTemplate()
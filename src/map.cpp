@@ -233,6 +233,17 @@ bool Map::hasTile(const Position pos) const
     return floor && (floor->getTileLocation(pos.x, pos.y).tile() != nullptr);
 }
 
+bool Map::hasTiles(const Position from, const Position to) const
+{
+    return root.containsTile(
+        std::min(from.x, to.x),
+        std::min(from.y, to.y),
+        std::max(from.x, to.x),
+        std::max(from.y, to.y),
+        std::min(from.z, to.z),
+        std::max(from.z, to.z));
+}
+
 TileThing Map::getTopThing(const Position pos)
 {
     return const_cast<const Map *>(this)->getTopThing(pos);
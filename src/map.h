@@ -52,6 +52,11 @@ class Map
     TileLocation *getTileLocation(int x, int y, int z) const;
     TileLocation *getTileLocation(const Position &pos) const;
     bool hasTile(const Position pos) const;
+
+    /*
+		Returns true if a tile exists in the box spanned by from and to. Empty parts of the quadtree are skipped.
+	*/
+    bool hasTiles(const Position from, const Position to) const;
     Tile *getTile(const Position pos) const;
     const Item *getTopItem(const Position pos) const;
     Item *getTopItem(const Position pos);
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "position.h"
+
+/*
+	The changes to the map of a map view that were gathered during a notification batch (see
+	MapView::beginNotificationBatch). Subscribers get them once per batch instead of once per change.
+*/
+struct MapChanges
+{
+    // Bounds of the changed tiles, inclusive. Only meaningful if tileCount is not 0.
+    Position from;
+    Position to;
+
+    // The number of tile changes. A tile that changed twice is counted twice.
+    uint32_t tileCount = 0;
+
+    // Guids of the observed items whose properties changed
+    std::vector<uint32_t> changedGuids;
+
+    void addTile(const Position &position)
+    {
+        if (tileCount == 0)
+        {
+            from = position;
+            to = position;
+        }
+        else
+        {
+            from = Position(std::min(from.x, position.x), std::min(from.y, position.y), std::min(from.z, position.z));
+            to = Position(std::max(to.x, position.x), std::max(to.y, position.y), std::max(to.z, position.z));
+        }
+
+        ++tileCount;
+    }
+
+    bool dirty(const Position &position) const noexcept
+    {
+        return tileCount != 0 &&
+               from.x <= position.x && position.x <= to.x &&
+               from.y <= position.y && position.y <= to.y &&
+               from.z <= position.z && position.z <= to.z;
+    }
+
+    bool empty() const noexcept
+    {
+        return tileCount == 0 && changedGuids.empty();
+    }
+};
@@ -1,7 +1,9 @@
 #include "map_renderer.h"
 
+#include <algorithm>
 #include <glm/vec2.hpp>
 #include <stdexcept>
+#include <utility>
 #include <variant>
 
 #include "../vendor/rollbear-visit/visit.hpp"
@@ -12,6 +14,8 @@
 #include "debug.h"
 #include "file.h"
 #include "graphics/appearances.h"
+#include "graphics/atlas_decompressor.h"
+#include "graphics/texture_atlas_cache.h"
 #include "logger.h"
 #include "map_view.h"
 #include "position.h"
@@ -83,21 +87,29 @@ glm::vec4 colors::opacity(float value)
 
 MapRenderer::MapRenderer(VulkanInfo &vulkanInfo, MapView *mapView)
     : mapView(mapView),
-      vulkanInfo(vulkanInfo),
+      vulkanInfo(&vulkanInfo),
       vulkanTexturesForAppearances(Appearances::textureAtlasCount()),
       vulkanSwapChainImageSize(0, 0)
 {
     activeTextureAtlasIds.reserve(Appearances::textureAtlasCount());
 
+    TextureAtlasCache::textureEvicted.connect<&MapRenderer::textureAtlasEvicted>(this);
+
     size_t ArbitraryGeneralReserveAmount = 8;
     vulkanTextures.reserve(ArbitraryGeneralReserveAmount);
 }
 
+MapRenderer::MapRenderer(MapView *mapView)
+    : mapView(mapView),
+      vulkanInfo(nullptr),
+      _currentFrame(&frames.front()),
+      vulkanSwapChainImageSize(0, 0) {}
+
 void MapRenderer::initResources(VkFormat colorFormat)
 {
     // VME_LOG_D("[window: " << window.debugName << "] MapRenderer::initResources (device: " << window.device() << ")");
 
-    vulkanInfo.update();
+    vulkanInfo->update();
     this->colorFormat = colorFormat;
 
     createRenderPass();
@@ -130,34 +142,41 @@ void MapRenderer::releaseResources()
     // auto device = window.device();
     // VME_LOG_D("[window: " << window.debugName << "] MapRenderer::releaseResources (device: " << device << ")");
 
-    vulkanInfo.vkDestroyDescriptorSetLayout(uboDescriptorSetLayout, nullptr);
+    // Texture descriptor sets are freed into the descriptor pool, so they are released before it is destroyed.
+    for (const auto id : activeTextureAtlasIds)
+    {
+        VulkanTexture &vulkanTexture = vulkanTexturesForAppearances.at(id);
+        if (vulkanTexture.hasResources())
+        {
+            vulkanTexture.releaseResources();
+        }
+    }
+    activeTextureAtlasIds.clear();
+    evictedTextureIds.clear();
+
+    vulkanTextures.clear();
+
+    vulkanInfo->vkDestroyDescriptorSetLayout(uboDescriptorSetLayout, nullptr);
     uboDescriptorSetLayout = VK_NULL_HANDLE;
 
-    vulkanInfo.vkDestroyDescriptorSetLayout(textureDescriptorSetLayout, nullptr);
+    vulkanInfo->vkDestroyDescriptorSetLayout(textureDescriptorSetLayout, nullptr);
     textureDescriptorSetLayout = VK_NULL_HANDLE;
 
-    vulkanInfo.vkDestroyDescriptorPool(descriptorPool, nullptr);
+    vulkanInfo->vkDestroyDescriptorPool(descriptorPool, nullptr);
     descriptorPool = VK_NULL_HANDLE;
 
-    vulkanInfo.vkDestroyPipeline(graphicsPipeline, nullptr);
+    vulkanInfo->vkDestroyPipeline(graphicsPipeline, nullptr);
     graphicsPipeline = VK_NULL_HANDLE;
 
-    vulkanInfo.vkDestroyPipelineLayout(pipelineLayout, nullptr);
+    vulkanInfo->vkDestroyPipelineLayout(pipelineLayout, nullptr);
     pipelineLayout = VK_NULL_HANDLE;
 
-    vulkanInfo.vkDestroyRenderPass(renderPass, nullptr);
+    vulkanInfo->vkDestroyRenderPass(renderPass, nullptr);
     renderPass = VK_NULL_HANDLE;
 
     vertexBuffer.releaseResources();
     indexBuffer.releaseResources();
 
-    for (const auto id : activeTextureAtlasIds)
-    {
-        vulkanTexturesForAppearances.at(id).releaseResources();
-    }
-    activeTextureAtlasIds.clear();
-
-    vulkanTextures.clear();
 
     for (auto &frame : frames)
     {
@@ -172,36 +191,85 @@ void MapRenderer::releaseResources()
 
 void MapRenderer::startNextFrame()
 {
-    _containsAnimation = false;
     // VME_LOG_D("index: " << _currentFrame->currentFrameIndex);
     // VME_LOG("Start next frame");
+    _frameStatistics.beginFrame();
+    ++renderedFrames;
+
+    releaseEvictedTextures();
+
     updateUniformBuffer();
 
     beginRenderPass();
 
     setupFrame();
 
+    drawFrame();
+
+    vulkanInfo->vkCmdEndRenderPass(_currentFrame->commandBuffer);
+
+    vulkanInfo->frameReady();
+    // vulkanInfo->requestUpdate();
+    currentDescriptorSet = nullptr;
+
+    _frameStatistics.endFrame();
+}
+
+void MapRenderer::recordFrame(DrawList &drawList)
+{
+    this->drawList = &drawList;
+    _frameStatistics.beginFrame();
+
+    drawFrame();
+
+    _frameStatistics.endFrame();
+    this->drawList = nullptr;
+}
+
+void MapRenderer::drawFrame()
+{
+    _animationScheduler.beginFrame();
+    TextureAtlasCache::beginFrame(atlasFrames);
+
     // Attempt to avoid possible floating point errors. Might be unnecessary.
     float zoom = mapView->getZoomFactor();
     auto floorZoom = std::floor(zoom);
     isDefaultZoom = floorZoom == zoom && floorZoom == 1;
 
-    drawMap();
-    drawCurrentAction();
-    drawMapOverlay();
+    // Animations are barely visible when zoomed out far, so they are not updated (and do not trigger redraws).
+    animationsEnabled = Settings::RENDER_ANIMATIONS && zoom >= Settings::MIN_ZOOM_FOR_ANIMATIONS;
 
-    vulkanInfo.vkCmdEndRenderPass(_currentFrame->commandBuffer);
+    // A recorded frame must be complete, so it decompresses atlases synchronously.
+    asyncAtlases = Settings::DECOMPRESS_ATLASES_ASYNC && !drawList;
+    if (asyncAtlases)
+    {
+        AtlasDecompressor::installFinished();
+    }
 
-    vulkanInfo.frameReady();
-    // vulkanInfo.requestUpdate();
-    currentDescriptorSet = nullptr;
+    {
+        FrameStatistics::PhaseTimer timer(_frameStatistics, RenderPhase::Map);
+        drawMap();
+    }
+    {
+        FrameStatistics::PhaseTimer timer(_frameStatistics, RenderPhase::CurrentAction);
+        drawCurrentAction();
+    }
+    {
+        FrameStatistics::PhaseTimer timer(_frameStatistics, RenderPhase::Overlay);
+        drawMapOverlay();
+    }
+
+    if (asyncAtlases)
+    {
+        prefetchAtlases();
+    }
 }
 
 void MapRenderer::setupFrame()
 {
-    vulkanInfo.vkCmdBindPipeline(_currentFrame->commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+    vulkanInfo->vkCmdBindPipeline(_currentFrame->commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
 
-    const util::Size size = vulkanInfo.vulkanSwapChainImageSize();
+    const util::Size size = vulkanInfo->vulkanSwapChainImageSize();
 
     VkViewport viewport;
     viewport.x = viewport.y = 0;
@@ -209,17 +277,18 @@ void MapRenderer::setupFrame()
     viewport.height = size.height();
     viewport.minDepth = 0;
     viewport.maxDepth = 1;
-    vulkanInfo.vkCmdSetViewport(_currentFrame->commandBuffer, 0, 1, &viewport);
+    vulkanInfo->vkCmdSetViewport(_currentFrame->commandBuffer, 0, 1, &viewport);
 
     VkRect2D scissor;
     scissor.offset.x = scissor.offset.y = 0;
     scissor.extent.width = viewport.width;
     scissor.extent.height = viewport.height;
-    vulkanInfo.vkCmdSetScissor(_currentFrame->commandBuffer, 0, 1, &scissor);
+    vulkanInfo->vkCmdSetScissor(_currentFrame->commandBuffer, 0, 1, &scissor);
 
     VkDeviceSize offsets[] = {0};
 
-    vulkanInfo.vkCmdBindDescriptorSets(
+    ++_frameStatistics.counters().descriptorBinds;
+    vulkanInfo->vkCmdBindDescriptorSets(
         _currentFrame->commandBuffer,
         VK_PIPELINE_BIND_POINT_GRAPHICS,
         pipelineLayout,
@@ -229,8 +298,8 @@ void MapRenderer::setupFrame()
         0,
         nullptr);
 
-    vulkanInfo.vkCmdBindVertexBuffers(_currentFrame->commandBuffer, 0, 1, &vertexBuffer.buffer, offsets);
-    vulkanInfo.vkCmdBindIndexBuffer(_currentFrame->commandBuffer, indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT16);
+    vulkanInfo->vkCmdBindVertexBuffers(_currentFrame->commandBuffer, 0, 1, &vertexBuffer.buffer, offsets);
+    vulkanInfo->vkCmdBindIndexBuffer(_currentFrame->commandBuffer, indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT16);
 }
 
 void MapRenderer::drawMap()
@@ -268,11 +337,17 @@ void MapRenderer::drawMap()
     if (selectAction && selectAction->area)
         flags |= ItemDrawFlags::ActiveSelectionArea;
 
-    for (auto &tileLocation : view.mapRegion(1, 1))
+    MapRegion region = view.mapRegion(1, 1);
+    beginOcclusionCulling(region, flags, filter != nullptr);
+
+    for (auto &tileLocation : region)
     {
         if (!tileLocation.hasTile() || (movingSelection && tileLocation.tile()->allSelected()))
             continue;
 
+        if (isTileOccluded(*tileLocation.tile()))
+            continue;
+
         uint32_t tileFlags = flags;
         if (shadeLowerFloors && tileLocation.z() > viewZ)
         {
@@ -282,6 +357,8 @@ void MapRenderer::drawMap()
         drawTile(tileLocation, tileFlags, filter);
     }
 
+    occlusion.enabled = false;
+
     // Draw paste preview
     auto pasteAction = mapView->editorAction.as<MouseAction::PasteMapBuffer>();
     if (pasteAction)
@@ -467,11 +544,9 @@ void MapRenderer::drawCreatureType(const CreatureType &creatureType, const Posit
         info.color = color;
         info.textureInfo = creatureType->getTextureInfo(0, posture, addonType, direction);
 
-        auto texture = creatureType->hasColorVariation()
-                           ? info.textureInfo.getTexture(creatureType->outfitId())
-                           : info.textureInfo.getTexture();
+        const auto &texture = info.textureInfo.getTexture();
 
-        info.descriptorSet = objectDescriptorSet(texture);
+        bindTexture(info, texture);
         info.position = position;
         info.width = info.textureInfo.atlas->spriteWidth;
         info.height = info.textureInfo.atlas->spriteHeight;
@@ -578,6 +653,77 @@ void MapRenderer::drawMapOverlay()
     }
 }
 
+void MapRenderer::prefetchAtlases()
+{
+    // Tiles beyond the edge of the viewport (in the direction of panning) to prefetch
+    constexpr int PrefetchTiles = 8;
+
+    Position camera = mapView->cameraPosition();
+    std::optional<Position> previous = std::exchange(lastCameraPosition, camera);
+    if (!previous || previous->z != camera.z)
+        return;
+
+    int dx = camera.x - previous->x;
+    int dy = camera.y - previous->y;
+    if (dx == 0 && dy == 0)
+        return;
+
+    const Map &map = *mapView->map();
+    const Camera::Viewport &viewport = mapView->getViewport();
+    int width = static_cast<int>(viewport.gameWidth());
+    int height = static_cast<int>(viewport.gameHeight());
+    int bottomFloor = camera.z <= GROUND_FLOOR ? GROUND_FLOOR : MAP_LAYERS - 1;
+
+    auto prefetchArea = [&map, &camera, bottomFloor](int x1, int y1, int x2, int y2) {
+        Position from(std::max(x1, 0), std::max(y1, 0), bottomFloor);
+        Position to(std::min(x2, map.width() - 1), std::min(y2, map.height() - 1), camera.z);
+        if (from.x > to.x || from.y > to.y)
+            return;
+
+        for (auto &tileLocation : map.getRegion(from, to))
+        {
+            const Tile *tile = tileLocation.tile();
+            if (!tile)
+                continue;
+
+            Position position = tileLocation.position();
+            if (tile->ground())
+            {
+                const Item &ground = *tile->ground();
+                AtlasDecompressor::request(ground.itemType->getTextureAtlas(ground.getSpriteId(position)));
+            }
+
+            for (const auto &item : tile->items())
+            {
+                AtlasDecompressor::request(item->itemType->getTextureAtlas(item->getSpriteId(position)));
+            }
+        }
+    };
+
+    // The visible region (see drawMap) is padded by one tile
+    if (dx != 0)
+    {
+        int x1 = dx > 0 ? camera.x + width + 2 : camera.x - PrefetchTiles;
+        prefetchArea(x1, camera.y - PrefetchTiles, x1 + PrefetchTiles - 1, camera.y + height + PrefetchTiles);
+    }
+
+    if (dy != 0)
+    {
+        int y1 = dy > 0 ? camera.y + height + 2 : camera.y - PrefetchTiles;
+        prefetchArea(camera.x - PrefetchTiles, y1, camera.x + width + PrefetchTiles, y1 + PrefetchTiles - 1);
+    }
+}
+
+void MapRenderer::animate(const Item &item)
+{
+    if (!animationsEnabled || !item.hasAnimation())
+        return;
+
+    item.animate();
+    _animationScheduler.add(*item.animation());
+    ++_frameStatistics.counters().animatedItems;
+}
+
 bool MapRenderer::shouldDrawItem(const Position pos, const Item &item, uint32_t flags, const ItemPredicate &filter) const noexcept
 {
     bool selected = item.selected && (flags & ItemDrawFlags::DrawSelected);
@@ -599,23 +745,43 @@ void MapRenderer::drawTile(const TileLocation &tileLocation, uint32_t flags, con
 
 void MapRenderer::drawTile(Tile *tile, uint32_t flags, const Position offset, const ItemPredicate &filter)
 {
+    ++_frameStatistics.counters().tilesVisited;
+
     auto position = tile->position();
     position += offset;
 
-    Item *groundPtr = tile->ground();
-    if (groundPtr != nullptr)
+    // Ground and items below the topmost opaque, tile-covering item are hidden by it and do not need to be drawn.
+    size_t firstVisibleItem = 0;
+    bool groundHidden = false;
+    if (occlusion.enabled)
     {
-        if (shouldDrawItem(position, *groundPtr, flags, filter))
+        DrawOffset itemOffset{0, 0};
+        const auto &items = tile->items();
+        for (size_t i = 0; i < items.size(); ++i)
         {
-            if (Settings::RENDER_ANIMATIONS)
+            const Item &item = *items[i];
+            if (shouldDrawItem(position, item, flags, filter) && coversTile(item, position, itemOffset))
             {
-                if (groundPtr->hasAnimation())
-                {
-                    groundPtr->animate();
-                    _containsAnimation = true;
-                }
+                firstVisibleItem = i;
+                groundHidden = true;
             }
 
+            if (item.itemType->hasElevation())
+            {
+                int elevation = item.itemType->getElevation();
+                itemOffset.x -= elevation;
+                itemOffset.y -= elevation;
+            }
+        }
+    }
+
+    Item *groundPtr = tile->ground();
+    if (groundPtr != nullptr && !(groundHidden && fitsInTile(*groundPtr, position, DrawOffset{0, 0})))
+    {
+        if (shouldDrawItem(position, *groundPtr, flags, filter))
+        {
+            animate(*groundPtr);
+
             ItemDrawInfo info{};
 
             info.drawFlags = flags;
@@ -629,21 +795,25 @@ void MapRenderer::drawTile(Tile *tile, uint32_t flags, const Position offset, co
     DrawOffset worldPosOffset{0, 0};
     ItemDrawInfo info{};
 
-    for (const std::shared_ptr<Item> &itemPtr : tile->items())
+    const auto &items = tile->items();
+    for (size_t i = 0; i < items.size(); ++i)
     {
-        const Item &item = *itemPtr;
-        if (!shouldDrawItem(position, item, flags, filter))
-            continue;
+        const Item &item = *items[i];
 
-        if (Settings::RENDER_ANIMATIONS)
+        bool hidden = i < firstVisibleItem && fitsInTile(item, position, worldPosOffset);
+        if (hidden || !shouldDrawItem(position, item, flags, filter))
         {
-            if (item.hasAnimation())
+            if (item.itemType->hasElevation())
             {
-                item.animate();
-                _containsAnimation = true;
+                int elevation = item.itemType->getElevation();
+                worldPosOffset.x -= elevation;
+                worldPosOffset.y -= elevation;
             }
+            continue;
         }
 
+        animate(item);
+
         info.drawFlags = flags;
         info.item = &item;
         info.position = position;
@@ -668,8 +838,143 @@ void MapRenderer::drawTile(Tile *tile, uint32_t flags, const Position offset, co
     }
 }
 
+void MapRenderer::beginOcclusionCulling(const MapRegion &region, uint32_t flags, bool hasFilter)
+{
+    occlusion.coveredTilesByChunk.clear();
+
+    // A filter can hide arbitrary items, so nothing is guaranteed to be drawn on top.
+    occlusion.enabled = !hasFilter;
+    occlusion.viewZ = mapView->z();
+    occlusion.drawFlags = flags;
+
+    const Position from = region.getFrom();
+    const Position to = region.getTo();
+    occlusion.x1 = std::min(from.x, to.x);
+    occlusion.y1 = std::min(from.y, to.y);
+    occlusion.x2 = std::max(from.x, to.x);
+    occlusion.y2 = std::max(from.y, to.y);
+}
+
+bool MapRenderer::isTileOccluded(const Tile &tile)
+{
+    if (!occlusion.enabled || tile.z() <= occlusion.viewZ)
+        return false;
+
+    const int x = tile.x();
+    const int y = tile.y();
+    const int z = tile.z();
+
+    // Sprites can extend one tile up and to the left (64x64 sprites, elevation), so those tiles must be covered too.
+    if (!(isCovered(x, y, z) && isCovered(x - 1, y, z) && isCovered(x, y - 1, z) && isCovered(x - 1, y - 1, z)))
+        return false;
+
+    // Shifted items can be drawn anywhere, so they are never considered hidden.
+    auto shifted = [](const Item &item) { return item.itemType->hasFlag(AppearanceFlag::Shift); };
+    if (tile.ground() && shifted(*tile.ground()))
+        return false;
+
+    return std::none_of(tile.items().begin(), tile.items().end(), [&shifted](const std::shared_ptr<Item> &item) {
+        return shifted(*item);
+    });
+}
+
+bool MapRenderer::isCovered(int x, int y, int z)
+{
+    // Chunk coordinates are offset to keep them positive for the key
+    uint64_t chunkX = static_cast<uint64_t>((x + 4) >> 2);
+    uint64_t chunkY = static_cast<uint64_t>((y + 4) >> 2);
+    uint64_t key = (chunkX << 32) | (chunkY << 8) | static_cast<uint64_t>(z);
+
+    auto found = occlusion.coveredTilesByChunk.find(key);
+    uint16_t mask;
+    if (found != occlusion.coveredTilesByChunk.end())
+    {
+        mask = found->second;
+    }
+    else
+    {
+        mask = computeChunkCoverage(x & (~3), y & (~3), z);
+        occlusion.coveredTilesByChunk.emplace(key, mask);
+    }
+
+    return (mask >> ((x & 3) * 4 + (y & 3))) & 1;
+}
+
+uint16_t MapRenderer::computeChunkCoverage(int chunkX, int chunkY, int z)
+{
+    const Map &map = *mapView->map();
+    uint16_t mask = 0;
+
+    for (int i = 0; i < MAP_TREE_CHILDREN_COUNT; ++i)
+    {
+        int x = chunkX + (i >> 2);
+        int y = chunkY + (i & 3);
+
+        // Because of the perspective, the tile at (x + d, y + d, z - d) is drawn on top of (x, y, z).
+        for (int d = 1; z - d >= occlusion.viewZ; ++d)
+        {
+            int upperX = x + d;
+            int upperY = y + d;
+            if (upperX < occlusion.x1 || upperX > occlusion.x2 || upperY < occlusion.y1 || upperY > occlusion.y2)
+                break;
+
+            if (isOccluder(map.getTile(Position(upperX, upperY, z - d))))
+            {
+                mask |= 1 << i;
+                break;
+            }
+        }
+    }
+
+    return mask;
+}
+
+bool MapRenderer::isOccluder(const Tile *tile) const
+{
+    if (!tile || !tile->ground())
+        return false;
+
+    const Item &ground = *tile->ground();
+    return shouldDrawItem(tile->position(), ground, occlusion.drawFlags) && coversTile(ground, tile->position(), DrawOffset{0, 0});
+}
+
+bool MapRenderer::coversTile(const Item &item, const Position position, DrawOffset offset) const
+{
+    if (offset.x != 0 || offset.y != 0)
+        return false;
+
+    const ItemType &itemType = *item.itemType;
+    if (itemType.hasFlag(AppearanceFlag::Shift) || itemType.hasFlag(AppearanceFlag::Translucent))
+        return false;
+
+    // Partial quadrant rendering does not draw the whole sprite
+    if (!isDefaultZoom && itemType.appearance->quadrantRenderType != QuadrantRenderType::Full)
+        return false;
+
+    uint32_t spriteId = item.getSpriteId(position);
+    const TextureAtlas *atlas = itemType.getTextureAtlas(spriteId);
+
+    // Not known until the atlas is decompressed, unless the sprite opacities were loaded. Assuming that it does not
+    // cover the tile is always safe.
+    if (asyncAtlases && atlas->isCompressed() && !atlas->hasSpriteOpacity())
+        return false;
+
+    return atlas->coversTile(spriteId);
+}
+
+bool MapRenderer::fitsInTile(const Item &item, const Position position, DrawOffset offset) const
+{
+    if (offset.x != 0 || offset.y != 0 || item.itemType->hasFlag(AppearanceFlag::Shift))
+        return false;
+
+    const TextureAtlas *atlas = item.itemType->getTextureAtlas(item.getSpriteId(position));
+    return atlas->spriteWidth == MapTileSize && atlas->spriteHeight == MapTileSize;
+}
+
 void MapRenderer::issueDraw(const DrawInfo::Base &info, const WorldPosition &worldPos)
 {
+    DEBUG_ASSERT(info.texture, "A texture must be bound before the draw is issued.");
+
     const auto atlas = info.textureInfo.atlas;
     const auto &window = info.textureInfo.window;
     PushConstantData pushConstant{};
@@ -688,7 +993,16 @@ void MapRenderer::issueDraw(const DrawInfo::Base &info, const WorldPosition &wor
     pushConstant.textureQuad = glm::vec4(window.x0, window.y0, window.x1, window.y1);
     pushConstant.fragQuad = atlas->getFragmentBounds(window);
 
-    vulkanInfo.vkCmdBindDescriptorSets(
+    ++_frameStatistics.counters().spritesIssued;
+
+    if (drawList)
+    {
+        drawList->emplace_back(DrawCommand{info.texture, pushConstant.textureQuad, pushConstant.fragQuad, info.color, worldPos, info.width, info.height});
+        return;
+    }
+
+    ++_frameStatistics.counters().descriptorBinds;
+    vulkanInfo->vkCmdBindDescriptorSets(
         _currentFrame->commandBuffer,
         VK_PIPELINE_BIND_POINT_GRAPHICS,
         pipelineLayout,
@@ -698,22 +1012,25 @@ void MapRenderer::issueDraw(const DrawInfo::Base &info, const WorldPosition &wor
         0,
         nullptr);
 
-    vulkanInfo.vkCmdPushConstants(_currentFrame->commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstantData), &pushConstant);
-    vulkanInfo.vkCmdDrawIndexed(_currentFrame->commandBuffer, 6, 1, 0, 0, 0);
+    vulkanInfo->vkCmdPushConstants(_currentFrame->commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstantData), &pushConstant);
+    vulkanInfo->vkCmdDrawIndexed(_currentFrame->commandBuffer, 6, 1, 0, 0, 0);
 }
 
 void MapRenderer::issueRectangleDraw(DrawInfo::Rectangle &info)
 {
     PushConstantData pushConstant{};
 
+    const Texture *texture = nullptr;
     if (std::holds_alternative<const Texture *>(info.texture))
     {
+        texture = std::get<const Texture *>(info.texture);
         pushConstant.textureQuad = {0, 0, 1, 1};
         pushConstant.fragQuad = {0, 0, 1, 1};
     }
     else if (std::holds_alternative<TextureInfo>(info.texture))
     {
         const TextureInfo textureInfo = std::get<TextureInfo>(info.texture);
+        texture = &textureInfo.getTexture();
         pushConstant.textureQuad = textureInfo.window.asVec4();
         pushConstant.fragQuad = textureInfo.atlas->getFragmentBounds(textureInfo.window);
     }
@@ -746,7 +1063,16 @@ void MapRenderer::issueRectangleDraw(DrawInfo::Rectangle &info)
     pushConstant.size = size;
     pushConstant.color = info.color;
 
-    vulkanInfo.vkCmdBindDescriptorSets(
+    ++_frameStatistics.counters().spritesIssued;
+
+    if (drawList)
+    {
+        drawList->emplace_back(DrawCommand{texture, pushConstant.textureQuad, pushConstant.fragQuad, info.color, WorldPosition(x1, y1), static_cast<uint32_t>(size.x), static_cast<uint32_t>(size.y)});
+        return;
+    }
+
+    ++_frameStatistics.counters().descriptorBinds;
+    vulkanInfo->vkCmdBindDescriptorSets(
         _currentFrame->commandBuffer,
         VK_PIPELINE_BIND_POINT_GRAPHICS,
         pipelineLayout,
@@ -756,8 +1082,8 @@ void MapRenderer::issueRectangleDraw(DrawInfo::Rectangle &info)
         0,
         nullptr);
 
-    vulkanInfo.vkCmdPushConstants(_currentFrame->commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstantData), &pushConstant);
-    vulkanInfo.vkCmdDrawIndexed(_currentFrame->commandBuffer, 6, 1, 0, 0, 0);
+    vulkanInfo->vkCmdPushConstants(_currentFrame->commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstantData), &pushConstant);
+    vulkanInfo->vkCmdDrawIndexed(_currentFrame->commandBuffer, 6, 1, 0, 0, 0);
 }
 
 void MapRenderer::drawBrushPreview(Brush *brush, const Position &position, int variation)
@@ -838,11 +1164,9 @@ void MapRenderer::drawBrushPreviewAtWorldPos(Brush *brush, const WorldPosition &
                     DrawInfo::Creature info;
                     info.color = colors::ItemPreview;
                     info.textureInfo = draw.creatureType->getTextureInfo(0, draw.direction);
-                    auto texture = draw.creatureType->hasColorVariation()
-                                       ? info.textureInfo.getTexture(draw.creatureType->outfitId())
-                                       : info.textureInfo.getTexture();
+                    const auto &texture = info.textureInfo.getTexture();
 
-                    info.descriptorSet = objectDescriptorSet(texture);
+                    bindTexture(info, texture);
 
                     info.width = info.textureInfo.atlas->spriteWidth;
                     info.height = info.textureInfo.atlas->spriteHeight;
@@ -886,7 +1210,7 @@ void MapRenderer::drawOverlayItemType(uint32_t serverId, const WorldPosition pos
     info.position = position;
     info.color = color;
     info.textureInfo = itemType.getTextureInfo();
-    info.descriptorSet = objectDescriptorSet(info.textureInfo.atlas);
+    bindTexture(info, info.textureInfo.atlas);
 
     issueDraw(info, position);
 }
@@ -970,20 +1294,28 @@ void MapRenderer::drawRectangle(const Texture &texture, const WorldPosition from
 
 void MapRenderer::drawRectangle(const Texture &texture, const WorldPosition from, const WorldPosition to, float opacity)
 {
-    VulkanTexture::Descriptor descriptor;
-    descriptor.layout = textureDescriptorSetLayout;
-    descriptor.pool = descriptorPool;
-
-    auto &vulkanTexture = vulkanTextures[&texture];
-    if (!vulkanTexture.hasResources())
-        vulkanTexture.initResources(texture, vulkanInfo, descriptor);
-
     DrawInfo::Rectangle info;
     info.from = from;
     info.to = to;
     info.texture = &texture;
     info.color = colors::opacity(opacity);
-    info.descriptorSet = vulkanTexture.descriptorSet();
+
+    if (drawList)
+    {
+        info.descriptorSet = VK_NULL_HANDLE;
+    }
+    else
+    {
+        VulkanTexture::Descriptor descriptor;
+        descriptor.layout = textureDescriptorSetLayout;
+        descriptor.pool = descriptorPool;
+
+        auto &vulkanTexture = vulkanTextures[&texture];
+        if (!vulkanTexture.hasResources())
+            vulkanTexture.initResources(texture, *vulkanInfo, descriptor);
+
+        info.descriptorSet = vulkanTexture.descriptorSet();
+    }
 
     issueRectangleDraw(info);
 }
@@ -1048,7 +1380,7 @@ void MapRenderer::drawItemType(const ItemTypeDrawInfo &drawInfo, QuadrantRenderT
 
             info.color = drawInfo.color;
             info.textureInfo = itemType->getTextureInfo(drawInfo.spriteId);
-            info.descriptorSet = objectDescriptorSet(info.textureInfo.atlas);
+            bindTexture(info, info.textureInfo.atlas);
             info.width = info.textureInfo.atlas->spriteWidth;
             info.height = info.textureInfo.atlas->spriteHeight;
 
@@ -1063,7 +1395,7 @@ void MapRenderer::drawItemType(const ItemTypeDrawInfo &drawInfo, QuadrantRenderT
             info.textureInfo = itemType->getTextureInfoTopLeftQuadrant(drawInfo.spriteId);
             info.width = info.textureInfo.atlas->spriteWidth / 2;
             info.height = info.textureInfo.atlas->spriteHeight / 2;
-            info.descriptorSet = objectDescriptorSet(info.textureInfo.atlas);
+            bindTexture(info, info.textureInfo.atlas);
 
             auto worldPos = getWorldPosForDraw(drawInfo, info.textureInfo.atlas);
             issueDraw(info, worldPos);
@@ -1084,7 +1416,7 @@ void MapRenderer::drawItemType(const ItemTypeDrawInfo &drawInfo, QuadrantRenderT
             info.width = atlas->spriteWidth / 2;
             info.height = atlas->spriteHeight / 2;
 
-            info.descriptorSet = objectDescriptorSet(atlas);
+            bindTexture(info, atlas);
 
             auto worldPos = getWorldPosForDraw(drawInfo, atlas);
 
@@ -1108,7 +1440,7 @@ void MapRenderer::drawItemType(const ItemTypeDrawInfo &drawInfo, QuadrantRenderT
             info.textureInfo = bottomRightTextureInfo;
             info.width = atlas->spriteWidth / 2;
             info.height = atlas->spriteHeight / 2;
-            info.descriptorSet = objectDescriptorSet(atlas);
+            bindTexture(info, atlas);
 
             auto worldPos = getWorldPosForDraw(drawInfo, atlas);
 
@@ -1144,6 +1476,11 @@ void MapRenderer::drawItem(const ItemDrawInfo &itemDrawInfo)
     info.spriteId = itemDrawInfo.item->getSpriteId(itemDrawInfo.position);
     info.worldPosOffset = itemDrawInfo.worldPosOffset;
 
+    // Invisible sprites are skipped without binding (and decompressing) their atlas
+    const TextureAtlas *atlas = info.itemType->getTextureAtlas(info.spriteId);
+    if (atlas->hasSpriteOpacity() && atlas->spriteOpacity(info.spriteId).empty())
+        return;
+
     drawItemType(info);
 }
 
@@ -1153,7 +1490,7 @@ DrawInfo::Object MapRenderer::getItemDrawInfo(const Item &item, const Position &
     info.position = position;
     info.color = getItemDrawColor(item, position, drawFlags);
     info.textureInfo = item.getTextureInfo(position);
-    info.descriptorSet = objectDescriptorSet(info.textureInfo.atlas->getOrCreateTexture());
+    bindTexture(info, info.textureInfo.atlas);
     info.width = info.textureInfo.atlas->spriteWidth;
     info.height = info.textureInfo.atlas->spriteHeight;
 
@@ -1166,11 +1503,9 @@ DrawInfo::Creature MapRenderer::creatureDrawInfo(const Creature &creature, const
     info.color = getCreatureDrawColor(creature, position, drawFlags);
     info.textureInfo = creature.getTextureInfo();
 
-    auto texture = creature.creatureType.hasColorVariation()
-                       ? info.textureInfo.getTexture(creature.creatureType.outfitId())
-                       : info.textureInfo.getTexture();
+    const auto &texture = info.textureInfo.getTexture();
 
-    info.descriptorSet = objectDescriptorSet(texture);
+    bindTexture(info, texture);
 
     info.position = position;
     info.width = info.textureInfo.atlas->spriteWidth;
@@ -1185,13 +1520,61 @@ DrawInfo::Object MapRenderer::itemTypeDrawInfo(const ItemType &itemType, const P
     info.position = position;
     info.color = getItemTypeDrawColor(drawFlags);
     info.textureInfo = itemType.getTextureInfo(position);
-    info.descriptorSet = objectDescriptorSet(info.textureInfo.atlas->getOrCreateTexture());
+    bindTexture(info, info.textureInfo.atlas);
     info.width = info.textureInfo.atlas->spriteWidth;
     info.height = info.textureInfo.atlas->spriteHeight;
 
     return info;
 }
 
+void MapRenderer::bindTexture(DrawInfo::Base &info, TextureAtlas *atlas) const
+{
+    // A placeholder is drawn until the atlas has been decompressed in the background
+    if (asyncAtlases && atlas->isCompressed())
+    {
+        AtlasDecompressor::request(atlas);
+        bindTexture(info, Texture::getOrCreateSolidTexture(SolidColor::Placeholder));
+        return;
+    }
+
+    bindTexture(info, atlas->getOrCreateTexture());
+}
+
+void MapRenderer::bindTexture(DrawInfo::Base &info, const Texture &texture) const
+{
+    info.texture = &texture;
+
+    // Vulkan resources are not needed when recording a draw list
+    info.descriptorSet = drawList ? VK_NULL_HANDLE : objectDescriptorSet(texture);
+}
+
+void MapRenderer::textureAtlasEvicted(uint32_t textureId)
+{
+    if (textureId < vulkanTexturesForAppearances.size() && vulkanTexturesForAppearances[textureId].hasResources())
+    {
+        evictedTextureIds.emplace_back(textureId);
+    }
+}
+
+void MapRenderer::releaseEvictedTextures()
+{
+    auto end = std::remove_if(evictedTextureIds.begin(), evictedTextureIds.end(), [this](uint32_t id) {
+        VulkanTexture &vulkanTexture = vulkanTexturesForAppearances[id];
+        if (!vulkanTexture.hasResources())
+            return true;
+
+        // Frames that are still in flight may sample the texture. It can also have been drawn again since the eviction.
+        if (renderedFrames - vulkanTexture.lastUsedFrame <= frames.size())
+            return false;
+
+        vulkanTexture.releaseResources();
+        activeTextureAtlasIds.erase(std::find(activeTextureAtlasIds.begin(), activeTextureAtlasIds.end(), id));
+        return true;
+    });
+
+    evictedTextureIds.erase(end, evictedTextureIds.end());
+}
+
 VkDescriptorSet MapRenderer::objectDescriptorSet(TextureAtlas *atlas) const
 {
     return objectDescriptorSet(atlas->getOrCreateTexture());
@@ -1204,12 +1587,13 @@ VkDescriptorSet MapRenderer::objectDescriptorSet(const Texture &texture) const
     descriptor.pool = descriptorPool;
     uint32_t id = texture.id();
 
-    if (vulkanTexturesForAppearances.size() < id)
+    if (vulkanTexturesForAppearances.size() <= id)
     {
-        vulkanTexturesForAppearances.resize(vulkanTexturesForAppearances.size() * 1.25);
+        vulkanTexturesForAppearances.resize(std::max<size_t>(id + 1, vulkanTexturesForAppearances.size() * 1.25));
     }
 
     VulkanTexture &vulkanTexture = vulkanTexturesForAppearances.at(id);
+    vulkanTexture.lastUsedFrame = renderedFrames;
 
     if (!vulkanTexture.hasResources())
     {
@@ -1218,7 +1602,7 @@ VkDescriptorSet MapRenderer::objectDescriptorSet(const Texture &texture) const
             activeTextureAtlasIds.emplace_back(id);
         }
 
-        vulkanTexture.initResources(texture, vulkanInfo, descriptor);
+        vulkanTexture.initResources(texture, *vulkanInfo, descriptor);
     }
 
     return vulkanTexture.descriptorSet();
@@ -1226,7 +1610,7 @@ VkDescriptorSet MapRenderer::objectDescriptorSet(const Texture &texture) const
 
 void MapRenderer::updateUniformBuffer()
 {
-    glm::mat4 projection = vulkanInfo.projectionMatrix(mapView);
+    glm::mat4 projection = vulkanInfo->projectionMatrix(mapView);
     // const auto p = projection;
     // std::ostringstream s;
     // VME_LOG_D("Next:");
@@ -1242,9 +1626,9 @@ void MapRenderer::updateUniformBuffer()
     ItemUniformBufferObject uniformBufferObject{projection};
 
     void *data;
-    vulkanInfo.vkMapMemory(_currentFrame->uniformBuffer.deviceMemory, 0, sizeof(ItemUniformBufferObject), 0, &data);
+    vulkanInfo->vkMapMemory(_currentFrame->uniformBuffer.deviceMemory, 0, sizeof(ItemUniformBufferObject), 0, &data);
     memcpy(data, &uniformBufferObject, sizeof(ItemUniformBufferObject));
-    vulkanInfo.vkUnmapMemory(_currentFrame->uniformBuffer.deviceMemory);
+    vulkanInfo->vkUnmapMemory(_currentFrame->uniformBuffer.deviceMemory);
 }
 
 /**
@@ -1260,7 +1644,7 @@ void MapRenderer::updateUniformBuffer()
  **/
 void MapRenderer::beginRenderPass()
 {
-    util::Size size = vulkanInfo.vulkanSwapChainImageSize();
+    util::Size size = vulkanInfo->vulkanSwapChainImageSize();
     VkRenderPassBeginInfo renderPassInfo = {};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     renderPassInfo.renderPass = renderPass;
@@ -1278,7 +1662,7 @@ void MapRenderer::beginRenderPass()
     clearValue.color = ClearColor;
     renderPassInfo.pClearValues = &clearValue;
 
-    vulkanInfo.vkCmdBeginRenderPass(_currentFrame->commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    vulkanInfo->vkCmdBeginRenderPass(_currentFrame->commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 }
 
 void MapRenderer::createRenderPass()
@@ -1322,7 +1706,7 @@ void MapRenderer::createRenderPass()
     renderPassInfo.dependencyCount = 1;
     renderPassInfo.pDependencies = &dependency;
 
-    if (vulkanInfo.vkCreateRenderPass(&renderPassInfo, nullptr, &this->renderPass) != VK_SUCCESS)
+    if (vulkanInfo->vkCreateRenderPass(&renderPassInfo, nullptr, &this->renderPass) != VK_SUCCESS)
     {
         throw std::runtime_error("failed to create render pass!");
     }
@@ -1429,7 +1813,7 @@ void MapRenderer::createGraphicsPipeline()
     pipelineLayoutInfo.pushConstantRangeCount = 1;
     pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
 
-    if (vulkanInfo.vkCreatePipelineLayout(&pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+    if (vulkanInfo->vkCreatePipelineLayout(&pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
     {
         throw std::runtime_error("failed to create pipeline layout!");
     }
@@ -1450,14 +1834,14 @@ void MapRenderer::createGraphicsPipeline()
     pipelineInfo.subpass = 0;
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-    if (vulkanInfo.vkCreateGraphicsPipelines(VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) !=
+    if (vulkanInfo->vkCreateGraphicsPipelines(VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) !=
         VK_SUCCESS)
     {
         throw std::runtime_error("failed to create graphics pipeline!");
     }
 
-    vulkanInfo.vkDestroyShaderModule(fragShaderModule, nullptr);
-    vulkanInfo.vkDestroyShaderModule(vertShaderModule, nullptr);
+    vulkanInfo->vkDestroyShaderModule(fragShaderModule, nullptr);
+    vulkanInfo->vkDestroyShaderModule(vertShaderModule, nullptr);
 }
 
 void MapRenderer::createDescriptorSetLayouts()
@@ -1474,7 +1858,7 @@ void MapRenderer::createDescriptorSetLayouts()
 
     layoutInfo.pBindings = &uboLayoutBinding;
 
-    if (vulkanInfo.vkCreateDescriptorSetLayout(&layoutInfo, nullptr, &uboDescriptorSetLayout) != VK_SUCCESS)
+    if (vulkanInfo->vkCreateDescriptorSetLayout(&layoutInfo, nullptr, &uboDescriptorSetLayout) != VK_SUCCESS)
     {
         throw std::runtime_error("Failed to create descriptor set layout for the uniform buffer object.");
     }
@@ -1488,7 +1872,7 @@ void MapRenderer::createDescriptorSetLayouts()
 
     layoutInfo.pBindings = &textureLayoutBinding;
 
-    if (vulkanInfo.vkCreateDescriptorSetLayout(&layoutInfo, nullptr, &textureDescriptorSetLayout) != VK_SUCCESS)
+    if (vulkanInfo->vkCreateDescriptorSetLayout(&layoutInfo, nullptr, &textureDescriptorSetLayout) != VK_SUCCESS)
     {
         throw std::runtime_error("Failed to create descriptor set layout for the textures.");
     }
@@ -1499,12 +1883,12 @@ void MapRenderer::createUniformBuffers()
     VkDeviceSize bufferSize = sizeof(ItemUniformBufferObject);
 
     Buffer::CreateInfo info;
-    info.vulkanInfo = &vulkanInfo;
+    info.vulkanInfo = vulkanInfo;
     info.size = bufferSize;
     info.usageFlags = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
     info.memoryFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
-    for (size_t i = 0; i < vulkanInfo.maxConcurrentFrameCount(); i++)
+    for (size_t i = 0; i < vulkanInfo->maxConcurrentFrameCount(); i++)
     {
         frames[i].uniformBuffer = Buffer::create(info);
     }
@@ -1513,7 +1897,7 @@ void MapRenderer::createUniformBuffers()
 void MapRenderer::createDescriptorPool()
 {
     std::array<VkDescriptorPoolSize, 2> poolSizes{};
-    uint32_t descriptorCount = vulkanInfo.maxConcurrentFrameCount() * 2;
+    uint32_t descriptorCount = vulkanInfo->maxConcurrentFrameCount() * 2;
 
     poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
     poolSizes[0].descriptorCount = descriptorCount;
@@ -1523,11 +1907,13 @@ void MapRenderer::createDescriptorPool()
 
     VkDescriptorPoolCreateInfo poolInfo{};
     poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    // Texture descriptor sets are freed when their texture atlas is evicted
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
     poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
     poolInfo.pPoolSizes = poolSizes.data();
     poolInfo.maxSets = descriptorCount + MAX_NUM_TEXTURES;
 
-    if (vulkanInfo.vkCreateDescriptorPool(&poolInfo, nullptr, &this->descriptorPool) != VK_SUCCESS)
+    if (vulkanInfo->vkCreateDescriptorPool(&poolInfo, nullptr, &this->descriptorPool) != VK_SUCCESS)
     {
         throw std::runtime_error("failed to create descriptor pool!");
     }
@@ -1545,7 +1931,7 @@ void MapRenderer::createDescriptorSets()
 
     std::array<VkDescriptorSet, maxFrames> descriptorSets;
 
-    if (vulkanInfo.vkAllocateDescriptorSets(&allocInfo, &descriptorSets[0]) != VK_SUCCESS)
+    if (vulkanInfo->vkAllocateDescriptorSets(&allocInfo, &descriptorSets[0]) != VK_SUCCESS)
     {
         ABORT_PROGRAM("failed to allocate descriptor sets");
     }
@@ -1555,7 +1941,7 @@ void MapRenderer::createDescriptorSets()
         frames[i].uboDescriptorSet = descriptorSets[i];
     }
 
-    for (size_t i = 0; i < vulkanInfo.maxConcurrentFrameCount(); ++i)
+    for (size_t i = 0; i < vulkanInfo->maxConcurrentFrameCount(); ++i)
     {
         VkDescriptorBufferInfo bufferInfo = {};
         bufferInfo.buffer = frames[i].uniformBuffer.buffer;
@@ -1571,7 +1957,7 @@ void MapRenderer::createDescriptorSets()
         descriptorWrites.descriptorCount = 1;
         descriptorWrites.pBufferInfo = &bufferInfo;
 
-        vulkanInfo.vkUpdateDescriptorSets(1, &descriptorWrites, 0, nullptr);
+        vulkanInfo->vkUpdateDescriptorSets(1, &descriptorWrites, 0, nullptr);
     }
 }
 
@@ -1580,7 +1966,7 @@ void MapRenderer::createVertexBuffer()
     std::array<glm::ivec2, 4> vertices{{{0, 0}, {0, 1}, {1, 1}, {1, 0}}};
 
     Buffer::CreateInfo stagingInfo;
-    stagingInfo.vulkanInfo = &vulkanInfo;
+    stagingInfo.vulkanInfo = vulkanInfo;
     stagingInfo.size = VertexBufferSize;
     stagingInfo.usageFlags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
     stagingInfo.memoryFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
@@ -1588,31 +1974,31 @@ void MapRenderer::createVertexBuffer()
     BoundBuffer stagingBuffer = Buffer::create(stagingInfo);
 
     void *data;
-    vulkanInfo.vkMapMemory(stagingBuffer.deviceMemory, 0, VertexBufferSize, 0, &data);
+    vulkanInfo->vkMapMemory(stagingBuffer.deviceMemory, 0, VertexBufferSize, 0, &data);
     memcpy(data, &vertices, sizeof(vertices));
 
     Buffer::CreateInfo bufferInfo;
-    bufferInfo.vulkanInfo = &vulkanInfo;
+    bufferInfo.vulkanInfo = vulkanInfo;
     bufferInfo.size = VertexBufferSize;
     bufferInfo.usageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
     bufferInfo.memoryFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
     vertexBuffer = Buffer::create(bufferInfo);
 
-    VkCommandBuffer commandBuffer = vulkanInfo.beginSingleTimeCommands();
+    VkCommandBuffer commandBuffer = vulkanInfo->beginSingleTimeCommands();
     VkBufferCopy copyRegion = {};
     copyRegion.size = VertexBufferSize;
-    vulkanInfo.vkCmdCopyBuffer(commandBuffer, stagingBuffer.buffer, vertexBuffer.buffer, 1, &copyRegion);
-    vulkanInfo.endSingleTimeCommands(commandBuffer);
+    vulkanInfo->vkCmdCopyBuffer(commandBuffer, stagingBuffer.buffer, vertexBuffer.buffer, 1, &copyRegion);
+    vulkanInfo->endSingleTimeCommands(commandBuffer);
 
-    vulkanInfo.vkUnmapMemory(stagingBuffer.deviceMemory);
+    vulkanInfo->vkUnmapMemory(stagingBuffer.deviceMemory);
 }
 
 void MapRenderer::createIndexBuffer()
 {
     std::array<uint16_t, 6> indices{0, 1, 3, 3, 1, 2};
     Buffer::CreateInfo stagingInfo;
-    stagingInfo.vulkanInfo = &vulkanInfo;
+    stagingInfo.vulkanInfo = vulkanInfo;
     stagingInfo.size = IndexBufferSize;
     stagingInfo.usageFlags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
     stagingInfo.memoryFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
@@ -1620,24 +2006,24 @@ void MapRenderer::createIndexBuffer()
     BoundBuffer indexStagingBuffer = Buffer::create(stagingInfo);
 
     void *data;
-    vulkanInfo.vkMapMemory(indexStagingBuffer.deviceMemory, 0, IndexBufferSize, 0, &data);
+    vulkanInfo->vkMapMemory(indexStagingBuffer.deviceMemory, 0, IndexBufferSize, 0, &data);
     memcpy(data, &indices, sizeof(indices));
 
     Buffer::CreateInfo bufferInfo;
-    bufferInfo.vulkanInfo = &vulkanInfo;
+    bufferInfo.vulkanInfo = vulkanInfo;
     bufferInfo.size = IndexBufferSize;
     bufferInfo.usageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
     bufferInfo.memoryFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
     indexBuffer = Buffer::create(bufferInfo);
 
-    VkCommandBuffer commandBuffer = vulkanInfo.beginSingleTimeCommands();
+    VkCommandBuffer commandBuffer = vulkanInfo->beginSingleTimeCommands();
     VkBufferCopy copyRegion = {};
     copyRegion.size = IndexBufferSize;
-    vulkanInfo.vkCmdCopyBuffer(commandBuffer, indexStagingBuffer.buffer, indexBuffer.buffer, 1, &copyRegion);
-    vulkanInfo.endSingleTimeCommands(commandBuffer);
+    vulkanInfo->vkCmdCopyBuffer(commandBuffer, indexStagingBuffer.buffer, indexBuffer.buffer, 1, &copyRegion);
+    vulkanInfo->endSingleTimeCommands(commandBuffer);
 
-    vulkanInfo.vkUnmapMemory(indexStagingBuffer.deviceMemory);
+    vulkanInfo->vkUnmapMemory(indexStagingBuffer.deviceMemory);
 }
 
 VkShaderModule MapRenderer::createShaderModule(const std::vector<uint8_t> &code)
@@ -1648,7 +2034,7 @@ VkShaderModule MapRenderer::createShaderModule(const std::vector<uint8_t> &code)
     createInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
 
     VkShaderModule shaderModule;
-    if (vulkanInfo.vkCreateShaderModule(&createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+    if (vulkanInfo->vkCreateShaderModule(&createInfo, nullptr, &shaderModule) != VK_SUCCESS)
     {
         throw std::runtime_error("failed to create shader module!");
     }
@@ -1679,7 +2065,7 @@ VkCommandBuffer MapRenderer::beginSingleTimeCommands(VulkanInfo *info)
 uint32_t MapRenderer::findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties)
 {
     VkPhysicalDeviceMemoryProperties memProperties;
-    vulkanInfo.vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+    vulkanInfo->vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
 
     for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
     {
@@ -1755,12 +2141,18 @@ void VulkanTexture::releaseResources()
 {
     DEBUG_ASSERT(hasResources(), "Tried to release resources, but there are no resources in the Texture Resource.");
 
+    vulkanInfo->vkFreeDescriptorSets(descriptorPool, 1, &_descriptorSet);
+    vulkanInfo->vkDestroySampler(sampler, nullptr);
+    vulkanInfo->vkDestroyImageView(imageView, nullptr);
     vulkanInfo->vkDestroyImage(textureImage, nullptr);
     vulkanInfo->vkFreeMemory(textureImageMemory, nullptr);
 
     textureImage = VK_NULL_HANDLE;
     _descriptorSet = VK_NULL_HANDLE;
     textureImageMemory = VK_NULL_HANDLE;
+    imageView = VK_NULL_HANDLE;
+    sampler = VK_NULL_HANDLE;
+    descriptorPool = VK_NULL_HANDLE;
 
     vulkanInfo = nullptr;
 
@@ -1862,8 +2254,9 @@ VkSampler VulkanTexture::createSampler()
 
 VkDescriptorSet VulkanTexture::createDescriptorSet(VulkanTexture::Descriptor descriptor)
 {
-    VkImageView imageView = createImageView(textureImage, ColorFormat);
-    VkSampler sampler = createSampler();
+    imageView = createImageView(textureImage, ColorFormat);
+    sampler = createSampler();
+    descriptorPool = descriptor.pool;
 
     VkDescriptorSetAllocateInfo allocInfo = {};
     allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
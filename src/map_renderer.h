@@ -6,6 +6,7 @@
 #include <glm/vec4.hpp>
 
 #include <memory>
+#include <optional>
 #include <vector>
 
 #include <unordered_map>
@@ -13,14 +14,18 @@
 
 #include "brushes/brush.h"
 #include "editor_action.h"
+#include "frame_statistics.h"
 #include "graphics/buffer.h"
 #include "graphics/texture.h"
 #include "graphics/texture_atlas.h"
+#include "graphics/texture_atlas_cache.h"
 #include "graphics/vertex.h"
 #include "graphics/vulkan_helpers.h"
 #include "item.h"
+#include "item_animation.h"
 #include "items.h"
 #include "map.h"
+#include "signal.h"
 #include "time_util.h"
 #include "util.h"
 
@@ -71,6 +76,7 @@ namespace DrawInfo
     {
         TextureInfo textureInfo;
         glm::vec4 color = colors::Default;
+        const Texture *texture = nullptr;
         VkDescriptorSet descriptorSet;
         uint32_t width;
         uint32_t height;
@@ -123,6 +129,25 @@ namespace DrawInfo
 
 }; // namespace DrawInfo
 
+/*
+	A single textured quad as it would be sent to the vertex shader. Elevation, draw offsets and quadrant render
+	types are already resolved into the position, size and texture window.
+*/
+struct DrawCommand
+{
+    const Texture *texture;
+    glm::vec4 textureQuad;
+    glm::vec4 fragQuad;
+    glm::vec4 color;
+    WorldPosition position;
+
+    // Size in world pixels
+    uint32_t width;
+    uint32_t height;
+};
+
+using DrawList = std::vector<DrawCommand>;
+
 namespace ItemDrawFlags
 {
     constexpr uint32_t None = 0;
@@ -209,6 +234,9 @@ class VulkanTexture
 
     bool unused = true;
 
+    // MapRenderer frame in which the texture was last bound
+    uint64_t lastUsedFrame = 0;
+
     void initResources(const Texture &texture, VulkanInfo &vulkanInfo, const VulkanTexture::Descriptor descriptor);
     void releaseResources();
 
@@ -230,6 +258,9 @@ class VulkanTexture
     VkImage textureImage = VK_NULL_HANDLE;
     VkDeviceMemory textureImageMemory = VK_NULL_HANDLE;
     VkDescriptorSet _descriptorSet = VK_NULL_HANDLE;
+    VkImageView imageView = VK_NULL_HANDLE;
+    VkSampler sampler = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
 
     VkDescriptorSet createDescriptorSet(VulkanTexture::Descriptor descriptor);
     void copyStagingBufferToImage(VkBuffer stagingBuffer);
@@ -241,10 +272,15 @@ class VulkanTexture
     VkSampler createSampler();
 };
 
-class MapRenderer
+class MapRenderer : public Nano::Observer<>
 {
   public:
     MapRenderer(VulkanInfo &vulkanInfo, MapView *mapView);
+
+    /*
+		Creates a renderer without Vulkan resources. It can only be used with recordFrame.
+	*/
+    explicit MapRenderer(MapView *mapView);
     static const int MAX_NUM_TEXTURES = 256 * 256;
 
     static const int TILE_SIZE = 32;
@@ -257,6 +293,12 @@ class MapRenderer
 
     void startNextFrame();
 
+    /*
+		Draws the same frame as startNextFrame, but appends the draws to drawList instead of issuing Vulkan commands.
+		See SoftwareRenderer for rasterizing the result.
+	*/
+    void recordFrame(DrawList &drawList);
+
     VkDescriptorPool &getDescriptorPool()
     {
         return descriptorPool;
@@ -277,7 +319,21 @@ class MapRenderer
         return _currentFrame;
     }
 
-    bool _containsAnimation = false;
+    /*
+		Holds the earliest time that an animation drawn in the last frame changes phase.
+	*/
+    const AnimationScheduler &animationScheduler() const noexcept
+    {
+        return _animationScheduler;
+    }
+
+    /*
+		Timings and draw counters of the recent frames.
+	*/
+    const FrameStatistics &frameStatistics() const noexcept
+    {
+        return _frameStatistics;
+    }
 
   private:
     using ItemPredicate = std::function<bool(const Position, const Item &item)>;
@@ -322,6 +378,7 @@ class MapRenderer
     VkCommandBuffer beginSingleTimeCommands(VulkanInfo *info);
     uint32_t findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties);
 
+    void drawFrame();
     void drawMap();
     void drawCurrentAction();
     void drawPreviewItem(uint32_t serverId, Position pos);
@@ -341,6 +398,9 @@ class MapRenderer
     glm::vec4 getCreatureDrawColor(const Creature &creature, const Position &position, uint32_t drawFlags) const;
     glm::vec4 getItemTypeDrawColor(uint32_t drawFlags);
 
+    void bindTexture(DrawInfo::Base &info, const Texture &texture) const;
+    void bindTexture(DrawInfo::Base &info, TextureAtlas *atlas) const;
+
     VkDescriptorSet objectDescriptorSet(const Texture &texture) const;
     VkDescriptorSet objectDescriptorSet(TextureAtlas *atlas) const;
 
@@ -367,8 +427,31 @@ class MapRenderer
     void drawCreature(const DrawInfo::Creature &info);
     void drawCreatureType(const CreatureType &creatureType, const Position position, Direction direction, glm::vec4 color, const DrawOffset &drawOffset = DrawOffset{0, 0});
 
+    void animate(const Item &item);
+
+    /*
+		Queues decompression of the atlases just outside the viewport, on the side that the camera is panning
+		towards, so that they are ready when they scroll into view.
+	*/
+    void prefetchAtlases();
+
+    void textureAtlasEvicted(uint32_t textureId);
+
+    /*
+		Releases the GPU resources of evicted texture atlases once no frame in flight can use them.
+	*/
+    void releaseEvictedTextures();
+
     bool shouldDrawItem(const Position pos, const Item &item, uint32_t flags, const ItemPredicate &filter = {}) const noexcept;
 
+    void beginOcclusionCulling(const MapRegion &region, uint32_t flags, bool hasFilter);
+    bool isTileOccluded(const Tile &tile);
+    bool isCovered(int x, int y, int z);
+    uint16_t computeChunkCoverage(int chunkX, int chunkY, int z);
+    bool isOccluder(const Tile *tile) const;
+    bool coversTile(const Item &item, const Position position, DrawOffset offset) const;
+    bool fitsInTile(const Item &item, const Position position, DrawOffset offset) const;
+
     void drawBrushPreview(Brush *brush, const Position &position, int variation);
     void drawBrushPreviewAtWorldPos(Brush *brush, const WorldPosition &worldPos, int variation);
     void drawPreview(ThingDrawInfo drawInfo, const Position &position);
@@ -380,7 +463,9 @@ class MapRenderer
 
     bool debug = false;
     MapView *mapView;
-    VulkanInfo &vulkanInfo;
+
+    // nullptr if the renderer was created without Vulkan resources
+    VulkanInfo *vulkanInfo;
     std::array<FrameData, 3> frames;
 
     // All sprites are drawn using this index buffer
@@ -415,5 +500,45 @@ class MapRenderer
 
     VkDescriptorSet currentDescriptorSet;
 
+    // Set while recording a frame (see recordFrame)
+    DrawList *drawList = nullptr;
+
+    /*
+		Per-frame occlusion state for drawMap. A tile is covered if opaque ground on a floor above it hides the
+		entire tile square (floors above are drawn later). Coverage is computed once per 4x4 chunk and floor,
+		and is then reused by every tile in that chunk for the rest of the frame.
+	*/
+    struct OcclusionCulling
+    {
+        bool enabled = false;
+        int viewZ = 0;
+
+        // Bounds of the drawn region. Only tiles within it are drawn and can occlude.
+        int x1 = 0;
+        int y1 = 0;
+        int x2 = 0;
+        int y2 = 0;
+
+        uint32_t drawFlags = 0;
+
+        // Key: chunk x, y and z. Value: one bit per tile in the chunk (same layout as Floor).
+        vme_unordered_map<uint64_t, uint16_t> coveredTilesByChunk;
+    } occlusion;
+
     bool isDefaultZoom = true;
+
+    // Compressed atlases are decompressed in the background instead of stalling the frame (see AtlasDecompressor)
+    bool asyncAtlases = false;
+    std::optional<Position> lastCameraPosition;
+
+    bool animationsEnabled = false;
+    AnimationScheduler _animationScheduler;
+
+    FrameStatistics _frameStatistics;
+    TextureAtlasCache::RendererFrames atlasFrames;
+
+    uint64_t renderedFrames = 0;
+
+    // Texture ids of evicted atlases whose VulkanTexture is not released yet
+    std::vector<uint32_t> evictedTextureIds;
 };
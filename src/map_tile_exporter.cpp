@@ -0,0 +1,633 @@
+#include "map_tile_exporter.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#include <stb_image.h>
+
+#include "creature.h"
+#include "editor_action.h"
+#include "file.h"
+#include "graphics/appearances.h"
+#include "items.h"
+#include "logger.h"
+#include "map.h"
+#include "map_view.h"
+#include "thread_pool.h"
+#include "time_util.h"
+
+namespace
+{
+    constexpr int ManifestVersion = 2;
+    constexpr const char *ManifestFilename = "tiles-manifest.txt";
+
+    // Manifest hash of chunks written by a cancelled export. The tiles above them were not rebuilt, so the next export
+    // has to treat them as changed.
+    constexpr uint64_t StaleChunkHash = 0;
+
+    // Tiles this far outside a chunk can still be drawn inside it: lower floors are offset up to 8 tiles, and large
+    // sprites and elevation reach a few tiles up and to the left.
+    constexpr int ChunkMarginTiles = 10;
+
+    // Opaque black is the clear color of the renderer
+    constexpr uint32_t BlankPixel = 0xFF000000;
+
+    int bottomFloor(int floor)
+    {
+        return floor <= GROUND_FLOOR ? GROUND_FLOOR : MAP_LAYERS - 1;
+    }
+} // namespace
+
+MapTileExporter::MapTileExporter(std::shared_ptr<Map> map, Options options)
+    : map(map), options(options), softwareRenderer(options.threadCount)
+{
+    int extent = std::max(map->width(), map->height()) * MapTileSize;
+    while ((TileSize << _maxZoom) < extent)
+    {
+        ++_maxZoom;
+    }
+
+    int chunkLevels = std::clamp(options.chunkLevels, 0, _maxZoom);
+    chunkZoom = _maxZoom - chunkLevels;
+    chunkSize = TileSize << chunkLevels;
+
+    if (this->options.floors.empty())
+    {
+        for (int floor = 0; floor < MAP_LAYERS; ++floor)
+        {
+            this->options.floors.emplace_back(floor);
+        }
+    }
+}
+
+MapTileExporter::~MapTileExporter() = default;
+
+int MapTileExporter::maxZoom() const noexcept
+{
+    return _maxZoom;
+}
+
+MapTileExporter::Result MapTileExporter::exportTiles()
+{
+    TimePoint start;
+    result = {};
+
+    std::filesystem::create_directories(options.outputDirectory);
+    loadManifest();
+
+    // Bound the number of tiles waiting to be encoded
+    uint32_t threadCount = options.threadCount != 0 ? options.threadCount : std::max(1u, std::thread::hardware_concurrency());
+    writers = std::make_unique<ThreadPool>(threadCount, threadCount * 4);
+
+    editorAction = std::make_unique<EditorAction>();
+    mapView = std::make_unique<MapView>(nullptr, *editorAction, map);
+    mapRenderer = std::make_unique<MapRenderer>(mapView.get());
+
+    uint32_t chunksPerFloor = 1u << (2 * chunkZoom);
+    doneChunks = 0;
+    totalChunks = chunksPerFloor * static_cast<uint32_t>(options.floors.size());
+
+    for (int floor : options.floors)
+    {
+        exportNode(floor, 0, 0, 0);
+        if (result.cancelled)
+        {
+            break;
+        }
+    }
+
+    writers->waitIdle();
+    writers.reset();
+
+    mapRenderer.reset();
+    mapView.reset();
+    editorAction.reset();
+
+    saveManifest();
+
+    if (result.cancelled)
+    {
+        VME_LOG("Cancelled the map tile export to " << options.outputDirectory.string() << " after " << doneChunks << " of " << totalChunks << " chunks.");
+        return result;
+    }
+
+    VME_LOG("Exported map tiles to " << options.outputDirectory.string() << " in " << start.elapsedMillis() << " ms ("
+                                     << result.renderedChunks << " chunks rendered, "
+                                     << result.unchangedChunks << " unchanged, "
+                                     << result.emptyChunks << " empty; "
+                                     << result.writtenTiles << " tiles written, "
+                                     << result.removedTiles << " removed).");
+
+    return result;
+}
+
+MapTileExporter::NodeResult MapTileExporter::exportNode(int floor, int zoom, int x, int y)
+{
+    if (zoom == chunkZoom)
+    {
+        NodeResult chunk = exportChunk(floor, x, y);
+        if (chunk.changed)
+        {
+            changedChunks.emplace(chunkKey(floor, x, y));
+        }
+
+        advanceProgress(1);
+        return chunk;
+    }
+
+    // Skip the whole subtree if it has no tiles now and had none in the last export
+    int span = 1 << (chunkZoom - zoom);
+    Position from = chunkTileArea(floor, x * span, y * span).first;
+    Position to = chunkTileArea(floor, (x + 1) * span - 1, (y + 1) * span - 1).second;
+
+    bool existedBefore = previousNodes.contains(nodeKey(floor, zoom, x, y));
+    if (!existedBefore && !map->hasTiles(from, to))
+    {
+        advanceProgress(span * span);
+        return {};
+    }
+
+    std::array<NodeResult, 4> children;
+    bool changed = false;
+    bool empty = true;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        children[i] = exportNode(floor, zoom + 1, 2 * x + (i & 1), 2 * y + (i >> 1));
+        if (result.cancelled)
+        {
+            return {};
+        }
+
+        changed |= children[i].changed;
+        empty &= children[i].empty;
+    }
+
+    if (!changed)
+    {
+        return NodeResult{empty, false, std::nullopt};
+    }
+
+    if (empty)
+    {
+        if (existedBefore)
+        {
+            removeTile(floor, zoom, x, y);
+        }
+        return NodeResult{true, true, std::nullopt};
+    }
+
+    Image image(TileSize, TileSize);
+    for (int i = 0; i < 4; ++i)
+    {
+        const NodeResult &child = children[i];
+        if (child.empty)
+        {
+            continue;
+        }
+
+        int offsetX = (i & 1) * TileSize / 2;
+        int offsetY = (i >> 1) * TileSize / 2;
+
+        if (child.image)
+        {
+            drawHalfSize(image, *child.image, offsetX, offsetY);
+        }
+        else
+        {
+            // Unchanged since the last export; its tile is already on disk (unless it was blank)
+            auto previous = readTile(floor, zoom + 1, 2 * x + (i & 1), 2 * y + (i >> 1));
+            if (previous)
+            {
+                drawHalfSize(image, *previous, offsetX, offsetY);
+            }
+        }
+    }
+
+    if (isBlank(image))
+    {
+        if (existedBefore)
+        {
+            removeTile(floor, zoom, x, y);
+        }
+    }
+    else
+    {
+        writeTile(floor, zoom, x, y, Image(image));
+    }
+
+    return NodeResult{false, true, std::move(image)};
+}
+
+MapTileExporter::NodeResult MapTileExporter::exportChunk(int floor, int x, int y)
+{
+    uint64_t key = chunkKey(floor, x, y);
+    auto previous = previousChunks.find(key);
+    bool existedBefore = previous != previousChunks.end();
+
+    const auto [from, to] = chunkTileArea(floor, x, y);
+    if (!map->hasTiles(from, to))
+    {
+        ++result.emptyChunks;
+        if (existedBefore)
+        {
+            removeChunkTiles(floor, x, y);
+            return NodeResult{true, true, std::nullopt};
+        }
+
+        return {};
+    }
+
+    uint64_t hash = chunkHash(floor, from, to);
+    chunks.emplace(key, hash);
+
+    if (!options.force && existedBefore && previous->second == hash)
+    {
+        ++result.unchangedChunks;
+        return NodeResult{false, false, std::nullopt};
+    }
+
+    ++result.renderedChunks;
+
+    Image image = renderChunk(floor, x, y);
+
+    // Write the zoom levels inside the chunk, halving the image until it is a single tile
+    for (int zoom = _maxZoom; zoom > chunkZoom; --zoom)
+    {
+        int shift = zoom - chunkZoom;
+        writeRegion(floor, zoom, x << shift, y << shift, image, existedBefore);
+        image = downsample(image);
+    }
+
+    if (isBlank(image))
+    {
+        if (existedBefore)
+        {
+            removeTile(floor, chunkZoom, x, y);
+        }
+    }
+    else
+    {
+        writeTile(floor, chunkZoom, x, y, Image(image));
+    }
+
+    return NodeResult{false, true, std::move(image)};
+}
+
+std::pair<Position, Position> MapTileExporter::chunkTileArea(int floor, int x, int y) const
+{
+    int chunkTiles = chunkSize / MapTileSize;
+
+    Position from(x * chunkTiles - ChunkMarginTiles, y * chunkTiles - ChunkMarginTiles, floor);
+    Position to((x + 1) * chunkTiles - 1 + ChunkMarginTiles, (y + 1) * chunkTiles - 1 + ChunkMarginTiles, bottomFloor(floor));
+
+    from.x = std::max(from.x, 0);
+    from.y = std::max(from.y, 0);
+
+    return {from, to};
+}
+
+SoftwareRenderer::Image MapTileExporter::renderChunk(int floor, int x, int y)
+{
+    // Offset by the floor so that map positions line up across floors
+    int floorOffset = (floor - GROUND_FLOOR) * MapTileSize;
+
+    Camera::Viewport viewport{
+        x * chunkSize + floorOffset,
+        y * chunkSize + floorOffset,
+        floor,
+        chunkSize,
+        chunkSize,
+        1.0f};
+
+    // Record a larger area so that tiles outside the chunk that draw into it are included
+    int margin = ChunkMarginTiles * MapTileSize;
+    mapView->setFloor(floor);
+    mapView->setX(viewport.x - margin);
+    mapView->setY(viewport.y - margin);
+    mapView->setViewportSize(chunkSize + 2 * margin, chunkSize + 2 * margin);
+
+    DrawList drawList;
+    mapRenderer->recordFrame(drawList);
+
+    return softwareRenderer.render(drawList, viewport);
+}
+
+uint64_t MapTileExporter::chunkHash(int floor, const Position &from, const Position &to) const
+{
+    File::Fnv1a hash;
+    hash.add(floor);
+
+    auto hashItem = [&hash](const Item &item) {
+        hash.add(item.serverId());
+        hash.add(item.subtype());
+    };
+
+    for (auto &location : map->getRegion(from, to))
+    {
+        const Tile *tile = location.tile();
+        if (!tile)
+        {
+            continue;
+        }
+
+        const Position &position = location.position();
+        hash.add(position.x);
+        hash.add(position.y);
+        hash.add(position.z);
+
+        if (tile->ground())
+        {
+            hashItem(*tile->ground());
+        }
+
+        for (const auto &item : tile->items())
+        {
+            hashItem(*item);
+        }
+
+        if (tile->creature())
+        {
+            hash.add(tile->creature()->creatureType.id());
+            hash.add(static_cast<int>(tile->creature()->direction()));
+        }
+    }
+
+    return hash.value();
+}
+
+uint64_t MapTileExporter::clientDataHash()
+{
+    // The catalog covers appearances and sprites; items.otb maps server IDs to them
+    const OTB::VersionInfo &otb = Items::items.otbVersionInfo();
+
+    File::Fnv1a hash;
+    hash.add(Appearances::catalogHash());
+    hash.add(otb.majorVersion);
+    hash.add(otb.minorVersion);
+    hash.add(otb.buildNumber);
+
+    return hash.value();
+}
+
+void MapTileExporter::writeRegion(int floor, int zoom, int x, int y, const Image &image, bool removeBlankTiles)
+{
+    int tiles = image.width / TileSize;
+    for (int tileY = 0; tileY < tiles; ++tileY)
+    {
+        for (int tileX = 0; tileX < tiles; ++tileX)
+        {
+            Image tile = crop(image, tileX * TileSize, tileY * TileSize, TileSize);
+            if (isBlank(tile))
+            {
+                if (removeBlankTiles)
+                {
+                    removeTile(floor, zoom, x + tileX, y + tileY);
+                }
+            }
+            else
+            {
+                writeTile(floor, zoom, x + tileX, y + tileY, std::move(tile));
+            }
+        }
+    }
+}
+
+void MapTileExporter::writeTile(int floor, int zoom, int x, int y, Image &&image)
+{
+    auto path = tilePath(floor, zoom, x, y);
+
+    // Directories are created here, on a single thread
+    std::filesystem::create_directories(path.parent_path());
+
+    writers->submit([path, image = std::move(image)]() {
+        if (!image.savePng(path))
+        {
+            VME_LOG_ERROR("Could not write map tile " << path.string());
+        }
+    });
+
+    ++result.writtenTiles;
+}
+
+void MapTileExporter::removeTile(int floor, int zoom, int x, int y)
+{
+    std::error_code error;
+    if (std::filesystem::remove(tilePath(floor, zoom, x, y), error))
+    {
+        ++result.removedTiles;
+    }
+}
+
+void MapTileExporter::removeChunkTiles(int floor, int x, int y)
+{
+    for (int zoom = chunkZoom; zoom <= _maxZoom; ++zoom)
+    {
+        int shift = zoom - chunkZoom;
+        int tiles = 1 << shift;
+        for (int tileY = 0; tileY < tiles; ++tileY)
+        {
+            for (int tileX = 0; tileX < tiles; ++tileX)
+            {
+                removeTile(floor, zoom, (x << shift) + tileX, (y << shift) + tileY);
+            }
+        }
+    }
+}
+
+std::optional<SoftwareRenderer::Image> MapTileExporter::readTile(int floor, int zoom, int x, int y) const
+{
+    auto path = tilePath(floor, zoom, x, y);
+    if (!std::filesystem::exists(path))
+    {
+        return std::nullopt;
+    }
+
+    int width, height, channels;
+    stbi_uc *pixels = stbi_load(path.string().c_str(), &width, &height, &channels, STBI_rgb_alpha);
+    if (!pixels)
+    {
+        VME_LOG_ERROR("Could not read map tile " << path.string());
+        return std::nullopt;
+    }
+
+    std::optional<Image> image;
+    if (width == TileSize && height == TileSize)
+    {
+        image.emplace(TileSize, TileSize);
+        std::memcpy(image->pixels.data(), pixels, image->pixels.size());
+    }
+
+    stbi_image_free(pixels);
+    return image;
+}
+
+std::filesystem::path MapTileExporter::tilePath(int floor, int zoom, int x, int y) const
+{
+    return options.outputDirectory / std::to_string(floor) / std::to_string(zoom) / std::to_string(x) / (std::to_string(y) + ".png");
+}
+
+SoftwareRenderer::Image MapTileExporter::downsample(const Image &image)
+{
+    Image result(image.width / 2, image.height / 2);
+    for (uint32_t y = 0; y < result.height; ++y)
+    {
+        const uint8_t *top = image.pixels.data() + 4 * static_cast<size_t>(2 * y) * image.width;
+        const uint8_t *bottom = top + 4 * static_cast<size_t>(image.width);
+        uint8_t *dst = result.pixels.data() + 4 * static_cast<size_t>(y) * result.width;
+
+        for (uint32_t x = 0; x < result.width; ++x, top += 8, bottom += 8, dst += 4)
+        {
+            for (int channel = 0; channel < 4; ++channel)
+            {
+                dst[channel] = static_cast<uint8_t>((top[channel] + top[channel + 4] + bottom[channel] + bottom[channel + 4] + 2) / 4);
+            }
+        }
+    }
+
+    return result;
+}
+
+void MapTileExporter::drawHalfSize(Image &target, const Image &source, int offsetX, int offsetY)
+{
+    Image half = downsample(source);
+    for (uint32_t y = 0; y < half.height; ++y)
+    {
+        std::memcpy(target.pixels.data() + 4 * ((static_cast<size_t>(offsetY) + y) * target.width + offsetX),
+                    half.pixels.data() + 4 * static_cast<size_t>(y) * half.width,
+                    4 * static_cast<size_t>(half.width));
+    }
+}
+
+SoftwareRenderer::Image MapTileExporter::crop(const Image &image, int x, int y, int size)
+{
+    Image result(size, size);
+    for (int row = 0; row < size; ++row)
+    {
+        std::memcpy(result.pixels.data() + 4 * static_cast<size_t>(row) * size,
+                    image.pixels.data() + 4 * ((static_cast<size_t>(y) + row) * image.width + x),
+                    4 * static_cast<size_t>(size));
+    }
+
+    return result;
+}
+
+bool MapTileExporter::isBlank(const Image &image)
+{
+    for (size_t i = 0; i < image.pixels.size(); i += 4)
+    {
+        uint32_t pixel;
+        std::memcpy(&pixel, image.pixels.data() + i, sizeof(uint32_t));
+        if (pixel != BlankPixel)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+uint64_t MapTileExporter::chunkKey(int floor, int x, int y)
+{
+    return nodeKey(floor, -1, x, y);
+}
+
+uint64_t MapTileExporter::nodeKey(int floor, int zoom, int x, int y)
+{
+    // x and y are below 2^24 since maps are at most 65536 tiles wide
+    return (static_cast<uint64_t>(floor & 0xF) << 60) |
+           (static_cast<uint64_t>(zoom & 0xFF) << 48) |
+           (static_cast<uint64_t>(x & 0xFFFFFF) << 24) |
+           static_cast<uint64_t>(y & 0xFFFFFF);
+}
+
+void MapTileExporter::advanceProgress(uint32_t chunkCount)
+{
+    doneChunks += chunkCount;
+    if (options.progress && !options.progress(doneChunks, totalChunks))
+    {
+        result.cancelled = true;
+    }
+}
+
+void MapTileExporter::loadManifest()
+{
+    previousChunks.clear();
+    previousNodes.clear();
+    chunks.clear();
+    changedChunks.clear();
+
+    std::ifstream file(options.outputDirectory / ManifestFilename);
+    if (!file)
+    {
+        return;
+    }
+
+    std::string magic;
+    int version, maxZoom, chunkZoom;
+    uint64_t dataHash;
+    file >> magic >> version >> maxZoom >> chunkZoom >> dataHash;
+    if (magic != "vme-map-tiles" || version != ManifestVersion || maxZoom != _maxZoom || chunkZoom != this->chunkZoom)
+    {
+        VME_LOG("The tile manifest in " << options.outputDirectory.string() << " is from a different export layout. Every chunk is rendered again.");
+        return;
+    }
+
+    if (dataHash != clientDataHash())
+    {
+        VME_LOG("The tiles in " << options.outputDirectory.string() << " were drawn with other client data. Every chunk is rendered again.");
+        return;
+    }
+
+    int floor, x, y;
+    uint64_t hash;
+    while (file >> floor >> x >> y >> hash)
+    {
+        previousChunks.emplace(chunkKey(floor, x, y), hash);
+
+        for (int zoom = chunkZoom - 1; zoom >= 0; --zoom)
+        {
+            int shift = chunkZoom - zoom;
+            previousNodes.emplace(nodeKey(floor, zoom, x >> shift, y >> shift));
+        }
+    }
+}
+
+void MapTileExporter::saveManifest() const
+{
+    auto path = options.outputDirectory / ManifestFilename;
+    const vme_unordered_map<uint64_t, uint64_t> *entries = &chunks;
+
+    // Chunks that were not visited by a cancelled export keep their previous state
+    vme_unordered_map<uint64_t, uint64_t> cancelledEntries;
+    if (result.cancelled)
+    {
+        cancelledEntries = previousChunks;
+        for (uint64_t key : changedChunks)
+        {
+            cancelledEntries[key] = StaleChunkHash;
+        }
+        entries = &cancelledEntries;
+    }
+
+    auto error = File::writeAtomically(path, [this, entries](std::ostream &file) {
+        file << "vme-map-tiles " << ManifestVersion << ' ' << _maxZoom << ' ' << chunkZoom << ' ' << clientDataHash() << '\n';
+
+        for (const auto &[key, hash] : *entries)
+        {
+            int floor = static_cast<int>(key >> 60);
+            int x = static_cast<int>((key >> 24) & 0xFFFFFF);
+            int y = static_cast<int>(key & 0xFFFFFF);
+            file << floor << ' ' << x << ' ' << y << ' ' << hash << '\n';
+        }
+    });
+
+    // Without a manifest, the next export renders every chunk again
+    if (error)
+    {
+        VME_LOG_ERROR("Could not write the tile manifest " << path.string() << ": " << error.message());
+    }
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "software_renderer.h"
+#include "util.h"
+
+class EditorAction;
+class Map;
+class MapView;
+class ThreadPool;
+
+/*
+	Exports the floors of a map as a pyramid of 256x256 PNG tiles in the slippy-map layout:
+
+		<outputDirectory>/<floor>/<zoom>/<x>/<y>.png
+
+	Zoom level maxZoom() shows the map at its original size (one map tile is 32x32 pixels); every lower level halves
+	the resolution. Tiles of different floors are aligned by map position, i.e. map tile (x, y) is at the same pixel
+	on every floor.
+
+	The map is rendered in square chunks of (1 << chunkLevels) tiles at the highest zoom level. Chunks are visited
+	in quadtree order, so each parent tile is built as soon as its four children are done and only a few tiles per
+	level are kept in memory. Chunks without map tiles are skipped using the map quadtree. Rendering is done by the
+	SoftwareRenderer and PNG encoding runs on a thread pool.
+
+	Content hashes of the rendered chunks are stored in the output directory, together with a hash of the client
+	data they were drawn with. A later export with the same client data only renders chunks whose hash changed and
+	rebuilds the lower zoom levels above them.
+*/
+class MapTileExporter
+{
+  public:
+    static constexpr int TileSize = 256;
+
+    struct Options
+    {
+        std::filesystem::path outputDirectory;
+
+        // 0 uses one thread per hardware thread
+        uint32_t threadCount = 0;
+
+        // A chunk spans (1 << chunkLevels) x (1 << chunkLevels) tiles at the highest zoom level
+        int chunkLevels = 3;
+
+        // Floors to export. Empty exports all floors.
+        std::vector<int> floors;
+
+        // Re-render every chunk, even if its content did not change since the last export
+        bool force = false;
+
+        /*
+			Called on the exporting thread after every chunk with the number of chunks done and in total. Returning
+			false cancels the export. Tiles written before the cancellation are kept, and their chunks are exported
+			again by the next export.
+		*/
+        std::function<bool(uint32_t done, uint32_t total)> progress;
+    };
+
+    struct Result
+    {
+        uint32_t renderedChunks = 0;
+        uint32_t unchangedChunks = 0;
+        uint32_t emptyChunks = 0;
+
+        uint32_t writtenTiles = 0;
+        uint32_t removedTiles = 0;
+
+        bool cancelled = false;
+    };
+
+    MapTileExporter(std::shared_ptr<Map> map, Options options);
+    ~MapTileExporter();
+
+    Result exportTiles();
+
+    int maxZoom() const noexcept;
+
+  private:
+    using Image = SoftwareRenderer::Image;
+
+    struct NodeResult
+    {
+        bool empty = true;
+        bool changed = false;
+
+        // Only set for changed, non-empty nodes
+        std::optional<Image> image;
+    };
+
+    NodeResult exportNode(int floor, int zoom, int x, int y);
+    NodeResult exportChunk(int floor, int x, int y);
+
+    Image renderChunk(int floor, int x, int y);
+    uint64_t chunkHash(int floor, const Position &from, const Position &to) const;
+    static uint64_t clientDataHash();
+    std::pair<Position, Position> chunkTileArea(int floor, int x, int y) const;
+
+    void writeTile(int floor, int zoom, int x, int y, Image &&image);
+    void removeTile(int floor, int zoom, int x, int y);
+    void removeChunkTiles(int floor, int x, int y);
+    std::optional<Image> readTile(int floor, int zoom, int x, int y) const;
+    std::filesystem::path tilePath(int floor, int zoom, int x, int y) const;
+
+    void writeRegion(int floor, int zoom, int x, int y, const Image &image, bool removeBlankTiles);
+    static Image downsample(const Image &image);
+    static Image crop(const Image &image, int x, int y, int size);
+    static void drawHalfSize(Image &target, const Image &source, int offsetX, int offsetY);
+    static bool isBlank(const Image &image);
+
+    void advanceProgress(uint32_t chunkCount);
+
+    void loadManifest();
+    void saveManifest() const;
+
+    static uint64_t chunkKey(int floor, int x, int y);
+    static uint64_t nodeKey(int floor, int zoom, int x, int y);
+
+    std::shared_ptr<Map> map;
+    Options options;
+
+    int _maxZoom = 0;
+    int chunkZoom = 0;
+    int chunkSize = TileSize;
+
+    std::unique_ptr<EditorAction> editorAction;
+    std::unique_ptr<MapView> mapView;
+    std::unique_ptr<MapRenderer> mapRenderer;
+    std::unique_ptr<ThreadPool> writers;
+    SoftwareRenderer softwareRenderer;
+
+    // Content hash of every non-empty chunk from the previous export
+    vme_unordered_map<uint64_t, uint64_t> previousChunks;
+    // Every node that had a non-empty chunk below it in the previous export
+    vme_unordered_set<uint64_t> previousNodes;
+
+    vme_unordered_map<uint64_t, uint64_t> chunks;
+    // Chunks whose tiles were written or removed by this export
+    vme_unordered_set<uint64_t> changedChunks;
+
+    uint32_t doneChunks = 0;
+    uint32_t totalChunks = 0;
+
+    Result result;
+};
@@ -13,6 +13,7 @@
 #include "items.h"
 #include "settings.h"
 #include "time_util.h"
+#include "trace.h"
 
 using namespace MapHistory;
 
@@ -79,8 +80,6 @@ void MapView::undo()
     bool changed = history.undo();
     if (changed)
     {
-        requestDraw();
-        requestMinimapDraw();
         undoRedoPerformed.fire();
     }
 }
@@ -90,8 +89,6 @@ void MapView::redo()
     bool changed = history.redo();
     if (changed)
     {
-        requestDraw();
-        requestMinimapDraw();
         undoRedoPerformed.fire();
     }
 }
@@ -576,8 +573,6 @@ void MapView::deleteSelectedItems()
     _selection.clear();
 
     history.endTransaction(TransactionType::RemoveMapItem);
-    requestDraw();
-    requestMinimapDraw();
 }
 
 void MapView::borderize(const Position &position)
@@ -625,6 +620,24 @@ void MapView::removeItemsInRegion(const Position &from, const Position &to, std:
     history.endTransaction(TransactionType::RemoveMapItem);
 }
 
+void MapView::replaceTiles(std::vector<Tile> &&tiles)
+{
+    if (tiles.empty())
+    {
+        return;
+    }
+
+    Action action(ActionType::SetTile);
+    action.reserve(tiles.size());
+
+    for (Tile &tile : tiles)
+    {
+        action.changes.emplace_back<SetTile>(std::move(tile));
+    }
+
+    history.commit(std::move(action));
+}
+
 void MapView::fillRegion(const Position &from, const Position &to, uint32_t serverId)
 {
     history.beginTransaction(TransactionType::AddMapItem);
@@ -648,6 +661,7 @@ void MapView::fillRegion(const Position &from, const Position &to, uint32_t serv
 
 void MapView::fillRegionByGroundBrush(const Position &from, const Position &to, GroundBrush *brush)
 {
+    VME_TRACE_SCOPE("MapView::fillRegionByGroundBrush");
     history.beginTransaction(TransactionType::AddMapItem);
 
     bool hasPlacementRestriction = GroundBrush::hasReplacementFilter();
@@ -699,6 +713,7 @@ void MapView::fillRegionByGroundBrush(const Position &from, const Position &to,
 
 void MapView::fillRegionByMountainBrush(const Position &from, const Position &to, MountainBrush *brush)
 {
+    VME_TRACE_SCOPE("MapView::fillRegionByMountainBrush");
     history.beginTransaction(TransactionType::AddMapItem);
 
     MapView &mapView = *this;
@@ -1120,7 +1135,6 @@ void MapView::endDragging(VME::ModifierKeys modifiers)
         editorAction.action());
 
     requestDraw();
-    requestMinimapDraw();
 }
 
 void MapView::setPanOffset(MouseAction::Pan &action, const ScreenPosition &offset)
@@ -1243,6 +1257,8 @@ void MapView::selectTopThing(const Position &position, bool isNewSelection)
 
 void MapView::mousePressEvent(VME::MouseEvent event)
 {
+    NotificationFrame frame(*this);
+
     if (event.buttons() & VME::MouseButtons::LeftButton)
     {
         Position pos = event.pos().toPos(*this);
@@ -1280,6 +1296,7 @@ void MapView::mousePressEvent(VME::MouseEvent event)
                 },
 
                 [this, pos, event](MouseAction::MapBrush &action) {
+                    VME_TRACE_SCOPE("MapView::applyBrush");
                     commitTransaction(TransactionType::Selection, [this] { clearSelection(); });
 
                     editorAction.lock();
@@ -1365,6 +1382,8 @@ void MapView::mousePressEvent(VME::MouseEvent event)
 
 void MapView::mouseMoveEvent(VME::MouseEvent event)
 {
+    NotificationFrame frame(*this);
+
     WorldPosition worldPos = event.pos().worldPos(*this);
     Position pos = worldPos.toPos(floor());
     TileQuadrant quadrant = worldPos.tileQuadrant();
@@ -1434,6 +1453,8 @@ void MapView::mouseMoveEvent(VME::MouseEvent event)
                     if (action.area)
                         return;
 
+                    VME_TRACE_SCOPE("MapView::applyBrush");
+
                     if (event.modifiers() & VME::ModifierKeys::Ctrl)
                     {
                         const Tile *tile = getTile(pos);
@@ -1506,8 +1527,6 @@ void MapView::mouseMoveEvent(VME::MouseEvent event)
                             }
                             break;
                         }
-
-                        requestMinimapDraw();
                     }
                 },
 
@@ -1537,6 +1556,8 @@ int MapView::getBrushVariation() const noexcept
 
 void MapView::mouseReleaseEvent(VME::MouseEvent event)
 {
+    NotificationFrame frame(*this);
+
     if (!(event.buttons() & VME::MouseButtons::LeftButton))
     {
         endCurrentAction(event.modifiers());
@@ -1602,7 +1623,6 @@ void MapView::endCurrentAction(VME::ModifierKeys modifiers)
                         Position deltaPos = select.moveDelta.value();
                         moveSelection(deltaPos);
                         requestDraw();
-                        requestMinimapDraw();
 
                         select.reset();
                         editorAction.unlock();
@@ -1763,14 +1783,86 @@ void MapView::translateCamera(WorldPosition delta)
 
 void MapView::requestDraw()
 {
+    if (notificationBatchDepth != 0)
+    {
+        drawRequestPending = true;
+        return;
+    }
+
     drawRequest.fire();
 }
 
 void MapView::requestMinimapDraw()
 {
+    if (notificationBatchDepth != 0)
+    {
+        drawMinimapRequestPending = true;
+        return;
+    }
+
     drawMinimapRequest.fire();
 }
 
+void MapView::beginNotificationBatch()
+{
+    if (notificationBatchDepth++ == 0)
+    {
+        Items::items.beginNotificationBatch();
+    }
+}
+
+void MapView::endNotificationBatch()
+{
+    DEBUG_ASSERT(notificationBatchDepth != 0, "There is no notification batch to end.");
+
+    if (--notificationBatchDepth == 0)
+    {
+        Items::items.endNotificationBatch(&pendingChanges.changedGuids);
+        flushNotifications();
+    }
+}
+
+void MapView::flushNotifications()
+{
+    Items::items.flushNotifications(&pendingChanges.changedGuids);
+
+    // Subscribers may start another batch
+    MapChanges changes = std::move(pendingChanges);
+    pendingChanges = MapChanges{};
+
+    bool draw = drawRequestPending;
+    bool drawMinimap = drawMinimapRequestPending;
+    drawRequestPending = false;
+    drawMinimapRequestPending = false;
+
+    if (!changes.empty())
+    {
+        mapChange.fire(changes);
+    }
+
+    if (draw)
+    {
+        drawRequest.fire();
+    }
+
+    if (drawMinimap)
+    {
+        drawMinimapRequest.fire();
+    }
+}
+
+void MapView::tileChanged(const Position &position)
+{
+    // A changed tile is always drawn, so the draw request is sent with the map change
+    pendingChanges.addTile(position);
+    drawRequestPending = true;
+
+    if (notificationBatchDepth == 0)
+    {
+        flushNotifications();
+    }
+}
+
 std::optional<TileQuadrant> MapView::getLastClickedTileQuadrant() const noexcept
 {
     return lastClickedTileQuadrant;
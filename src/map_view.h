@@ -14,6 +14,7 @@
 #include "history/history_action.h"
 #include "item_location.h"
 #include "map.h"
+#include "map_changes.h"
 #include "position.h"
 #include "selection.h"
 #include "signal.h"
@@ -59,6 +60,8 @@ class MapView
     void testBordering();
 
     inline const Map *map() const noexcept;
+    // Shares ownership of the map, e.g. with a MapTileExporter
+    inline std::shared_ptr<Map> sharedMap() const noexcept;
 
     inline uint16_t mapWidth() const noexcept;
     inline uint16_t mapHeight() const noexcept;
@@ -78,6 +81,15 @@ class MapView
     void requestDraw();
     void requestMinimapDraw();
 
+    /*
+		While a batch is open, draw requests, tile changes and item property changes are gathered instead of sent.
+		They are sent once when the outermost batch ends, or earlier at a frame boundary (flushNotifications).
+		Every history transaction is a batch.
+	*/
+    void beginNotificationBatch();
+    void endNotificationBatch();
+    void flushNotifications();
+
     /**
 	 * Shorthand method for comitting actions within a group. Equivalent to:
 	 * 
@@ -176,6 +188,12 @@ class MapView
     void removeItem(Tile &tile, Item *item);
     void removeItem(Tile &tile, std::function<bool(const Item &)> p);
 
+    /*
+		Puts each tile at its position in the map as a single action. Used for bulk edits such as scripted map
+		generation.
+	*/
+    void replaceTiles(std::vector<Tile> &&tiles);
+
     void zoomOut();
     void zoomIn();
     void resetZoom();
@@ -274,6 +292,7 @@ class MapView
     template <auto MemberFunction, typename T>
     void onDrawRequested(T *instance);
 
+    // Called when the camera moves. Edits to the map are sent through onMapChanged.
     template <auto MemberFunction, typename T>
     void onDrawMinimapRequest(T *instance);
 
@@ -286,6 +305,10 @@ class MapView
     template <auto MemberFunction, typename T>
     void onUndoRedo(T *instance);
 
+    // Called once per notification batch that changed the map
+    template <auto MemberFunction, typename T>
+    void onMapChanged(T *instance);
+
     int getBrushVariation() const noexcept;
 
     static Direction getDirection(int variation);
@@ -300,6 +323,25 @@ class MapView
   private:
     friend class MapHistory::ChangeItem;
 
+    /*
+		Sends the gathered notifications when an input event is handled. Brush actions keep a transaction open over
+		many events, and their changes should still be drawn as they happen.
+	*/
+    struct NotificationFrame
+    {
+        NotificationFrame(MapView &mapView)
+            : mapView(mapView) {}
+
+        ~NotificationFrame()
+        {
+            mapView.flushNotifications();
+        }
+
+        MapView &mapView;
+    };
+
+    void tileChanged(const Position &position);
+
     void borderize(const Position &position);
 
     Tile deepCopyTile(const Position position) const;
@@ -365,6 +407,12 @@ class MapView
     Nano::Signal<void()> drawRequest;
     Nano::Signal<void()> drawMinimapRequest;
     Nano::Signal<void()> undoRedoPerformed;
+    Nano::Signal<void(const MapChanges &)> mapChange;
+
+    uint32_t notificationBatchDepth = 0;
+    bool drawRequestPending = false;
+    bool drawMinimapRequestPending = false;
+    MapChanges pendingChanges;
 };
 
 inline const Map *MapView::map() const noexcept
@@ -372,6 +420,11 @@ inline const Map *MapView::map() const noexcept
     return _map.get();
 }
 
+inline std::shared_ptr<Map> MapView::sharedMap() const noexcept
+{
+    return _map;
+}
+
 inline uint16_t MapView::mapWidth() const noexcept
 {
     return _map->width();
@@ -525,4 +578,10 @@ void MapView::onUndoRedo(T *instance)
     undoRedoPerformed.connect<MemberFunction>(instance);
 }
 
+template <auto MemberFunction, typename T>
+void MapView::onMapChanged(T *instance)
+{
+    mapChange.connect<MemberFunction>(instance);
+}
+
 VME_ENUM_OPERATORS(MapView::ViewOption)
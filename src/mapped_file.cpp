@@ -0,0 +1,124 @@
+#include "mapped_file.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const uint8_t *data, size_t size)
+    : _data(data), _size(size) {}
+
+MappedFile::~MappedFile()
+{
+    release();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : _data(std::exchange(other._data, nullptr)), _size(std::exchange(other._size, 0)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        _data = std::exchange(other._data, nullptr);
+        _size = std::exchange(other._size, 0);
+    }
+
+    return *this;
+}
+
+#ifdef _WIN32
+
+std::optional<MappedFile> MappedFile::open(const std::filesystem::path &path)
+{
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return std::nullopt;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return std::nullopt;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr)
+    {
+        return std::nullopt;
+    }
+
+    // The view keeps the mapping alive
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (view == nullptr)
+    {
+        return std::nullopt;
+    }
+
+    return MappedFile(static_cast<const uint8_t *>(view), static_cast<size_t>(size.QuadPart));
+}
+
+void MappedFile::release() noexcept
+{
+    if (_data)
+    {
+        UnmapViewOfFile(_data);
+        _data = nullptr;
+        _size = 0;
+    }
+}
+
+#else
+
+std::optional<MappedFile> MappedFile::open(const std::filesystem::path &path)
+{
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file == -1)
+    {
+        return std::nullopt;
+    }
+
+    struct stat status;
+    if (fstat(file, &status) != 0 || status.st_size == 0)
+    {
+        close(file);
+        return std::nullopt;
+    }
+
+    size_t size = static_cast<size_t>(status.st_size);
+
+    // The mapping stays valid after the file is closed
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED)
+    {
+        return std::nullopt;
+    }
+
+    return MappedFile(static_cast<const uint8_t *>(data), size);
+}
+
+void MappedFile::release() noexcept
+{
+    if (_data)
+    {
+        munmap(const_cast<uint8_t *>(_data), _size);
+        _data = nullptr;
+        _size = 0;
+    }
+}
+
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+/*
+	A read-only memory mapping of a whole file. The mapping is released when the MappedFile is destroyed.
+*/
+class MappedFile
+{
+  public:
+    // Returns nullopt if the file does not exist, is empty or could not be mapped.
+    static std::optional<MappedFile> open(const std::filesystem::path &path);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    inline const uint8_t *data() const noexcept
+    {
+        return _data;
+    }
+
+    inline size_t size() const noexcept
+    {
+        return _size;
+    }
+
+  private:
+    MappedFile(const uint8_t *data, size_t size);
+
+    void release() noexcept;
+
+    const uint8_t *_data = nullptr;
+    size_t _size = 0;
+};
@@ -10,6 +10,13 @@ ObservableItem::ObservableItem(Item *item)
       _item(item),
       disconnect(Items::items.trackItem<&ObservableItem::itemAddressChanged, &ObservableItem::itemPropertyChanged>(_guid, this)) {}
 
+ObservableItem::ObservableItem(ObservableItem &&other)
+    : _guid(other._guid),
+      _item(other._item),
+      disconnect(Items::items.trackItem<&ObservableItem::itemAddressChanged, &ObservableItem::itemPropertyChanged>(_guid, this)),
+      onAddressChangedCallback(std::move(other.onAddressChangedCallback)),
+      onPropertyChangedCallback(std::move(other.onPropertyChangedCallback)) {}
+
 Item *ObservableItem::item() const noexcept
 {
     return _item;
@@ -37,6 +44,11 @@ TrackedContainer::TrackedContainer(Item *item)
     : ObservableItem(item),
       containerDisconnect(Items::items.trackContainer<&TrackedContainer::updateContainer>(_guid, this)) {}
 
+TrackedContainer::TrackedContainer(TrackedContainer &&other)
+    : ObservableItem(std::move(other)),
+      containerDisconnect(Items::items.trackContainer<&TrackedContainer::updateContainer>(_guid, this)),
+      onContainerChangeCallback(std::move(other.onContainerChangeCallback)) {}
+
 void TrackedContainer::updateContainer(ContainerChange change)
 {
     if (onContainerChangeCallback)
@@ -71,8 +83,30 @@ ItemGuidDisconnect::ItemGuidDisconnect()
 }
 
 ItemGuidDisconnect::ItemGuidDisconnect(std::function<void()> f)
-    : f(f)
+    : f(std::move(f))
+{
+}
+
+ItemGuidDisconnect::ItemGuidDisconnect(ItemGuidDisconnect &&other) noexcept
+    : f(std::move(other.f))
+{
+    other.f = nullptr;
+}
+
+ItemGuidDisconnect &ItemGuidDisconnect::operator=(ItemGuidDisconnect &&other) noexcept
 {
+    if (this != &other)
+    {
+        if (f)
+        {
+            f();
+        }
+
+        f = std::move(other.f);
+        other.f = nullptr;
+    }
+
+    return *this;
 }
 
 ItemGuidDisconnect::~ItemGuidDisconnect()
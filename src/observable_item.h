@@ -36,11 +36,21 @@ struct ContainerChange
     ContainerChange(ContainerChangeType type, uint8_t fromIndex, uint8_t toIndex);
 };
 
+/*
+	Runs the disconnect function once, when destroyed. Move-only: a copy would disconnect (and release the signal)
+	twice.
+*/
 struct ItemGuidDisconnect
 {
     ItemGuidDisconnect();
     ItemGuidDisconnect(std::function<void()> f);
 
+    ItemGuidDisconnect(ItemGuidDisconnect &&other) noexcept;
+    ItemGuidDisconnect &operator=(ItemGuidDisconnect &&other) noexcept;
+
+    ItemGuidDisconnect(const ItemGuidDisconnect &) = delete;
+    ItemGuidDisconnect &operator=(const ItemGuidDisconnect &) = delete;
+
     ~ItemGuidDisconnect();
 
   private:
@@ -51,6 +61,9 @@ struct ObservableItem
 {
     ObservableItem(Item *item);
 
+    // The signals are connected to the instance, so the new instance tracks the item again
+    ObservableItem(ObservableItem &&other);
+
     Item *item() const noexcept;
 
     template <auto MemberFunction, typename T>
@@ -87,6 +100,7 @@ struct ObservableItem
 struct TrackedContainer : ObservableItem
 {
     TrackedContainer(Item *item);
+    TrackedContainer(TrackedContainer &&other);
 
     template <auto MemberFunction, typename T>
     void onContainerChanged(T *instance)
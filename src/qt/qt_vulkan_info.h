@@ -85,10 +85,18 @@ class QtVulkanInfo : public VulkanInfo
     {
         return df->vkAllocateDescriptorSets(device(), pAllocateInfo, pDescriptorSets);
     }
+    inline VkResult vkFreeDescriptorSets(VkDescriptorPool descriptorPool, uint32_t descriptorSetCount, const VkDescriptorSet *pDescriptorSets) override
+    {
+        return df->vkFreeDescriptorSets(device(), descriptorPool, descriptorSetCount, pDescriptorSets);
+    }
     inline VkResult vkCreateSampler(const VkSamplerCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkSampler *pSampler) override
     {
         return df->vkCreateSampler(device(), pCreateInfo, pAllocator, pSampler);
     }
+    inline void vkDestroySampler(VkSampler sampler, const VkAllocationCallbacks *pAllocator) override
+    {
+        df->vkDestroySampler(device(), sampler, pAllocator);
+    }
     inline void vkCmdCopyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkImage dstImage, VkImageLayout dstImageLayout, uint32_t regionCount, const VkBufferImageCopy *pRegions) override
     {
         df->vkCmdCopyBufferToImage(commandBuffer, srcBuffer, dstImage, dstImageLayout, regionCount, pRegions);
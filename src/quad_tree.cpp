@@ -1,5 +1,6 @@
 #include "quad_tree.h"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <sstream>
@@ -70,6 +71,59 @@ Floor *Node::floor(uint32_t z) const
     return children.floor(z);
 }
 
+bool Node::containsTile(int x1, int y1, int x2, int y2, int z1, int z2) const
+{
+    DEBUG_ASSERT(isRoot(), "Only the root knows the area that it covers.");
+
+    // The root covers 16 bits in x and y (see getLeafUnsafe)
+    return containsTile(0, 0, 0x10000, x1, y1, x2, y2, z1, z2);
+}
+
+bool Node::containsTile(int originX, int originY, int size, int x1, int y1, int x2, int y2, int z1, int z2) const
+{
+    if (originX > x2 || originY > y2 || originX + size - 1 < x1 || originY + size - 1 < y1)
+    {
+        return false;
+    }
+
+    if (isLeaf())
+    {
+        for (int z = std::max(z1, 0); z <= std::min(z2, MAP_LAYERS - 1); ++z)
+        {
+            Floor *f = floor(z);
+            if (!f)
+                continue;
+
+            for (int x = std::max(x1, originX); x <= std::min(x2, originX + size - 1); ++x)
+            {
+                for (int y = std::max(y1, originY); y <= std::min(y2, originY + size - 1); ++y)
+                {
+                    if (f->getTileLocation(x, y).hasTile())
+                        return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    // The child index is given by the bits YYXX (see getLeafWithCreate)
+    int childSize = size / 4;
+    for (size_t index = 0; index < Children::Amount; ++index)
+    {
+        Node *child = children.node(index);
+        if (child && child->containsTile(originX + static_cast<int>(index & 3) * childSize,
+                                         originY + static_cast<int>(index >> 2) * childSize,
+                                         childSize,
+                                         x1, y1, x2, y2, z1, z2))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 Node *Node::getLeafUnsafe(int x, int y) const
 {
     Node *node = const_cast<Node *>(this);
@@ -97,6 +97,12 @@ namespace quadtree
         Node *getLeafUnsafe(int x, int y) const;
         TileLocation *getTile(int x, int y, int z) const;
 
+        /*
+			Returns true if a tile exists in the area [x1, x2] x [y1, y2] on any floor in [z1, z2].
+			Only subtrees that intersect the area are visited.
+		*/
+        bool containsTile(int x1, int y1, int x2, int y2, int z1, int z2) const;
+
         Floor &getOrCreateFloor(const Position &pos);
         Floor *floor(uint32_t z) const;
 
@@ -113,6 +119,8 @@ namespace quadtree
         Children children;
 
       private:
+        bool containsTile(int originX, int originY, int size, int x1, int y1, int x2, int y2, int z1, int z2) const;
+
         static constexpr std::array<NodeType, 2> NodeTypeCreationMapping{{NodeType::Leaf, NodeType::Node}};
     };
 }; // namespace quadtree
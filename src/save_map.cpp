@@ -8,6 +8,7 @@
 #include "definitions.h"
 #include "items.h"
 #include "tile.h"
+#include "trace.h"
 #include "version.h"
 
 #pragma warning(push)
@@ -23,6 +24,7 @@ constexpr uint32_t DEFAULT_BUFFER_SIZE = util::power(2, 20);
 
 void SaveMap::saveMap(const Map &map)
 {
+    VME_TRACE_SCOPE("SaveMap::saveMap");
     std::ofstream stream;
     SaveBuffer buffer = SaveBuffer(stream);
 
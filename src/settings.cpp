@@ -7,4 +7,14 @@ int Settings::DEFAULT_CREATURE_SPAWN_INTERVAL = 60;
 
 bool Settings::HIGHLIGHT_BRUSH_IN_PALETTE_ON_SELECT = false;
 bool Settings::RENDER_ANIMATIONS = false;
+float Settings::MIN_ZOOM_FOR_ANIMATIONS = 0.5f;
+bool Settings::DECOMPRESS_ATLASES_ASYNC = true;
+size_t Settings::TEXTURE_ATLAS_MEMORY_BUDGET = 512 * 1024 * 1024;
+bool Settings::CACHE_ATLASES_ON_DISK = true;
+bool Settings::CACHE_CLIENT_DATA = true;
+bool Settings::COMPILE_BRUSHES = true;
+bool Settings::PRECOMPUTE_SPRITE_OPACITY = true;
+bool Settings::CACHE_THUMBNAILS = true;
+size_t Settings::GUI_IMAGE_CACHE_MEMORY_BUDGET = 32 * 1024 * 1024;
+bool Settings::PROFILE_LUA_SCRIPTS = false;
 bool Settings::PLACE_MOUNTAIN_FEATURES = false;
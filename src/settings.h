@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+
 enum class BorderBrushVariationType
 {
     Detailed,
@@ -16,6 +18,35 @@ struct Settings
     static bool HIGHLIGHT_BRUSH_IN_PALETTE_ON_SELECT;
 
     static bool RENDER_ANIMATIONS;
+    // Animations are not updated when the zoom factor is below this value.
+    static float MIN_ZOOM_FOR_ANIMATIONS;
+
+    // Decompress texture atlases on worker threads. The map skips sprites whose atlas is not ready yet.
+    static bool DECOMPRESS_ATLASES_ASYNC;
+
+    // Memory in bytes for decompressed texture atlases. Least recently used atlases are evicted above it.
+    static size_t TEXTURE_ATLAS_MEMORY_BUDGET;
+
+    // Keep decompressed texture atlases on disk so that later starts do not have to decompress them again.
+    static bool CACHE_ATLASES_ON_DISK;
+
+    // Keep the item types and appearances built from the client files on disk and load them from there on later starts.
+    static bool CACHE_CLIENT_DATA;
+
+    // Keep the brush files compiled on disk and only parse the ones that changed since the last start.
+    static bool COMPILE_BRUSHES;
+
+    // Summarize the opacity of every sprite while loading, instead of when its atlas is first decompressed.
+    static bool PRECOMPUTE_SPRITE_OPACITY;
+
+    // Keep the palette thumbnails on disk so that later starts can show them without decompressing texture atlases.
+    static bool CACHE_THUMBNAILS;
+
+    // Memory in bytes for the item and creature thumbnails of the GUI. Least recently used thumbnails are dropped above it.
+    static size_t GUI_IMAGE_CACHE_MEMORY_BUDGET;
+
+    // Profile Lua scripts. The report is logged and the sampled stacks are written next to the script (<script>.folded).
+    static bool PROFILE_LUA_SCRIPTS;
 
     static bool PLACE_MOUNTAIN_FEATURES;
 };
\ No newline at end of file
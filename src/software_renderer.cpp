@@ -0,0 +1,344 @@
+#include "software_renderer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#include <stb_image_write.h>
+
+#include "map_view.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VME_SOFTWARE_RENDERER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // Magenta texels are treated as transparent by the fragment shader
+    constexpr uint32_t MagentaBGR = 0x00FF00FF;
+
+    inline bool isTransparentTexel(uint32_t texel)
+    {
+        return (texel >> 24) == 0 || (texel & 0x00FFFFFF) == MagentaBGR;
+    }
+
+    inline uint32_t texelAt(const Texture &texture, int x, int y)
+    {
+        x = std::clamp(x, 0, texture.width() - 1);
+        y = std::clamp(y, 0, texture.height() - 1);
+
+        uint32_t texel;
+        std::memcpy(&texel, texture.pixels().data() + 4 * (static_cast<size_t>(y) * texture.width() + x), sizeof(uint32_t));
+        return texel;
+    }
+
+    /*
+		Returns the texel as RGBA in the range [0, 255]. Texture memory is BGRA.
+	*/
+    inline glm::vec4 unpackTexel(uint32_t texel)
+    {
+        if (isTransparentTexel(texel))
+        {
+            return glm::vec4(0.0f);
+        }
+
+        return glm::vec4((texel >> 16) & 0xFF, (texel >> 8) & 0xFF, texel & 0xFF, texel >> 24);
+    }
+
+    /*
+		Same filter as textureBilinear in shader.frag (CLAMP_TO_EDGE addressing).
+	*/
+    glm::vec4 sampleBilinear(const Texture &texture, float u, float v)
+    {
+        float x = u * texture.width() - 0.5f;
+        float y = v * texture.height() - 0.5f;
+
+        float originX = std::floor(x);
+        float originY = std::floor(y);
+
+        float weightX = x - originX;
+        float weightY = y - originY;
+
+        int x0 = static_cast<int>(originX);
+        int y0 = static_cast<int>(originY);
+
+        glm::vec4 c00 = unpackTexel(texelAt(texture, x0, y0));
+        glm::vec4 c10 = unpackTexel(texelAt(texture, x0 + 1, y0));
+        glm::vec4 c01 = unpackTexel(texelAt(texture, x0, y0 + 1));
+        glm::vec4 c11 = unpackTexel(texelAt(texture, x0 + 1, y0 + 1));
+
+        glm::vec4 top = c00 + (c10 - c00) * weightX;
+        glm::vec4 bottom = c01 + (c11 - c01) * weightX;
+        return top + (bottom - top) * weightY;
+    }
+
+    /*
+		SRC_ALPHA, ONE_MINUS_SRC_ALPHA blending of an RGBA color in the range [0, 255]. The target is always opaque.
+	*/
+    inline void blendPixel(uint8_t *dst, const glm::vec4 &src)
+    {
+        float alpha = src.a / 255.0f;
+        if (alpha <= 0.0f)
+        {
+            return;
+        }
+
+        for (int i = 0; i < 3; ++i)
+        {
+            float value = src[i] * alpha + dst[i] * (1.0f - alpha);
+            dst[i] = static_cast<uint8_t>(std::clamp(std::lround(value), 0L, 255L));
+        }
+    }
+
+    /*
+		Blends count texels (BGRA) onto count pixels (RGBA), multiplying each texel by color.
+	*/
+    void blendRow(uint8_t *dst, const uint8_t *src, int count, const glm::vec4 &color)
+    {
+#ifdef VME_SOFTWARE_RENDERER_SSE2
+        const __m128 colorFactor = _mm_setr_ps(color.r, color.g, color.b, color.a);
+        const __m128 inverse255 = _mm_set1_ps(1.0f / 255.0f);
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128i zero = _mm_setzero_si128();
+#endif
+
+        for (int i = 0; i < count; ++i, src += 4, dst += 4)
+        {
+            uint32_t texel;
+            std::memcpy(&texel, src, sizeof(uint32_t));
+            if (isTransparentTexel(texel))
+            {
+                continue;
+            }
+
+#ifdef VME_SOFTWARE_RENDERER_SSE2
+            __m128i texelParts = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(texel)), zero), zero);
+            __m128 bgra = _mm_cvtepi32_ps(texelParts);
+            __m128 source = _mm_mul_ps(_mm_shuffle_ps(bgra, bgra, _MM_SHUFFLE(3, 0, 1, 2)), colorFactor);
+
+            __m128 alpha = _mm_mul_ps(_mm_shuffle_ps(source, source, _MM_SHUFFLE(3, 3, 3, 3)), inverse255);
+
+            uint32_t target;
+            std::memcpy(&target, dst, sizeof(uint32_t));
+            __m128 destination = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(target)), zero), zero));
+
+            __m128 result = _mm_add_ps(_mm_mul_ps(source, alpha), _mm_mul_ps(destination, _mm_sub_ps(one, alpha)));
+
+            __m128i packed = _mm_cvtps_epi32(result);
+            packed = _mm_packs_epi32(packed, packed);
+            packed = _mm_packus_epi16(packed, packed);
+
+            uint32_t out = static_cast<uint32_t>(_mm_cvtsi128_si32(packed)) | 0xFF000000;
+            std::memcpy(dst, &out, sizeof(uint32_t));
+#else
+            blendPixel(dst, unpackTexel(texel) * color);
+#endif
+        }
+    }
+
+    inline bool nearlyEqual(float a, float b)
+    {
+        return std::abs(a - b) < 1e-3f;
+    }
+} // namespace
+
+SoftwareRenderer::Image::Image(uint32_t width, uint32_t height)
+    : width(width), height(height), pixels(static_cast<size_t>(width) * height * 4, 0)
+{
+    // Same clear color as the Vulkan render pass (opaque black)
+    for (size_t i = 3; i < pixels.size(); i += 4)
+    {
+        pixels[i] = 255;
+    }
+}
+
+bool SoftwareRenderer::Image::savePng(const std::filesystem::path &path) const
+{
+    return stbi_write_png(path.string().c_str(), width, height, 4, pixels.data(), width * 4) != 0;
+}
+
+SoftwareRenderer::SoftwareRenderer(uint32_t threadCount)
+    : threadCount(threadCount != 0 ? threadCount : std::max(1u, std::thread::hardware_concurrency())) {}
+
+SoftwareRenderer::Image SoftwareRenderer::render(MapView &mapView) const
+{
+    MapRenderer mapRenderer(&mapView);
+
+    DrawList drawList;
+    mapRenderer.recordFrame(drawList);
+
+    return render(drawList, mapView.getViewport());
+}
+
+SoftwareRenderer::Image SoftwareRenderer::render(const DrawList &drawList, const Camera::Viewport &viewport) const
+{
+    Image image(std::max(viewport.width, 0), std::max(viewport.height, 0));
+    if (image.width == 0 || image.height == 0)
+    {
+        return image;
+    }
+
+    int tilesX = (image.width + TileSize - 1) / TileSize;
+    int tilesY = (image.height + TileSize - 1) / TileSize;
+
+    // Indices of the commands that touch each tile, in draw order
+    std::vector<std::vector<uint32_t>> tiles(static_cast<size_t>(tilesX) * tilesY);
+
+    for (uint32_t i = 0; i < drawList.size(); ++i)
+    {
+        ScreenRect rect = screenRect(drawList[i], viewport);
+        rect.x1 = std::max(rect.x1, 0);
+        rect.y1 = std::max(rect.y1, 0);
+        rect.x2 = std::min(rect.x2, static_cast<int>(image.width));
+        rect.y2 = std::min(rect.y2, static_cast<int>(image.height));
+
+        if (rect.x1 >= rect.x2 || rect.y1 >= rect.y2)
+        {
+            continue;
+        }
+
+        for (int tileY = rect.y1 / TileSize; tileY <= (rect.y2 - 1) / TileSize; ++tileY)
+        {
+            for (int tileX = rect.x1 / TileSize; tileX <= (rect.x2 - 1) / TileSize; ++tileX)
+            {
+                tiles[tileY * tilesX + tileX].emplace_back(i);
+            }
+        }
+    }
+
+    std::atomic<size_t> nextTile = 0;
+
+    auto worker = [&]() {
+        for (size_t index = nextTile++; index < tiles.size(); index = nextTile++)
+        {
+            if (tiles[index].empty())
+            {
+                continue;
+            }
+
+            int x = static_cast<int>(index % tilesX) * TileSize;
+            int y = static_cast<int>(index / tilesX) * TileSize;
+
+            ScreenRect clip{x, y, std::min(x + TileSize, static_cast<int>(image.width)), std::min(y + TileSize, static_cast<int>(image.height))};
+            drawTile(Target{image, viewport, clip}, drawList, tiles[index]);
+        }
+    };
+
+    size_t workerCount = std::min<size_t>(threadCount, tiles.size());
+
+    std::vector<std::thread> threads;
+    threads.reserve(workerCount - 1);
+    for (size_t i = 1; i < workerCount; ++i)
+    {
+        threads.emplace_back(worker);
+    }
+
+    worker();
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    return image;
+}
+
+void SoftwareRenderer::drawTile(const Target &target, const DrawList &drawList, const std::vector<uint32_t> &commandIndices)
+{
+    for (uint32_t index : commandIndices)
+    {
+        draw(target, drawList[index]);
+    }
+}
+
+SoftwareRenderer::ScreenRect SoftwareRenderer::screenRect(const DrawCommand &command, const Camera::Viewport &viewport)
+{
+    float x1 = (command.position.x - viewport.x) * viewport.zoom;
+    float y1 = (command.position.y - viewport.y) * viewport.zoom;
+    float x2 = x1 + command.width * viewport.zoom;
+    float y2 = y1 + command.height * viewport.zoom;
+
+    // A pixel is covered if its center is inside the quad (top-left fill rule)
+    return ScreenRect{
+        static_cast<int>(std::ceil(x1 - 0.5f)),
+        static_cast<int>(std::ceil(y1 - 0.5f)),
+        static_cast<int>(std::ceil(x2 - 0.5f)),
+        static_cast<int>(std::ceil(y2 - 0.5f))};
+}
+
+void SoftwareRenderer::draw(const Target &target, const DrawCommand &command)
+{
+    const Texture &texture = *command.texture;
+    const auto &quad = command.textureQuad;
+
+    // At the default zoom, sprites map texels 1:1 to pixels. Bilinear filtering then samples exact texel centers,
+    // so rows can be blitted directly.
+    if (target.viewport.zoom == 1.0f &&
+        quad.z > quad.x && quad.w > quad.y &&
+        nearlyEqual((quad.z - quad.x) * texture.width(), static_cast<float>(command.width)) &&
+        nearlyEqual((quad.w - quad.y) * texture.height(), static_cast<float>(command.height)))
+    {
+        blit(target, command, command.position.x - target.viewport.x, command.position.y - target.viewport.y);
+        return;
+    }
+
+    ScreenRect rect = screenRect(command, target.viewport);
+    int fromX = std::max(rect.x1, target.clip.x1);
+    int fromY = std::max(rect.y1, target.clip.y1);
+    int toX = std::min(rect.x2, target.clip.x2);
+    int toY = std::min(rect.y2, target.clip.y2);
+
+    float screenX = (command.position.x - target.viewport.x) * target.viewport.zoom;
+    float screenY = (command.position.y - target.viewport.y) * target.viewport.zoom;
+    float screenWidth = command.width * target.viewport.zoom;
+    float screenHeight = command.height * target.viewport.zoom;
+
+    const auto &bounds = command.fragQuad;
+
+    for (int y = fromY; y < toY; ++y)
+    {
+        // y = 0 uses the larger v coordinate because texture memory is stored upside down (see shader.vert)
+        float t = (y + 0.5f - screenY) / screenHeight;
+        float v = std::clamp(quad.w + (quad.y - quad.w) * t, bounds.y, bounds.w);
+
+        uint8_t *dst = target.image.pixels.data() + 4 * (static_cast<size_t>(y) * target.image.width + fromX);
+        for (int x = fromX; x < toX; ++x, dst += 4)
+        {
+            float s = (x + 0.5f - screenX) / screenWidth;
+            float u = std::clamp(quad.x + (quad.z - quad.x) * s, bounds.x, bounds.z);
+
+            blendPixel(dst, sampleBilinear(texture, u, v) * command.color);
+        }
+    }
+}
+
+void SoftwareRenderer::blit(const Target &target, const DrawCommand &command, int screenX, int screenY)
+{
+    const Texture &texture = *command.texture;
+
+    int fromX = std::max(screenX, target.clip.x1);
+    int fromY = std::max(screenY, target.clip.y1);
+    int toX = std::min(screenX + static_cast<int>(command.width), target.clip.x2);
+    int toY = std::min(screenY + static_cast<int>(command.height), target.clip.y2);
+
+    if (fromX >= toX || fromY >= toY)
+    {
+        return;
+    }
+
+    int texelX = static_cast<int>(std::lround(command.textureQuad.x * texture.width())) + (fromX - screenX);
+    int topTexelRow = static_cast<int>(std::lround(command.textureQuad.w * texture.height())) - 1;
+
+    for (int y = fromY; y < toY; ++y)
+    {
+        int texelY = topTexelRow - (y - screenY);
+
+        const uint8_t *src = texture.pixels().data() + 4 * (static_cast<size_t>(texelY) * texture.width() + texelX);
+        uint8_t *dst = target.image.pixels.data() + 4 * (static_cast<size_t>(y) * target.image.width + fromX);
+
+        blendRow(dst, src, toX - fromX, command.color);
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include "camera.h"
+#include "map_renderer.h"
+
+class MapView;
+
+/*
+	Rasterizes the draw list of a MapRenderer on the CPU. Used to render map regions without a GPU (previews,
+	documentation images and golden-image tests).
+
+	The output matches the Vulkan pipeline (shader.vert/shader.frag) closely: pixel-center sampling, the same
+	bilinear filter with magenta treated as transparent, the draw color multiplied in and SRC_ALPHA blending
+	into an 8-bit target. Small differences (at most a few levels per channel) can occur at non-default zoom
+	levels due to GPU interpolation precision.
+
+	The image is split into square tiles that are rendered in parallel. Every tile draws the commands that touch
+	it in list order, so the result does not depend on the thread count.
+*/
+class SoftwareRenderer
+{
+  public:
+    struct Image
+    {
+        Image(uint32_t width, uint32_t height);
+
+        uint32_t width;
+        uint32_t height;
+
+        // RGBA with 8 bits per channel. Rows are stored top to bottom.
+        std::vector<uint8_t> pixels;
+
+        bool savePng(const std::filesystem::path &path) const;
+    };
+
+    /*
+		A threadCount of 0 uses one thread per hardware thread.
+	*/
+    explicit SoftwareRenderer(uint32_t threadCount = 0);
+
+    /*
+		Renders what a MapView with the same viewport would show on screen.
+	*/
+    Image render(MapView &mapView) const;
+
+    Image render(const DrawList &drawList, const Camera::Viewport &viewport) const;
+
+    static constexpr int TileSize = 64;
+
+  private:
+    struct ScreenRect
+    {
+        int x1;
+        int y1;
+        // Exclusive
+        int x2;
+        int y2;
+    };
+
+    struct Target
+    {
+        Image &image;
+        const Camera::Viewport &viewport;
+        ScreenRect clip;
+    };
+
+    static void drawTile(const Target &target, const DrawList &drawList, const std::vector<uint32_t> &commandIndices);
+    static void draw(const Target &target, const DrawCommand &command);
+    static void blit(const Target &target, const DrawCommand &command, int screenX, int screenY);
+
+    static ScreenRect screenRect(const DrawCommand &command, const Camera::Viewport &viewport);
+
+    uint32_t threadCount;
+};
@@ -0,0 +1,187 @@
+#include "task_graph.h"
+
+#include <algorithm>
+#include <exception>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include "debug.h"
+#include "logger.h"
+#include "thread_pool.h"
+#include "time_util.h"
+
+struct TaskGraph::RunState
+{
+    std::vector<Node> &nodes;
+    std::vector<Timing> &timings;
+    TimePoint start;
+
+    std::mutex mutex;
+    std::vector<uint32_t> remainingDependencies;
+    std::exception_ptr error;
+};
+
+void TaskGraph::add(std::string name, std::function<void()> task, std::vector<std::string> dependencies)
+{
+    DEBUG_ASSERT(!contains(name), "A task named '" + name + "' was already added.");
+
+    size_t index = nodes.size();
+
+    Node node;
+    node.name = name;
+    node.task = std::move(task);
+
+    for (const auto &dependency : dependencies)
+    {
+        auto found = indices.find(dependency);
+        if (found == indices.end())
+        {
+            ABORT_PROGRAM("The task '" << name << "' depends on '" << dependency << "', which has not been added.");
+        }
+
+        nodes[found->second].dependents.emplace_back(index);
+        ++node.dependencyCount;
+    }
+
+    nodes.emplace_back(std::move(node));
+    indices.emplace(std::move(name), index);
+}
+
+bool TaskGraph::contains(const std::string &name) const
+{
+    return indices.find(name) != indices.end();
+}
+
+void TaskGraph::run(uint32_t threadCount)
+{
+    _timings.clear();
+    for (const auto &node : nodes)
+    {
+        _timings.emplace_back(Timing{node.name});
+    }
+
+    RunState state{nodes, _timings};
+    for (const auto &node : nodes)
+    {
+        state.remainingDependencies.emplace_back(node.dependencyCount);
+    }
+
+    {
+        if (threadCount == 0)
+        {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        // Tasks submit their dependents before they finish, so the pool is only idle once every task has run.
+        ThreadPool threadPool(std::min<uint32_t>(threadCount, static_cast<uint32_t>(std::max<size_t>(nodes.size(), 1))));
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            if (nodes[i].dependencyCount == 0)
+            {
+                submit(threadPool, state, i);
+            }
+        }
+
+        threadPool.waitIdle();
+    }
+
+    _totalMillis = state.start.elapsedNanos() / 1e6;
+
+    if (state.error)
+    {
+        std::rethrow_exception(state.error);
+    }
+}
+
+void TaskGraph::submit(ThreadPool &threadPool, RunState &state, size_t index)
+{
+    threadPool.submit([&threadPool, &state, index]() {
+        Timing &timing = state.timings[index];
+
+        bool failed;
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            failed = state.error != nullptr;
+        }
+
+        TimePoint start;
+        timing.startMillis = state.start.elapsedNanos() / 1e6;
+        timing.skipped = failed;
+
+        if (!failed)
+        {
+            try
+            {
+                state.nodes[index].task();
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(state.mutex);
+                if (!state.error)
+                {
+                    state.error = std::current_exception();
+                }
+            }
+        }
+
+        timing.millis = start.elapsedNanos() / 1e6;
+
+        std::vector<size_t> ready;
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            for (size_t dependent : state.nodes[index].dependents)
+            {
+                if (--state.remainingDependencies[dependent] == 0)
+                {
+                    ready.emplace_back(dependent);
+                }
+            }
+        }
+
+        for (size_t dependent : ready)
+        {
+            submit(threadPool, state, dependent);
+        }
+    });
+}
+
+const std::vector<TaskGraph::Timing> &TaskGraph::timings() const noexcept
+{
+    return _timings;
+}
+
+double TaskGraph::totalMillis() const noexcept
+{
+    return _totalMillis;
+}
+
+void TaskGraph::logTimings(const std::string &title) const
+{
+    std::vector<const Timing *> byStart;
+    double workMillis = 0;
+    for (const auto &timing : _timings)
+    {
+        byStart.emplace_back(&timing);
+        workMillis += timing.millis;
+    }
+
+    std::sort(byStart.begin(), byStart.end(), [](const Timing *a, const Timing *b) { return a->startMillis < b->startMillis; });
+
+    std::ostringstream s;
+    s << std::fixed << std::setprecision(1);
+    s << title << " took " << _totalMillis << " ms (" << workMillis << " ms in " << _timings.size() << " tasks):";
+
+    for (const Timing *timing : byStart)
+    {
+        s << std::endl
+          << "    " << std::setw(8) << timing->startMillis << " ms  +" << std::setw(8) << timing->millis << " ms  " << timing->name;
+        if (timing->skipped)
+        {
+            s << " (skipped)";
+        }
+    }
+
+    VME_LOG(s.str());
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "util.h"
+
+class ThreadPool;
+
+/*
+	A set of named tasks with dependencies between them, used to load independent parts of the editor in parallel
+	at startup. run starts every task on a thread pool as soon as the tasks that it depends on have finished, and
+	records when each task started and how long it took.
+
+	Dependencies must be added before the tasks that depend on them, so a graph can not contain cycles.
+*/
+class TaskGraph
+{
+  public:
+    struct Timing
+    {
+        std::string name;
+
+        // Relative to the start of run
+        double startMillis = 0;
+        double millis = 0;
+        bool skipped = false;
+    };
+
+    void add(std::string name, std::function<void()> task, std::vector<std::string> dependencies = {});
+
+    bool contains(const std::string &name) const;
+
+    /*
+		Runs all tasks and blocks until they are done. A threadCount of 0 uses one thread per hardware thread.
+
+		If a task throws, the tasks that were not started yet are skipped and the first exception is rethrown once
+		the running tasks have finished.
+	*/
+    void run(uint32_t threadCount = 0);
+
+    // Timings of the last run, in the order the tasks were added
+    const std::vector<Timing> &timings() const noexcept;
+    double totalMillis() const noexcept;
+
+    void logTimings(const std::string &title) const;
+
+  private:
+    struct Node
+    {
+        std::string name;
+        std::function<void()> task;
+        uint32_t dependencyCount = 0;
+        std::vector<size_t> dependents;
+    };
+
+    struct RunState;
+
+    static void submit(ThreadPool &threadPool, RunState &state, size_t index);
+
+    std::vector<Node> nodes;
+    vme_unordered_map<std::string, size_t> indices;
+
+    std::vector<Timing> _timings;
+    double _totalMillis = 0;
+};
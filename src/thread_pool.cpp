@@ -0,0 +1,138 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <exception>
+
+#include "logger.h"
+
+ThreadPool::ThreadPool(uint32_t threadCount, size_t maxQueuedTasks)
+    : maxQueuedTasks(maxQueuedTasks)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    workers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        workers.emplace_back(&ThreadPool::run, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (maxQueuedTasks != 0)
+        {
+            taskTaken.wait(lock, [this] { return tasks.size() < maxQueuedTasks; });
+        }
+
+        tasks.emplace_back(std::move(task));
+    }
+
+    taskAvailable.notify_one();
+}
+
+void ThreadPool::waitIdle()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return tasks.empty() && runningTasks == 0; });
+}
+
+uint32_t ThreadPool::threadCount() const noexcept
+{
+    return static_cast<uint32_t>(workers.size());
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)> &f)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    std::vector<std::exception_ptr> errors(count);
+    {
+        uint32_t threadCount = static_cast<uint32_t>(std::min<size_t>(count, std::max(std::thread::hardware_concurrency(), 1u)));
+        ThreadPool pool(threadCount);
+        for (size_t i = 0; i < count; ++i)
+        {
+            pool.submit([&f, &errors, i]() {
+                try
+                {
+                    f(i);
+                }
+                catch (...)
+                {
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+        pool.waitIdle();
+    }
+
+    for (auto &error : errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+void ThreadPool::run()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            taskAvailable.wait(lock, [this] { return stopping || !tasks.empty(); });
+
+            if (tasks.empty())
+            {
+                // Stopping and all tasks are done
+                return;
+            }
+
+            task = std::move(tasks.front());
+            tasks.pop_front();
+            ++runningTasks;
+        }
+        taskTaken.notify_one();
+
+        try
+        {
+            task();
+        }
+        catch (const std::exception &exception)
+        {
+            VME_LOG_ERROR("[ThreadPool] A task threw an exception: " << exception.what());
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --runningTasks;
+            if (tasks.empty() && runningTasks == 0)
+            {
+                idle.notify_all();
+            }
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+	A fixed set of worker threads that run submitted tasks in FIFO order.
+
+	If maxQueuedTasks is non-zero, submit blocks while that many tasks are waiting. This bounds the memory held by
+	queued tasks when a producer is faster than the workers.
+*/
+class ThreadPool
+{
+  public:
+    /*
+		A threadCount of 0 uses one thread per hardware thread.
+	*/
+    explicit ThreadPool(uint32_t threadCount = 0, size_t maxQueuedTasks = 0);
+
+    /*
+		Runs all queued tasks before joining the workers.
+	*/
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    void submit(std::function<void()> task);
+
+    /*
+		Blocks until the queue is empty and no task is running.
+	*/
+    void waitIdle();
+
+    uint32_t threadCount() const noexcept;
+
+    /*
+		Runs f(0) to f(count - 1) on a temporary pool with at most one thread per hardware thread, and returns when
+		all of them are done. submit only logs exceptions; here the first exception thrown by f is rethrown on the
+		calling thread.
+	*/
+    static void parallelFor(size_t count, const std::function<void(size_t)> &f);
+
+  private:
+    void run();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    std::condition_variable taskTaken;
+    std::condition_variable idle;
+
+    size_t maxQueuedTasks;
+    uint32_t runningTasks = 0;
+    bool stopping = false;
+};
@@ -19,7 +19,7 @@ class TimePoint
     }
 
     template <typename T>
-    TimePoint addTime(time_t delta)
+    TimePoint addTime(time_t delta) const
     {
         auto rawTime = std::chrono::time_point_cast<T>(this->timePoint).time_since_epoch().count() + delta;
         std::chrono::time_point<std::chrono::steady_clock> result(T{rawTime});
@@ -28,18 +28,18 @@ class TimePoint
     }
 
     template <typename T>
-    TimePoint back(time_t delta)
+    TimePoint back(time_t delta) const
     {
         return addTime<T>(-delta);
     }
 
     template <typename T>
-    TimePoint forward(time_t delta)
+    TimePoint forward(time_t delta) const
     {
         return addTime<T>(delta);
     }
 
-    TimePoint forwardMs(time_t delta)
+    TimePoint forwardMs(time_t delta) const
     {
         return addTime<std::chrono::milliseconds>(delta);
     }
@@ -49,6 +49,11 @@ class TimePoint
     time_t elapsedNanos() const;
     time_t elapsedMillis(TimePoint start) const;
 
+    bool operator<(const TimePoint &other) const noexcept
+    {
+        return timePoint < other.timePoint;
+    }
+
   private:
     std::chrono::steady_clock::time_point timePoint;
 };
@@ -0,0 +1,157 @@
+#include "trace.h"
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "logger.h"
+
+std::atomic<bool> Trace::recording = false;
+
+namespace
+{
+    struct Span
+    {
+        const char *name;
+        TimePoint::time_t start;
+        TimePoint::time_t duration;
+    };
+
+    /*
+		Only its own thread appends to a buffer. The mutex is locked by the owning thread for every span, which is
+		uncontended except while the trace is cleared or written.
+	*/
+    struct ThreadBuffer
+    {
+        uint32_t threadId;
+        std::mutex mutex;
+        std::vector<Span> spans;
+        uint64_t dropped = 0;
+    };
+
+    std::mutex buffersMutex;
+    /*
+		Shared, so that the spans of a thread that exits are kept until the trace is written. A buffer that only this
+		list holds belongs to a thread that exited, and is released when the trace is cleared.
+	*/
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    uint32_t nextThreadId = 1;
+
+    ThreadBuffer &threadBuffer()
+    {
+        thread_local std::shared_ptr<ThreadBuffer> buffer = []() {
+            auto buffer = std::make_shared<ThreadBuffer>();
+
+            std::lock_guard<std::mutex> lock(buffersMutex);
+            buffer->threadId = nextThreadId++;
+            buffers.emplace_back(buffer);
+
+            return buffer;
+        }();
+
+        return *buffer;
+    }
+
+    void writeEscaped(std::ostream &stream, const char *s)
+    {
+        for (; *s; ++s)
+        {
+            if (*s == '"' || *s == '\\')
+            {
+                stream << '\\';
+            }
+            stream << *s;
+        }
+    }
+} // namespace
+
+void Trace::start()
+{
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        std::erase_if(buffers, [](const std::shared_ptr<ThreadBuffer> &buffer) { return buffer.use_count() == 1; });
+
+        for (auto &buffer : buffers)
+        {
+            std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+            buffer->spans.clear();
+            buffer->dropped = 0;
+        }
+    }
+
+    recording.store(true, std::memory_order_relaxed);
+}
+
+void Trace::stop()
+{
+    recording.store(false, std::memory_order_relaxed);
+}
+
+void Trace::record(const char *name, TimePoint start)
+{
+    TimePoint::time_t duration = start.elapsedMicros();
+    TimePoint::time_t startMicros = start.timeSince<std::chrono::microseconds>(TimePoint::sinceStart());
+
+    ThreadBuffer &buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    if (buffer.spans.size() < Trace::MaxSpansPerThread)
+    {
+        buffer.spans.emplace_back(Span{name, startMicros, duration});
+    }
+    else
+    {
+        ++buffer.dropped;
+    }
+}
+
+uint64_t Trace::droppedSpans()
+{
+    uint64_t dropped = 0;
+
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    for (auto &buffer : buffers)
+    {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        dropped += buffer->dropped;
+    }
+
+    return dropped;
+}
+
+bool Trace::write(const std::filesystem::path &path)
+{
+    std::ofstream stream(path, std::ios::out | std::ios::trunc);
+
+    stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    bool first = true;
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        for (auto &buffer : buffers)
+        {
+            std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+            for (const Span &span : buffer->spans)
+            {
+                stream << (first ? "\n" : ",\n");
+                first = false;
+
+                stream << "{\"name\":\"";
+                writeEscaped(stream, span.name);
+                stream << "\",\"cat\":\"vme\",\"ph\":\"X\",\"ts\":" << span.start
+                       << ",\"dur\":" << span.duration
+                       << ",\"pid\":1,\"tid\":" << buffer->threadId << '}';
+            }
+        }
+    }
+
+    stream << "\n]}\n";
+
+    if (!stream)
+    {
+        VME_LOG_ERROR("Could not write the trace " << path.string());
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+#include "time_util.h"
+
+/*
+	Records timed spans (VME_TRACE_SCOPE) and exports them in the Chrome trace event format. The file can be opened
+	in chrome://tracing or https://ui.perfetto.dev.
+
+	Every thread records into a buffer of its own, so spans on worker threads do not contend with each other. A span
+	costs one relaxed load while tracing is stopped.
+*/
+class Trace
+{
+  public:
+    // About 24 MB per thread. Later spans of the thread are dropped.
+    static constexpr size_t MaxSpansPerThread = 1 << 20;
+
+    /*
+		Records the time from construction to destruction as one span. The name must outlive the trace (use string
+		literals).
+	*/
+    class Scope
+    {
+      public:
+        Scope(const char *name)
+            : name(enabled() ? name : nullptr), start(this->name ? TimePoint::now() : TimePoint(std::chrono::steady_clock::time_point{})) {}
+
+        ~Scope()
+        {
+            if (name)
+            {
+                record(name, start);
+            }
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+      private:
+        const char *name;
+        TimePoint start;
+    };
+
+    // Clears the recorded spans, including those of threads that exited, and starts recording
+    static void start();
+    static void stop();
+
+    static bool enabled()
+    {
+        return recording.load(std::memory_order_relaxed);
+    }
+
+    // Writes the spans recorded so far as a JSON trace. Returns false if the file could not be written.
+    static bool write(const std::filesystem::path &path);
+
+    // The number of spans that were not recorded because a thread buffer was full
+    static uint64_t droppedSpans();
+
+  private:
+    static void record(const char *name, TimePoint start);
+
+    static std::atomic<bool> recording;
+};
+
+#define VME_TRACE_CONCAT_INNER(a, b) a##b
+#define VME_TRACE_CONCAT(a, b) VME_TRACE_CONCAT_INNER(a, b)
+
+#ifdef VME_DISABLE_TRACING
+#define VME_TRACE_SCOPE(name) \
+    do                        \
+    {                         \
+    } while (0)
+#else
+#define VME_TRACE_SCOPE(name) Trace::Scope VME_TRACE_CONCAT(__vme_trace_scope_, __COUNTER__)(name)
+#endif
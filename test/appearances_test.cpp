@@ -0,0 +1,113 @@
+#include "catch.hpp"
+
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/graphics/appearances.h"
+#include "../src/graphics/texture_atlas.h"
+#include "../src/items.h"
+
+namespace
+{
+    // A serialized frame group with one sprite from each atlas
+    std::string encodeFrameGroup(const std::vector<uint32_t> &spriteIds)
+    {
+        proto::FrameGroup group;
+        group.set_fixed_frame_group(proto::appearances::FIXED_FRAME_GROUP_OBJECT_INITIAL);
+        group.set_id(0);
+
+        proto::SpriteInfo *spriteInfo = group.mutable_sprite_info();
+        spriteInfo->set_layers(1);
+        spriteInfo->set_pattern_width(static_cast<uint32_t>(spriteIds.size()));
+        spriteInfo->set_pattern_height(1);
+        spriteInfo->set_pattern_depth(1);
+        for (uint32_t spriteId : spriteIds)
+        {
+            spriteInfo->add_sprite_id(spriteId);
+        }
+
+        return group.SerializeAsString();
+    }
+
+    std::span<const uint8_t> bytes(const std::string &encoded)
+    {
+        return std::span<const uint8_t>(reinterpret_cast<const uint8_t *>(encoded.data()), encoded.size());
+    }
+} // namespace
+
+TEST_CASE("appearances.h", "[rendering]")
+{
+    TextureAtlas *first = Items::items.getItemTypeByServerId(4526)->getFirstTextureAtlas();
+    TextureAtlas *second = Appearances::getTextureAtlas(first->lastSpriteId + 1);
+    REQUIRE(second != nullptr);
+
+    std::vector<uint32_t> spriteIds{first->firstSpriteId, second->firstSpriteId};
+    std::string encoded = encodeFrameGroup(spriteIds);
+
+    ObjectAppearance appearance(100000, "lazy", nullptr, bytes(encoded));
+
+    SECTION("The first sprite ID is read without decoding the frame group")
+    {
+        REQUIRE_FALSE(appearance.isDecoded());
+        REQUIRE(appearance.getFirstSpriteId() == first->firstSpriteId);
+
+        // Caching the texture atlases does not decode it
+        appearance.cacheTextureAtlases();
+        REQUIRE_FALSE(appearance.isDecoded());
+    }
+
+    SECTION("The frame group is decoded on first access")
+    {
+        const SpriteInfo &spriteInfo = appearance.getSpriteInfo();
+        REQUIRE(appearance.isDecoded());
+
+        REQUIRE(spriteInfo.spriteIds == spriteIds);
+        REQUIRE(spriteInfo.layers == 1);
+        REQUIRE(spriteInfo.patternSize == 2);
+        REQUIRE(appearance.frameGroupCount() == 1);
+
+        // Its atlases are cached when it is decoded
+        REQUIRE(appearance.atlases()[0] == first);
+        REQUIRE(appearance.atlases()[1] == second);
+    }
+
+    SECTION("Accessing the atlases decodes the frame group")
+    {
+        appearance.cacheTextureAtlases();
+
+        REQUIRE(appearance.atlases()[0] == first);
+        REQUIRE(appearance.isDecoded());
+        REQUIRE(appearance.atlases()[1] == second);
+    }
+
+    SECTION("Threads that access the frame group at the same time see one decoded frame group")
+    {
+        constexpr int ThreadCount = 8;
+
+        std::vector<const SpriteInfo *> seen(ThreadCount);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < ThreadCount; ++i)
+        {
+            threads.emplace_back([&appearance, &seen, i]() { seen[i] = &appearance.getSpriteInfo(); });
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+
+        REQUIRE(appearance.frameGroupCount() == 1);
+        for (const SpriteInfo *spriteInfo : seen)
+        {
+            REQUIRE(spriteInfo == &appearance.getSpriteInfo());
+        }
+    }
+
+    SECTION("An object without a frame group is decoded from the start")
+    {
+        ObjectAppearance empty(100001, "empty", nullptr, {});
+        REQUIRE(empty.isDecoded());
+        REQUIRE(empty.frameGroupCount() == 0);
+    }
+}
@@ -0,0 +1,97 @@
+#include "catch.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "../src/graphics/atlas_decompressor.h"
+#include "../src/graphics/texture_atlas.h"
+#include "../src/graphics/texture_atlas_cache.h"
+#include "../src/items.h"
+#include "../src/settings.h"
+
+namespace
+{
+    // Evicts every atlas that is not protected by a renderer
+    void evictAll(TextureAtlasCache::RendererFrames &renderer)
+    {
+        size_t budget = Settings::TEXTURE_ATLAS_MEMORY_BUDGET;
+        Settings::TEXTURE_ATLAS_MEMORY_BUDGET = 0;
+
+        TextureAtlasCache::beginFrame(renderer);
+        TextureAtlasCache::beginFrame(renderer);
+
+        Settings::TEXTURE_ATLAS_MEMORY_BUDGET = budget;
+    }
+
+    // Waits until a worker calls the wake-up, like the main thread waits for the event it posts
+    bool waitForWakeUp(const std::atomic<int> &wakeUps, int count)
+    {
+        for (int i = 0; i < 1000; ++i)
+        {
+            if (wakeUps >= count)
+            {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        return false;
+    }
+} // namespace
+
+TEST_CASE("atlas_decompressor.h", "[rendering]")
+{
+    static std::atomic<int> wakeUps = 0;
+    wakeUps = 0;
+    AtlasDecompressor::setWakeUp([]() { ++wakeUps; });
+
+    TextureAtlas *atlas = Items::items.getItemTypeByServerId(4526)->getFirstTextureAtlas();
+
+    TextureAtlasCache::RendererFrames renderer;
+    evictAll(renderer);
+    REQUIRE(atlas->isCompressed());
+
+    AtlasDecompressor::request(atlas);
+    REQUIRE(AtlasDecompressor::hasPending());
+    REQUIRE(atlas->decompressionPending());
+
+    SECTION("A finished decompression wakes up the main thread, which installs it")
+    {
+        REQUIRE(waitForWakeUp(wakeUps, 1));
+
+        // The atlas stays compressed until it is installed on the main thread
+        REQUIRE(atlas->isCompressed());
+
+        REQUIRE(AtlasDecompressor::installFinished() == 1);
+        REQUIRE_FALSE(atlas->isCompressed());
+        REQUIRE_FALSE(atlas->decompressionPending());
+        REQUIRE_FALSE(AtlasDecompressor::hasPending());
+
+        // A decompressed atlas is not queued again
+        AtlasDecompressor::request(atlas);
+        REQUIRE_FALSE(AtlasDecompressor::hasPending());
+        REQUIRE(wakeUps == 1);
+    }
+
+    SECTION("A pending atlas is queued once")
+    {
+        AtlasDecompressor::request(atlas);
+        REQUIRE(waitForWakeUp(wakeUps, 1));
+        REQUIRE(AtlasDecompressor::installFinished() == 1);
+        REQUIRE(wakeUps == 1);
+    }
+
+    SECTION("A synchronous decompression takes over the pending one")
+    {
+        atlas->getOrCreateTexture();
+        REQUIRE_FALSE(atlas->isCompressed());
+        REQUIRE_FALSE(atlas->decompressionPending());
+
+        REQUIRE(waitForWakeUp(wakeUps, 1));
+        REQUIRE(AtlasDecompressor::installFinished() == 0);
+        REQUIRE_FALSE(AtlasDecompressor::hasPending());
+    }
+
+    AtlasDecompressor::setWakeUp(nullptr);
+}
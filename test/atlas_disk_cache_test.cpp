@@ -0,0 +1,111 @@
+#include "catch.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <vector>
+
+#include "../src/graphics/atlas_disk_cache.h"
+#include "test_files.h"
+
+namespace
+{
+    std::vector<uint8_t> atlasPixels(uint8_t value)
+    {
+        return std::vector<uint8_t>(64 * 64 * 4, value);
+    }
+
+    // The entry of an atlas file is named after it
+    std::filesystem::path entryPath(const TestFiles::TemporaryDirectory &cacheDirectory, const std::filesystem::path &atlasFile)
+    {
+        std::filesystem::path path = cacheDirectory / atlasFile.filename();
+        path += ".rgba";
+        return path;
+    }
+} // namespace
+
+TEST_CASE("atlas_disk_cache.h", "[rendering]")
+{
+    TestFiles::TemporaryDirectory directory("vme_atlas_disk_cache_test");
+    TestFiles::TemporaryDirectory cacheDirectory("vme_atlas_disk_cache_test_entries");
+
+    std::filesystem::path atlasFile = directory / "sprites-0123abcd.bmp.lzma";
+    TestFiles::write(atlasFile, "compressed atlas");
+
+    auto pixels = atlasPixels(7);
+
+    AtlasDiskCache::open(cacheDirectory.path, "12.60");
+    REQUIRE(AtlasDiskCache::isOpen());
+
+    AtlasDiskCache::Statistics before = AtlasDiskCache::statistics();
+
+    REQUIRE_FALSE(AtlasDiskCache::read(atlasFile));
+    AtlasDiskCache::write(atlasFile, pixels);
+    REQUIRE(std::filesystem::exists(entryPath(cacheDirectory, atlasFile)));
+
+    SECTION("Pixels are read back from the entry")
+    {
+        auto cached = AtlasDiskCache::read(atlasFile);
+        REQUIRE(cached);
+        REQUIRE(*cached == pixels);
+
+        AtlasDiskCache::Statistics after = AtlasDiskCache::statistics();
+        REQUIRE(after.hits == before.hits + 1);
+        REQUIRE(after.misses == before.misses + 1);
+        REQUIRE(after.writeFailures == before.writeFailures);
+    }
+
+    SECTION("A rewritten entry replaces the old one")
+    {
+        auto changed = atlasPixels(9);
+        AtlasDiskCache::write(atlasFile, changed);
+        REQUIRE(*AtlasDiskCache::read(atlasFile) == changed);
+    }
+
+    SECTION("The entry of a changed atlas file is ignored")
+    {
+        TestFiles::write(atlasFile, "a longer compressed atlas");
+        REQUIRE_FALSE(AtlasDiskCache::read(atlasFile));
+    }
+
+    SECTION("The entry of an atlas file with another modification time is ignored")
+    {
+        auto modified = std::filesystem::last_write_time(atlasFile);
+        std::filesystem::last_write_time(atlasFile, modified + std::chrono::seconds(1));
+        REQUIRE_FALSE(AtlasDiskCache::read(atlasFile));
+    }
+
+    SECTION("The entry of another client version is ignored")
+    {
+        AtlasDiskCache::open(cacheDirectory.path, "13.00");
+        REQUIRE_FALSE(AtlasDiskCache::read(atlasFile));
+
+        AtlasDiskCache::open(cacheDirectory.path, "12.60");
+        REQUIRE(AtlasDiskCache::read(atlasFile));
+    }
+
+    SECTION("The entry of another format version is ignored")
+    {
+        TestFiles::overwrite(entryPath(cacheDirectory, atlasFile), AtlasDiskCache::FormatVersionOffset, static_cast<uint32_t>(AtlasDiskCache::FormatVersion + 1));
+        REQUIRE_FALSE(AtlasDiskCache::read(atlasFile));
+    }
+
+    SECTION("An entry that was cut short is ignored")
+    {
+        std::filesystem::resize_file(entryPath(cacheDirectory, atlasFile), pixels.size() / 2);
+        REQUIRE_FALSE(AtlasDiskCache::read(atlasFile));
+    }
+
+    SECTION("Nothing is read or written while the cache is closed")
+    {
+        AtlasDiskCache::close();
+        REQUIRE_FALSE(AtlasDiskCache::isOpen());
+        REQUIRE_FALSE(AtlasDiskCache::read(atlasFile));
+
+        std::filesystem::remove(entryPath(cacheDirectory, atlasFile));
+        AtlasDiskCache::write(atlasFile, pixels);
+        REQUIRE_FALSE(std::filesystem::exists(entryPath(cacheDirectory, atlasFile)));
+    }
+
+    // The atlases of later tests are decompressed without the cache
+    AtlasDiskCache::close();
+}
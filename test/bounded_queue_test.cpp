@@ -0,0 +1,81 @@
+#include "catch.hpp"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/bounded_queue.h"
+
+TEST_CASE("bounded_queue.h", "[util]")
+{
+    SECTION("Values are popped in order until the queue is empty")
+    {
+        BoundedQueue<std::string> queue(3);
+        REQUIRE(queue.capacity() == 4);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            REQUIRE(queue.push(std::to_string(i)));
+        }
+
+        // Full: the value is not taken
+        std::string value = "4";
+        REQUIRE_FALSE(queue.push(std::move(value)));
+        REQUIRE(value == "4");
+
+        for (int i = 0; i < 4; ++i)
+        {
+            REQUIRE(queue.pop(value));
+            REQUIRE(value == std::to_string(i));
+        }
+
+        REQUIRE_FALSE(queue.pop(value));
+    }
+
+    SECTION("Every value pushed by several threads is popped once")
+    {
+        constexpr int Producers = 4;
+        constexpr int ValuesPerProducer = 10000;
+
+        BoundedQueue<int> queue(64);
+        std::vector<std::atomic<int>> popped(Producers * ValuesPerProducer);
+
+        std::vector<std::thread> producers;
+        for (int producer = 0; producer < Producers; ++producer)
+        {
+            producers.emplace_back([&queue, producer]() {
+                for (int i = 0; i < ValuesPerProducer; ++i)
+                {
+                    while (!queue.push(producer * ValuesPerProducer + i))
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        int remaining = Producers * ValuesPerProducer;
+        while (remaining != 0)
+        {
+            int value;
+            if (queue.pop(value))
+            {
+                ++popped[value];
+                --remaining;
+            }
+        }
+
+        for (std::thread &producer : producers)
+        {
+            producer.join();
+        }
+
+        int value;
+        REQUIRE_FALSE(queue.pop(value));
+        for (const auto &count : popped)
+        {
+            REQUIRE(count == 1);
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#include "catch.hpp"
+
+#include <filesystem>
+
+#include "../src/brushes/brush_database.h"
+#include "../src/brushes/brush_loader.h"
+#include "test_files.h"
+
+TEST_CASE("brush_database.h", "[core]")
+{
+    TestFiles::TemporaryDirectory directory("vme_brush_database_test");
+
+    std::filesystem::path databaseFile = directory / "brushes.vmedb";
+    std::filesystem::path grounds = directory / "grounds.json";
+    std::filesystem::path walls = directory / "walls.json";
+
+    // Comments are allowed in brush files
+    TestFiles::write(grounds, R"({
+    // A comment
+    "brushes": [{ "id": "grass", "type": "ground", "lookId": 4526, "zOrder": 3500, "items": [{ "id": 4526, "chance": 2500 }] }]
+})");
+    TestFiles::write(walls, R"({ "brushes": [{ "id": "stone wall", "type": "wall", "lookId": 1050, "thickness": 1.5, "enabled": true }] })");
+
+    {
+        BrushDatabase database(databaseFile, {grounds, walls});
+        REQUIRE(database.compile() == 2);
+    }
+    REQUIRE(std::filesystem::exists(databaseFile));
+
+    SECTION("Documents read from the database equal the parsed sources")
+    {
+        BrushDatabase database(databaseFile, {grounds, walls});
+        REQUIRE(database.compile() == 0);
+
+        REQUIRE(database.compiledDocument(grounds));
+        REQUIRE(database.compiledDocument(walls));
+        REQUIRE(*database.compiledDocument(grounds) == BrushLoader::parseFile(grounds));
+        REQUIRE(*database.compiledDocument(walls) == BrushLoader::parseFile(walls));
+    }
+
+    SECTION("Only a changed source is parsed again")
+    {
+        TestFiles::write(walls, R"({ "brushes": [{ "id": "wooden wall", "type": "wall", "lookId": 1100 }] })");
+
+        BrushDatabase database(databaseFile, {grounds, walls});
+        REQUIRE(database.compile() == 1);
+        REQUIRE(database.compiledDocument(walls)->at("brushes")[0].at("id") == "wooden wall");
+
+        // The database was rewritten with the new document
+        BrushDatabase reloaded(databaseFile, {grounds, walls});
+        REQUIRE(reloaded.compile() == 0);
+        REQUIRE(*reloaded.compiledDocument(walls) == BrushLoader::parseFile(walls));
+    }
+
+    SECTION("A damaged database is parsed again")
+    {
+        std::filesystem::resize_file(databaseFile, std::filesystem::file_size(databaseFile) - 8);
+
+        BrushDatabase database(databaseFile, {grounds, walls});
+        REQUIRE(database.compile() == 1);
+        REQUIRE(*database.compiledDocument(grounds) == BrushLoader::parseFile(grounds));
+        REQUIRE(*database.compiledDocument(walls) == BrushLoader::parseFile(walls));
+    }
+
+    SECTION("A database of another format version is parsed again")
+    {
+        TestFiles::overwrite(databaseFile, BrushDatabase::FormatVersionOffset, static_cast<uint32_t>(BrushDatabase::FormatVersion + 1));
+
+        BrushDatabase database(databaseFile, {grounds, walls});
+        REQUIRE(database.compile() == 2);
+    }
+}
@@ -0,0 +1,163 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "../src/brushes/brush_search.h"
+#include "../src/brushes/ground_brush.h"
+#include "../src/brushes/raw_brush.h"
+
+#define FTS_FUZZY_MATCH_IMPLEMENTATION
+#include "../vendor/fts_fuzzy_match/fts_fuzzy_match.h"
+
+namespace
+{
+    std::vector<Brush *> runSearch(BrushSearch &search, size_t batchSize = BrushSearch::DefaultBatchSize)
+    {
+        std::vector<Brush *> matches;
+        REQUIRE(search.run([&matches](BrushSearchResult &&batch) {
+            matches.insert(matches.end(), batch.matches->begin(), batch.matches->end());
+        },
+                           batchSize));
+        REQUIRE(search.finished());
+
+        return matches;
+    }
+
+    int score(const std::string &query, const Brush *brush)
+    {
+        int result = 1;
+        fts::fuzzy_match(query.c_str(), brush->name().c_str(), result);
+        return result;
+    }
+
+    // The brushes that the search looked at before the index, matched the same way
+    size_t countMatches(const std::string &query)
+    {
+        size_t count = 0;
+        int unused;
+        for (const auto &[serverId, brush] : Brush::getRawBrushes())
+        {
+            if (fts::fuzzy_match(query.c_str(), brush->name().c_str(), unused) || std::to_string(serverId).find(query) != std::string::npos)
+            {
+                ++count;
+            }
+        }
+        for (const auto &[_, brush] : Brush::getGroundBrushes())
+        {
+            if (fts::fuzzy_match(query.c_str(), brush->name().c_str(), unused))
+            {
+                ++count;
+            }
+        }
+
+        return count;
+    }
+
+    bool contains(const std::vector<Brush *> &brushes, const Brush *brush)
+    {
+        return std::find(brushes.begin(), brushes.end(), brush) != brushes.end();
+    }
+} // namespace
+
+TEST_CASE("brush_search.h", "[core]")
+{
+    Brush *grass = Brush::getOrCreateRawBrush(4526);
+    Brush *shovel = Brush::getOrCreateRawBrush(2554);
+    Brush::getOrCreateRawBrush(2148);
+
+    if (!Brush::getGroundBrush("search_test_ground"))
+    {
+        Brush::addGroundBrush(GroundBrush("search_test_ground", "Search test ground", {WeightedItemId(4527, 1)}));
+        Brush::addGroundBrush(GroundBrush("search_test_sand", "Sandy search test ground", {WeightedItemId(4528, 1)}));
+    }
+
+    auto index = Brush::searchIndex();
+    REQUIRE(index->upToDate());
+
+    SECTION("Results are ordered by brush type, raw brushes by server ID and others by score")
+    {
+        for (std::string query : {"gr", "search", "4526"})
+        {
+            BrushSearch search(index, query);
+            std::vector<Brush *> matches = runSearch(search);
+            REQUIRE(matches.size() == countMatches(query));
+
+            for (size_t i = 1; i < matches.size(); ++i)
+            {
+                const Brush *previous = matches[i - 1];
+                const Brush *brush = matches[i];
+                REQUIRE(to_underlying(previous->type()) <= to_underlying(brush->type()));
+
+                if (previous->type() == brush->type())
+                {
+                    if (brush->type() == BrushType::Raw)
+                    {
+                        REQUIRE(static_cast<const RawBrush *>(previous)->serverId() < static_cast<const RawBrush *>(brush)->serverId());
+                    }
+                    else
+                    {
+                        REQUIRE(score(query, previous) <= score(query, brush));
+                    }
+                }
+            }
+        }
+    }
+
+    SECTION("A numeric query matches raw brushes by server ID")
+    {
+        BrushSearch search(index, "4526");
+        std::vector<Brush *> matches = runSearch(search);
+
+        REQUIRE(contains(matches, grass));
+        REQUIRE_FALSE(contains(matches, shovel));
+    }
+
+    SECTION("A search that extends a finished query gives the same results as a full search")
+    {
+        auto previous = std::make_shared<BrushSearch>(index, "s");
+        runSearch(*previous);
+
+        for (std::string query : {"se", "search test", "sandy"})
+        {
+            BrushSearch refined(index, query, previous);
+            BrushSearch full(index, query);
+            REQUIRE(runSearch(refined) == runSearch(full));
+        }
+
+        // A query that does not extend the previous one is not limited to its matches
+        BrushSearch other(index, "grass", previous);
+        std::vector<Brush *> matches = runSearch(other);
+        REQUIRE(contains(matches, grass));
+    }
+
+    SECTION("A search does not refine an unfinished search")
+    {
+        auto cancelled = std::make_shared<BrushSearch>(index, "s");
+        cancelled->cancel();
+        REQUIRE_FALSE(cancelled->run([](BrushSearchResult &&) {}));
+        REQUIRE_FALSE(cancelled->finished());
+
+        BrushSearch search(index, "search", cancelled);
+        BrushSearch full(index, "search");
+        REQUIRE(runSearch(search) == runSearch(full));
+    }
+
+    SECTION("Batches hold at most batchSize matches and count only their own matches")
+    {
+        BrushSearch search(index, "search");
+
+        size_t total = 0;
+        REQUIRE(search.run([&total](BrushSearchResult &&batch) {
+            REQUIRE(batch.matches->size() == 1);
+            REQUIRE(batch.rawCount + batch.groundCount + batch.doodadCount + batch.creatureCount == 1);
+            ++total;
+        },
+                           1));
+
+        BrushSearch full(index, "search");
+        REQUIRE(total == runSearch(full).size());
+        REQUIRE(total >= 2);
+    }
+}
@@ -0,0 +1,114 @@
+#include "catch.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <tuple>
+
+#include "../src/client_data_cache.h"
+#include "../src/items.h"
+#include "test_files.h"
+
+namespace
+{
+    // Moves the modification time of a file an hour ahead, without changing its contents
+    void touch(const std::filesystem::path &path)
+    {
+        std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + std::chrono::hours(1));
+    }
+
+    ClientDataCache::SourceCheck checkSources(const std::filesystem::path &cacheFile, const ClientDataCache::SourceFiles &sourceFiles)
+    {
+        // A new cache every time, since a cache keeps the source hashes it computed
+        return ClientDataCache(cacheFile, sourceFiles).checkSources();
+    }
+
+    auto itemTypeFields(uint32_t serverId)
+    {
+        const ItemType &itemType = *Items::items.getItemTypeByServerId(serverId);
+        return std::make_tuple(
+            itemType.name(),
+            itemType.article,
+            itemType.description,
+            itemType.group,
+            itemType.type,
+            itemType.weight,
+            itemType.stackOrder,
+            itemType.flags,
+            itemType.stackable,
+            itemType.pickupable,
+            itemType.clientId(),
+            itemType.getFirstTextureAtlas());
+    }
+} // namespace
+
+TEST_CASE("client_data_cache.h", "[core]")
+{
+    using SourceCheck = ClientDataCache::SourceCheck;
+
+    TestFiles::TemporaryDirectory directory("vme_client_data_cache_test");
+
+    // The contents of the source files only matter for their hashes. The cache holds the loaded client data.
+    ClientDataCache::SourceFiles sourceFiles{directory / "appearances.dat", directory / "items.otb", directory / "items.xml"};
+    TestFiles::write(sourceFiles.appearances, "appearances");
+    TestFiles::write(sourceFiles.itemsOtb, "items.otb");
+    TestFiles::write(sourceFiles.itemsXml, "items.xml");
+
+    std::filesystem::path cacheFile = directory / "client-data.bin";
+    REQUIRE(checkSources(cacheFile, sourceFiles) == SourceCheck::Invalid);
+
+    REQUIRE(ClientDataCache(cacheFile, sourceFiles).save());
+    REQUIRE(checkSources(cacheFile, sourceFiles) == SourceCheck::SameStamps);
+
+    SECTION("Sources with new modification times are hashed once")
+    {
+        touch(sourceFiles.appearances);
+        touch(sourceFiles.itemsXml);
+
+        REQUIRE(checkSources(cacheFile, sourceFiles) == SourceCheck::SameContents);
+        REQUIRE(checkSources(cacheFile, sourceFiles) == SourceCheck::SameStamps);
+    }
+
+    SECTION("Changed sources are detected")
+    {
+        // Same size, so only the modification time and the hash differ
+        TestFiles::write(sourceFiles.itemsOtb, "ITEMS.OTB");
+        touch(sourceFiles.itemsOtb);
+
+        REQUIRE(checkSources(cacheFile, sourceFiles) == SourceCheck::Changed);
+        REQUIRE(checkSources(cacheFile, sourceFiles) == SourceCheck::Changed);
+    }
+
+    SECTION("A missing source is a change")
+    {
+        std::filesystem::remove(sourceFiles.itemsXml);
+        REQUIRE(checkSources(cacheFile, sourceFiles) == SourceCheck::Changed);
+    }
+
+    SECTION("A cache of another format version is invalid")
+    {
+        TestFiles::overwrite(cacheFile, ClientDataCache::FormatVersionOffset, static_cast<uint32_t>(ClientDataCache::FormatVersion + 1));
+        REQUIRE(checkSources(cacheFile, sourceFiles) == SourceCheck::Invalid);
+    }
+
+    SECTION("Loaded item types equal the ones the cache was written from")
+    {
+        size_t itemCount = Items::items.size();
+        uint32_t highestServerId = Items::items.highestServerId;
+        auto grass = itemTypeFields(4526);
+        auto stone = itemTypeFields(2554);
+        auto coin = itemTypeFields(2148);
+
+        // Replaces the loaded item types, like loading the cache on startup
+        ClientDataCache cache(cacheFile, sourceFiles);
+        REQUIRE(cache.load());
+        REQUIRE(cache.loaded());
+        Items::cacheTextureAtlases();
+
+        REQUIRE(Items::items.size() == itemCount);
+        REQUIRE(Items::items.highestServerId == highestServerId);
+        REQUIRE(itemTypeFields(4526) == grass);
+        REQUIRE(itemTypeFields(2554) == stone);
+        REQUIRE(itemTypeFields(2148) == coin);
+    }
+}
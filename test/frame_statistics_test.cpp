@@ -0,0 +1,90 @@
+#include "catch.hpp"
+
+#include <chrono>
+#include <thread>
+
+#include "../src/frame_statistics.h"
+
+namespace
+{
+    // Records a frame that issues sprites sprites
+    void recordFrame(FrameStatistics &statistics, uint32_t sprites)
+    {
+        statistics.beginFrame();
+        statistics.counters().spritesIssued = sprites;
+        statistics.endFrame();
+    }
+} // namespace
+
+TEST_CASE("frame_statistics.h", "[rendering]")
+{
+    FrameStatistics statistics;
+
+    SECTION("Without frames the percentiles are zero")
+    {
+        REQUIRE(statistics.frameCount() == 0);
+        REQUIRE(statistics.counter(&FrameCounters::spritesIssued).p99 == 0);
+    }
+
+    SECTION("Counters start at zero in every frame")
+    {
+        statistics.beginFrame();
+        statistics.counters().tilesVisited = 5;
+        ++statistics.counters().spritesIssued;
+        statistics.endFrame();
+
+        REQUIRE(statistics.lastCounters().tilesVisited == 5);
+        REQUIRE(statistics.lastCounters().spritesIssued == 1);
+
+        recordFrame(statistics, 3);
+        REQUIRE(statistics.lastCounters().tilesVisited == 0);
+        REQUIRE(statistics.lastCounters().spritesIssued == 3);
+    }
+
+    SECTION("Percentiles are nearest-rank")
+    {
+        // Out of order, to show that the values are sorted
+        for (uint32_t i = 100; i >= 1; --i)
+        {
+            recordFrame(statistics, i);
+        }
+
+        REQUIRE(statistics.frameCount() == 100);
+
+        FrameStatistics::Percentiles sprites = statistics.counter(&FrameCounters::spritesIssued);
+        REQUIRE(sprites.p50 == 50);
+        REQUIRE(sprites.p95 == 95);
+        REQUIRE(sprites.p99 == 99);
+    }
+
+    SECTION("Only the last WindowSize frames are kept")
+    {
+        constexpr uint32_t Extra = 10;
+        for (uint32_t i = 1; i <= FrameStatistics::WindowSize + Extra; ++i)
+        {
+            recordFrame(statistics, i);
+        }
+
+        REQUIRE(statistics.frameCount() == FrameStatistics::WindowSize);
+        REQUIRE(statistics.lastCounters().spritesIssued == FrameStatistics::WindowSize + Extra);
+
+        // Frames 1 to Extra were overwritten
+        FrameStatistics::Percentiles sprites = statistics.counter(&FrameCounters::spritesIssued);
+        REQUIRE(sprites.p50 == Extra + FrameStatistics::WindowSize / 2);
+    }
+
+    SECTION("Phase timers add to their phase of the frame")
+    {
+        statistics.beginFrame();
+        for (int i = 0; i < 2; ++i)
+        {
+            FrameStatistics::PhaseTimer timer(statistics, RenderPhase::Map);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        statistics.endFrame();
+
+        REQUIRE(statistics.lastMillis(RenderPhase::Map) >= 4);
+        REQUIRE(statistics.lastMillis(RenderPhase::Overlay) == 0);
+        REQUIRE(statistics.lastMillis(RenderPhase::Frame) >= statistics.lastMillis(RenderPhase::Map));
+    }
+}
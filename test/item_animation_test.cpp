@@ -0,0 +1,95 @@
+#include "catch.hpp"
+
+#include <chrono>
+
+#include "../src/item_animation.h"
+
+namespace
+{
+    SpriteAnimation animationInfo(uint32_t firstPhaseDuration, AnimationLoopType loopType = AnimationLoopType::Infinite)
+    {
+        SpriteAnimation info{};
+        info.defaultStartPhase = 0;
+        info.synchronized = false;
+        info.randomStartPhase = false;
+        info.loopType = loopType;
+        info.loopCount = 1;
+        info.phases = {SpritePhase{firstPhaseDuration, firstPhaseDuration}, SpritePhase{1000, 1000}};
+
+        return info;
+    }
+
+    bool sameTime(const TimePoint &a, const TimePoint &b)
+    {
+        return !(a < b) && !(b < a);
+    }
+} // namespace
+
+TEST_CASE("item_animation.h", "[rendering]")
+{
+    AnimationScheduler scheduler;
+    scheduler.beginFrame();
+
+    SECTION("Without animations there is no deadline")
+    {
+        REQUIRE_FALSE(scheduler.hasDeadline());
+        REQUIRE_FALSE(scheduler.millisUntilNextDeadline().has_value());
+    }
+
+    SECTION("The deadline is the earliest phase change of the animations of the frame")
+    {
+        SpriteAnimation slowInfo = animationInfo(300);
+        SpriteAnimation fastInfo = animationInfo(100);
+        ItemAnimation slow(&slowInfo);
+        ItemAnimation fast(&fastInfo);
+
+        scheduler.add(slow);
+        scheduler.add(fast);
+        scheduler.add(slow);
+
+        REQUIRE(scheduler.hasDeadline());
+        REQUIRE(sameTime(*scheduler.nextDeadline(), *fast.nextPhaseTime()));
+
+        long long millis = *scheduler.millisUntilNextDeadline();
+        REQUIRE(millis >= 0);
+        REQUIRE(millis <= 101);
+
+        SECTION("beginFrame clears the deadline")
+        {
+            scheduler.beginFrame();
+            REQUIRE_FALSE(scheduler.hasDeadline());
+
+            scheduler.add(slow);
+            REQUIRE(sameTime(*scheduler.nextDeadline(), *slow.nextPhaseTime()));
+        }
+    }
+
+    SECTION("The phase changes after the deadline, not before")
+    {
+        SpriteAnimation info = animationInfo(100);
+        ItemAnimation animation(&info);
+
+        animation.state.lastUpdateTime = TimePoint::now().back<std::chrono::milliseconds>(50);
+        animation.update();
+        REQUIRE(animation.state.phaseIndex == 0);
+
+        // The deadline has passed
+        animation.state.lastUpdateTime = TimePoint::now().back<std::chrono::milliseconds>(102);
+        scheduler.add(animation);
+        REQUIRE(*scheduler.millisUntilNextDeadline() == 0);
+
+        animation.update();
+        REQUIRE(animation.state.phaseIndex == 1);
+    }
+
+    SECTION("Finished animations have no deadline")
+    {
+        SpriteAnimation info = animationInfo(100, AnimationLoopType::Counted);
+        ItemAnimation animation(&info);
+        animation.state.info = info.loopCount;
+
+        REQUIRE(animation.finished());
+        scheduler.add(animation);
+        REQUIRE_FALSE(scheduler.hasDeadline());
+    }
+}
@@ -0,0 +1,169 @@
+#include "catch.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../src/logger.h"
+
+namespace
+{
+    std::mutex capturedMutex;
+    std::vector<std::pair<Logger::Level, std::string>> captured;
+
+    void capture(Logger::Level level, const std::string &message)
+    {
+        std::lock_guard lock(capturedMutex);
+        captured.emplace_back(level, message);
+    }
+
+    // The captured messages that start with prefix, in the order they were written
+    std::vector<std::string> capturedMessages(const std::string &prefix)
+    {
+        Logger::flush();
+
+        std::lock_guard lock(capturedMutex);
+        std::vector<std::string> messages;
+        for (const auto &[level, message] : captured)
+        {
+            if (message.rfind(prefix, 0) == 0)
+            {
+                messages.emplace_back(message);
+            }
+        }
+
+        return messages;
+    }
+
+    // Captures the log while it exists
+    class CapturedLog
+    {
+      public:
+        CapturedLog()
+        {
+            Logger::flush();
+            {
+                std::lock_guard lock(capturedMutex);
+                captured.clear();
+            }
+            previousSink = Logger::setSink(capture);
+        }
+
+        ~CapturedLog()
+        {
+            Logger::flush();
+            Logger::setLevel(Logger::CompiledLevel);
+            Logger::setSink(previousSink);
+        }
+
+      private:
+        Logger::Sink previousSink;
+    };
+
+    // Two call sites, so that each section starts without suppressed messages
+    void logWarnings(const std::string &prefix, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            VME_LOG_W(prefix << i);
+        }
+    }
+
+    void logOtherWarnings(const std::string &prefix, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            VME_LOG_W(prefix << i);
+        }
+    }
+} // namespace
+
+TEST_CASE("logger.h", "[util]")
+{
+    CapturedLog log;
+
+    SECTION("Messages below the run time level are discarded")
+    {
+        Logger::setLevel(Logger::Level::Warning);
+        REQUIRE_FALSE(Logger::enabled(Logger::Level::Info));
+        REQUIRE(Logger::enabled(Logger::Level::Warning));
+        REQUIRE(Logger::enabled(Logger::Level::Error));
+
+        VME_LOG("level: info");
+        VME_LOG_ERROR("level: error");
+
+        Logger::setLevel(Logger::Level::Debug);
+        REQUIRE(Logger::enabled(Logger::Level::Info));
+
+        // Levels below the compiled level can not be enabled
+        REQUIRE(Logger::enabled(Logger::Level::Debug) == (Logger::CompiledLevel == Logger::Level::Debug));
+
+        REQUIRE(capturedMessages("level: ") == std::vector<std::string>{"level: error"});
+    }
+
+    SECTION("The next message of a warning call site reports the messages it suppressed")
+    {
+        constexpr uint32_t Limit = Logger::RateLimit::MessagesPerWindow;
+
+        logWarnings("limited: ", Limit + 5);
+
+        std::vector<std::string> messages = capturedMessages("limited: ");
+        REQUIRE(messages.size() == Limit);
+        REQUIRE(messages.back() == "limited: " + std::to_string(Limit - 1));
+
+        // The first message of the next window
+        std::this_thread::sleep_for(std::chrono::milliseconds(Logger::RateLimit::WindowMilliseconds + 50));
+        logWarnings("limited: ", 1);
+
+        messages = capturedMessages("limited: ");
+        REQUIRE(messages.size() == Limit + 1);
+        REQUIRE(messages.back() == "limited: 0 (5 similar warnings were suppressed)");
+    }
+
+    SECTION("reportSuppressed logs the messages that each warning call site suppressed")
+    {
+        constexpr uint32_t Limit = Logger::RateLimit::MessagesPerWindow;
+
+        logOtherWarnings("reported: ", Limit + 5);
+        REQUIRE(capturedMessages("reported: ").size() == Limit);
+
+        Logger::reportSuppressed();
+
+        std::vector<std::string> reports = capturedMessages("5 similar warnings from logger_test.cpp:");
+        REQUIRE(reports.size() == 1);
+        REQUIRE(reports.front().ends_with(" were suppressed."));
+
+        // They are only reported once
+        Logger::reportSuppressed();
+        REQUIRE(capturedMessages("5 similar warnings from logger_test.cpp:").size() == 1);
+    }
+
+    SECTION("flush waits for the messages of every thread, which are written in the order they were logged")
+    {
+        constexpr int MessageCount = 200;
+
+        auto logMessages = [](const std::string &prefix) {
+            for (int i = 0; i < MessageCount; ++i)
+            {
+                VME_LOG(prefix << i);
+            }
+        };
+
+        std::thread other(logMessages, "flush b: ");
+        logMessages("flush a: ");
+        other.join();
+
+        for (const std::string prefix : {"flush a: ", "flush b: "})
+        {
+            std::vector<std::string> messages = capturedMessages(prefix);
+            REQUIRE(messages.size() == MessageCount);
+            for (int i = 0; i < MessageCount; ++i)
+            {
+                REQUIRE(messages[i] == prefix + std::to_string(i));
+            }
+        }
+    }
+}
@@ -0,0 +1,124 @@
+#include "catch.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "../src/lua/lua_generation.h"
+#include "../src/map_view.h"
+
+namespace
+{
+    std::filesystem::path writeScript(const std::string &name, const std::string &source)
+    {
+        std::filesystem::path file = std::filesystem::temp_directory_path() / name;
+        std::ofstream(file, std::ios::out | std::ios::trunc) << source;
+        return file;
+    }
+
+    // Grass is placed on about half of the tiles, chosen by math.random
+    constexpr auto RandomGroundScript = R"(
+function generateChunk(region, seed)
+    for y = region.y, region.y + region.height - 1 do
+        for x = region.x, region.x + region.width - 1 do
+            if math.random() < 0.5 then
+                region:setGround(x, y, 4526)
+            end
+        end
+    end
+end
+)";
+
+    uint32_t groundId(const MapView &mapView, const Position &position)
+    {
+        const Tile *tile = mapView.map()->getTile(position);
+        return tile && tile->ground() ? tile->ground()->serverId() : 0;
+    }
+} // namespace
+
+TEST_CASE("lua_generation.h", "[lua]")
+{
+    SECTION("The chunk seed only depends on the seed and the chunk origin")
+    {
+        REQUIRE(LuaChunkGenerator::chunkSeed(7, Position(64, 128, 7)) == LuaChunkGenerator::chunkSeed(7, Position(64, 128, 7)));
+        REQUIRE(LuaChunkGenerator::chunkSeed(7, Position(64, 128, 7)) != LuaChunkGenerator::chunkSeed(8, Position(64, 128, 7)));
+        REQUIRE(LuaChunkGenerator::chunkSeed(7, Position(64, 128, 7)) != LuaChunkGenerator::chunkSeed(7, Position(128, 64, 7)));
+        REQUIRE(LuaChunkGenerator::chunkSeed(7, Position(64, 128, 7)) != LuaChunkGenerator::chunkSeed(7, Position(64, 128, 6)));
+    }
+
+    SECTION("A run gives the same map on one and on several threads")
+    {
+        auto script = writeScript("vme_generation_test.lua", RandomGroundScript);
+        Position from(100, 100, 7);
+        Position to(163, 163, 7);
+
+        std::unique_ptr<UIUtils> utils;
+        EditorAction editorAction;
+
+        MapView single(std::move(utils), editorAction);
+        auto singleResult = LuaChunkGenerator({script, "generateChunk", 16, 42, 1}).run(single, from, to);
+
+        MapView several(std::unique_ptr<UIUtils>(), editorAction);
+        auto severalResult = LuaChunkGenerator({script, "generateChunk", 16, 42, 4}).run(several, from, to);
+
+        REQUIRE(singleResult.has_value());
+        REQUIRE(singleResult == severalResult);
+        REQUIRE(*singleResult != 0);
+
+        for (int y = from.y; y <= to.y; ++y)
+        {
+            for (int x = from.x; x <= to.x; ++x)
+            {
+                Position position(x, y, 7);
+                REQUIRE(groundId(single, position) == groundId(several, position));
+            }
+        }
+
+        std::filesystem::remove(script);
+    }
+
+    SECTION("Collecting the region inside the callback does not free the chunk")
+    {
+        auto script = writeScript("vme_generation_gc_test.lua", R"(
+function generateChunk(region, seed)
+    region:setGround(region.x, region.y, 4526)
+    region = nil
+    collectgarbage()
+    collectgarbage()
+end
+)");
+
+        std::unique_ptr<UIUtils> utils;
+        EditorAction editorAction;
+        MapView mapView(std::move(utils), editorAction);
+
+        auto result = LuaChunkGenerator({script, "generateChunk", 8, 1, 2}).run(mapView, Position(10, 10, 7), Position(25, 25, 7));
+
+        // One tile per chunk
+        REQUIRE(result == 4);
+        REQUIRE(groundId(mapView, Position(10, 10, 7)) == 4526);
+        REQUIRE(groundId(mapView, Position(18, 18, 7)) == 4526);
+
+        std::filesystem::remove(script);
+    }
+
+    SECTION("A script that replaces math.randomseed fails without aborting")
+    {
+        auto script = writeScript("vme_generation_seed_test.lua", R"(
+math = nil
+
+function generateChunk(region, seed)
+end
+)");
+
+        std::unique_ptr<UIUtils> utils;
+        EditorAction editorAction;
+        MapView mapView(std::move(utils), editorAction);
+
+        LuaChunkGenerator generator({script, "generateChunk", 8, 1, 1});
+        REQUIRE_FALSE(generator.run(mapView, Position(10, 10, 7), Position(17, 17, 7)).has_value());
+        REQUIRE_FALSE(generator.error().empty());
+
+        std::filesystem::remove(script);
+    }
+}
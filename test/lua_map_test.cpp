@@ -0,0 +1,137 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <string>
+
+#include "../src/items.h"
+#include "../src/lua/lua_map.h"
+#include "../src/lua/luascript_interface.h"
+#include "../src/map_view.h"
+
+namespace
+{
+    // The first item that is stacked like a border
+    uint32_t borderItemId()
+    {
+        for (uint32_t serverId = 100; serverId < Items::items.size(); ++serverId)
+        {
+            if (Items::items.validItemType(serverId) && Items::items.getItemTypeByServerId(serverId)->stackOrder == TileStackOrder::Border)
+            {
+                return serverId;
+            }
+        }
+
+        return 0;
+    }
+} // namespace
+
+TEST_CASE("lua_map.h", "[lua]")
+{
+    std::unique_ptr<UIUtils> utils;
+    EditorAction editorAction;
+    MapView mapView(std::move(utils), editorAction);
+
+    constexpr uint32_t Grass = 4526;
+
+    // Grass on (0, 0, 7) - (3, 3, 7)
+    MapRegionBuffer corner = MapRegionBuffer::read(*mapView.map(), Position(0, 0, 7), 4, 4);
+    std::fill(corner.ground.begin(), corner.ground.end(), Grass);
+    REQUIRE(corner.write(mapView) == 16);
+
+    SECTION("Written tiles are read back")
+    {
+        MapRegionBuffer region = MapRegionBuffer::read(*mapView.map(), Position(0, 0, 7), 5, 5);
+        REQUIRE(region.ground[region.index(3, 3)] == Grass);
+        REQUIRE(region.ground[region.index(4, 4)] == 0);
+
+        // Nothing changed, so nothing is written
+        REQUIRE(region.write(mapView) == 0);
+    }
+
+    SECTION("Positions outside of the map are read as empty")
+    {
+        MapRegionBuffer region = MapRegionBuffer::read(*mapView.map(), Position(-4, -4, 7), 8, 8);
+        for (int y = 0; y < 8; ++y)
+        {
+            for (int x = 0; x < 8; ++x)
+            {
+                bool onGrass = x >= 4 && y >= 4;
+                REQUIRE(region.ground[region.index(x, y)] == (onGrass ? Grass : 0));
+            }
+        }
+
+        // Past the width of the map, where coordinates would wrap around to the grass
+        MapRegionBuffer edge = MapRegionBuffer::read(*mapView.map(), Position(mapView.mapWidth() - 2, 0, 7), 4, 4);
+        for (uint32_t ground : edge.ground)
+        {
+            REQUIRE(ground == 0);
+        }
+    }
+
+    SECTION("A write is one undoable transaction")
+    {
+        MapRegionBuffer region = MapRegionBuffer::read(*mapView.map(), Position(0, 0, 7), 4, 4);
+        region.ground[region.index(0, 0)] = 0;
+        region.ground[region.index(1, 1)] = 0;
+        REQUIRE(region.write(mapView) == 2);
+
+        mapView.undo();
+
+        MapRegionBuffer undone = MapRegionBuffer::read(*mapView.map(), Position(0, 0, 7), 4, 4);
+        REQUIRE(undone.ground[undone.index(0, 0)] == Grass);
+        REQUIRE(undone.ground[undone.index(1, 1)] == Grass);
+    }
+
+    SECTION("A top item that is stacked below the other items is not on top")
+    {
+        uint32_t border = borderItemId();
+        REQUIRE(border != 0);
+
+        mapView.commitTransaction(TransactionType::AddMapItem, [&mapView] {
+            mapView.addItem(Position(2, 2, 7), 2554);
+            mapView.addItem(Position(2, 2, 7), 2148);
+        });
+
+        MapRegionBuffer region = MapRegionBuffer::read(*mapView.map(), Position(2, 2, 7), 1, 1);
+        REQUIRE(region.topItem[0] == 2148);
+
+        region.topItem[0] = border;
+        REQUIRE(region.write(mapView) == 1);
+
+        // The border replaces the top item but is stacked below 2554
+        const auto &items = mapView.getTile(Position(2, 2, 7))->items();
+        REQUIRE(items.size() == 2);
+        REQUIRE(items.front()->serverId() == border);
+        REQUIRE(items.back()->serverId() == 2554);
+
+        REQUIRE(region.topItem[0] == 2554);
+        REQUIRE(region.write(mapView) == 0);
+    }
+
+    SECTION("Scripts of the script interface edit the registered map")
+    {
+        LuaScriptInterface &lua = *LuaScriptInterface::get();
+        if (!lua.luaState())
+        {
+            REQUIRE(LuaScriptInterface::initialize());
+        }
+
+        lua_State *L = lua.luaState();
+        lua.registerMap(&mapView);
+
+        REQUIRE(luaL_dostring(L, "local region = MapRegion(0, 0, 7, 2, 1) region:setGround(1, 0, 0) return region:write()") == 0);
+        REQUIRE(lua_tointeger(L, -1) == 1);
+        lua_pop(L, 1);
+        REQUIRE(mapView.getTile(Position(1, 0, 7))->ground() == nullptr);
+
+        // Regions larger than the map are rejected
+        std::string tooWide = "MapRegion(0, 0, 7, " + std::to_string(mapView.mapWidth() + 1) + ", 1)";
+        REQUIRE(luaL_dostring(L, tooWide.c_str()) != 0);
+        REQUIRE(std::string(lua_tostring(L, -1)).find("wider than the map") != std::string::npos);
+        lua_pop(L, 1);
+
+        lua.registerMap(nullptr);
+        REQUIRE(luaL_dostring(L, "MapRegion(0, 0, 7, 1, 1)") != 0);
+        lua_pop(L, 1);
+    }
+}
@@ -0,0 +1,115 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "../src/lua/lua_profiler.h"
+#include "../src/lua/lua_state.h"
+
+namespace
+{
+    const LuaProfiler::FunctionStats *findFunction(const std::vector<LuaProfiler::FunctionStats> &stats, const std::string &name)
+    {
+        auto found = std::find_if(stats.begin(), stats.end(), [&name](const LuaProfiler::FunctionStats &function) {
+            return function.name.rfind(name + " (", 0) == 0;
+        });
+
+        return found == stats.end() ? nullptr : &*found;
+    }
+
+    // Runs the global function name of the script in a scope
+    void run(lua_State *L, const char *source, const char *name)
+    {
+        REQUIRE(luaL_dostring(L, source) == 0);
+
+        LuaProfiler::Scope scope(L, "test");
+        lua_getglobal(L, name);
+        REQUIRE(lua_pcall(L, 0, 0, 0) == 0);
+    }
+} // namespace
+
+TEST_CASE("lua_profiler.h", "[lua]")
+{
+    lua_State *L = luaL_newstate();
+    luaL_openlibs(L);
+
+    // LuaJIT does not call hooks from compiled traces
+    REQUIRE(luaL_dostring(L, "if jit then jit.off() end") == 0);
+
+    SECTION("Calls and self time are counted per function")
+    {
+        LuaProfiler profiler(100);
+        profiler.attach(L);
+
+        run(L, R"(
+function busy()
+    local x = 0
+    for i = 1, 2000 do x = x + i end
+    return x
+end
+
+function outer()
+    for i = 1, 50 do busy() end
+end
+)",
+            "outer");
+
+        profiler.detach();
+
+        auto stats = profiler.functionStats();
+        auto outer = findFunction(stats, "outer");
+        auto busy = findFunction(stats, "busy");
+        REQUIRE(outer);
+        REQUIRE(busy);
+
+        REQUIRE(outer->calls == 1);
+        REQUIRE(busy->calls == 50);
+
+        // busy runs inside outer, so its time is part of the total time of outer but not of its self time
+        REQUIRE(busy->totalTime <= outer->totalTime);
+        REQUIRE(outer->selfTime + busy->totalTime <= outer->totalTime);
+    }
+
+    SECTION("Tail calls do not leave frames behind")
+    {
+        // Samples often, so a stack that kept growing would show up in the folded stacks
+        LuaProfiler profiler(10);
+        profiler.attach(L);
+
+        run(L, R"(
+local function loop(n)
+    if n == 0 then
+        return 0
+    end
+    return loop(n - 1)
+end
+
+function start()
+    return loop(20000)
+end
+)",
+            "start");
+
+        profiler.detach();
+
+        std::filesystem::path file = std::filesystem::temp_directory_path() / "vme_lua_profiler_test.folded";
+        REQUIRE(profiler.writeFoldedStacks(file));
+
+        std::ifstream stream(file);
+        std::string line;
+        size_t lines = 0;
+        while (std::getline(stream, line))
+        {
+            ++lines;
+            REQUIRE(line.rfind("[test]", 0) == 0);
+            REQUIRE(std::count(line.begin(), line.end(), ';') <= 3);
+        }
+
+        REQUIRE(lines != 0);
+        std::filesystem::remove(file);
+    }
+
+    lua_close(L);
+}
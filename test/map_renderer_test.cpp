@@ -0,0 +1,96 @@
+#include "catch.hpp"
+
+#include <memory>
+
+#include "../src/item.h"
+#include "../src/map.h"
+#include "../src/map_renderer.h"
+#include "../src/map_view.h"
+
+namespace
+{
+    constexpr uint32_t Grass = 4526;
+    constexpr uint32_t GoldCoin = 2148;
+
+    size_t recordDraws(MapRenderer &renderer)
+    {
+        DrawList drawList;
+        renderer.recordFrame(drawList);
+        return drawList.size();
+    }
+
+    void addTile(Map &map, const Position &position)
+    {
+        map.addItem(position, Grass);
+        map.addItem(position, GoldCoin);
+    }
+
+    bool coversTile(uint32_t serverId)
+    {
+        Item item(serverId);
+        uint32_t spriteId = item.getSpriteId(Position(0, 0, 7));
+        return item.itemType->getTextureAtlas(spriteId)->coversTile(spriteId);
+    }
+} // namespace
+
+TEST_CASE("map_renderer.h", "[rendering]")
+{
+    auto map = std::make_shared<Map>(32, 32);
+    EditorAction editorAction;
+    MapView mapView(nullptr, editorAction, map);
+
+    mapView.setFloor(6);
+    mapView.setX(0);
+    mapView.setY(0);
+    mapView.setViewportSize(32 * MapTileSize, 32 * MapTileSize);
+
+    MapRenderer renderer(&mapView);
+
+    SECTION("Opaque ground covers its tile")
+    {
+        REQUIRE(coversTile(Grass));
+        REQUIRE_FALSE(coversTile(GoldCoin));
+    }
+
+    SECTION("Tiles under opaque ground on the floors above are not drawn")
+    {
+        // Grass on (11, 11, 6) - (14, 14, 6), which is drawn over (10, 10, 7) - (13, 13, 7)
+        for (int x = 11; x <= 14; ++x)
+        {
+            for (int y = 11; y <= 14; ++y)
+            {
+                map->addItem(Position(x, y, 6), Grass);
+            }
+        }
+
+        size_t coverDraws = recordDraws(renderer);
+
+        // The draws of one tile that is not covered
+        addTile(*map, Position(25, 25, 7));
+        size_t uncoveredDraws = recordDraws(renderer);
+        size_t tileDraws = uncoveredDraws - coverDraws;
+        REQUIRE(tileDraws > 0);
+
+        SECTION("A covered tile is culled")
+        {
+            addTile(*map, Position(12, 12, 7));
+            REQUIRE(recordDraws(renderer) == uncoveredDraws);
+        }
+
+        SECTION("A tile is drawn if the tiles up and to the left of it are not covered")
+        {
+            // Its sprites could spill into (9, 9, 7), which is not covered
+            addTile(*map, Position(10, 10, 7));
+            REQUIRE(recordDraws(renderer) == uncoveredDraws + tileDraws);
+        }
+
+        SECTION("A tile is drawn if the floor above it is not drawn")
+        {
+            mapView.setFloor(7);
+            size_t floorDraws = recordDraws(renderer);
+
+            addTile(*map, Position(12, 12, 7));
+            REQUIRE(recordDraws(renderer) == floorDraws + tileDraws);
+        }
+    }
+}
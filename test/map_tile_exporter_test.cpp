@@ -0,0 +1,113 @@
+#include "catch.hpp"
+
+#include <filesystem>
+#include <memory>
+
+#include "../src/map.h"
+#include "../src/map_tile_exporter.h"
+
+namespace
+{
+    bool tileExists(const std::filesystem::path &directory, int floor, int zoom, int x, int y)
+    {
+        return std::filesystem::exists(directory / std::to_string(floor) / std::to_string(zoom) / std::to_string(x) / (std::to_string(y) + ".png"));
+    }
+} // namespace
+
+TEST_CASE("map_tile_exporter.h", "[rendering]")
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "vme_map_tile_exporter_test";
+    std::filesystem::remove_all(directory);
+
+    // 24 x 24 map tiles are 768 x 768 pixels: zoom levels 0 (one tile) to 2 (3 x 3 tiles)
+    auto map = std::make_shared<Map>(24, 24);
+    map->addItem(Position(1, 1, 7), 4526);
+    map->addItem(Position(20, 20, 7), 4526);
+
+    MapTileExporter::Options options;
+    options.outputDirectory = directory;
+    options.threadCount = 2;
+    options.chunkLevels = 1;
+    options.floors = {7};
+
+    MapTileExporter exporter(map, options);
+    REQUIRE(exporter.maxZoom() == 2);
+
+    auto result = exporter.exportTiles();
+    REQUIRE(result.renderedChunks == 4);
+    REQUIRE(result.writtenTiles == 5);
+
+    // Only tiles with something drawn on them are written
+    REQUIRE(tileExists(directory, 7, 2, 0, 0));
+    REQUIRE(tileExists(directory, 7, 2, 2, 2));
+    REQUIRE_FALSE(tileExists(directory, 7, 2, 1, 1));
+
+    REQUIRE(tileExists(directory, 7, 1, 0, 0));
+    REQUIRE(tileExists(directory, 7, 1, 1, 1));
+    REQUIRE_FALSE(tileExists(directory, 7, 1, 1, 0));
+
+    REQUIRE(tileExists(directory, 7, 0, 0, 0));
+    REQUIRE_FALSE(tileExists(directory, 6, 0, 0, 0));
+
+    SECTION("An export of an unchanged map writes nothing")
+    {
+        auto unchanged = MapTileExporter(map, options).exportTiles();
+        REQUIRE(unchanged.renderedChunks == 0);
+        REQUIRE(unchanged.unchangedChunks == 4);
+        REQUIRE(unchanged.writtenTiles == 0);
+    }
+
+    SECTION("The tiles of removed map tiles are removed")
+    {
+        map->removeTile(Position(20, 20, 7));
+
+        auto changed = MapTileExporter(map, options).exportTiles();
+        REQUIRE(changed.removedTiles == 2);
+
+        REQUIRE_FALSE(tileExists(directory, 7, 2, 2, 2));
+        REQUIRE_FALSE(tileExists(directory, 7, 1, 1, 1));
+
+        REQUIRE(tileExists(directory, 7, 2, 0, 0));
+        REQUIRE(tileExists(directory, 7, 1, 0, 0));
+        REQUIRE(tileExists(directory, 7, 0, 0, 0));
+    }
+
+    SECTION("A cancelled export is finished by the next export")
+    {
+        std::filesystem::remove_all(directory);
+
+        uint32_t reportedTotal = 0;
+        MapTileExporter::Options cancelling = options;
+        cancelling.progress = [&reportedTotal](uint32_t done, uint32_t total) {
+            reportedTotal = total;
+            return done < 1;
+        };
+
+        auto cancelled = MapTileExporter(map, cancelling).exportTiles();
+        REQUIRE(cancelled.cancelled);
+        REQUIRE(cancelled.renderedChunks == 1);
+        REQUIRE(reportedTotal == 4);
+
+        // The tiles above the rendered chunk are not built
+        REQUIRE_FALSE(tileExists(directory, 7, 0, 0, 0));
+
+        uint32_t lastDone = 0;
+        MapTileExporter::Options resuming = options;
+        resuming.progress = [&lastDone](uint32_t done, uint32_t) {
+            lastDone = done;
+            return true;
+        };
+
+        // The chunk of the cancelled export is rendered again, since its parent tiles are missing
+        auto resumed = MapTileExporter(map, resuming).exportTiles();
+        REQUIRE_FALSE(resumed.cancelled);
+        REQUIRE(resumed.renderedChunks == 4);
+        REQUIRE(lastDone == 4);
+        REQUIRE(tileExists(directory, 7, 0, 0, 0));
+
+        auto unchanged = MapTileExporter(map, options).exportTiles();
+        REQUIRE(unchanged.unchangedChunks == 4);
+    }
+
+    std::filesystem::remove_all(directory);
+}
@@ -2,7 +2,73 @@
 
 #include "../src/map_view.h"
 
+struct MapViewObserver
+{
+    void onMapChanged(const MapChanges &changes)
+    {
+        ++mapChanges;
+        latestChanges = changes;
+    }
+
+    void onDrawRequested()
+    {
+        ++drawRequests;
+    }
+
+    int mapChanges = 0;
+    int drawRequests = 0;
+    MapChanges latestChanges;
+};
+
 TEST_CASE("map_view.h", "[core][map view]")
 {
-    // SECTION("")
-}
\ No newline at end of file
+    MapViewObserver observer;
+
+    std::unique_ptr<UIUtils> utils;
+    EditorAction editorAction;
+    MapView mapView(std::move(utils), editorAction);
+
+    mapView.onMapChanged<&MapViewObserver::onMapChanged>(&observer);
+    mapView.onDrawRequested<&MapViewObserver::onDrawRequested>(&observer);
+
+    SECTION("A transaction sends one map change and one draw request")
+    {
+        mapView.commitTransaction(TransactionType::AddMapItem, [&mapView] {
+            mapView.addItem(Position(10, 12, 7), 4526);
+            mapView.addItem(Position(14, 11, 7), 4526);
+            mapView.addItem(Position(12, 15, 7), 2554);
+        });
+
+        REQUIRE(observer.mapChanges == 1);
+        REQUIRE(observer.drawRequests == 1);
+
+        REQUIRE(observer.latestChanges.tileCount == 3);
+        REQUIRE(observer.latestChanges.from == Position(10, 11, 7));
+        REQUIRE(observer.latestChanges.to == Position(14, 15, 7));
+
+        SECTION("Undoing the transaction also sends one of each")
+        {
+            mapView.undo();
+
+            REQUIRE(observer.mapChanges == 2);
+            REQUIRE(observer.drawRequests == 2);
+            REQUIRE(observer.latestChanges.dirty(Position(12, 15, 7)));
+        }
+
+        SECTION("Undoing and redoing a selection sends one draw request and no map change")
+        {
+            mapView.commitTransaction(TransactionType::Selection, [&mapView] {
+                mapView.selectTopItem(Position(10, 12, 7));
+            });
+            REQUIRE(observer.drawRequests == 2);
+
+            mapView.undo();
+            REQUIRE(observer.mapChanges == 1);
+            REQUIRE(observer.drawRequests == 3);
+
+            mapView.redo();
+            REQUIRE(observer.mapChanges == 1);
+            REQUIRE(observer.drawRequests == 4);
+        }
+    }
+}
@@ -75,6 +75,45 @@ TEST_CASE("observable_item.h", "[observer][item]")
         }
     }
 
+    SECTION("A moved observer keeps notifying and releases its signal once")
+    {
+        Item item(2554);
+        ItemObserver observer;
+
+        {
+            std::optional<ObservableItem> moved;
+            {
+                ObservableItem tracked(&item);
+                moved.emplace(std::move(tracked));
+            }
+
+            moved->onPropertyChanged<&ItemObserver::onPropertyChanged>(&observer);
+            REQUIRE(Items::items.itemSignals.size() == 1);
+
+            item.setCount(25);
+            REQUIRE(observer.latestPropertyChange == ItemChangeType::Count);
+        }
+
+        REQUIRE(Items::items.itemSignals.size() == 0);
+
+        // Items tracked afterwards do not share a signal
+        Item first(2554);
+        Item second(2554);
+        ItemObserver firstObserver;
+        ItemObserver secondObserver;
+
+        ObservableItem trackedFirst(&first);
+        trackedFirst.onPropertyChanged<&ItemObserver::onPropertyChanged>(&firstObserver);
+        ObservableItem trackedSecond(&second);
+        trackedSecond.onPropertyChanged<&ItemObserver::onPropertyChanged>(&secondObserver);
+
+        REQUIRE(Items::items.itemSignals.size() == 2);
+
+        first.setCount(10);
+        REQUIRE(firstObserver.latestPropertyChange == ItemChangeType::Count);
+        REQUIRE_FALSE(secondObserver.latestPropertyChange.has_value());
+    }
+
     SECTION("Container signals are cleared when no longer needed")
     {
         Item item(1987);
@@ -0,0 +1,67 @@
+#include "catch.hpp"
+
+#include <array>
+#include <cstring>
+#include <vector>
+
+#include "../src/graphics/outfit_variation.h"
+
+namespace
+{
+    // BGRA, as stored in texture memory
+    constexpr uint32_t Yellow = 0xFFFFFF00;
+    constexpr uint32_t Red = 0xFFFF0000;
+    constexpr uint32_t Green = 0xFF00FF00;
+    constexpr uint32_t Blue = 0xFF0000FF;
+    constexpr uint32_t Magenta = 0x00FF00FF;
+
+    std::vector<uint8_t> toBytes(const std::vector<uint32_t> &pixels)
+    {
+        std::vector<uint8_t> bytes(pixels.size() * 4);
+        std::memcpy(bytes.data(), pixels.data(), bytes.size());
+        return bytes;
+    }
+
+    uint32_t pixelAt(const std::vector<uint8_t> &bytes, size_t index)
+    {
+        uint32_t pixel;
+        std::memcpy(&pixel, bytes.data() + 4 * index, sizeof(uint32_t));
+        return pixel;
+    }
+} // namespace
+
+TEST_CASE("outfit_variation.h", "[rendering]")
+{
+    const std::array<uint32_t, 4> colors = {0xFF808080, 0xFFFF0000, 0xFF00FF00, 0xFF000000};
+
+    SECTION("Each template color selects its outfit color")
+    {
+        // More than four pixels so that both the vectorized loop and the remainder are used
+        std::vector<uint32_t> mask = {Yellow, Red, Green, Blue, Magenta, Yellow, Red};
+        std::vector<uint8_t> source = toBytes(std::vector<uint32_t>(mask.size(), 0xFFFFFFFF));
+        std::vector<uint8_t> maskBytes = toBytes(mask);
+        std::vector<uint8_t> target(source.size());
+
+        OutfitVariation::colorizeRow(target.data(), source.data(), maskBytes.data(), mask.size(), colors);
+
+        REQUIRE(pixelAt(target, 0) == 0xFF808080);
+        REQUIRE(pixelAt(target, 1) == 0xFFFF0000);
+        REQUIRE(pixelAt(target, 2) == 0xFF00FF00);
+        REQUIRE(pixelAt(target, 3) == 0xFF000000);
+        REQUIRE(pixelAt(target, 4) == 0xFFFFFFFF);
+        REQUIRE(pixelAt(target, 5) == 0xFF808080);
+        REQUIRE(pixelAt(target, 6) == 0xFFFF0000);
+    }
+
+    SECTION("Pixels outside the template are copied unchanged")
+    {
+        std::vector<uint32_t> sourcePixels = {0x80402010, 0x00000000, 0x12345678, 0xFFFFFFFF, 0x01020304};
+        std::vector<uint8_t> source = toBytes(sourcePixels);
+        std::vector<uint8_t> maskBytes = toBytes(std::vector<uint32_t>(sourcePixels.size(), Magenta));
+        std::vector<uint8_t> target(source.size());
+
+        OutfitVariation::colorizeRow(target.data(), source.data(), maskBytes.data(), sourcePixels.size(), colors);
+
+        REQUIRE(target == source);
+    }
+}
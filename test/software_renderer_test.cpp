@@ -0,0 +1,195 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+#include "../src/software_renderer.h"
+
+namespace
+{
+    DrawCommand solidCommand(SolidColor color, WorldPosition position, uint32_t width, uint32_t height, float opacity = 1.0f)
+    {
+        return DrawCommand{
+            &Texture::getOrCreateSolidTexture(color),
+            glm::vec4(0, 0, 1, 1),
+            glm::vec4(0, 0, 1, 1),
+            colors::opacity(opacity),
+            position,
+            width,
+            height};
+    }
+
+    DrawCommand textureCommand(const Texture &texture, WorldPosition position, uint32_t width, uint32_t height, float opacity = 1.0f)
+    {
+        return DrawCommand{
+            &texture,
+            glm::vec4(0, 0, 1, 1),
+            glm::vec4(0, 0, 1, 1),
+            colors::opacity(opacity),
+            position,
+            width,
+            height};
+    }
+
+    std::array<uint8_t, 4> pixelAt(const SoftwareRenderer::Image &image, int x, int y)
+    {
+        const uint8_t *pixel = image.pixels.data() + 4 * (y * image.width + x);
+        return {pixel[0], pixel[1], pixel[2], pixel[3]};
+    }
+
+    /*
+		Creates a texture from RGBA colors given top row first. Texture memory is BGRA with the bottom row first.
+	*/
+    Texture createTexture(uint32_t width, uint32_t height, const std::vector<glm::vec4> &colors)
+    {
+        std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                const glm::vec4 &color = colors[y * width + x];
+                uint8_t *texel = pixels.data() + 4 * ((height - 1 - y) * width + x);
+                texel[0] = static_cast<uint8_t>(color.b);
+                texel[1] = static_cast<uint8_t>(color.g);
+                texel[2] = static_cast<uint8_t>(color.r);
+                texel[3] = static_cast<uint8_t>(color.a);
+            }
+        }
+
+        return Texture(width, height, std::move(pixels));
+    }
+
+    glm::vec4 blend(const glm::vec4 &source, const glm::vec4 &destination)
+    {
+        float alpha = source.a / 255.0f;
+        return glm::vec4(glm::vec3(source) * alpha + glm::vec3(destination) * (1.0f - alpha), 255.0f);
+    }
+
+    /*
+		Largest difference of any channel between the image and the expected RGBA color of every pixel.
+	*/
+    int maxDifference(const SoftwareRenderer::Image &image, const std::function<glm::vec4(int x, int y)> &expected)
+    {
+        int result = 0;
+        for (int y = 0; y < static_cast<int>(image.height); ++y)
+        {
+            for (int x = 0; x < static_cast<int>(image.width); ++x)
+            {
+                auto pixel = pixelAt(image, x, y);
+                glm::vec4 color = expected(x, y);
+                for (int i = 0; i < 4; ++i)
+                {
+                    result = std::max(result, std::abs(pixel[i] - static_cast<int>(std::lround(color[i]))));
+                }
+            }
+        }
+
+        return result;
+    }
+
+    // The renderer rounds every blend to 8 bits; the expected colors are not rounded until the comparison
+    constexpr int Tolerance = 2;
+
+    const glm::vec4 Red(255, 0, 0, 255);
+    const glm::vec4 Green(0, 255, 0, 255);
+    const glm::vec4 Blue(0, 0, 255, 255);
+    const glm::vec4 White(255, 255, 255, 255);
+} // namespace
+
+TEST_CASE("software_renderer.h", "[rendering]")
+{
+    SECTION("A sprite at the default zoom covers exactly its pixels")
+    {
+        Camera::Viewport viewport{0, 0, GROUND_FLOOR, 64, 64, 1.0f};
+
+        DrawList drawList{solidCommand(SolidColor::Red, WorldPosition(10, 10), 32, 32)};
+        auto image = SoftwareRenderer(1).render(drawList, viewport);
+
+        REQUIRE(image.width == 64);
+        REQUIRE(image.height == 64);
+
+        using Pixel = std::array<uint8_t, 4>;
+        REQUIRE(pixelAt(image, 10, 10) == Pixel{255, 0, 0, 255});
+        REQUIRE(pixelAt(image, 41, 41) == Pixel{255, 0, 0, 255});
+        REQUIRE(pixelAt(image, 9, 10) == Pixel{0, 0, 0, 255});
+        REQUIRE(pixelAt(image, 42, 41) == Pixel{0, 0, 0, 255});
+    }
+
+    SECTION("The result does not depend on the thread count")
+    {
+        Camera::Viewport viewport{5, 7, GROUND_FLOOR, 300, 200, 1.5f};
+
+        DrawList drawList;
+        for (int i = 0; i < 40; ++i)
+        {
+            drawList.emplace_back(solidCommand(i % 2 == 0 ? SolidColor::Blue : SolidColor::Green, WorldPosition(i * 7, i * 3), 64, 40, 0.6f));
+        }
+
+        auto singleThreaded = SoftwareRenderer(1).render(drawList, viewport);
+        auto multiThreaded = SoftwareRenderer(4).render(drawList, viewport);
+
+        REQUIRE(singleThreaded.pixels == multiThreaded.pixels);
+    }
+
+    SECTION("A zoomed texture is sampled bilinearly and blended with its opacity")
+    {
+        // 32 x 32 world pixels fill the 64 x 64 image
+        Camera::Viewport viewport{0, 0, GROUND_FLOOR, 64, 64, 2.0f};
+
+        Texture gradient = createTexture(2, 2, {Red, Green, Blue, White});
+
+        DrawList drawList{
+            solidCommand(SolidColor::Red, WorldPosition(0, 0), 32, 32),
+            textureCommand(gradient, WorldPosition(0, 0), 32, 32, 0.75f)};
+
+        auto image = SoftwareRenderer(2).render(drawList, viewport);
+
+        // Texel centers are at 16 and 48 pixels. Outside of them, the edge texels are repeated (CLAMP_TO_EDGE).
+        auto expected = [](int x, int y) {
+            float weightX = std::clamp((x + 0.5f) / 32.0f - 0.5f, 0.0f, 1.0f);
+            float weightY = std::clamp((y + 0.5f) / 32.0f - 0.5f, 0.0f, 1.0f);
+
+            glm::vec4 top = Red + (Green - Red) * weightX;
+            glm::vec4 bottom = Blue + (White - Blue) * weightX;
+            glm::vec4 texel = top + (bottom - top) * weightY;
+
+            return blend(texel * colors::opacity(0.75f), Red);
+        };
+
+        REQUIRE(maxDifference(image, expected) <= Tolerance);
+    }
+
+    SECTION("A sprite at the default zoom blends translucent texels and skips magenta")
+    {
+        Camera::Viewport viewport{0, 0, GROUND_FLOOR, 8, 8, 1.0f};
+
+        const glm::vec4 Translucent(255, 255, 255, 128);
+        const glm::vec4 Magenta(255, 0, 255, 255);
+
+        std::vector<glm::vec4> texels(16, Translucent);
+        texels[0] = Magenta;
+        Texture sprite = createTexture(4, 4, texels);
+
+        DrawList drawList{
+            solidCommand(SolidColor::Red, WorldPosition(0, 0), 8, 8),
+            textureCommand(sprite, WorldPosition(2, 2), 4, 4)};
+
+        auto image = SoftwareRenderer(1).render(drawList, viewport);
+
+        auto expected = [&](int x, int y) {
+            bool inside = x >= 2 && x < 6 && y >= 2 && y < 6;
+            if (!inside || (x == 2 && y == 2))
+            {
+                return Red;
+            }
+
+            return blend(Translucent, Red);
+        };
+
+        REQUIRE(maxDifference(image, expected) <= Tolerance);
+    }
+}
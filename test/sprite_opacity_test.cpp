@@ -0,0 +1,135 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <vector>
+
+#include "../src/graphics/appearances.h"
+#include "../src/graphics/sprite_opacity.h"
+#include "../src/graphics/texture_atlas.h"
+#include "../src/items.h"
+#include "test_files.h"
+
+namespace
+{
+    // The pixels are stored as a BMP: bottom-up BGRA
+    void setAlpha(std::vector<uint8_t> &pixels, const TextureAtlas &atlas, uint32_t spriteIndex, uint32_t x, uint32_t y, uint8_t alpha)
+    {
+        uint32_t left = (spriteIndex % atlas.columns) * atlas.spriteWidth;
+        uint32_t top = (spriteIndex / atlas.columns) * atlas.spriteHeight;
+
+        pixels[4 * (static_cast<size_t>(atlas.height - (top + y) - 1) * atlas.width + left + x) + 3] = alpha;
+    }
+
+    void fillAlpha(std::vector<uint8_t> &pixels, const TextureAtlas &atlas, uint32_t spriteIndex, uint8_t alpha)
+    {
+        for (uint32_t y = 0; y < atlas.spriteHeight; ++y)
+        {
+            for (uint32_t x = 0; x < atlas.spriteWidth; ++x)
+            {
+                setAlpha(pixels, atlas, spriteIndex, x, y, alpha);
+            }
+        }
+    }
+
+    bool sameOpacity(const SpriteOpacity &a, const SpriteOpacity &b)
+    {
+        return a.flags == b.flags && a.transparentQuadrants == b.transparentQuadrants &&
+               a.x0 == b.x0 && a.y0 == b.y0 && a.x1 == b.x1 && a.y1 == b.y1;
+    }
+
+    std::vector<SpriteOpacity> opacities(const TextureAtlas &atlas)
+    {
+        std::vector<SpriteOpacity> result;
+        for (uint32_t spriteId = atlas.firstSpriteId; spriteId <= atlas.lastSpriteId; ++spriteId)
+        {
+            result.emplace_back(atlas.spriteOpacity(spriteId));
+        }
+
+        return result;
+    }
+
+    bool sameOpacities(const std::vector<SpriteOpacity> &a, const std::vector<SpriteOpacity> &b)
+    {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end(), sameOpacity);
+    }
+} // namespace
+
+TEST_CASE("sprite_opacity.h", "[rendering]")
+{
+    SECTION("A summary holds the opacity, transparent quadrants and visible bounds of a sprite")
+    {
+        TextureAtlas atlas("missing.bmp.lzma", 384, 384, 1, 4, SpriteLayout::ONE_BY_ONE, "missing.bmp.lzma");
+        std::vector<uint8_t> pixels(atlas.sizeInBytes(), 0);
+
+        // 0: Opaque
+        fillAlpha(pixels, atlas, 0, 0xFF);
+
+        // 1: Transparent
+
+        // 2: A single half transparent pixel in the top right quadrant
+        setAlpha(pixels, atlas, 2, 20, 5, 0x80);
+
+        // 3: Opaque except for the top left pixel
+        fillAlpha(pixels, atlas, 3, 0xFF);
+        setAlpha(pixels, atlas, 3, 0, 0, 0);
+
+        auto opacities = SpriteOpacity::analyze(atlas, pixels);
+        REQUIRE(opacities.size() == 4);
+
+        const SpriteOpacity &opaque = opacities[0];
+        REQUIRE(opaque.opaque());
+        REQUIRE(opaque.coversTile());
+        REQUIRE(opaque.transparentQuadrants == 0);
+        REQUIRE((opaque.x0 == 0 && opaque.y0 == 0 && opaque.x1 == 32 && opaque.y1 == 32));
+
+        const SpriteOpacity &transparent = opacities[1];
+        REQUIRE(transparent.flags == 0);
+        REQUIRE(transparent.empty());
+        REQUIRE(transparent.transparentQuadrants == (SpriteOpacity::TopLeft | SpriteOpacity::TopRight | SpriteOpacity::BottomLeft | SpriteOpacity::BottomRight));
+
+        const SpriteOpacity &pixel = opacities[2];
+        REQUIRE(pixel.flags == 0);
+        REQUIRE_FALSE(pixel.transparent(SpriteOpacity::TopRight));
+        REQUIRE(pixel.transparent(SpriteOpacity::TopLeft));
+        REQUIRE(pixel.transparent(SpriteOpacity::BottomLeft));
+        REQUIRE(pixel.transparent(SpriteOpacity::BottomRight));
+        REQUIRE((pixel.x0 == 20 && pixel.y0 == 5 && pixel.x1 == 21 && pixel.y1 == 6));
+
+        const SpriteOpacity &almostOpaque = opacities[3];
+        REQUIRE_FALSE(almostOpaque.opaque());
+        REQUIRE_FALSE(almostOpaque.coversTile());
+        REQUIRE(almostOpaque.transparentQuadrants == 0);
+        REQUIRE((almostOpaque.x0 == 0 && almostOpaque.y0 == 0 && almostOpaque.x1 == 32 && almostOpaque.y1 == 32));
+    }
+
+    SECTION("Cached summaries are reused and missing or outdated ones are analyzed")
+    {
+        TextureAtlas *first = Items::items.getItemTypeByServerId(4526)->getFirstTextureAtlas();
+        TextureAtlas *second = Appearances::getTextureAtlas(first->lastSpriteId + 1);
+        REQUIRE(first != second);
+
+        TestFiles::TemporaryDirectory directory("vme_sprite_opacity_test");
+        std::filesystem::path cacheFile = directory / "sprite-opacity.bin";
+
+        REQUIRE(SpriteOpacityCache::load(cacheFile, {first}) == 1);
+        std::vector<SpriteOpacity> analyzed = opacities(*first);
+
+        // Read back from the cache
+        REQUIRE(SpriteOpacityCache::load(cacheFile, {first}) == 0);
+        REQUIRE(sameOpacities(opacities(*first), analyzed));
+
+        // Only the atlas that is missing from the cache is analyzed
+        REQUIRE(SpriteOpacityCache::load(cacheFile, {first, second}) == 1);
+        REQUIRE(SpriteOpacityCache::load(cacheFile, {first, second}) == 0);
+
+        // A cache of another format version is not used
+        TestFiles::overwrite(cacheFile, SpriteOpacityCache::FormatVersionOffset, static_cast<uint32_t>(SpriteOpacityCache::FormatVersion + 1));
+        REQUIRE(SpriteOpacityCache::load(cacheFile, {first, second}) == 2);
+        REQUIRE(sameOpacities(opacities(*first), analyzed));
+
+        // A damaged cache keeps the summaries that were read before the damage
+        std::filesystem::resize_file(cacheFile, std::filesystem::file_size(cacheFile) - 1);
+        REQUIRE(SpriteOpacityCache::load(cacheFile, {first, second}) == 1);
+    }
+}
@@ -0,0 +1,146 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/task_graph.h"
+
+namespace
+{
+    // The names of the tasks that ran, in the order they finished
+    class RunOrder
+    {
+      public:
+        std::function<void()> task(const std::string &name)
+        {
+            return [this, name]() {
+                std::lock_guard lock(mutex);
+                names.emplace_back(name);
+            };
+        }
+
+        size_t position(const std::string &name) const
+        {
+            return std::find(names.begin(), names.end(), name) - names.begin();
+        }
+
+        std::mutex mutex;
+        std::vector<std::string> names;
+    };
+
+    const TaskGraph::Timing &timing(const TaskGraph &graph, const std::string &name)
+    {
+        const auto &timings = graph.timings();
+        return *std::find_if(timings.begin(), timings.end(), [&name](const TaskGraph::Timing &timing) { return timing.name == name; });
+    }
+} // namespace
+
+TEST_CASE("task_graph.h", "[util]")
+{
+    TaskGraph graph;
+    RunOrder order;
+
+    SECTION("Tasks run after the tasks they depend on")
+    {
+        graph.add("appearances", order.task("appearances"));
+        graph.add("items", order.task("items"), {"appearances"});
+        graph.add("creatures", order.task("creatures"), {"appearances"});
+        graph.add("brushes", order.task("brushes"), {"items", "creatures"});
+        graph.add("settings", order.task("settings"));
+
+        REQUIRE(graph.contains("brushes"));
+        REQUIRE_FALSE(graph.contains("map"));
+
+        graph.run(4);
+
+        REQUIRE(order.names.size() == 5);
+        REQUIRE(order.position("appearances") < order.position("items"));
+        REQUIRE(order.position("appearances") < order.position("creatures"));
+        REQUIRE(order.position("items") < order.position("brushes"));
+        REQUIRE(order.position("creatures") < order.position("brushes"));
+
+        // Timings are in the order the tasks were added
+        REQUIRE(graph.timings().size() == 5);
+        REQUIRE(graph.timings().front().name == "appearances");
+        REQUIRE(graph.timings().back().name == "settings");
+        REQUIRE(timing(graph, "brushes").startMillis >= timing(graph, "items").startMillis);
+        REQUIRE(graph.totalMillis() >= 0);
+
+        SECTION("A graph can be run again")
+        {
+            order.names.clear();
+            graph.run(1);
+
+            REQUIRE(order.names.size() == 5);
+            REQUIRE(graph.timings().size() == 5);
+        }
+    }
+
+    SECTION("Independent tasks run in parallel")
+    {
+        std::atomic<int> started = 0;
+
+        // Each task waits until the other one has started
+        auto task = [&started]() {
+            ++started;
+            for (int i = 0; i < 1000 && started < 2; ++i)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            if (started < 2)
+            {
+                throw std::runtime_error("The other task did not start.");
+            }
+        };
+
+        graph.add("first", task);
+        graph.add("second", task);
+
+        REQUIRE_NOTHROW(graph.run(2));
+    }
+
+    SECTION("The first exception is rethrown and the tasks that were not started yet are skipped")
+    {
+        graph.add("appearances", []() { throw std::runtime_error("Could not load appearances.dat"); });
+        graph.add("items", order.task("items"), {"appearances"});
+        graph.add("brushes", order.task("brushes"), {"items"});
+
+        REQUIRE_THROWS_WITH(graph.run(1), "Could not load appearances.dat");
+
+        REQUIRE(order.names.empty());
+        REQUIRE_FALSE(timing(graph, "appearances").skipped);
+        REQUIRE(timing(graph, "items").skipped);
+        REQUIRE(timing(graph, "brushes").skipped);
+    }
+
+    SECTION("Tasks that are running when another task throws finish")
+    {
+        std::atomic<bool> thrown = false;
+
+        graph.add("slow", [&thrown]() {
+            for (int i = 0; i < 1000 && !thrown; ++i)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+        graph.add("failing", [&thrown]() {
+            thrown = true;
+            throw std::runtime_error("failed");
+        });
+        graph.add("after slow", order.task("after slow"), {"slow"});
+
+        REQUIRE_THROWS_AS(graph.run(2), std::runtime_error);
+
+        REQUIRE(thrown);
+        REQUIRE_FALSE(timing(graph, "slow").skipped);
+        REQUIRE(timing(graph, "after slow").skipped);
+        REQUIRE(order.names.empty());
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+
+/*
+	Files for tests of the caches that are stored on disk.
+*/
+namespace TestFiles
+{
+    /*
+		An empty directory in the temporary directory. It is removed with its contents when destroyed.
+	*/
+    class TemporaryDirectory
+    {
+      public:
+        explicit TemporaryDirectory(const std::string &name)
+            : path(std::filesystem::temp_directory_path() / name)
+        {
+            std::filesystem::remove_all(path);
+            std::filesystem::create_directories(path);
+        }
+
+        ~TemporaryDirectory()
+        {
+            std::error_code error;
+            std::filesystem::remove_all(path, error);
+        }
+
+        TemporaryDirectory(const TemporaryDirectory &) = delete;
+        TemporaryDirectory &operator=(const TemporaryDirectory &) = delete;
+
+        std::filesystem::path operator/(const std::filesystem::path &name) const
+        {
+            return path / name;
+        }
+
+        const std::filesystem::path path;
+    };
+
+    inline void write(const std::filesystem::path &path, const std::string &contents)
+    {
+        std::ofstream(path, std::ios::out | std::ios::trunc | std::ios::binary) << contents;
+    }
+
+    // Overwrites a value in an existing file, e.g. a field of a cache header
+    template <typename T>
+    void overwrite(const std::filesystem::path &path, size_t offset, const T &value)
+    {
+        std::fstream stream(path, std::ios::in | std::ios::out | std::ios::binary);
+        stream.seekp(offset);
+        stream.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+} // namespace TestFiles
@@ -0,0 +1,95 @@
+#include "catch.hpp"
+
+#include "../src/graphics/appearances.h"
+#include "../src/graphics/texture_atlas.h"
+#include "../src/graphics/texture_atlas_cache.h"
+#include "../src/items.h"
+#include "../src/settings.h"
+
+namespace
+{
+    // Evicts every atlas that is not protected by a renderer
+    void evictAll(TextureAtlasCache::RendererFrames &renderer)
+    {
+        size_t budget = Settings::TEXTURE_ATLAS_MEMORY_BUDGET;
+        Settings::TEXTURE_ATLAS_MEMORY_BUDGET = 0;
+
+        TextureAtlasCache::beginFrame(renderer);
+        TextureAtlasCache::beginFrame(renderer);
+
+        Settings::TEXTURE_ATLAS_MEMORY_BUDGET = budget;
+    }
+} // namespace
+
+TEST_CASE("texture_atlas_cache.h", "[rendering]")
+{
+    TextureAtlas *first = Items::items.getItemTypeByServerId(4526)->getFirstTextureAtlas();
+    TextureAtlas *second = Appearances::getTextureAtlas(first->lastSpriteId + 1);
+    REQUIRE(second != nullptr);
+
+    size_t budget = Settings::TEXTURE_ATLAS_MEMORY_BUDGET;
+
+    TextureAtlasCache::RendererFrames renderer;
+    evictAll(renderer);
+    REQUIRE(TextureAtlasCache::statistics().residentBytes == 0);
+
+    SECTION("Atlases used in the current or previous frame are not evicted")
+    {
+        TextureAtlasCache::beginFrame(renderer);
+        first->getOrCreateTexture();
+
+        Settings::TEXTURE_ATLAS_MEMORY_BUDGET = 0;
+
+        TextureAtlasCache::beginFrame(renderer);
+        REQUIRE_FALSE(first->isCompressed());
+
+        TextureAtlasCache::beginFrame(renderer);
+        REQUIRE(first->isCompressed());
+    }
+
+    SECTION("The frames of other renderers do not end the protection")
+    {
+        TextureAtlasCache::RendererFrames other;
+
+        TextureAtlasCache::beginFrame(renderer);
+        first->getOrCreateTexture();
+
+        Settings::TEXTURE_ATLAS_MEMORY_BUDGET = 0;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            TextureAtlasCache::beginFrame(other);
+        }
+        REQUIRE_FALSE(first->isCompressed());
+
+        TextureAtlasCache::beginFrame(renderer);
+        REQUIRE_FALSE(first->isCompressed());
+
+        TextureAtlasCache::beginFrame(renderer);
+        REQUIRE(first->isCompressed());
+    }
+
+    SECTION("The least recently used atlas is evicted first")
+    {
+        TextureAtlasCache::beginFrame(renderer);
+        first->getOrCreateTexture();
+        TextureAtlasCache::beginFrame(renderer);
+        second->getOrCreateTexture();
+
+        // Neither atlas is protected after two more frames
+        TextureAtlasCache::beginFrame(renderer);
+        TextureAtlasCache::beginFrame(renderer);
+        REQUIRE(TextureAtlasCache::statistics().residentAtlases == 2);
+
+        uint64_t evictions = TextureAtlasCache::statistics().evictions;
+        Settings::TEXTURE_ATLAS_MEMORY_BUDGET = second->sizeInBytes();
+
+        TextureAtlasCache::beginFrame(renderer);
+        REQUIRE(first->isCompressed());
+        REQUIRE_FALSE(second->isCompressed());
+        REQUIRE(TextureAtlasCache::statistics().evictions == evictions + 1);
+        REQUIRE(TextureAtlasCache::statistics().residentBytes == second->sizeInBytes());
+    }
+
+    Settings::TEXTURE_ATLAS_MEMORY_BUDGET = budget;
+}
@@ -0,0 +1,141 @@
+#include "catch.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "../src/graphics/thumbnail_disk_cache.h"
+#include "test_files.h"
+
+namespace
+{
+    std::vector<uint8_t> thumbnailPixels(uint8_t value, uint16_t width, uint16_t height)
+    {
+        return std::vector<uint8_t>(static_cast<size_t>(width) * height * 4, value);
+    }
+
+    bool samePixels(const ThumbnailDiskCache::Thumbnail &thumbnail, const std::vector<uint8_t> &pixels)
+    {
+        return static_cast<size_t>(thumbnail.width) * thumbnail.height * 4 == pixels.size() &&
+               std::memcmp(thumbnail.pixels, pixels.data(), pixels.size()) == 0;
+    }
+} // namespace
+
+TEST_CASE("thumbnail_disk_cache.h", "[rendering]")
+{
+    TestFiles::TemporaryDirectory directory("vme_thumbnail_disk_cache_test");
+    std::filesystem::path file = directory / "thumbnails.bin";
+
+    auto first = thumbnailPixels(1, 32, 32);
+    auto second = thumbnailPixels(2, 32, 16);
+
+    {
+        ThumbnailDiskCache cache(file, "12.70");
+        REQUIRE(cache.size() == 0);
+
+        cache.add(20, 7, 32, 32, first.data());
+        cache.add(10, 8, 32, 16, second.data());
+
+        // Found before they are saved
+        REQUIRE(cache.find(20, 7));
+        REQUIRE(cache.unsavedBytes() == first.size() + second.size());
+
+        cache.save();
+        REQUIRE(cache.size() == 2);
+        REQUIRE(cache.unsavedBytes() == 0);
+    }
+
+    SECTION("Thumbnails are read back from the file")
+    {
+        ThumbnailDiskCache cache(file, "12.70");
+        REQUIRE(cache.size() == 2);
+
+        auto thumbnail = cache.find(20, 7);
+        REQUIRE(thumbnail);
+        REQUIRE(samePixels(*thumbnail, first));
+
+        thumbnail = cache.find(10, 8);
+        REQUIRE(thumbnail);
+        REQUIRE(thumbnail->height == 16);
+        REQUIRE(samePixels(*thumbnail, second));
+
+        REQUIRE_FALSE(cache.find(30, 7));
+    }
+
+    SECTION("A thumbnail with a changed source is replaced")
+    {
+        ThumbnailDiskCache cache(file, "12.70");
+        REQUIRE_FALSE(cache.find(20, 9));
+
+        auto changed = thumbnailPixels(3, 32, 32);
+        cache.add(20, 9, 32, 32, changed.data());
+        cache.save();
+
+        REQUIRE(cache.size() == 2);
+        REQUIRE(samePixels(*cache.find(20, 9), changed));
+        REQUIRE(samePixels(*cache.find(10, 8), second));
+    }
+
+    SECTION("A save is written on another thread while the cache is used")
+    {
+        ThumbnailDiskCache cache(file, "12.70");
+
+        auto third = thumbnailPixels(4, 16, 16);
+        cache.add(30, 1, 16, 16, third.data());
+
+        auto save = cache.beginSave();
+        REQUIRE(save);
+        REQUIRE(cache.unsavedBytes() == 0);
+
+        // Only one save runs at a time
+        REQUIRE_FALSE(cache.beginSave());
+
+        std::thread writer([save]() { save->write(); });
+
+        // Thumbnails that are being saved and thumbnails that are added meanwhile are found
+        auto fourth = thumbnailPixels(5, 16, 16);
+        cache.add(40, 1, 16, 16, fourth.data());
+        REQUIRE(samePixels(*cache.find(30, 1), third));
+        REQUIRE(samePixels(*cache.find(20, 7), first));
+
+        writer.join();
+        cache.finishSave(*save);
+
+        REQUIRE(cache.size() == 3);
+        REQUIRE(samePixels(*cache.find(30, 1), third));
+        REQUIRE(samePixels(*cache.find(40, 1), fourth));
+        REQUIRE(cache.unsavedBytes() == fourth.size());
+
+        cache.save();
+        REQUIRE(cache.size() == 4);
+    }
+
+    SECTION("A record that points past the end of the file is not read")
+    {
+        // The pixel offset of the first record follows its key and source hash
+        uint64_t offset = std::numeric_limits<uint64_t>::max() - 16;
+        TestFiles::overwrite(file, ThumbnailDiskCache::HeaderSize + 16, offset);
+
+        ThumbnailDiskCache cache(file, "12.70");
+        REQUIRE(cache.size() == 0);
+        REQUIRE_FALSE(cache.find(10, 8));
+    }
+
+    SECTION("The file of another client version is ignored")
+    {
+        ThumbnailDiskCache cache(file, "13.00");
+        REQUIRE(cache.size() == 0);
+        REQUIRE_FALSE(cache.find(20, 7));
+    }
+
+    SECTION("The file of another format version is ignored")
+    {
+        TestFiles::overwrite(file, ThumbnailDiskCache::FormatVersionOffset, static_cast<uint32_t>(ThumbnailDiskCache::FormatVersion + 1));
+
+        ThumbnailDiskCache cache(file, "12.70");
+        REQUIRE(cache.size() == 0);
+        REQUIRE_FALSE(cache.find(20, 7));
+    }
+}
@@ -0,0 +1,101 @@
+#include "catch.hpp"
+
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+
+#include <nlohmann/json.hpp>
+
+#include "../src/trace.h"
+#include "test_files.h"
+
+namespace
+{
+    constexpr auto OuterName = "trace test outer";
+    constexpr auto InnerName = "trace test \"inner\"";
+
+    void traceNested()
+    {
+        Trace::Scope outer(OuterName);
+        {
+            Trace::Scope inner(InnerName);
+        }
+    }
+} // namespace
+
+TEST_CASE("trace.h", "[util]")
+{
+    TestFiles::TemporaryDirectory directory("vme_trace_test");
+
+    SECTION("Nested scopes on two threads are written as complete events of their thread")
+    {
+        Trace::start();
+        std::thread other(traceNested);
+        traceNested();
+        other.join();
+        Trace::stop();
+
+        REQUIRE(Trace::write(directory / "trace.json"));
+
+        std::ifstream stream(directory / "trace.json");
+        nlohmann::json trace = nlohmann::json::parse(stream);
+
+        // The outer and inner event of each thread
+        std::map<uint32_t, nlohmann::json> outerEvents;
+        std::map<uint32_t, nlohmann::json> innerEvents;
+        for (const nlohmann::json &event : trace.at("traceEvents"))
+        {
+            REQUIRE(event.at("ph") == "X");
+
+            std::string name = event.at("name");
+            uint32_t tid = event.at("tid");
+            if (name == OuterName)
+            {
+                REQUIRE(outerEvents.emplace(tid, event).second);
+            }
+            else if (name == InnerName)
+            {
+                REQUIRE(innerEvents.emplace(tid, event).second);
+            }
+        }
+
+        REQUIRE(outerEvents.size() == 2);
+        REQUIRE(innerEvents.size() == 2);
+
+        for (const auto &[tid, outer] : outerEvents)
+        {
+            REQUIRE(innerEvents.contains(tid));
+            const nlohmann::json &inner = innerEvents.at(tid);
+
+            int64_t outerStart = outer.at("ts");
+            int64_t innerStart = inner.at("ts");
+            int64_t outerEnd = outerStart + outer.at("dur").get<int64_t>();
+            int64_t innerEnd = innerStart + inner.at("dur").get<int64_t>();
+
+            // Start and duration are each rounded down to microseconds
+            REQUIRE(outerStart <= innerStart);
+            REQUIRE(innerEnd <= outerEnd + 1);
+        }
+    }
+
+    SECTION("Spans past the buffer of a thread are counted as dropped until the trace is cleared")
+    {
+        Trace::start();
+        std::thread([]() {
+            for (size_t i = 0; i < Trace::MaxSpansPerThread + 3; ++i)
+            {
+                Trace::Scope scope("trace test dropped");
+            }
+        }).join();
+        Trace::stop();
+
+        REQUIRE(Trace::droppedSpans() == 3);
+
+        // Also releases the buffer of the thread, which exited
+        Trace::start();
+        Trace::stop();
+        REQUIRE(Trace::droppedSpans() == 0);
+    }
+}